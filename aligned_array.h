@@ -0,0 +1,699 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_ALIGNED_ARRAY_H_
+#define CPP_LABS_ALIGNED_ARRAY_H_
+
+// AlignedArray<T, N, Alignment> is a fixed-size array, like the plain
+// 'int my_array[kArraySize]' of array_example.cc or std::array<T, N>, whose
+// bulk operations (Fill, CopyFrom, Equals, Sum, Min, Max) are specialized at
+// compile time on N:
+//
+// 1. Tiny arrays (at most one cache line) are fully unrolled: there is no loop
+// at all, just N straight-line operations.
+// 2. Larger arrays of float, double or int32_t use a SIMD main loop (AVX-512
+// or AVX2, whichever the compiler targets) followed by a single masked
+// operation for the N % width leftover elements instead of a scalar tail loop.
+// 3. Any other case uses a plain loop with several independent accumulators,
+// which the compiler is free to vectorize.
+//
+// Since N is a template argument, the number of SIMD iterations and the tail
+// mask are compile-time constants. Build with -DBUILD_WITH_NATIVE_ARCH=ON to
+// enable the AVX2/AVX-512 paths.
+//
+// Notes:
+// 1. Sum of floating point values is computed in a different order than a
+// sequential loop, so the result may differ in the last bits.
+// 2. Sum of integers wraps around like the sequential loop would.
+
+#include <cassert>  // Header for assert.
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for int32_t.
+#include <cstring>  // Header for std::memcpy.
+#include <type_traits>  // Header for std::conditional.
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>  // Header for the SIMD intrinsics.
+#endif
+
+#include "aligned_memory.h"
+
+namespace cpp_labs {
+namespace internal {
+
+// Arrays of at most this many bytes are fully unrolled.
+const std::size_t kUnrollBytes = 64;
+
+// Calls function(I) for I in [Begin, End). Every call gets a constant index
+// after inlining, so the loop disappears.
+template <std::size_t Begin, std::size_t End>
+struct Unroll {
+  template <typename Function>
+  static void Apply(const Function& function) {
+    function(Begin);
+    Unroll<Begin + 1, End>::Apply(function);
+  }
+};
+
+template <std::size_t End>
+struct Unroll<End, End> {
+  template <typename Function>
+  static void Apply(const Function&) {}
+};
+
+// SIMD operations used by the kernels. The primary template marks a type as
+// not supported, which selects the generic loops.
+template <typename T>
+struct SimdOps {
+  static const bool kEnabled = false;
+};
+
+#if defined(__AVX512F__)
+
+// Mask with the lowest count lanes set.
+inline __mmask16 TailMask16(const std::size_t count) {
+  return static_cast<__mmask16>((1u << count) - 1u);
+}
+
+inline __mmask8 TailMask8(const std::size_t count) {
+  return static_cast<__mmask8>((1u << count) - 1u);
+}
+
+template <>
+struct SimdOps<float> {
+  static const bool kEnabled = true;
+  static const std::size_t kWidth = 16;
+  typedef __m512 Vector;
+
+  static Vector Load(const float* ptr) { return _mm512_loadu_ps(ptr); }
+  static void Store(float* ptr, const Vector value) {
+    _mm512_storeu_ps(ptr, value);
+  }
+  // Loads the first count lanes; the rest are taken from filler.
+  static Vector MaskLoad(const float* ptr, const std::size_t count,
+                         const Vector filler) {
+    return _mm512_mask_loadu_ps(filler, TailMask16(count), ptr);
+  }
+  static void MaskStore(float* ptr, const std::size_t count,
+                        const Vector value) {
+    _mm512_mask_storeu_ps(ptr, TailMask16(count), value);
+  }
+  static Vector Set1(const float value) { return _mm512_set1_ps(value); }
+  static Vector Add(const Vector a, const Vector b) {
+    return _mm512_add_ps(a, b);
+  }
+  static Vector Min(const Vector a, const Vector b) {
+    return _mm512_min_ps(a, b);
+  }
+  static Vector Max(const Vector a, const Vector b) {
+    return _mm512_max_ps(a, b);
+  }
+  static bool AllEqual(const Vector a, const Vector b) {
+    return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ) == 0xFFFF;
+  }
+  static float ReduceAdd(const Vector value) {
+    return _mm512_reduce_add_ps(value);
+  }
+  static float ReduceMin(const Vector value) {
+    return _mm512_reduce_min_ps(value);
+  }
+  static float ReduceMax(const Vector value) {
+    return _mm512_reduce_max_ps(value);
+  }
+};
+
+template <>
+struct SimdOps<double> {
+  static const bool kEnabled = true;
+  static const std::size_t kWidth = 8;
+  typedef __m512d Vector;
+
+  static Vector Load(const double* ptr) { return _mm512_loadu_pd(ptr); }
+  static void Store(double* ptr, const Vector value) {
+    _mm512_storeu_pd(ptr, value);
+  }
+  static Vector MaskLoad(const double* ptr, const std::size_t count,
+                         const Vector filler) {
+    return _mm512_mask_loadu_pd(filler, TailMask8(count), ptr);
+  }
+  static void MaskStore(double* ptr, const std::size_t count,
+                        const Vector value) {
+    _mm512_mask_storeu_pd(ptr, TailMask8(count), value);
+  }
+  static Vector Set1(const double value) { return _mm512_set1_pd(value); }
+  static Vector Add(const Vector a, const Vector b) {
+    return _mm512_add_pd(a, b);
+  }
+  static Vector Min(const Vector a, const Vector b) {
+    return _mm512_min_pd(a, b);
+  }
+  static Vector Max(const Vector a, const Vector b) {
+    return _mm512_max_pd(a, b);
+  }
+  static bool AllEqual(const Vector a, const Vector b) {
+    return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ) == 0xFF;
+  }
+  static double ReduceAdd(const Vector value) {
+    return _mm512_reduce_add_pd(value);
+  }
+  static double ReduceMin(const Vector value) {
+    return _mm512_reduce_min_pd(value);
+  }
+  static double ReduceMax(const Vector value) {
+    return _mm512_reduce_max_pd(value);
+  }
+};
+
+template <>
+struct SimdOps<int32_t> {
+  static const bool kEnabled = true;
+  static const std::size_t kWidth = 16;
+  typedef __m512i Vector;
+
+  static Vector Load(const int32_t* ptr) { return _mm512_loadu_si512(ptr); }
+  static void Store(int32_t* ptr, const Vector value) {
+    _mm512_storeu_si512(ptr, value);
+  }
+  static Vector MaskLoad(const int32_t* ptr, const std::size_t count,
+                         const Vector filler) {
+    return _mm512_mask_loadu_epi32(filler, TailMask16(count), ptr);
+  }
+  static void MaskStore(int32_t* ptr, const std::size_t count,
+                        const Vector value) {
+    _mm512_mask_storeu_epi32(ptr, TailMask16(count), value);
+  }
+  static Vector Set1(const int32_t value) { return _mm512_set1_epi32(value); }
+  static Vector Add(const Vector a, const Vector b) {
+    return _mm512_add_epi32(a, b);
+  }
+  static Vector Min(const Vector a, const Vector b) {
+    return _mm512_min_epi32(a, b);
+  }
+  static Vector Max(const Vector a, const Vector b) {
+    return _mm512_max_epi32(a, b);
+  }
+  static bool AllEqual(const Vector a, const Vector b) {
+    return _mm512_cmpeq_epi32_mask(a, b) == 0xFFFF;
+  }
+  static int32_t ReduceAdd(const Vector value) {
+    return _mm512_reduce_add_epi32(value);
+  }
+  static int32_t ReduceMin(const Vector value) {
+    return _mm512_reduce_min_epi32(value);
+  }
+  static int32_t ReduceMax(const Vector value) {
+    return _mm512_reduce_max_epi32(value);
+  }
+};
+
+#elif defined(__AVX2__)
+
+// Lane mask with the lowest count 32-bit lanes set to all ones.
+inline __m256i TailMask32(const std::size_t count) {
+  return _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(count)),
+                            _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+// Lane mask with the lowest count 64-bit lanes set to all ones.
+inline __m256i TailMask64(const std::size_t count) {
+  return _mm256_cmpgt_epi64(_mm256_set1_epi64x(static_cast<long long>(count)),
+                            _mm256_setr_epi64x(0, 1, 2, 3));
+}
+
+// AVX2 has no horizontal reductions, so the lanes are spilled to memory.
+template <typename T, typename Vector, typename Function>
+inline T ReduceLanes(const Vector value, const Function& function) {
+  const std::size_t kLanes = sizeof(Vector) / sizeof(T);
+  T lanes[kLanes];
+  std::memcpy(lanes, &value, sizeof(value));
+  T result = lanes[0];
+  for (std::size_t i = 1; i < kLanes; ++i) {
+    result = function(result, lanes[i]);
+  }
+  return result;
+}
+
+template <typename T>
+struct AddFunction {
+  T operator()(const T a, const T b) const { return a + b; }
+};
+template <typename T>
+struct MinFunction {
+  T operator()(const T a, const T b) const { return b < a ? b : a; }
+};
+template <typename T>
+struct MaxFunction {
+  T operator()(const T a, const T b) const { return a < b ? b : a; }
+};
+
+template <>
+struct SimdOps<float> {
+  static const bool kEnabled = true;
+  static const std::size_t kWidth = 8;
+  typedef __m256 Vector;
+
+  static Vector Load(const float* ptr) { return _mm256_loadu_ps(ptr); }
+  static void Store(float* ptr, const Vector value) {
+    _mm256_storeu_ps(ptr, value);
+  }
+  static Vector MaskLoad(const float* ptr, const std::size_t count,
+                         const Vector filler) {
+    const __m256i mask = TailMask32(count);
+    return _mm256_blendv_ps(filler, _mm256_maskload_ps(ptr, mask),
+                            _mm256_castsi256_ps(mask));
+  }
+  static void MaskStore(float* ptr, const std::size_t count,
+                        const Vector value) {
+    _mm256_maskstore_ps(ptr, TailMask32(count), value);
+  }
+  static Vector Set1(const float value) { return _mm256_set1_ps(value); }
+  static Vector Add(const Vector a, const Vector b) {
+    return _mm256_add_ps(a, b);
+  }
+  static Vector Min(const Vector a, const Vector b) {
+    return _mm256_min_ps(a, b);
+  }
+  static Vector Max(const Vector a, const Vector b) {
+    return _mm256_max_ps(a, b);
+  }
+  static bool AllEqual(const Vector a, const Vector b) {
+    return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)) == 0xFF;
+  }
+  static float ReduceAdd(const Vector value) {
+    return ReduceLanes<float>(value, AddFunction<float>());
+  }
+  static float ReduceMin(const Vector value) {
+    return ReduceLanes<float>(value, MinFunction<float>());
+  }
+  static float ReduceMax(const Vector value) {
+    return ReduceLanes<float>(value, MaxFunction<float>());
+  }
+};
+
+template <>
+struct SimdOps<double> {
+  static const bool kEnabled = true;
+  static const std::size_t kWidth = 4;
+  typedef __m256d Vector;
+
+  static Vector Load(const double* ptr) { return _mm256_loadu_pd(ptr); }
+  static void Store(double* ptr, const Vector value) {
+    _mm256_storeu_pd(ptr, value);
+  }
+  static Vector MaskLoad(const double* ptr, const std::size_t count,
+                         const Vector filler) {
+    const __m256i mask = TailMask64(count);
+    return _mm256_blendv_pd(filler, _mm256_maskload_pd(ptr, mask),
+                            _mm256_castsi256_pd(mask));
+  }
+  static void MaskStore(double* ptr, const std::size_t count,
+                        const Vector value) {
+    _mm256_maskstore_pd(ptr, TailMask64(count), value);
+  }
+  static Vector Set1(const double value) { return _mm256_set1_pd(value); }
+  static Vector Add(const Vector a, const Vector b) {
+    return _mm256_add_pd(a, b);
+  }
+  static Vector Min(const Vector a, const Vector b) {
+    return _mm256_min_pd(a, b);
+  }
+  static Vector Max(const Vector a, const Vector b) {
+    return _mm256_max_pd(a, b);
+  }
+  static bool AllEqual(const Vector a, const Vector b) {
+    return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ)) == 0xF;
+  }
+  static double ReduceAdd(const Vector value) {
+    return ReduceLanes<double>(value, AddFunction<double>());
+  }
+  static double ReduceMin(const Vector value) {
+    return ReduceLanes<double>(value, MinFunction<double>());
+  }
+  static double ReduceMax(const Vector value) {
+    return ReduceLanes<double>(value, MaxFunction<double>());
+  }
+};
+
+template <>
+struct SimdOps<int32_t> {
+  static const bool kEnabled = true;
+  static const std::size_t kWidth = 8;
+  typedef __m256i Vector;
+
+  static Vector Load(const int32_t* ptr) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+  }
+  static void Store(int32_t* ptr, const Vector value) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), value);
+  }
+  static Vector MaskLoad(const int32_t* ptr, const std::size_t count,
+                         const Vector filler) {
+    const __m256i mask = TailMask32(count);
+    return _mm256_blendv_epi8(
+        filler, _mm256_maskload_epi32(reinterpret_cast<const int*>(ptr), mask),
+        mask);
+  }
+  static void MaskStore(int32_t* ptr, const std::size_t count,
+                        const Vector value) {
+    _mm256_maskstore_epi32(reinterpret_cast<int*>(ptr), TailMask32(count),
+                           value);
+  }
+  static Vector Set1(const int32_t value) { return _mm256_set1_epi32(value); }
+  static Vector Add(const Vector a, const Vector b) {
+    return _mm256_add_epi32(a, b);
+  }
+  static Vector Min(const Vector a, const Vector b) {
+    return _mm256_min_epi32(a, b);
+  }
+  static Vector Max(const Vector a, const Vector b) {
+    return _mm256_max_epi32(a, b);
+  }
+  static bool AllEqual(const Vector a, const Vector b) {
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b)) == -1;
+  }
+  static int32_t ReduceAdd(const Vector value) {
+    return ReduceLanes<int32_t>(value, AddFunction<int32_t>());
+  }
+  static int32_t ReduceMin(const Vector value) {
+    return ReduceLanes<int32_t>(value, MinFunction<int32_t>());
+  }
+  static int32_t ReduceMax(const Vector value) {
+    return ReduceLanes<int32_t>(value, MaxFunction<int32_t>());
+  }
+};
+
+#endif  // defined(__AVX512F__)
+
+// Tags selecting the implementation of the kernels.
+struct UnrolledPath {};
+struct SimdPath {};
+struct LoopPath {};
+
+template <typename T, std::size_t N>
+struct KernelPath {
+  typedef typename std::conditional<
+      N * sizeof(T) <= kUnrollBytes, UnrolledPath,
+      typename std::conditional<SimdOps<T>::kEnabled, SimdPath,
+                                LoopPath>::type>::type type;
+};
+
+template <typename T>
+inline T MinOf(const T a, const T b) {
+  return b < a ? b : a;
+}
+
+template <typename T>
+inline T MaxOf(const T a, const T b) {
+  return a < b ? b : a;
+}
+
+// Fully unrolled kernels for tiny arrays.
+template <typename T, std::size_t N>
+struct Kernels {
+  static void Fill(T* data, const T& value, UnrolledPath) {
+    Unroll<0, N>::Apply([&](const std::size_t i) { data[i] = value; });
+  }
+  static void Copy(const T* source, T* destination, UnrolledPath) {
+    CopyUnrolled(source, destination, std::is_trivially_copyable<T>());
+  }
+  // A constant-size memcpy compiles to a few wide moves.
+  static void CopyUnrolled(const T* source, T* destination, std::true_type) {
+    std::memcpy(destination, source, N * sizeof(T));
+  }
+  static void CopyUnrolled(const T* source, T* destination, std::false_type) {
+    Unroll<0, N>::Apply(
+        [&](const std::size_t i) { destination[i] = source[i]; });
+  }
+  static bool Equals(const T* a, const T* b, UnrolledPath) {
+    // Branch-free: for a handful of elements this beats an early exit.
+    bool equal = true;
+    Unroll<0, N>::Apply([&](const std::size_t i) { equal &= a[i] == b[i]; });
+    return equal;
+  }
+  static T Sum(const T* data, UnrolledPath) {
+    T sum = data[0];
+    Unroll<1, N>::Apply([&](const std::size_t i) { sum += data[i]; });
+    return sum;
+  }
+  static T Min(const T* data, UnrolledPath) {
+    T result = data[0];
+    Unroll<1, N>::Apply(
+        [&](const std::size_t i) { result = MinOf(result, data[i]); });
+    return result;
+  }
+  static T Max(const T* data, UnrolledPath) {
+    T result = data[0];
+    Unroll<1, N>::Apply(
+        [&](const std::size_t i) { result = MaxOf(result, data[i]); });
+    return result;
+  }
+
+  // Plain loops with independent accumulators for the types without SIMD
+  // support. Four accumulators hide the latency of the dependent additions.
+  static void Fill(T* data, const T& value, LoopPath) {
+    for (std::size_t i = 0; i < N; ++i) {
+      data[i] = value;
+    }
+  }
+  static void Copy(const T* source, T* destination, LoopPath) {
+    for (std::size_t i = 0; i < N; ++i) {
+      destination[i] = source[i];
+    }
+  }
+  static bool Equals(const T* a, const T* b, LoopPath) {
+    for (std::size_t i = 0; i < N; ++i) {
+      if (!(a[i] == b[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+  static T Sum(const T* data, LoopPath) {
+    const std::size_t kMain = N / 4 * 4;
+    T sums[4] = {T(), T(), T(), T()};
+    for (std::size_t i = 0; i < kMain; i += 4) {
+      sums[0] += data[i];
+      sums[1] += data[i + 1];
+      sums[2] += data[i + 2];
+      sums[3] += data[i + 3];
+    }
+    for (std::size_t i = kMain; i < N; ++i) {
+      sums[0] += data[i];
+    }
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+  }
+  static T Min(const T* data, LoopPath) {
+    T result = data[0];
+    for (std::size_t i = 1; i < N; ++i) {
+      result = MinOf(result, data[i]);
+    }
+    return result;
+  }
+  static T Max(const T* data, LoopPath) {
+    T result = data[0];
+    for (std::size_t i = 1; i < N; ++i) {
+      result = MaxOf(result, data[i]);
+    }
+    return result;
+  }
+
+  // SIMD kernels: a main loop over full vectors plus one masked operation for
+  // the last kTail elements. Two accumulators keep two additions in flight.
+  template <typename Ops = SimdOps<T> >
+  struct Simd {
+    typedef typename Ops::Vector Vector;
+    static const std::size_t kWidth = Ops::kWidth;
+    static const std::size_t kMain = N / kWidth * kWidth;
+    static const std::size_t kTail = N - kMain;
+
+    template <typename Combine>
+    static Vector Reduce(const T* data, const Vector identity,
+                         const Combine& combine) {
+      Vector accumulator_0 = identity;
+      Vector accumulator_1 = identity;
+      std::size_t i = 0;
+      for (; i + 2 * kWidth <= kMain; i += 2 * kWidth) {
+        accumulator_0 = combine(accumulator_0, Ops::Load(data + i));
+        accumulator_1 = combine(accumulator_1, Ops::Load(data + i + kWidth));
+      }
+      if (i < kMain) {
+        accumulator_0 = combine(accumulator_0, Ops::Load(data + i));
+      }
+      if (kTail != 0) {
+        accumulator_1 = combine(accumulator_1,
+                                Ops::MaskLoad(data + kMain, kTail, identity));
+      }
+      return combine(accumulator_0, accumulator_1);
+    }
+  };
+
+  static void Fill(T* data, const T& value, SimdPath) {
+    typedef Simd<> S;
+    const typename S::Vector vector = SimdOps<T>::Set1(value);
+    for (std::size_t i = 0; i < S::kMain; i += S::kWidth) {
+      SimdOps<T>::Store(data + i, vector);
+    }
+    if (S::kTail != 0) {
+      SimdOps<T>::MaskStore(data + S::kMain, S::kTail, vector);
+    }
+  }
+  static void Copy(const T* source, T* destination, SimdPath) {
+    typedef Simd<> S;
+    for (std::size_t i = 0; i < S::kMain; i += S::kWidth) {
+      SimdOps<T>::Store(destination + i, SimdOps<T>::Load(source + i));
+    }
+    if (S::kTail != 0) {
+      SimdOps<T>::MaskStore(
+          destination + S::kMain, S::kTail,
+          SimdOps<T>::MaskLoad(source + S::kMain, S::kTail,
+                               SimdOps<T>::Set1(T())));
+    }
+  }
+  static bool Equals(const T* a, const T* b, SimdPath) {
+    typedef Simd<> S;
+    for (std::size_t i = 0; i < S::kMain; i += S::kWidth) {
+      if (!SimdOps<T>::AllEqual(SimdOps<T>::Load(a + i),
+                                SimdOps<T>::Load(b + i))) {
+        return false;
+      }
+    }
+    if (S::kTail != 0) {
+      const typename S::Vector zero = SimdOps<T>::Set1(T());
+      return SimdOps<T>::AllEqual(
+          SimdOps<T>::MaskLoad(a + S::kMain, S::kTail, zero),
+          SimdOps<T>::MaskLoad(b + S::kMain, S::kTail, zero));
+    }
+    return true;
+  }
+  static T Sum(const T* data, SimdPath) {
+    typedef Simd<> S;
+    return SimdOps<T>::ReduceAdd(S::Reduce(
+        data, SimdOps<T>::Set1(T()),
+        [](const typename S::Vector a, const typename S::Vector b) {
+          return SimdOps<T>::Add(a, b);
+        }));
+  }
+  // For Min and Max any element of the array is a valid identity, so the
+  // masked-off lanes are filled with data[0].
+  static T Min(const T* data, SimdPath) {
+    typedef Simd<> S;
+    return SimdOps<T>::ReduceMin(S::Reduce(
+        data, SimdOps<T>::Set1(data[0]),
+        [](const typename S::Vector a, const typename S::Vector b) {
+          return SimdOps<T>::Min(a, b);
+        }));
+  }
+  static T Max(const T* data, SimdPath) {
+    typedef Simd<> S;
+    return SimdOps<T>::ReduceMax(S::Reduce(
+        data, SimdOps<T>::Set1(data[0]),
+        [](const typename S::Vector a, const typename S::Vector b) {
+          return SimdOps<T>::Max(a, b);
+        }));
+  }
+};
+
+}  // namespace internal
+
+template <typename T, std::size_t N, std::size_t Alignment = kCacheLineSize>
+class AlignedArray {
+ public:
+  static_assert(N > 0, "AlignedArray must hold at least one element.");
+  static_assert((Alignment & (Alignment - 1)) == 0,
+                "Alignment must be a power of two.");
+
+  typedef T value_type;
+  typedef T* iterator;
+  typedef const T* const_iterator;
+  typedef std::size_t size_type;
+
+  static constexpr std::size_t size() { return N; }
+
+  T* data() { return data_; }
+  const T* data() const { return data_; }
+
+  T* begin() { return data_; }
+  T* end() { return data_ + N; }
+  const T* begin() const { return data_; }
+  const T* end() const { return data_ + N; }
+
+  T& operator[](const std::size_t index) {
+    assert(index < N);
+    return data_[index];
+  }
+  const T& operator[](const std::size_t index) const {
+    assert(index < N);
+    return data_[index];
+  }
+
+  // Sets every element to value.
+  void Fill(const T& value) { Kernels::Fill(data_, value, Path()); }
+
+  // Copies every element of other into this array.
+  void CopyFrom(const AlignedArray& other) {
+    Kernels::Copy(other.data_, data_, Path());
+  }
+
+  // Returns true if every element is equal to the corresponding element of
+  // other.
+  bool Equals(const AlignedArray& other) const {
+    return Kernels::Equals(data_, other.data_, Path());
+  }
+
+  T Sum() const { return Kernels::Sum(data_, Path()); }
+  T Min() const { return Kernels::Min(data_, Path()); }
+  T Max() const { return Kernels::Max(data_, Path()); }
+
+  bool operator==(const AlignedArray& other) const { return Equals(other); }
+  bool operator!=(const AlignedArray& other) const { return !Equals(other); }
+
+  // Before C++17, 'new' ignores alignments larger than the one of the
+  // fundamental types, so large arrays allocated on the heap go through these.
+  static void* operator new(const std::size_t size) {
+    return AlignedAllocate(Alignment < sizeof(void*) ? sizeof(void*)
+                                                     : Alignment,
+                           size);
+  }
+  static void operator delete(void* ptr) { AlignedFree(ptr); }
+
+ private:
+  typedef internal::Kernels<T, N> Kernels;
+  typedef typename internal::KernelPath<T, N>::type Path;
+
+  alignas(Alignment) T data_[N];
+};
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_ALIGNED_ARRAY_H_
@@ -0,0 +1,294 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary compares the bulk operations of AlignedArray against naive loops
+// over a plain array (as in array_example.cc) and against the standard
+// algorithms applied to a std::array, for sizes from 4 to 1M elements.
+//
+// Usage: aligned_array_benchmark [elements_per_measurement]
+//        (default: 100000000 elements processed per measurement)
+//
+// Build with -DBUILD_WITH_NATIVE_ARCH=ON to enable the AVX2/AVX-512 paths of
+// AlignedArray. Without it the compiler targets the baseline x86-64 ISA.
+
+#include <algorithm>  // Header for std::equal, std::count, std::min_element.
+#include <array>  // Header for std::array.
+#include <cstddef>  // Header for std::ptrdiff_t.
+#include <cstdint>  // Header for int32_t.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <numeric>  // Header for std::accumulate.
+
+#include "aligned_array.h"
+#include "benchmark_utils.h"
+
+namespace {
+
+typedef int32_t ValueType;
+
+// Returns the nanoseconds per element of calling operation(repetition)
+// num_repetitions times over an array of num_elements.
+template <typename Operation>
+double NanosecondsPerElement(const std::size_t num_elements,
+                             const std::size_t num_repetitions,
+                             const Operation& operation) {
+  cpp_labs::Timer timer;
+  for (std::size_t i = 0; i < num_repetitions; ++i) {
+    operation(i);
+    cpp_labs::ClobberMemory();
+  }
+  return timer.ElapsedNanoseconds() / (num_elements * num_repetitions);
+}
+
+// The three contenders for one size N. Each one owns two arrays so that copy
+// and compare have a source and a destination.
+template <std::size_t N>
+struct Contenders {
+  ValueType* naive_a;
+  ValueType* naive_b;
+  std::array<ValueType, N>* std_a;
+  std::array<ValueType, N>* std_b;
+  cpp_labs::AlignedArray<ValueType, N>* aligned_a;
+  cpp_labs::AlignedArray<ValueType, N>* aligned_b;
+
+  Contenders()
+      : naive_a(new ValueType[N]),
+        naive_b(new ValueType[N]),
+        std_a(new std::array<ValueType, N>),
+        std_b(new std::array<ValueType, N>),
+        aligned_a(new cpp_labs::AlignedArray<ValueType, N>),
+        aligned_b(new cpp_labs::AlignedArray<ValueType, N>) {
+    for (std::size_t i = 0; i < N; ++i) {
+      const ValueType value = static_cast<ValueType>((i * 7919) % 1000);
+      naive_a[i] = naive_b[i] = value;
+      (*std_a)[i] = (*std_b)[i] = value;
+      (*aligned_a)[i] = (*aligned_b)[i] = value;
+    }
+  }
+
+  ~Contenders() {
+    delete [] naive_a;
+    delete [] naive_b;
+    delete std_a;
+    delete std_b;
+    delete aligned_a;
+    delete aligned_b;
+  }
+};
+
+void PrintRow(const std::size_t size, const char* operation,
+              const double naive_ns, const double std_ns,
+              const double aligned_ns) {
+  std::cout << std::setw(8) << size << std::setw(8) << operation
+            << std::setw(12) << naive_ns << std::setw(12) << std_ns
+            << std::setw(12) << aligned_ns << std::setw(10)
+            << naive_ns / aligned_ns << "x" << std::endl;
+}
+
+// Returns whether the operations of AlignedArray<T, N> give the results of the
+// standard algorithms. The values are small integers, so that the sums are
+// exact in any order of addition, also for float.
+template <typename T, std::size_t N>
+bool AgreesWithStd() {
+  std::array<T, N>* expected = new std::array<T, N>;
+  cpp_labs::AlignedArray<T, N>* a = new cpp_labs::AlignedArray<T, N>;
+  cpp_labs::AlignedArray<T, N>* b = new cpp_labs::AlignedArray<T, N>;
+  for (std::size_t i = 0; i < N; ++i) {
+    (*expected)[i] = (*a)[i] = static_cast<T>((i * 7919) % 8);
+  }
+  bool agrees =
+      a->Sum() == std::accumulate(expected->begin(), expected->end(), T(0)) &&
+      a->Min() == *std::min_element(expected->begin(), expected->end()) &&
+      a->Max() == *std::max_element(expected->begin(), expected->end());
+  b->CopyFrom(*a);
+  agrees = agrees && std::equal(b->begin(), b->end(), expected->begin()) &&
+           *a == *b;
+  // A difference in the last element, which the tail loops handle.
+  (*b)[N - 1] = T(100);
+  agrees = agrees && *a != *b;
+  b->Fill(T(3));
+  agrees = agrees && std::count(b->begin(), b->end(), T(3)) ==
+                         static_cast<std::ptrdiff_t>(N);
+  delete expected;
+  delete a;
+  delete b;
+  return agrees;
+}
+
+// Prints the rows of size N. Returns whether AlignedArray agrees with the
+// standard algorithms.
+template <std::size_t N>
+bool RunBenchmark(const std::size_t elements_per_measurement) {
+  Contenders<N> c;
+  const std::size_t reps = std::max<std::size_t>(
+      1, elements_per_measurement / N);
+
+  // Fill.
+  PrintRow(N, "fill",
+           NanosecondsPerElement(N, reps, [&](const std::size_t rep) {
+             for (std::size_t i = 0; i < N; ++i) {
+               c.naive_a[i] = static_cast<ValueType>(rep);
+             }
+           }),
+           NanosecondsPerElement(N, reps, [&](const std::size_t rep) {
+             std::fill(c.std_a->begin(), c.std_a->end(),
+                       static_cast<ValueType>(rep));
+           }),
+           NanosecondsPerElement(N, reps, [&](const std::size_t rep) {
+             c.aligned_a->Fill(static_cast<ValueType>(rep));
+           }));
+
+  // Copy.
+  PrintRow(N, "copy",
+           NanosecondsPerElement(N, reps, [&](const std::size_t) {
+             for (std::size_t i = 0; i < N; ++i) {
+               c.naive_a[i] = c.naive_b[i];
+             }
+           }),
+           NanosecondsPerElement(N, reps, [&](const std::size_t) {
+             *c.std_a = *c.std_b;
+           }),
+           NanosecondsPerElement(N, reps, [&](const std::size_t) {
+             c.aligned_a->CopyFrom(*c.aligned_b);
+           }));
+
+  // Compare (equal arrays, so every element is visited).
+  PrintRow(N, "equal",
+           NanosecondsPerElement(N, reps, [&](const std::size_t) {
+             bool equal = true;
+             for (std::size_t i = 0; i < N; ++i) {
+               if (c.naive_a[i] != c.naive_b[i]) {
+                 equal = false;
+                 break;
+               }
+             }
+             cpp_labs::DoNotOptimize(equal);
+           }),
+           NanosecondsPerElement(N, reps, [&](const std::size_t) {
+             cpp_labs::DoNotOptimize(*c.std_a == *c.std_b);
+           }),
+           NanosecondsPerElement(N, reps, [&](const std::size_t) {
+             cpp_labs::DoNotOptimize(*c.aligned_a == *c.aligned_b);
+           }));
+
+  // Sum.
+  PrintRow(N, "sum",
+           NanosecondsPerElement(N, reps, [&](const std::size_t) {
+             ValueType sum = 0;
+             for (std::size_t i = 0; i < N; ++i) {
+               sum += c.naive_a[i];
+             }
+             cpp_labs::DoNotOptimize(sum);
+           }),
+           NanosecondsPerElement(N, reps, [&](const std::size_t) {
+             cpp_labs::DoNotOptimize(
+                 std::accumulate(c.std_a->begin(), c.std_a->end(),
+                                 ValueType(0)));
+           }),
+           NanosecondsPerElement(N, reps, [&](const std::size_t) {
+             cpp_labs::DoNotOptimize(c.aligned_a->Sum());
+           }));
+
+  // Min and max.
+  PrintRow(N, "min",
+           NanosecondsPerElement(N, reps, [&](const std::size_t) {
+             ValueType result = c.naive_a[0];
+             for (std::size_t i = 1; i < N; ++i) {
+               if (c.naive_a[i] < result) {
+                 result = c.naive_a[i];
+               }
+             }
+             cpp_labs::DoNotOptimize(result);
+           }),
+           NanosecondsPerElement(N, reps, [&](const std::size_t) {
+             cpp_labs::DoNotOptimize(
+                 *std::min_element(c.std_a->begin(), c.std_a->end()));
+           }),
+           NanosecondsPerElement(N, reps, [&](const std::size_t) {
+             cpp_labs::DoNotOptimize(c.aligned_a->Min());
+           }));
+  PrintRow(N, "max",
+           NanosecondsPerElement(N, reps, [&](const std::size_t) {
+             ValueType result = c.naive_a[0];
+             for (std::size_t i = 1; i < N; ++i) {
+               if (result < c.naive_a[i]) {
+                 result = c.naive_a[i];
+               }
+             }
+             cpp_labs::DoNotOptimize(result);
+           }),
+           NanosecondsPerElement(N, reps, [&](const std::size_t) {
+             cpp_labs::DoNotOptimize(
+                 *std::max_element(c.std_a->begin(), c.std_a->end()));
+           }),
+           NanosecondsPerElement(N, reps, [&](const std::size_t) {
+             cpp_labs::DoNotOptimize(c.aligned_a->Max());
+           }));
+
+  // Sanity check: AlignedArray must agree with the standard algorithms for
+  // every element type with a SIMD path (float, double and int32_t) and for
+  // one without (int64_t).
+  const bool agrees = AgreesWithStd<float, N>() &&
+                      AgreesWithStd<double, N>() &&
+                      AgreesWithStd<int32_t, N>() &&
+                      AgreesWithStd<int64_t, N>();
+  if (!agrees) {
+    std::cerr << "AlignedArray disagrees with std::array for N = " << N
+              << std::endl;
+  }
+  return agrees;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t elements_per_measurement =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, 100000000);
+
+  std::cout << std::setw(8) << "N" << std::setw(8) << "op" << std::setw(12)
+            << "naive ns/el" << std::setw(12) << "std ns/el" << std::setw(12)
+            << "aligned" << std::setw(11) << "speedup" << std::endl;
+  bool correct = true;
+  correct &= RunBenchmark<4>(elements_per_measurement);
+  correct &= RunBenchmark<13>(elements_per_measurement);
+  correct &= RunBenchmark<64>(elements_per_measurement);
+  correct &= RunBenchmark<250>(elements_per_measurement);
+  correct &= RunBenchmark<1024>(elements_per_measurement);
+  correct &= RunBenchmark<4099>(elements_per_measurement);
+  correct &= RunBenchmark<16384>(elements_per_measurement);
+  correct &= RunBenchmark<65536>(elements_per_measurement);
+  correct &= RunBenchmark<262144>(elements_per_measurement);
+  correct &= RunBenchmark<1048576>(elements_per_measurement);
+  return correct ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_ALIGNED_MEMORY_H_
+#define CPP_LABS_ALIGNED_MEMORY_H_
+
+// Helpers to allocate heap memory aligned to a cache line (or any other power
+// of two). Plain 'new' only guarantees alignment suitable for the fundamental
+// types, which is not enough for SIMD loads or for keeping two arrays from
+// sharing a cache line.
+
+#include <cstddef>  // Header for std::size_t.
+#include <cstdlib>  // Header for posix_memalign and free.
+#include <limits>  // Header for std::numeric_limits.
+#include <new>  // Header for std::bad_alloc.
+#if defined(_WIN32)
+#include <malloc.h>  // Header for _aligned_malloc.
+#endif
+
+namespace cpp_labs {
+
+// Size of a cache line on the x86-64 and most ARM64 CPUs.
+const std::size_t kCacheLineSize = 64;
+
+// Starts loading the cache line of address, without waiting for it. On x86 it
+// is an asm statement: GCC may treat a function whose only effect is a
+// __builtin_prefetch as having no effect at all, and drop the calls to it.
+inline void PrefetchCacheLine(const void* address) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  asm volatile("prefetcht0 %0" : : "m"(*static_cast<const char*>(address)));
+#else
+  __builtin_prefetch(address);
+#endif
+}
+
+// Allocates size bytes aligned to alignment, which must be a power of two and
+// a multiple of sizeof(void*). Throws std::bad_alloc on failure, just like
+// the 'new' operator.
+inline void* AlignedAllocate(const std::size_t alignment,
+                             const std::size_t size) {
+  void* ptr = nullptr;
+  // Requesting zero bytes is valid but some implementations return nullptr.
+  const std::size_t bytes = size == 0 ? alignment : size;
+#if defined(_WIN32)
+  ptr = _aligned_malloc(bytes, alignment);
+#else
+  if (posix_memalign(&ptr, alignment, bytes) != 0) {
+    ptr = nullptr;
+  }
+#endif
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+// Releases memory obtained with AlignedAllocate.
+inline void AlignedFree(void* ptr) {
+#if defined(_WIN32)
+  _aligned_free(ptr);
+#else
+  free(ptr);
+#endif
+}
+
+// STL-compatible allocator returning memory aligned to Alignment, e.g.,
+//   std::vector<float, AlignedAllocator<float, 64> > my_vector;
+template <typename T, std::size_t Alignment = kCacheLineSize>
+class AlignedAllocator {
+ public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+
+  template <typename U>
+  struct rebind {
+    typedef AlignedAllocator<U, Alignment> other;
+  };
+
+  AlignedAllocator() {}
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment>& /*other*/) {}
+
+  T* allocate(const std::size_t num_elements) {
+    if (num_elements > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+      throw std::bad_alloc();
+    }
+    return static_cast<T*>(
+        AlignedAllocate(Alignment, num_elements * sizeof(T)));
+  }
+
+  void deallocate(T* ptr, const std::size_t /*num_elements*/) {
+    AlignedFree(ptr);
+  }
+};
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment>& lhs,
+                const AlignedAllocator<U, Alignment>& rhs) {
+  return true;
+}
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment>& lhs,
+                const AlignedAllocator<U, Alignment>& rhs) {
+  return false;
+}
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_ALIGNED_MEMORY_H_
@@ -0,0 +1,639 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_ASYNC_FILE_READER_H_
+#define CPP_LABS_ASYNC_FILE_READER_H_
+
+// Reads a file sequentially in large blocks, several of them in flight at a
+// time, so that the disk works while the program parses the blocks it already
+// has (instead of waiting for each read, as a std::ifstream loop does).
+//
+// Usage:
+//
+//   cpp_labs::AsyncFileReader reader("names.txt");
+//   cpp_labs::Span<const char> block;
+//   while (reader.Next(&block)) {
+//     ...  // Meanwhile, the next blocks are being read.
+//   }
+//   if (reader.failed()) { ... }
+//
+// or, to build a container from a file of "Key=... Value=..." lines:
+//
+//   std::unordered_map<std::string, int> name_to_id;
+//   if (!cpp_labs::LoadKeyValueFile("names.txt", &name_to_id)) { ... }
+//
+// The reads are submitted to io_uring (Linux 5.1 or newer), through the raw
+// system calls, or, if io_uring is not available, to a pool of threads that
+// call pread. There are num_buffers buffers of block_bytes: while the
+// program holds one block (from one call of Next to the next), the others
+// are being filled.
+//
+// Notes:
+//
+// 1. Blocks are returned in file order, whatever the order the reads finish.
+// 2. Short reads (which the kernel may return for any read) are resubmitted
+// for the rest of the block, so every block but the last is full.
+// 3. With buffered reads the kernel also reads ahead; the gain comes from
+// never leaving the disk idle while parsing, and from the large requests.
+
+#include <algorithm>  // Header for std::min.
+#include <condition_variable>  // Header for std::condition_variable.
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for uint64_t.
+#include <cstring>  // Header for std::memchr and std::memset.
+#include <deque>  // Header for std::deque.
+#include <limits>  // Header for std::numeric_limits.
+#include <memory>  // Header for std::unique_ptr.
+#include <mutex>  // Header for std::mutex.
+#include <string>  // Header for std::string.
+#include <thread>  // Header for std::thread.
+#include <utility>  // Header for std::pair.
+#include <vector>  // Header for std::vector.
+
+#include <cerrno>  // Header for errno.
+#include <fcntl.h>  // Header for open and posix_fadvise.
+#include <sys/stat.h>  // Header for fstat.
+#include <sys/uio.h>  // Header for iovec.
+#include <unistd.h>  // Header for pread and close.
+#if defined(__linux__)
+#include <linux/io_uring.h>  // Header for io_uring_params and io_uring_sqe.
+#include <sys/mman.h>  // Header for mmap.
+#include <sys/syscall.h>  // Header for __NR_io_uring_setup.
+#endif
+
+#include "span.h"
+
+#if defined(__linux__) && defined(__NR_io_uring_setup) && \
+    defined(IORING_OFF_SQ_RING)
+#define CPP_LABS_HAS_IO_URING 1
+#endif
+
+namespace cpp_labs {
+
+enum class IoBackend { kIoUring, kThreadPool };
+
+inline const char* IoBackendName(const IoBackend backend) {
+  return backend == IoBackend::kIoUring ? "io_uring" : "pread thread pool";
+}
+
+namespace internal {
+
+// A minimal io_uring: a submission ring where reads are queued and a
+// completion ring where the kernel reports them, both shared with the kernel.
+class IoUring {
+ public:
+  IoUring()
+      : fd_(-1), sq_ring_(nullptr), cq_ring_(nullptr), sqes_(nullptr),
+        sq_ring_bytes_(0), cq_ring_bytes_(0), sqes_bytes_(0) {}
+  ~IoUring() {
+#if defined(CPP_LABS_HAS_IO_URING)
+    if (sqes_ != nullptr) {
+      munmap(sqes_, sqes_bytes_);
+    }
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_bytes_);
+    }
+    if (sq_ring_ != nullptr) {
+      munmap(sq_ring_, sq_ring_bytes_);
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+#endif
+  }
+  IoUring(const IoUring&) = delete;
+  IoUring& operator=(const IoUring&) = delete;
+
+  // Returns false if the kernel does not support io_uring (or forbids it).
+  bool Init(const unsigned entries) {
+#if defined(CPP_LABS_HAS_IO_URING)
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd_ < 0) {
+      return false;
+    }
+    sq_ring_bytes_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_bytes_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    // Kernels with IORING_FEAT_SINGLE_MMAP (5.4 and later) map both rings at
+    // once; older ones need a mapping for each, and so do older headers.
+#if defined(IORING_FEAT_SINGLE_MMAP)
+    const bool single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+#else
+    const bool single_map = false;
+#endif
+    if (single_map) {
+      sq_ring_bytes_ = std::max(sq_ring_bytes_, cq_ring_bytes_);
+      cq_ring_bytes_ = sq_ring_bytes_;
+    }
+    sq_ring_ = Map(sq_ring_bytes_, IORING_OFF_SQ_RING);
+    cq_ring_ = single_map ? sq_ring_ : Map(cq_ring_bytes_, IORING_OFF_CQ_RING);
+    sqes_bytes_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = Map(sqes_bytes_, IORING_OFF_SQES);
+    if (sq_ring_ == nullptr || cq_ring_ == nullptr || sqes_ == nullptr) {
+      return false;
+    }
+    char* sq = static_cast<char*>(sq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    char* cq = static_cast<char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  // Queues a read of vector (which must stay valid until it completes) and
+  // submits it.
+  bool SubmitRead(const int fd, const iovec* vector, const uint64_t offset,
+                  const uint64_t user_data) {
+#if defined(CPP_LABS_HAS_IO_URING)
+    // Only this thread writes the tail.
+    const unsigned tail = *sq_tail_;
+    const unsigned index = tail & sq_mask_;
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(vector);
+    sqe->len = 1;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    sq_array_[index] = index;
+    // The kernel must see the entry before the new tail.
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    return Enter(1, 0, 0) >= 0;
+#else
+    return false;
+#endif
+  }
+
+  // Waits for a read to complete; result is the number of bytes read, or
+  // -errno.
+  bool WaitCompletion(uint64_t* user_data, int64_t* result) {
+#if defined(CPP_LABS_HAS_IO_URING)
+    const unsigned head = *cq_head_;
+    while (__atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE) == head) {
+      if (Enter(0, 1, IORING_ENTER_GETEVENTS) < 0) {
+        return false;
+      }
+    }
+    const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+    *user_data = cqe.user_data;
+    *result = cqe.res;
+    // Hands the entry back to the kernel.
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+ private:
+#if defined(CPP_LABS_HAS_IO_URING)
+  void* Map(const std::size_t bytes, const off_t offset) {
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd_, offset);
+    return memory == MAP_FAILED ? nullptr : memory;
+  }
+
+  int Enter(const unsigned to_submit, const unsigned min_complete,
+            const unsigned flags) {
+    int result;
+    do {
+      result = static_cast<int>(syscall(__NR_io_uring_enter, fd_, to_submit,
+                                        min_complete, flags, nullptr, 0));
+    } while (result < 0 && errno == EINTR);
+    return result;
+  }
+
+  unsigned* sq_tail_;
+  unsigned sq_mask_;
+  unsigned* sq_array_;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned cq_mask_;
+  io_uring_cqe* cqes_;
+#endif
+  int fd_;
+  void* sq_ring_;
+  void* cq_ring_;
+  void* sqes_;
+  std::size_t sq_ring_bytes_;
+  std::size_t cq_ring_bytes_;
+  std::size_t sqes_bytes_;
+};
+
+// The fallback of IoUring: threads that call pread, with the same interface.
+class PreadPool {
+ public:
+  explicit PreadPool(const int num_threads) : stop_(false) {
+    for (int i = 0; i < num_threads; ++i) {
+      threads_.emplace_back([this]() { Work(); });
+    }
+  }
+  ~PreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    request_ready_.notify_all();
+    for (std::thread& thread : threads_) {
+      thread.join();
+    }
+  }
+  PreadPool(const PreadPool&) = delete;
+  PreadPool& operator=(const PreadPool&) = delete;
+
+  bool SubmitRead(const int fd, const iovec* vector, const uint64_t offset,
+                  const uint64_t user_data) {
+    Request request;
+    request.fd = fd;
+    request.vector = vector;
+    request.offset = offset;
+    request.user_data = user_data;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      requests_.push_back(request);
+    }
+    request_ready_.notify_one();
+    return true;
+  }
+
+  bool WaitCompletion(uint64_t* user_data, int64_t* result) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    completion_ready_.wait(lock, [this]() { return !completions_.empty(); });
+    *user_data = completions_.front().first;
+    *result = completions_.front().second;
+    completions_.pop_front();
+    return true;
+  }
+
+ private:
+  struct Request {
+    int fd;
+    const iovec* vector;
+    uint64_t offset;
+    uint64_t user_data;
+  };
+
+  void Work() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      request_ready_.wait(lock,
+                          [this]() { return stop_ || !requests_.empty(); });
+      if (stop_) {
+        return;
+      }
+      const Request request = requests_.front();
+      requests_.pop_front();
+      lock.unlock();
+      const ssize_t bytes =
+          pread(request.fd, request.vector->iov_base, request.vector->iov_len,
+                static_cast<off_t>(request.offset));
+      const int64_t result = bytes < 0 ? -errno : bytes;
+      lock.lock();
+      completions_.emplace_back(request.user_data, result);
+      completion_ready_.notify_one();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable request_ready_;
+  std::condition_variable completion_ready_;
+  std::deque<Request> requests_;
+  std::deque<std::pair<uint64_t, int64_t> > completions_;
+  std::vector<std::thread> threads_;
+  bool stop_;
+};
+
+}  // namespace internal
+
+// Reads a file in blocks of block_bytes, in order, with up to num_buffers
+// reads in flight. Not thread-safe: one thread calls Next.
+class AsyncFileReader {
+ public:
+  explicit AsyncFileReader(const std::string& path,
+                           const std::size_t block_bytes = 1 << 22,
+                           const int num_buffers = 4,
+                           const IoBackend preferred = IoBackend::kIoUring)
+      : fd_(open(path.c_str(), O_RDONLY)), file_size_(0),
+        block_bytes_(block_bytes), num_blocks_(0), next_submit_(0),
+        next_block_(0), in_flight_(0), holding_block_(false), failed_(fd_ < 0),
+        backend_(IoBackend::kThreadPool) {
+    if (failed_) {
+      return;
+    }
+    struct stat status;
+    if (fstat(fd_, &status) != 0) {
+      failed_ = true;
+      return;
+    }
+    file_size_ = status.st_size;
+    num_blocks_ = (file_size_ + block_bytes_ - 1) / block_bytes_;
+    posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if (preferred == IoBackend::kIoUring &&
+        ring_.Init(static_cast<unsigned>(num_buffers))) {
+      backend_ = IoBackend::kIoUring;
+    } else {
+      pool_.reset(new internal::PreadPool(num_buffers));
+    }
+    slots_.resize(num_buffers);
+    for (Slot& slot : slots_) {
+      slot.buffer.reset(new char[block_bytes_]);
+    }
+    while (next_submit_ < num_blocks_ &&
+           next_submit_ < static_cast<uint64_t>(num_buffers)) {
+      SubmitBlock();
+    }
+  }
+
+  ~AsyncFileReader() {
+    // The kernel (or the pool) may still write into the buffers.
+    while (in_flight_ > 0 && Complete()) {
+    }
+    pool_.reset();
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+  AsyncFileReader(const AsyncFileReader&) = delete;
+  AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+  // Returns the next block of the file. The block is valid until the next
+  // call, which reuses its buffer. Returns false at the end of the file or on
+  // a read error.
+  bool Next(Span<const char>* block) {
+    if (holding_block_) {
+      holding_block_ = false;
+      if (next_submit_ < num_blocks_) {
+        SubmitBlock();
+      }
+    }
+    if (failed_ || next_block_ >= num_blocks_) {
+      return false;
+    }
+    Slot& slot = slots_[next_block_ % slots_.size()];
+    while (!slot.done) {
+      if (!Complete()) {
+        failed_ = true;
+        return false;
+      }
+    }
+    if (failed_) {
+      return false;
+    }
+    *block = Span<const char>(slot.buffer.get(), slot.filled);
+    ++next_block_;
+    holding_block_ = true;
+    return true;
+  }
+
+  // Whether the file could not be opened or a read failed.
+  bool failed() const { return failed_; }
+  IoBackend backend() const { return backend_; }
+  uint64_t file_size() const { return file_size_; }
+
+ private:
+  struct Slot {
+    std::unique_ptr<char[]> buffer;
+    iovec vector;
+    uint64_t offset;
+    std::size_t wanted;
+    std::size_t filled;
+    bool done;
+  };
+
+  // Starts the read of block next_submit_ into its slot.
+  void SubmitBlock() {
+    Slot& slot = slots_[next_submit_ % slots_.size()];
+    slot.offset = next_submit_ * block_bytes_;
+    slot.wanted = static_cast<std::size_t>(
+        std::min<uint64_t>(block_bytes_, file_size_ - slot.offset));
+    slot.filled = 0;
+    slot.done = false;
+    ++next_submit_;
+    SubmitRest(&slot);
+  }
+
+  // Submits the read of the part of the slot not filled yet.
+  void SubmitRest(Slot* slot) {
+    slot->vector.iov_base = slot->buffer.get() + slot->filled;
+    slot->vector.iov_len = slot->wanted - slot->filled;
+    const uint64_t index = slot - slots_.data();
+    const bool submitted =
+        backend_ == IoBackend::kIoUring
+            ? ring_.SubmitRead(fd_, &slot->vector,
+                               slot->offset + slot->filled, index)
+            : pool_->SubmitRead(fd_, &slot->vector,
+                                slot->offset + slot->filled, index);
+    if (submitted) {
+      ++in_flight_;
+    } else {
+      slot->done = true;
+      failed_ = true;
+    }
+  }
+
+  // Waits for one read to complete and updates its slot.
+  bool Complete() {
+    uint64_t index = 0;
+    int64_t result = 0;
+    const bool completed = backend_ == IoBackend::kIoUring
+                               ? ring_.WaitCompletion(&index, &result)
+                               : pool_->WaitCompletion(&index, &result);
+    if (!completed) {
+      return false;
+    }
+    --in_flight_;
+    Slot& slot = slots_[index];
+    if (result < 0) {
+      failed_ = true;
+      slot.done = true;
+      return true;
+    }
+    slot.filled += static_cast<std::size_t>(result);
+    // A read of 0 bytes means the file shrank: the block ends there.
+    if (slot.filled < slot.wanted && result > 0) {
+      SubmitRest(&slot);
+    } else {
+      slot.done = true;
+    }
+    return true;
+  }
+
+  const int fd_;
+  uint64_t file_size_;
+  const std::size_t block_bytes_;
+  uint64_t num_blocks_;
+  // The next block to read, and the next block to return.
+  uint64_t next_submit_;
+  uint64_t next_block_;
+  int in_flight_;
+  bool holding_block_;
+  bool failed_;
+  IoBackend backend_;
+  std::vector<Slot> slots_;
+  internal::IoUring ring_;
+  std::unique_ptr<internal::PreadPool> pool_;
+};
+
+// Calls function(line, length) for every line of the file, without the
+// '\n'. Lines may span blocks; only those are copied. Returns false on a read
+// error.
+template <typename Function>
+bool ForEachLine(AsyncFileReader* reader, Function function) {
+  std::string partial_line;
+  Span<const char> block;
+  while (reader->Next(&block)) {
+    const char* begin = block.begin();
+    const char* const end = block.end();
+    if (!partial_line.empty()) {
+      const char* newline =
+          static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+      if (newline == nullptr) {
+        partial_line.append(begin, end);
+        continue;
+      }
+      partial_line.append(begin, newline);
+      function(partial_line.data(), partial_line.size());
+      partial_line.clear();
+      begin = newline + 1;
+    }
+    while (begin < end) {
+      const char* newline =
+          static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+      if (newline == nullptr) {
+        partial_line.assign(begin, end);
+        break;
+      }
+      function(begin, static_cast<std::size_t>(newline - begin));
+      begin = newline + 1;
+    }
+  }
+  if (!partial_line.empty()) {
+    function(partial_line.data(), partial_line.size());
+  }
+  return !reader->failed();
+}
+
+// Parses a "Key=<key> Value=<value>" line, as printed by map_example.cc.
+// Returns false if the line does not have that form or the value does not fit
+// in an int.
+inline bool ParseKeyValueLine(const char* line, const std::size_t length,
+                              const char** key, std::size_t* key_length,
+                              int* value) {
+  static const char kKeyPrefix[] = "Key=";
+  static const char kValuePrefix[] = " Value=";
+  const std::size_t kKeyPrefixLength = sizeof(kKeyPrefix) - 1;
+  const std::size_t kValuePrefixLength = sizeof(kValuePrefix) - 1;
+  if (length < kKeyPrefixLength + kValuePrefixLength + 1 ||
+      std::memcmp(line, kKeyPrefix, kKeyPrefixLength) != 0) {
+    return false;
+  }
+  // The value is the digits after the last " Value=".
+  const char* end = line + length;
+  const char* value_begin = end;
+  while (value_begin > line && value_begin[-1] >= '0' &&
+         value_begin[-1] <= '9') {
+    --value_begin;
+  }
+  const bool negative = value_begin > line && value_begin[-1] == '-';
+  const char* prefix_end = negative ? value_begin - 1 : value_begin;
+  if (value_begin == end ||
+      prefix_end < line + kKeyPrefixLength + kValuePrefixLength ||
+      std::memcmp(prefix_end - kValuePrefixLength, kValuePrefix,
+                  kValuePrefixLength) != 0) {
+    return false;
+  }
+  // The magnitude of INT_MIN is one more than INT_MAX.
+  const int64_t max_number =
+      static_cast<int64_t>(std::numeric_limits<int>::max()) +
+      (negative ? 1 : 0);
+  int64_t number = 0;
+  for (const char* digit = value_begin; digit < end; ++digit) {
+    const int digit_value = *digit - '0';
+    if (number > (max_number - digit_value) / 10) {
+      return false;
+    }
+    number = number * 10 + digit_value;
+  }
+  *key = line + kKeyPrefixLength;
+  *key_length = static_cast<std::size_t>(prefix_end - kValuePrefixLength -
+                                         *key);
+  *value = static_cast<int>(negative ? -number : number);
+  return true;
+}
+
+// Loads a file of "Key=... Value=..." lines into a map from std::string to
+// int (std::map or std::unordered_map); the last value of a key wins. Lines
+// that do not parse are skipped. Returns false if the file cannot be read.
+template <typename Map>
+bool LoadKeyValueFile(const std::string& path, Map* map,
+                      const IoBackend preferred = IoBackend::kIoUring) {
+  AsyncFileReader reader(path, 1 << 22, 4, preferred);
+  std::string key;
+  return ForEachLine(&reader, [map, &key](const char* line,
+                                          const std::size_t length) {
+    const char* key_begin;
+    std::size_t key_length;
+    int value;
+    if (ParseKeyValueLine(line, length, &key_begin, &key_length, &value)) {
+      // Reuses the capacity of key for every line.
+      key.assign(key_begin, key_length);
+      (*map)[key] = value;
+    }
+  });
+}
+
+// Loads a file into a set of std::string, one element per line.
+template <typename Set>
+bool LoadLineSet(const std::string& path, Set* set,
+                 const IoBackend preferred = IoBackend::kIoUring) {
+  AsyncFileReader reader(path, 1 << 22, 4, preferred);
+  return ForEachLine(&reader, [set](const char* line,
+                                    const std::size_t length) {
+    set->emplace(line, length);
+  });
+}
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_ASYNC_FILE_READER_H_
@@ -0,0 +1,235 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary measures how long it takes to load a name->id map from a large
+// text file of "Key=... Value=..." lines (as printed by map_example.cc), with
+// a std::ifstream loop and with AsyncFileReader (see async_file_reader.h).
+//
+// Usage: async_file_reader_benchmark [megabytes] [directory] [num_keys]
+//   Defaults: megabytes = 10240, directory = /tmp, num_keys = 1000000.
+//
+// The file has lines "Key=user_<k> Value=<i>" for num_keys distinct names,
+// repeated until it has the given size; every line goes into a
+// std::unordered_map<std::string, int> (the last value wins). The map stays
+// small, so the time is that of reading, parsing and inserting.
+//
+// For each reader it reports:
+//
+// 1. read only: the time to read the file, without parsing.
+// 2. load map: the time to read, parse and insert every line.
+//
+// Notes:
+//
+// 1. Before every run the file is dropped from the page cache
+// (posix_fadvise(POSIX_FADV_DONTNEED)), so it is read from the disk. With a
+// fast disk or a file cached anyway the loads are bound by parsing and
+// hashing instead, and the readers are closer.
+// 2. All the readers share the parser (ParseKeyValueLine), so the differences
+// come from the reads: the std::ifstream loop waits for each read, while
+// AsyncFileReader keeps 4 reads of 4 MB in flight while the lines are parsed.
+
+#include <cstdint>  // Header for uint64_t.
+#include <cstdio>  // Header for std::remove.
+#include <fstream>  // Header for std::ifstream and std::ofstream.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <string>  // Header for std::string.
+#include <unordered_map>  // Header for std::unordered_map.
+#include <vector>  // Header for std::vector.
+
+#include <fcntl.h>  // Header for open and posix_fadvise.
+#include <unistd.h>  // Header for fdatasync and close.
+
+#include "async_file_reader.h"
+#include "benchmark_utils.h"
+
+namespace {
+
+const std::size_t kBlockBytes = 1 << 22;
+
+typedef std::unordered_map<std::string, int> NameToId;
+
+// Writes whole lines until the file has at least bytes; returns the number of
+// lines and sets file_bytes.
+uint64_t WriteFile(const std::string& path, const uint64_t bytes,
+                   const uint64_t num_keys, uint64_t* file_bytes) {
+  std::ofstream file(path.c_str(), std::ios::binary);
+  std::string buffer;
+  uint64_t written = 0;
+  uint64_t line = 0;
+  while (written < bytes) {
+    buffer.clear();
+    while (buffer.size() < kBlockBytes && written + buffer.size() < bytes) {
+      buffer += "Key=user_" +
+                std::to_string((line * 2654435761u) % num_keys) +
+                " Value=" + std::to_string(line % 1000000007) + "\n";
+      ++line;
+    }
+    file.write(buffer.data(), buffer.size());
+    written += buffer.size();
+  }
+  *file_bytes = written;
+  return line;
+}
+
+// Drops the pages of the file from the page cache.
+void DropFromCache(const std::string& path) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    // Dirty pages cannot be dropped: write them first.
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+void Insert(const char* line, const std::size_t length, NameToId* map,
+            std::string* key) {
+  const char* key_begin;
+  std::size_t key_length;
+  int value;
+  if (cpp_labs::ParseKeyValueLine(line, length, &key_begin, &key_length,
+                                  &value)) {
+    key->assign(key_begin, key_length);
+    (*map)[*key] = value;
+  }
+}
+
+uint64_t ReadWithIfstream(const std::string& path) {
+  std::ifstream file(path.c_str(), std::ios::binary);
+  std::vector<char> buffer(kBlockBytes);
+  uint64_t bytes = 0;
+  while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+    bytes += file.gcount();
+  }
+  return bytes;
+}
+
+uint64_t ReadWithAsyncReader(const std::string& path,
+                             const cpp_labs::IoBackend backend) {
+  cpp_labs::AsyncFileReader reader(path, kBlockBytes, 4, backend);
+  cpp_labs::Span<const char> block;
+  uint64_t bytes = 0;
+  while (reader.Next(&block)) {
+    bytes += block.size();
+  }
+  return bytes;
+}
+
+void LoadWithIfstream(const std::string& path, NameToId* map) {
+  std::ifstream file(path.c_str());
+  std::string line;
+  std::string key;
+  while (std::getline(file, line)) {
+    Insert(line.data(), line.size(), map, &key);
+  }
+}
+
+void LoadWithAsyncReader(const std::string& path,
+                         const cpp_labs::IoBackend backend, NameToId* map) {
+  cpp_labs::AsyncFileReader reader(path, kBlockBytes, 4, backend);
+  std::string key;
+  cpp_labs::ForEachLine(
+      &reader, [map, &key](const char* line, const std::size_t length) {
+        Insert(line, length, map, &key);
+      });
+}
+
+void PrintRow(const std::string& reader, const std::string& operation,
+              const double seconds, const uint64_t bytes,
+              const std::string& result) {
+  std::cout << std::setw(20) << reader << std::setw(12) << operation
+            << std::setw(10) << seconds << std::setw(10)
+            << bytes / seconds / 1e9
+            << "   " << result << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const uint64_t megabytes = cpp_labs::ParseSizeArgument(argc, argv, 1, 10240);
+  const std::string directory = argc > 2 ? argv[2] : "/tmp";
+  const uint64_t num_keys =
+      cpp_labs::ParseSizeArgument(argc, argv, 3, 1000000);
+  if (megabytes == 0 || num_keys == 0) {
+    std::cerr << "megabytes and num_keys must be positive." << std::endl;
+    return 1;
+  }
+  const std::string path = directory + "/cpp_labs_name_to_id.txt";
+  std::cout << "Writing " << megabytes << " MB to " << path << "..."
+            << std::endl;
+  uint64_t bytes = 0;
+  const uint64_t num_lines = WriteFile(path, megabytes << 20, num_keys, &bytes);
+
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << std::setw(20) << "reader" << std::setw(12) << "operation"
+            << std::setw(10) << "seconds" << std::setw(10) << "GB/s"
+            << "   result" << std::endl;
+  const cpp_labs::IoBackend kBackends[] = {cpp_labs::IoBackend::kThreadPool,
+                                           cpp_labs::IoBackend::kIoUring};
+
+  DropFromCache(path);
+  cpp_labs::Timer timer;
+  uint64_t read_bytes = ReadWithIfstream(path);
+  PrintRow("std::ifstream", "read only", timer.ElapsedSeconds(), bytes,
+           read_bytes == bytes ? "ok" : "SHORT");
+  for (const cpp_labs::IoBackend backend : kBackends) {
+    DropFromCache(path);
+    timer.Reset();
+    read_bytes = ReadWithAsyncReader(path, backend);
+    PrintRow(cpp_labs::IoBackendName(backend), "read only",
+             timer.ElapsedSeconds(), bytes,
+             read_bytes == bytes ? "ok" : "SHORT");
+  }
+
+  // The std::ifstream loop builds the expected map.
+  NameToId expected;
+  DropFromCache(path);
+  timer.Reset();
+  LoadWithIfstream(path, &expected);
+  PrintRow("std::ifstream", "load map", timer.ElapsedSeconds(), bytes,
+           std::to_string(expected.size()) + " names from " +
+               std::to_string(num_lines) + " lines");
+  for (const cpp_labs::IoBackend backend : kBackends) {
+    NameToId map;
+    DropFromCache(path);
+    timer.Reset();
+    LoadWithAsyncReader(path, backend, &map);
+    PrintRow(cpp_labs::IoBackendName(backend), "load map",
+             timer.ElapsedSeconds(), bytes,
+             map == expected ? "same map" : "MISMATCH");
+  }
+  std::remove(path.c_str());
+  return 0;
+}
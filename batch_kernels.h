@@ -0,0 +1,266 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_BATCH_KERNELS_H_
+#define CPP_LABS_BATCH_KERNELS_H_
+
+// Column kernels for short sequences of binary operations selected at run
+// time (e.g., from a configuration file).
+//
+// An op-code sequence such as {kAdd, kSubtract} describes a per-row operator
+// over columns 0, 1 and 2:
+//
+//   output[row] = (column_0[row] + column_1[row]) - column_2[row]
+//
+// Evaluating it row by row with a function pointer (or std::function, or a
+// switch) per operation costs an indirect call per element and hides the
+// operation from the optimizer. Instead, this header instantiates one kernel
+// per combination of operations, ColumnKernelImpl<AddOp, SubtractOp>, whose
+// loop the compiler inlines and vectorizes. SelectColumnKernel picks the
+// instantiation once (a table lookup), and the kernel then runs over a whole
+// batch of rows.
+//
+// There are kNumOpCodes^1 + ... + kNumOpCodes^kMaxKernelOps instantiations
+// (84 for 4 op codes and up to 3 operations), built at compile time with
+// IndexSequence. Each new op code or longer sequence multiplies the code size,
+// so keep both small and fall back to a slower path for anything longer.
+//
+// Example:
+//   const OpCode ops[] = {OpCode::kAdd, OpCode::kSubtract};
+//   const ColumnKernel kernel = SelectColumnKernel(ops, 2);
+//   const int* columns[] = {a, b, c};
+//   kernel(columns, num_rows, output);
+//
+// As with the built-in int operations, the caller must keep the results in the
+// range of int.
+
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for uint8_t.
+
+#include "index_sequence.h"
+
+namespace cpp_labs {
+
+enum class OpCode : uint8_t {
+  kAdd = 0,
+  kSubtract = 1,
+  kMultiply = 2,
+  kMax = 3
+};
+
+const std::size_t kNumOpCodes = 4;
+const std::size_t kMaxKernelOps = 3;
+
+// The scalar operations, as in functions_example.cc.
+struct AddOp {
+  static int Apply(const int number_1, const int number_2) {
+    return number_1 + number_2;
+  }
+};
+
+struct SubtractOp {
+  static int Apply(const int number_1, const int number_2) {
+    return number_1 - number_2;
+  }
+};
+
+struct MultiplyOp {
+  static int Apply(const int number_1, const int number_2) {
+    return number_1 * number_2;
+  }
+};
+
+struct MaxOp {
+  static int Apply(const int number_1, const int number_2) {
+    return number_1 > number_2 ? number_1 : number_2;
+  }
+};
+
+// Returns the scalar function of an op code, for row-at-a-time evaluation.
+typedef int (*ScalarOp)(int, int);
+
+inline ScalarOp ScalarOpFunction(const OpCode op) {
+  switch (op) {
+    case OpCode::kAdd:
+      return &AddOp::Apply;
+    case OpCode::kSubtract:
+      return &SubtractOp::Apply;
+    case OpCode::kMultiply:
+      return &MultiplyOp::Apply;
+    case OpCode::kMax:
+      return &MaxOp::Apply;
+  }
+  return nullptr;
+}
+
+// Computes output[row] for row in [0, num_rows) from columns[0] to
+// columns[num_ops], where num_ops is the length of the op-code sequence.
+typedef void (*ColumnKernel)(const int* const* columns, std::size_t num_rows,
+                             int* output);
+
+namespace internal {
+
+// Maps an op code (as a number) to its operation type.
+template <std::size_t Code>
+struct OpType;
+template <>
+struct OpType<0> {
+  typedef AddOp type;
+};
+template <>
+struct OpType<1> {
+  typedef SubtractOp type;
+};
+template <>
+struct OpType<2> {
+  typedef MultiplyOp type;
+};
+template <>
+struct OpType<3> {
+  typedef MaxOp type;
+};
+
+// Applies Ops... in order to the accumulator; the k-th operation reads
+// columns[Column + k].
+template <std::size_t Column, typename... Ops>
+struct ApplyOps;
+
+template <std::size_t Column>
+struct ApplyOps<Column> {
+  static int Run(const int accumulator, const int* const*, std::size_t) {
+    return accumulator;
+  }
+};
+
+template <std::size_t Column, typename Op, typename... Ops>
+struct ApplyOps<Column, Op, Ops...> {
+  static int Run(const int accumulator, const int* const* columns,
+                 const std::size_t row) {
+    return ApplyOps<Column + 1, Ops...>::Run(
+        Op::Apply(accumulator, columns[Column][row]), columns, row);
+  }
+};
+
+}  // namespace internal
+
+// The kernel of one op-code sequence. The column pointers are copied to
+// locals so that the compiler knows they do not change inside the loop.
+template <typename... Ops>
+void ColumnKernelImpl(const int* const* columns, const std::size_t num_rows,
+                      int* output) {
+  const int* local_columns[sizeof...(Ops) + 1];
+  for (std::size_t i = 0; i <= sizeof...(Ops); ++i) {
+    local_columns[i] = columns[i];
+  }
+  for (std::size_t row = 0; row < num_rows; ++row) {
+    output[row] = internal::ApplyOps<1, Ops...>::Run(local_columns[0][row],
+                                                     local_columns, row);
+  }
+}
+
+namespace internal {
+
+// Number of sequences of NumOps op codes.
+template <std::size_t NumOps>
+struct NumSequences {
+  static const std::size_t value =
+      kNumOpCodes * NumSequences<NumOps - 1>::value;
+};
+template <>
+struct NumSequences<0> {
+  static const std::size_t value = 1;
+};
+
+// The kernel of the sequence whose k-th op code is digit k of Index in base
+// kNumOpCodes.
+template <std::size_t Index, std::size_t... Positions>
+ColumnKernel MakeKernel(IndexSequence<Positions...>) {
+  return &ColumnKernelImpl<typename OpType<
+      Index / NumSequences<Positions>::value % kNumOpCodes>::type...>;
+}
+
+// Table of the kernels of every sequence of NumOps op codes, indexed as in
+// MakeKernel.
+template <std::size_t NumOps>
+class KernelTable {
+ public:
+  static const KernelTable& Get() {
+    static const KernelTable table{
+        MakeIndexSequence<NumSequences<NumOps>::value>()};
+    return table;
+  }
+
+  ColumnKernel kernel(const std::size_t index) const { return kernels_[index]; }
+
+ private:
+  template <std::size_t... Indices>
+  explicit KernelTable(IndexSequence<Indices...>)
+      : kernels_{MakeKernel<Indices>(MakeIndexSequence<NumOps>())...} {}
+
+  const ColumnKernel kernels_[NumSequences<NumOps>::value];
+};
+
+}  // namespace internal
+
+// Returns the kernel of the given op-code sequence, or nullptr if num_ops is
+// 0 or larger than kMaxKernelOps, or if an op code is not one of OpCode.
+inline ColumnKernel SelectColumnKernel(const OpCode* ops,
+                                       const std::size_t num_ops) {
+  std::size_t index = 0;
+  std::size_t scale = 1;
+  for (std::size_t i = 0; i < num_ops; ++i) {
+    if (static_cast<std::size_t>(ops[i]) >= kNumOpCodes) {
+      return nullptr;
+    }
+    index += static_cast<std::size_t>(ops[i]) * scale;
+    scale *= kNumOpCodes;
+  }
+  switch (num_ops) {
+    case 1:
+      return internal::KernelTable<1>::Get().kernel(index);
+    case 2:
+      return internal::KernelTable<2>::Get().kernel(index);
+    case 3:
+      return internal::KernelTable<3>::Get().kernel(index);
+    default:
+      return nullptr;
+  }
+}
+
+static_assert(kMaxKernelOps == 3,
+              "Update SelectColumnKernel when changing kMaxKernelOps.");
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_BATCH_KERNELS_H_
@@ -0,0 +1,238 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary compares four ways of evaluating a per-row operator given as an
+// op-code sequence (batch_kernels.h) over int columns:
+//
+// 1. a function pointer per operation and row (the Add/Subtract functions of
+// functions_example.cc called through pointers),
+// 2. a std::function per operation and row,
+// 3. a switch on the op code per operation and row (an interpreter),
+// 4. the kernel specialized for the whole sequence, selected once per batch.
+//
+// Usage: batch_kernels_benchmark [num_rows] [ops]
+//   Defaults: num_rows = 100000000, ops = "+-*".
+//   ops is a sequence of up to 3 of '+' (add), '-' (subtract), '*' (multiply)
+//   and 'M' (max); the operator reads one column per op plus the first one.
+//
+// Notes:
+//
+// 1. The rows are processed in batches of kBatchRows, as a query engine
+// would; the specialized kernel is looked up again for every batch, which
+// costs a few nanoseconds per batch.
+// 2. The columns take (num_ops + 2) * 4 bytes per row; with the defaults that
+// is 2 GB. The column values are small so that no sequence overflows an int.
+
+#include <functional>  // Header for std::function.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <random>  // Header for std::mt19937.
+#include <vector>  // Header for std::vector.
+
+#include "batch_kernels.h"
+#include "benchmark_utils.h"
+
+namespace {
+
+const std::size_t kBatchRows = 4096;
+
+using cpp_labs::OpCode;
+
+// Parses "+-*" into op codes. Returns false on an unknown character.
+bool ParseOps(const char* text, std::vector<OpCode>* ops) {
+  for (const char* c = text; *c != '\0'; ++c) {
+    switch (*c) {
+      case '+':
+        ops->push_back(OpCode::kAdd);
+        break;
+      case '-':
+        ops->push_back(OpCode::kSubtract);
+        break;
+      case '*':
+        ops->push_back(OpCode::kMultiply);
+        break;
+      case 'M':
+        ops->push_back(OpCode::kMax);
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+void RunFunctionPointers(const std::vector<OpCode>& ops,
+                         const int* const* columns, const std::size_t num_rows,
+                         int* output) {
+  std::vector<cpp_labs::ScalarOp> functions;
+  for (const OpCode op : ops) {
+    functions.push_back(cpp_labs::ScalarOpFunction(op));
+  }
+  for (std::size_t row = 0; row < num_rows; ++row) {
+    int accumulator = columns[0][row];
+    for (std::size_t i = 0; i < functions.size(); ++i) {
+      accumulator = functions[i](accumulator, columns[i + 1][row]);
+    }
+    output[row] = accumulator;
+  }
+}
+
+void RunStdFunctions(const std::vector<OpCode>& ops, const int* const* columns,
+                     const std::size_t num_rows, int* output) {
+  std::vector<std::function<int(int, int)> > functions;
+  for (const OpCode op : ops) {
+    functions.push_back(cpp_labs::ScalarOpFunction(op));
+  }
+  for (std::size_t row = 0; row < num_rows; ++row) {
+    int accumulator = columns[0][row];
+    for (std::size_t i = 0; i < functions.size(); ++i) {
+      accumulator = functions[i](accumulator, columns[i + 1][row]);
+    }
+    output[row] = accumulator;
+  }
+}
+
+void RunSwitch(const std::vector<OpCode>& ops, const int* const* columns,
+               const std::size_t num_rows, int* output) {
+  for (std::size_t row = 0; row < num_rows; ++row) {
+    int accumulator = columns[0][row];
+    for (std::size_t i = 0; i < ops.size(); ++i) {
+      const int value = columns[i + 1][row];
+      switch (ops[i]) {
+        case OpCode::kAdd:
+          accumulator = accumulator + value;
+          break;
+        case OpCode::kSubtract:
+          accumulator = accumulator - value;
+          break;
+        case OpCode::kMultiply:
+          accumulator = accumulator * value;
+          break;
+        case OpCode::kMax:
+          accumulator = accumulator > value ? accumulator : value;
+          break;
+      }
+    }
+    output[row] = accumulator;
+  }
+}
+
+void RunSpecializedKernel(const std::vector<OpCode>& ops,
+                          const int* const* columns,
+                          const std::size_t num_rows, int* output) {
+  const cpp_labs::ColumnKernel kernel =
+      cpp_labs::SelectColumnKernel(ops.data(), ops.size());
+  kernel(columns, num_rows, output);
+}
+
+typedef void (*BatchFunction)(const std::vector<OpCode>& ops,
+                              const int* const* columns, std::size_t num_rows,
+                              int* output);
+
+// Runs function over all the rows in batches, and returns the seconds.
+double RunInBatches(const BatchFunction function,
+                    const std::vector<OpCode>& ops,
+                    const std::vector<std::vector<int> >& columns,
+                    std::vector<int>* output) {
+  const std::size_t num_rows = output->size();
+  std::vector<const int*> batch_columns(columns.size());
+  cpp_labs::Timer timer;
+  for (std::size_t first = 0; first < num_rows; first += kBatchRows) {
+    const std::size_t batch_rows =
+        num_rows - first < kBatchRows ? num_rows - first : kBatchRows;
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+      batch_columns[i] = columns[i].data() + first;
+    }
+    function(ops, batch_columns.data(), batch_rows, output->data() + first);
+  }
+  cpp_labs::ClobberMemory();
+  return timer.ElapsedSeconds();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t num_rows =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, 100000000);
+  const char* ops_text = argc > 2 ? argv[2] : "+-*";
+  std::vector<OpCode> ops;
+  if (num_rows == 0 || !ParseOps(ops_text, &ops) || ops.empty() ||
+      ops.size() > cpp_labs::kMaxKernelOps) {
+    std::cerr << "Usage: batch_kernels_benchmark [num_rows] [ops], where ops "
+              << "has 1 to " << cpp_labs::kMaxKernelOps
+              << " of '+', '-', '*' and 'M'." << std::endl;
+    return 1;
+  }
+
+  std::mt19937 rng(1234);
+  std::uniform_int_distribution<int> distribution(-100, 100);
+  std::vector<std::vector<int> > columns(ops.size() + 1,
+                                         std::vector<int>(num_rows));
+  for (std::vector<int>& column : columns) {
+    for (int& value : column) {
+      value = distribution(rng);
+    }
+  }
+
+  struct Variant {
+    const char* name;
+    BatchFunction function;
+  };
+  const Variant kVariants[] = {
+      {"function pointer per row", &RunFunctionPointers},
+      {"std::function per row", &RunStdFunctions},
+      {"switch per row", &RunSwitch},
+      {"specialized kernel", &RunSpecializedKernel}};
+
+  std::cout << num_rows << " rows, ops \"" << ops_text << "\", batches of "
+            << kBatchRows << " rows\n"
+            << std::setw(28) << "evaluation" << std::setw(12) << "ns/row"
+            << std::setw(14) << "M rows/s" << std::endl;
+  std::vector<int> expected;
+  for (const Variant& variant : kVariants) {
+    std::vector<int> output(num_rows);
+    const double seconds =
+        RunInBatches(variant.function, ops, columns, &output);
+    std::cout << std::setw(28) << variant.name << std::setw(12)
+              << seconds * 1e9 / num_rows << std::setw(14)
+              << num_rows / seconds / 1e6;
+    if (expected.empty()) {
+      expected.swap(output);
+    } else if (output != expected) {
+      std::cout << "  (wrong result!)";
+    }
+    std::cout << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,160 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_BENCHMARK_UTILS_H_
+#define CPP_LABS_BENCHMARK_UTILS_H_
+
+// Small helpers shared by the *_benchmark.cc binaries: a wall-clock timer,
+// a barrier that stops the optimizer from deleting the measured work,
+// percentiles of latency samples, running a measurement in a child process,
+// and parsing of the optional command line arguments.
+
+#include <sys/resource.h>  // Header for getrusage and struct rusage.
+#include <sys/wait.h>  // Header for wait4.
+#include <unistd.h>  // Header for fork and pipe.
+
+#include <algorithm>  // Header for std::nth_element.
+#include <chrono>  // Header for std::chrono::steady_clock.
+#include <cstddef>  // Header for std::size_t.
+#include <cstdlib>  // Header for std::strtoull.
+#include <vector>  // Header for std::vector.
+
+namespace cpp_labs {
+
+// Measures wall-clock time since construction (or the last Reset).
+class Timer {
+ public:
+  Timer() { Reset(); }
+
+  void Reset() { start_ = std::chrono::steady_clock::now(); }
+
+  double ElapsedSeconds() const {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start_).count();
+  }
+
+  double ElapsedNanoseconds() const { return ElapsedSeconds() * 1e9; }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Tells the compiler that value is used, so the computation producing it is
+// not removed as dead code.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  volatile const T sink = value;
+  (void)sink;
+#endif
+}
+
+// Tells the compiler that all memory may have been read or written.
+inline void ClobberMemory() {
+#if defined(__GNUC__)
+  asm volatile("" : : : "memory");
+#endif
+}
+
+// Returns the sample below which the given percentage of the samples fall;
+// e.g., Percentile(&latencies, 99.9) is the p999 latency. Reorders samples.
+template <typename T>
+T Percentile(std::vector<T>* samples, const double percentage) {
+  if (samples->empty()) {
+    return T();
+  }
+  std::size_t rank =
+      static_cast<std::size_t>(percentage / 100.0 * samples->size());
+  if (rank >= samples->size()) {
+    rank = samples->size() - 1;
+  }
+  std::nth_element(samples->begin(), samples->begin() + rank, samples->end());
+  return (*samples)[rank];
+}
+
+// Runs function() in a child process (fork) and sends its result back
+// through a pipe, so that the memory used by the measurement (and its peak,
+// returned in peak_memory_kb) belongs to that measurement only. Result must be
+// trivially copyable. Returns false if the child failed (e.g., it ran out of
+// memory).
+template <typename Result, typename Function>
+bool RunInChildProcess(const Function& function, Result* result,
+                       long* peak_memory_kb) {
+  int pipe_fds[2];
+  if (pipe(pipe_fds) != 0) {
+    return false;
+  }
+  const pid_t pid = fork();
+  if (pid == 0) {
+    close(pipe_fds[0]);
+    const Result child_result = function();
+    const ssize_t written =
+        write(pipe_fds[1], &child_result, sizeof(child_result));
+    _exit(written == sizeof(child_result) ? 0 : 1);
+  }
+  close(pipe_fds[1]);
+  const ssize_t bytes_read = read(pipe_fds[0], result, sizeof(*result));
+  close(pipe_fds[0]);
+  int status = 0;
+  struct rusage usage;
+  if (pid < 0 || wait4(pid, &status, 0, &usage) != pid) {
+    return false;
+  }
+  *peak_memory_kb = usage.ru_maxrss;
+  return bytes_read == sizeof(*result) && WIFEXITED(status) &&
+         WEXITSTATUS(status) == 0;
+}
+
+// Peak resident memory of this process so far, in KB.
+inline long PeakMemoryKb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// Returns argv[index] as a number, or default_value when it is not given.
+inline std::size_t ParseSizeArgument(const int argc, char** argv,
+                                     const int index,
+                                     const std::size_t default_value) {
+  if (index >= argc) {
+    return default_value;
+  }
+  return static_cast<std::size_t>(std::strtoull(argv[index], nullptr, 10));
+}
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_BENCHMARK_UTILS_H_
@@ -0,0 +1,610 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_BINARY_SERIALIZATION_H_
+#define CPP_LABS_BINARY_SERIALIZATION_H_
+
+// A compact, versioned binary file format for containers: std::vector, std::set
+// and std::unordered_set of trivially copyable types (e.g., int), and
+// std::map and std::unordered_map from std::string to int.
+//
+// Usage:
+//
+//   cpp_labs::BinaryWriter writer("containers.bin");
+//   writer.Write(my_vector);
+//   writer.Write(my_map);
+//   if (!writer.Close()) { ... }
+//
+//   cpp_labs::BinaryReader reader("containers.bin");
+//   cpp_labs::Span<const int> values;  // Points into the file: no copy.
+//   cpp_labs::StringIntMapView entries;
+//   if (!reader.ok() || !reader.Next(&values) || !reader.Next(&entries)) {
+//     ...
+//   }
+//   std::map<std::string, int> my_map;
+//   entries.ForEach([&](const char* key, std::size_t length, int value) {
+//     my_map.emplace(std::string(key, length), value);
+//   });
+//
+// Layout of a file (integers in the byte order of the machine, which the
+// header records):
+//
+//   FileHeader: magic "CPPLABS", format version, byte order mark.
+//   Sections, one per container, each one a SectionHeader (kind, element size,
+//   number of elements, payload bytes, element type) and the payload:
+//   - kPodArray: the elements as in memory, aligned to 64 bytes in the file
+//   (and so in memory once the file is mapped, since mappings start on a page).
+//   - kStringIntMap: chunks of at most kStreamChunkBytes, each one a
+//   ChunkHeader (bytes, number of records) and records of (key length, value,
+//   key bytes).
+//
+// Notes:
+//
+// 1. The writer streams through a buffer of kStreamChunkBytes: memory does not
+// grow with the container (a std::vector is written straight from its
+// buffer). The chunks of a map let a reader also process it a piece at a time.
+// 2. The reader maps the file (mmap), so the views are pointers into the page
+// cache: reading a POD array costs nothing until it is used, and no element is
+// allocated. Views are valid as long as the reader is.
+// 3. Sets are written in iteration order; a std::set reloads in linear time
+// because every element is inserted at the end.
+// 4. Readers reject files with a newer format version or another byte order.
+// Sections carry their size, so a reader can skip kinds it does not know.
+// 5. Arrays record the type of their elements (integer, floating point or
+// other, and the size), so an array of int does not load as one of float.
+// Readers check the sizes against the file and stop at corrupt sections.
+
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for uint32_t and uint64_t.
+#include <cstdio>  // Header for std::FILE.
+#include <cstring>  // Header for std::memcpy.
+#include <iterator>  // Header for std::iterator_traits.
+#include <map>  // Header for std::map.
+#include <set>  // Header for std::set.
+#include <string>  // Header for std::string.
+#include <type_traits>  // Header for std::is_trivially_copyable.
+#include <unordered_map>  // Header for std::unordered_map.
+#include <unordered_set>  // Header for std::unordered_set.
+#include <vector>  // Header for std::vector.
+
+#include <fcntl.h>  // Header for open.
+#include <sys/mman.h>  // Header for mmap and munmap.
+#include <sys/stat.h>  // Header for fstat.
+#include <unistd.h>  // Header for close.
+
+#include "span.h"
+
+namespace cpp_labs {
+
+// Increase it when the layout changes; readers reject files with a version
+// newer than theirs.
+const uint32_t kBinaryFormatVersion = 1;
+const std::size_t kStreamChunkBytes = 1 << 16;
+
+namespace internal {
+
+const char kBinaryMagic[8] = {'C', 'P', 'P', 'L', 'A', 'B', 'S', '\0'};
+const uint32_t kByteOrderMark = 0x01020304;
+const std::size_t kPayloadAlignment = 64;
+
+enum SectionKind : uint32_t { kPodArray = 1, kStringIntMap = 2 };
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+};
+
+struct SectionHeader {
+  uint32_t kind;
+  uint32_t element_size;
+  uint64_t count;
+  uint64_t payload_bytes;
+  // ElementType<T>() of the array elements (0 for maps).
+  uint32_t element_type;
+  uint32_t reserved;
+};
+
+// The kind of number (or other) that T is in the upper 16 bits, and its size
+// in the lower ones.
+template <typename T>
+uint32_t ElementType() {
+  const uint32_t category =
+      std::is_floating_point<T>::value
+          ? 3
+          : std::is_integral<T>::value ? (std::is_signed<T>::value ? 1 : 2)
+                                       : 4;
+  return category << 16 | static_cast<uint32_t>(sizeof(T));
+}
+
+struct ChunkHeader {
+  uint32_t bytes;
+  uint32_t count;
+};
+
+// Each map entry is a RecordHeader followed by the key bytes.
+struct RecordHeader {
+  uint32_t key_length;
+  int32_t value;
+};
+
+inline uint64_t AlignOffset(const uint64_t offset, const uint64_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace internal
+
+// Writes containers to a file, one section each. Errors are sticky: Close (or
+// ok) tells whether everything was written.
+class BinaryWriter {
+ public:
+  explicit BinaryWriter(const std::string& path)
+      : file_(std::fopen(path.c_str(), "wb")), offset_(0),
+        ok_(file_ != nullptr) {
+    if (ok_) {
+      // The writer buffers by itself.
+      std::setvbuf(file_, nullptr, _IONBF, 0);
+      buffer_.reserve(kStreamChunkBytes);
+      internal::FileHeader header;
+      std::memcpy(header.magic, internal::kBinaryMagic, sizeof(header.magic));
+      header.version = kBinaryFormatVersion;
+      header.byte_order = internal::kByteOrderMark;
+      Append(&header, sizeof(header));
+    }
+  }
+  ~BinaryWriter() { Close(); }
+  BinaryWriter(const BinaryWriter&) = delete;
+  BinaryWriter& operator=(const BinaryWriter&) = delete;
+
+  template <typename T, typename Allocator>
+  void Write(const std::vector<T, Allocator>& values) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only trivially copyable elements can be written.");
+    BeginPodArray<T>(values.size());
+    Append(values.data(), values.size() * sizeof(T));
+  }
+
+  template <typename T, typename Compare, typename Allocator>
+  void Write(const std::set<T, Compare, Allocator>& values) {
+    WritePodRange(values.begin(), values.end(), values.size());
+  }
+
+  template <typename T, typename Hash, typename Equal, typename Allocator>
+  void Write(const std::unordered_set<T, Hash, Equal, Allocator>& values) {
+    WritePodRange(values.begin(), values.end(), values.size());
+  }
+
+  template <typename Compare, typename Allocator>
+  void Write(const std::map<std::string, int, Compare, Allocator>& entries) {
+    WriteStringIntMap(entries);
+  }
+
+  template <typename Hash, typename Equal, typename Allocator>
+  void Write(const std::unordered_map<std::string, int, Hash, Equal,
+                                      Allocator>& entries) {
+    WriteStringIntMap(entries);
+  }
+
+  bool ok() const { return ok_; }
+
+  // Flushes and closes the file; returns whether everything was written.
+  bool Close() {
+    if (file_ != nullptr) {
+      Flush();
+      ok_ = std::fclose(file_) == 0 && ok_;
+      file_ = nullptr;
+    }
+    return ok_;
+  }
+
+ private:
+  template <typename Iterator>
+  void WritePodRange(Iterator begin, const Iterator end,
+                     const std::size_t size) {
+    typedef typename std::iterator_traits<Iterator>::value_type T;
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only trivially copyable elements can be written.");
+    BeginPodArray<T>(size);
+    // The elements are not contiguous: copy them through the buffer.
+    for (; begin != end; ++begin) {
+      Append(&*begin, sizeof(T));
+    }
+  }
+
+  template <typename T>
+  void BeginPodArray(const std::size_t count) {
+    internal::SectionHeader header;
+    header.kind = internal::kPodArray;
+    header.element_size = static_cast<uint32_t>(sizeof(T));
+    header.count = count;
+    header.payload_bytes = count * sizeof(T);
+    header.element_type = internal::ElementType<T>();
+    header.reserved = 0;
+    AppendSectionHeader(header);
+    AppendPadding(internal::kPayloadAlignment);
+  }
+
+  template <typename Map>
+  void WriteStringIntMap(const Map& entries) {
+    // The payload size is only known at the end: write the header now and
+    // rewrite it then.
+    const uint64_t header_offset = internal::AlignOffset(offset_, 8);
+    internal::SectionHeader header;
+    header.kind = internal::kStringIntMap;
+    header.element_size = 0;
+    header.count = entries.size();
+    header.payload_bytes = 0;
+    header.element_type = 0;
+    header.reserved = 0;
+    AppendSectionHeader(header);
+    const uint64_t payload_offset = offset_;
+
+    std::vector<char> chunk;
+    chunk.reserve(kStreamChunkBytes);
+    uint32_t chunk_count = 0;
+    for (const auto& entry : entries) {
+      internal::RecordHeader record;
+      record.key_length = static_cast<uint32_t>(entry.first.size());
+      record.value = entry.second;
+      // A record larger than a chunk gets a chunk of its own.
+      if (!chunk.empty() &&
+          chunk.size() + sizeof(record) + entry.first.size() >
+              kStreamChunkBytes - sizeof(internal::ChunkHeader)) {
+        AppendChunk(chunk, chunk_count);
+        chunk.clear();
+        chunk_count = 0;
+      }
+      const char* record_bytes = reinterpret_cast<const char*>(&record);
+      chunk.insert(chunk.end(), record_bytes, record_bytes + sizeof(record));
+      chunk.insert(chunk.end(), entry.first.begin(), entry.first.end());
+      ++chunk_count;
+    }
+    if (!chunk.empty()) {
+      AppendChunk(chunk, chunk_count);
+    }
+
+    header.payload_bytes = offset_ - payload_offset;
+    Flush();
+    if (ok_) {
+      ok_ = std::fseek(file_, static_cast<long>(header_offset), SEEK_SET) ==
+                0 &&
+            std::fwrite(&header, sizeof(header), 1, file_) == 1 &&
+            std::fseek(file_, 0, SEEK_END) == 0;
+    }
+  }
+
+  void AppendChunk(const std::vector<char>& chunk, const uint32_t count) {
+    internal::ChunkHeader header;
+    header.bytes = static_cast<uint32_t>(chunk.size());
+    header.count = count;
+    Append(&header, sizeof(header));
+    Append(chunk.data(), chunk.size());
+  }
+
+  void AppendSectionHeader(const internal::SectionHeader& header) {
+    AppendPadding(8);
+    Append(&header, sizeof(header));
+  }
+
+  void AppendPadding(const std::size_t alignment) {
+    static const char kZeros[internal::kPayloadAlignment] = {};
+    Append(kZeros, internal::AlignOffset(offset_, alignment) - offset_);
+  }
+
+  void Append(const void* data, const std::size_t bytes) {
+    if (!ok_) {
+      return;
+    }
+    offset_ += bytes;
+    if (buffer_.size() + bytes > kStreamChunkBytes) {
+      Flush();
+    }
+    const char* begin = static_cast<const char*>(data);
+    if (bytes >= kStreamChunkBytes) {
+      // Large blocks (e.g., a whole std::vector) go straight to the file.
+      ok_ = std::fwrite(begin, 1, bytes, file_) == bytes;
+    } else {
+      buffer_.insert(buffer_.end(), begin, begin + bytes);
+    }
+  }
+
+  void Flush() {
+    if (ok_ && !buffer_.empty()) {
+      ok_ = std::fwrite(buffer_.data(), 1, buffer_.size(), file_) ==
+            buffer_.size();
+    }
+    buffer_.clear();
+  }
+
+  std::FILE* file_;
+  std::vector<char> buffer_;
+  // Bytes written so far, including those still in the buffer.
+  uint64_t offset_;
+  bool ok_;
+};
+
+// A zero-copy view of a map section: the keys point into the mapped file.
+class StringIntMapView {
+ public:
+  StringIntMapView() : payload_(nullptr), bytes_(0), size_(0) {}
+
+  std::size_t size() const { return size_; }
+
+  // Calls function(key, key_length, value) for every entry, in the order they
+  // were written. The key is not null-terminated.
+  template <typename Function>
+  void ForEach(Function function) const {
+    std::size_t offset = 0;
+    while (offset + sizeof(internal::ChunkHeader) <= bytes_) {
+      internal::ChunkHeader chunk;
+      std::memcpy(&chunk, payload_ + offset, sizeof(chunk));
+      offset += sizeof(chunk);
+      // A corrupt chunk may claim more bytes than the section has.
+      if (chunk.bytes > bytes_ - offset) {
+        return;
+      }
+      const std::size_t chunk_end = offset + chunk.bytes;
+      for (uint32_t i = 0; i < chunk.count; ++i) {
+        internal::RecordHeader record;
+        if (offset + sizeof(record) > chunk_end) {
+          return;
+        }
+        std::memcpy(&record, payload_ + offset, sizeof(record));
+        offset += sizeof(record);
+        if (offset + record.key_length > chunk_end) {
+          return;
+        }
+        function(payload_ + offset, static_cast<std::size_t>(record.key_length),
+                 static_cast<int>(record.value));
+        offset += record.key_length;
+      }
+      offset = chunk_end;
+    }
+  }
+
+ private:
+  friend class BinaryReader;
+
+  const char* payload_;
+  std::size_t bytes_;
+  std::size_t size_;
+};
+
+// Reads the sections of a file written by BinaryWriter, in order, through a
+// read-only mapping of the file.
+class BinaryReader {
+ public:
+  explicit BinaryReader(const std::string& path)
+      : data_(nullptr), size_(0), offset_(0), version_(0) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    struct stat status;
+    if (fstat(fd, &status) == 0 &&
+        status.st_size >= static_cast<off_t>(sizeof(internal::FileHeader))) {
+      void* memory =
+          mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (memory != MAP_FAILED) {
+        data_ = static_cast<const char*>(memory);
+        size_ = status.st_size;
+      }
+    }
+    // The mapping stays valid after the file is closed.
+    close(fd);
+    if (data_ == nullptr) {
+      return;
+    }
+    internal::FileHeader header;
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, internal::kBinaryMagic,
+                    sizeof(header.magic)) != 0 ||
+        header.version == 0 || header.version > kBinaryFormatVersion ||
+        header.byte_order != internal::kByteOrderMark) {
+      Unmap();
+      return;
+    }
+    version_ = header.version;
+    offset_ = sizeof(header);
+  }
+  ~BinaryReader() { Unmap(); }
+  BinaryReader(const BinaryReader&) = delete;
+  BinaryReader& operator=(const BinaryReader&) = delete;
+
+  // Whether the file was mapped and has a valid header.
+  bool ok() const { return data_ != nullptr; }
+  uint32_t version() const { return version_; }
+  // Whether every section has been read.
+  bool at_end() const {
+    return !ok() || internal::AlignOffset(offset_, 8) >= size_;
+  }
+
+  // Reads the next section into a view, if it is an array of T. Returns false
+  // (and stays at the section) if it is not, or if the file is truncated.
+  template <typename T>
+  bool Next(Span<const T>* view) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only trivially copyable elements can be read.");
+    internal::SectionHeader header;
+    const char* payload = nullptr;
+    if (!NextSection(internal::kPodArray, sizeof(T),
+                     internal::ElementType<T>(), &header, &payload)) {
+      return false;
+    }
+    *view = Span<const T>(reinterpret_cast<const T*>(payload), header.count);
+    return true;
+  }
+
+  bool Next(StringIntMapView* view) {
+    internal::SectionHeader header;
+    const char* payload = nullptr;
+    if (!NextSection(internal::kStringIntMap, 0, 0, &header, &payload)) {
+      return false;
+    }
+    view->payload_ = payload;
+    view->bytes_ = header.payload_bytes;
+    view->size_ = header.count;
+    return true;
+  }
+
+  // Skips the next section, whatever its kind.
+  bool Skip() {
+    internal::SectionHeader header;
+    const char* payload = nullptr;
+    return NextSection(0, 0, 0, &header, &payload);
+  }
+
+  // Copies the next section into a container, replacing its contents.
+  template <typename T, typename Allocator>
+  bool Read(std::vector<T, Allocator>* values) {
+    Span<const T> view;
+    if (!Next(&view)) {
+      return false;
+    }
+    values->assign(view.begin(), view.end());
+    return true;
+  }
+
+  template <typename T, typename Compare, typename Allocator>
+  bool Read(std::set<T, Compare, Allocator>* values) {
+    Span<const T> view;
+    if (!Next(&view)) {
+      return false;
+    }
+    values->clear();
+    for (const T& value : view) {
+      // The elements were written in order: each one goes at the end.
+      values->insert(values->end(), value);
+    }
+    return true;
+  }
+
+  template <typename T, typename Hash, typename Equal, typename Allocator>
+  bool Read(std::unordered_set<T, Hash, Equal, Allocator>* values) {
+    Span<const T> view;
+    if (!Next(&view)) {
+      return false;
+    }
+    values->clear();
+    values->reserve(view.size());
+    values->insert(view.begin(), view.end());
+    return true;
+  }
+
+  template <typename Compare, typename Allocator>
+  bool Read(std::map<std::string, int, Compare, Allocator>* entries) {
+    StringIntMapView view;
+    if (!Next(&view)) {
+      return false;
+    }
+    entries->clear();
+    view.ForEach([entries](const char* key, const std::size_t length,
+                           const int value) {
+      entries->emplace_hint(entries->end(), std::string(key, length), value);
+    });
+    return true;
+  }
+
+  template <typename Hash, typename Equal, typename Allocator>
+  bool Read(std::unordered_map<std::string, int, Hash, Equal, Allocator>*
+                entries) {
+    StringIntMapView view;
+    if (!Next(&view)) {
+      return false;
+    }
+    entries->clear();
+    entries->reserve(view.size());
+    view.ForEach([entries](const char* key, const std::size_t length,
+                           const int value) {
+      entries->emplace(std::string(key, length), value);
+    });
+    return true;
+  }
+
+ private:
+  // Finds the section at the current offset and, if it has the given kind
+  // (any kind if 0), element size and element type, moves past it.
+  bool NextSection(const uint32_t kind, const uint32_t element_size,
+                   const uint32_t element_type,
+                   internal::SectionHeader* header, const char** payload) {
+    if (!ok()) {
+      return false;
+    }
+    const uint64_t header_offset = internal::AlignOffset(offset_, 8);
+    if (header_offset + sizeof(*header) > size_) {
+      return false;
+    }
+    std::memcpy(header, data_ + header_offset, sizeof(*header));
+    if (kind != 0 &&
+        (header->kind != kind || header->element_size != element_size ||
+         header->element_type != element_type)) {
+      return false;
+    }
+    uint64_t payload_offset = header_offset + sizeof(*header);
+    if (header->kind == internal::kPodArray) {
+      payload_offset =
+          internal::AlignOffset(payload_offset, internal::kPayloadAlignment);
+      // Without multiplying, which a corrupt count could overflow.
+      if (header->element_size == 0 ||
+          header->payload_bytes % header->element_size != 0 ||
+          header->payload_bytes / header->element_size != header->count) {
+        return false;
+      }
+    }
+    if (payload_offset > size_ ||
+        header->payload_bytes > size_ - payload_offset) {
+      return false;
+    }
+    *payload = data_ + payload_offset;
+    offset_ = payload_offset + header->payload_bytes;
+    return true;
+  }
+
+  void Unmap() {
+    if (data_ != nullptr) {
+      munmap(const_cast<char*>(data_), size_);
+      data_ = nullptr;
+      size_ = 0;
+    }
+  }
+
+  const char* data_;
+  std::size_t size_;
+  uint64_t offset_;
+  uint32_t version_;
+};
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_BINARY_SERIALIZATION_H_
@@ -0,0 +1,336 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary measures how fast containers are saved to and loaded from a
+// file as text (the "Key=... Value=..." lines printed by map_example.cc) and
+// in the binary format of binary_serialization.h.
+//
+// Usage: binary_serialization_benchmark [num_elements] [directory]
+//   Defaults: num_elements = 4000000, directory = /tmp.
+//
+// Each container (std::vector<int>, std::set<int>, std::unordered_set<int>,
+// std::map<std::string, int> and std::unordered_map<std::string, int>) holds
+// num_elements entries and is:
+//
+// 1. text save / load: written with std::ofstream, one element (or one
+// "Key=... Value=..." line) per line, and parsed back with std::ifstream.
+// 2. binary save / load: written with BinaryWriter and copied back into a
+// container with BinaryReader::Read.
+// 3. binary view: read through the zero-copy view of BinaryReader::Next,
+// summing every element, without building a container.
+//
+// The throughput is in GB/s of data (4 bytes per int, key bytes + 4 per map
+// entry), so text and binary rows are comparable. Every loaded container is
+// checked against the original.
+//
+// Notes:
+//
+// 1. The files are read right after they are written, so they come from the
+// page cache: the times are those of formatting, parsing and copying, not of
+// the disk.
+// 2. Both loaders insert the elements of ordered containers with the end as
+// hint (the files are in order), so the difference is in the format.
+
+#include <cstdint>  // Header for int64_t.
+#include <cstdio>  // Header for std::remove.
+#include <fstream>  // Header for std::ifstream and std::ofstream.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <map>  // Header for std::map.
+#include <set>  // Header for std::set.
+#include <string>  // Header for std::string.
+#include <unordered_map>  // Header for std::unordered_map.
+#include <unordered_set>  // Header for std::unordered_set.
+#include <vector>  // Header for std::vector.
+
+#include <sys/stat.h>  // Header for stat.
+
+#include "benchmark_utils.h"
+#include "binary_serialization.h"
+
+namespace {
+
+// Integer containers: one value per line.
+template <typename Container>
+void SaveText(const Container& values, const std::string& path) {
+  std::ofstream file(path.c_str());
+  for (const int value : values) {
+    file << value << '\n';
+  }
+}
+
+void SaveText(const std::map<std::string, int>& entries,
+              const std::string& path) {
+  std::ofstream file(path.c_str());
+  for (const std::pair<const std::string, int>& entry : entries) {
+    file << "Key=" << entry.first << " Value=" << entry.second << '\n';
+  }
+}
+
+void SaveText(const std::unordered_map<std::string, int>& entries,
+              const std::string& path) {
+  std::ofstream file(path.c_str());
+  for (const std::pair<const std::string, int>& entry : entries) {
+    file << "Key=" << entry.first << " Value=" << entry.second << '\n';
+  }
+}
+
+void LoadText(const std::string& path, std::vector<int>* values) {
+  std::ifstream file(path.c_str());
+  int value;
+  while (file >> value) {
+    values->push_back(value);
+  }
+}
+
+void LoadText(const std::string& path, std::set<int>* values) {
+  std::ifstream file(path.c_str());
+  int value;
+  while (file >> value) {
+    values->insert(values->end(), value);
+  }
+}
+
+void LoadText(const std::string& path, std::unordered_set<int>* values) {
+  std::ifstream file(path.c_str());
+  int value;
+  while (file >> value) {
+    values->insert(value);
+  }
+}
+
+// Calls function(key, value) for every "Key=... Value=..." line.
+template <typename Function>
+void ParseKeyValueLines(const std::string& path, Function function) {
+  std::ifstream file(path.c_str());
+  const std::string kKeyPrefix = "Key=";
+  const std::string kValuePrefix = " Value=";
+  std::string line;
+  while (std::getline(file, line)) {
+    const std::size_t value_position = line.rfind(kValuePrefix);
+    if (line.compare(0, kKeyPrefix.size(), kKeyPrefix) != 0 ||
+        value_position == std::string::npos) {
+      continue;
+    }
+    function(line.substr(kKeyPrefix.size(),
+                         value_position - kKeyPrefix.size()),
+             std::stoi(line.substr(value_position + kValuePrefix.size())));
+  }
+}
+
+void LoadText(const std::string& path, std::map<std::string, int>* entries) {
+  ParseKeyValueLines(path, [entries](std::string key, const int value) {
+    entries->emplace_hint(entries->end(), std::move(key), value);
+  });
+}
+
+void LoadText(const std::string& path,
+              std::unordered_map<std::string, int>* entries) {
+  ParseKeyValueLines(path, [entries](std::string key, const int value) {
+    entries->emplace(std::move(key), value);
+  });
+}
+
+// Sums the elements through the zero-copy views.
+int64_t ViewChecksum(cpp_labs::BinaryReader* reader, const int*) {
+  cpp_labs::Span<const int> values;
+  int64_t sum = 0;
+  if (reader->Next(&values)) {
+    for (const int value : values) {
+      sum += value;
+    }
+  }
+  return sum;
+}
+
+int64_t ViewChecksum(cpp_labs::BinaryReader* reader, const std::string*) {
+  cpp_labs::StringIntMapView entries;
+  int64_t sum = 0;
+  if (reader->Next(&entries)) {
+    entries.ForEach([&sum](const char* key, const std::size_t length,
+                           const int value) {
+      sum += static_cast<unsigned char>(key[length - 1]) + value;
+    });
+  }
+  return sum;
+}
+
+int64_t Checksum(const std::vector<int>& values) {
+  int64_t sum = 0;
+  for (const int value : values) {
+    sum += value;
+  }
+  return sum;
+}
+
+int64_t Checksum(const std::map<std::string, int>& entries) {
+  int64_t sum = 0;
+  for (const std::pair<const std::string, int>& entry : entries) {
+    sum += static_cast<unsigned char>(entry.first.back()) + entry.second;
+  }
+  return sum;
+}
+
+long FileSize(const std::string& path) {
+  struct stat status;
+  return stat(path.c_str(), &status) == 0 ? static_cast<long>(status.st_size)
+                                          : -1;
+}
+
+// Returns correct.
+bool PrintRow(const std::string& name, const std::string& operation,
+              const double gigabytes, const double seconds, const long bytes,
+              const bool correct) {
+  std::cout << std::setw(36) << name << std::setw(14) << operation
+            << std::setw(10) << gigabytes / seconds << std::setw(10);
+  if (bytes >= 0) {
+    std::cout << bytes / 1e6;
+  } else {
+    std::cout << "-";
+  }
+  std::cout << (correct ? "" : "   MISMATCH") << std::endl;
+  return correct;
+}
+
+// Saves and loads container both ways. Element is the element type of the
+// views (int, or std::string for maps); expected_checksum is the checksum of
+// the whole container. Returns whether every load matched.
+template <typename Container, typename Element>
+bool Measure(const std::string& name, const Container& container,
+             const double gigabytes, const int64_t expected_checksum,
+             const std::string& directory, const Element*) {
+  const std::string text_path = directory + "/cpp_labs_serialization.txt";
+  const std::string binary_path = directory + "/cpp_labs_serialization.bin";
+
+  bool correct = true;
+  cpp_labs::Timer timer;
+  SaveText(container, text_path);
+  PrintRow(name, "text save", gigabytes, timer.ElapsedSeconds(),
+           FileSize(text_path), true);
+  {
+    timer.Reset();
+    Container loaded;
+    LoadText(text_path, &loaded);
+    correct &= PrintRow(name, "text load", gigabytes, timer.ElapsedSeconds(),
+                        -1, loaded == container);
+  }
+
+  timer.Reset();
+  {
+    cpp_labs::BinaryWriter writer(binary_path);
+    writer.Write(container);
+    if (!writer.Close()) {
+      std::cerr << "Could not write " << binary_path << std::endl;
+    }
+  }
+  PrintRow(name, "binary save", gigabytes, timer.ElapsedSeconds(),
+           FileSize(binary_path), true);
+  {
+    timer.Reset();
+    Container loaded;
+    cpp_labs::BinaryReader reader(binary_path);
+    const bool read = reader.Read(&loaded);
+    correct &= PrintRow(name, "binary load", gigabytes,
+                        timer.ElapsedSeconds(), -1,
+                        read && loaded == container);
+  }
+  {
+    timer.Reset();
+    cpp_labs::BinaryReader reader(binary_path);
+    const int64_t checksum =
+        ViewChecksum(&reader, static_cast<const Element*>(nullptr));
+    correct &= PrintRow(name, "binary view", gigabytes,
+                        timer.ElapsedSeconds(), -1,
+                        checksum == expected_checksum);
+  }
+  std::remove(text_path.c_str());
+  std::remove(binary_path.c_str());
+  return correct;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t num_elements =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, 4000000);
+  const std::string directory = argc > 2 ? argv[2] : "/tmp";
+
+  // Distinct values in a scrambled order (a multiplicative permutation).
+  std::vector<int> values(num_elements);
+  for (std::size_t i = 0; i < num_elements; ++i) {
+    values[i] = static_cast<int>((i * 2654435761u) & 0x7FFFFFFF);
+  }
+  std::map<std::string, int> entries;
+  std::size_t key_bytes = 0;
+  for (std::size_t i = 0; i < num_elements; ++i) {
+    std::string key = "user_" + std::to_string(values[i]);
+    key_bytes += key.size();
+    entries.emplace(std::move(key), static_cast<int>(i));
+  }
+  const double int_gigabytes = num_elements * sizeof(int) / 1e9;
+  const double map_gigabytes =
+      (key_bytes + entries.size() * sizeof(int)) / 1e9;
+
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << num_elements << " elements, files in " << directory << "\n";
+  std::cout << std::setw(36) << "container" << std::setw(14) << "operation"
+            << std::setw(10) << "GB/s" << std::setw(10) << "file MB"
+            << std::endl;
+  const int* kInt = nullptr;
+  const std::string* kString = nullptr;
+  const int64_t int_checksum = Checksum(values);
+  bool correct = true;
+  correct &= Measure("std::vector<int>", values, int_gigabytes, int_checksum,
+                     directory, kInt);
+  {
+    const std::set<int> set(values.begin(), values.end());
+    correct &= Measure("std::set<int>", set, int_gigabytes, int_checksum,
+                       directory, kInt);
+  }
+  {
+    const std::unordered_set<int> set(values.begin(), values.end());
+    correct &= Measure("std::unordered_set<int>", set, int_gigabytes,
+                       int_checksum, directory, kInt);
+  }
+  const int64_t map_checksum = Checksum(entries);
+  correct &= Measure("std::map<std::string, int>", entries, map_gigabytes,
+                     map_checksum, directory, kString);
+  {
+    const std::unordered_map<std::string, int> map(entries.begin(),
+                                                   entries.end());
+    correct &= Measure("std::unordered_map<std::string, int>", map,
+                       map_gigabytes, map_checksum, directory, kString);
+  }
+  return correct ? 0 : 1;
+}
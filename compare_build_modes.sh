@@ -0,0 +1,233 @@
+#!/bin/bash
+# Copyright (C) 2016 West Virginia University.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+#
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#
+#     * Redistributions in binary form must reproduce the above
+#       copyright notice, this list of conditions and the following
+#       disclaimer in the documentation and/or other materials provided
+#       with the distribution.
+#
+#     * Neither the name of West Virginia University nor the
+#       names of its contributors may be used to endorse or promote products
+#       derived from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+# ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+# LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+# CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+# SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+# CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+# ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+# Please contact the author of this library if you have any questions.
+# Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+# Builds the labs in several build modes, runs the same benchmark workloads
+# with every build and prints the speedup of each mode over the plain Release
+# build.
+#
+# Usage: ./compare_build_modes.sh [build_root] [workloads_file]
+#   Defaults: build_root = ./build_modes, workloads_file = the list below.
+#
+# The build modes (a build directory each under build_root):
+#
+# 1. release: the default Release build (-O3), the baseline.
+# 2. native: -march=native.
+# 3. x86-64-v3: -march=x86-64-v3 (AVX2, BMI2 and FMA), for binaries that run on
+# any x86 CPU of the last decade.
+# 4. lto: link-time optimization (ThinLTO with Clang).
+# 5. pgo: profile-guided optimization, trained with a run of the workloads.
+# 6. pgo+lto+native: all of the above.
+#
+# Environment variables:
+#   BUILD_MODES: the modes to compare (default: all of them), e.g.
+#     BUILD_MODES="release pgo". The first one is the baseline.
+#   CXX: the compiler (e.g., CXX=clang++; Clang needs llvm-profdata for PGO).
+#   REPETITIONS: runs of every workload; the fastest counts (default: 3).
+#   CPU: the CPU to run the workloads on with taskset (default: 0).
+#   TRAINING_FILE: the workloads of the PGO training run (default: the
+#     measured workloads).
+#
+# Every line of a workloads file is a benchmark binary and its arguments; the
+# script times the whole run of each. The benchmarks use fixed random seeds, so
+# every build does the same work.
+#
+# Notes:
+#
+# 1. Training on the measured workloads gives PGO its best case; train on
+# other sizes (TRAINING_FILE) to see how well a profile carries over.
+# 2. The times include generating the inputs of each benchmark.
+# 3. For steady numbers use a quiet machine, with the performance CPU governor
+# and without turbo boost.
+
+set -euo pipefail
+
+readonly SOURCE_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+readonly BUILD_ROOT="$(mkdir -p "${1:-build_modes}" && cd "${1:-build_modes}" \
+                      && pwd)"
+readonly ALL_MODES="release native x86-64-v3 lto pgo pgo+lto+native"
+read -r -a MODES <<< "${BUILD_MODES:-${ALL_MODES}}"
+for mode in "${MODES[@]}"; do
+  if [[ " ${ALL_MODES} " != *" ${mode} "* ]]; then
+    echo "Unknown build mode: ${mode} (choose from ${ALL_MODES})" >&2
+    exit 1
+  fi
+done
+readonly REPETITIONS="${REPETITIONS:-3}"
+
+# Sizes that take a few seconds each on a laptop.
+readonly DEFAULT_WORKLOADS="sorted_set_ops_benchmark 4194304 4194304
+compressed_int_sequence_benchmark 1048576
+batch_kernels_benchmark 20000000
+aligned_array_benchmark 20000000
+soa_vector_benchmark 4000000
+segmented_vector_benchmark 4000000
+tree_set_benchmark 500000 500000
+incremental_hash_map_benchmark 2000000
+numeric_types_benchmark 20000000"
+
+WORKLOADS=()
+if [[ $# -ge 2 ]]; then
+  mapfile -t WORKLOADS < <(grep -v '^[[:space:]]*\(#\|$\)' "$2")
+else
+  mapfile -t WORKLOADS <<< "${DEFAULT_WORKLOADS}"
+fi
+TRAINING_WORKLOADS=("${WORKLOADS[@]}")
+if [[ -n "${TRAINING_FILE:-}" ]]; then
+  mapfile -t TRAINING_WORKLOADS < <(grep -v '^[[:space:]]*\(#\|$\)' \
+                                         "${TRAINING_FILE}")
+fi
+
+PIN=()
+if command -v taskset > /dev/null; then
+  PIN=(taskset -c "${CPU:-0}")
+fi
+
+# The CMake options of a mode. All of them are given every time because the
+# build directories keep their cache between runs of the script.
+mode_options() {
+  local options=(-DCMAKE_BUILD_TYPE=Release -DBUILD_WITH_NATIVE_ARCH=OFF
+                 -DBUILD_WITH_MARCH= -DBUILD_WITH_LTO=OFF -DBUILD_WITH_PGO=OFF)
+  case "$1" in
+    release|pgo) ;;
+    native) options+=(-DBUILD_WITH_NATIVE_ARCH=ON) ;;
+    x86-64-v3) options+=(-DBUILD_WITH_MARCH=x86-64-v3) ;;
+    lto) options+=(-DBUILD_WITH_LTO=ON) ;;
+    pgo+lto+native)
+      options+=(-DBUILD_WITH_LTO=ON -DBUILD_WITH_NATIVE_ARCH=ON) ;;
+  esac
+  echo "${options[@]}"
+}
+
+# Configures build_dir with the given options and builds the benchmarks of the
+# workloads.
+build() {
+  local build_dir="$1"
+  shift
+  cmake -S "${SOURCE_DIR}" -B "${build_dir}" "$@" >> "${build_dir}.log"
+  local workload
+  for workload in "${WORKLOADS[@]}" "${TRAINING_WORKLOADS[@]}"; do
+    echo "${workload%% *}"
+  done | sort -u | while read -r target; do
+    cmake --build "${build_dir}" --target "${target}" -j "$(nproc)" \
+        >> "${build_dir}.log"
+  done
+}
+
+# Prints the seconds of the fastest of REPETITIONS runs of a workload.
+time_workload() {
+  local build_dir="$1"
+  local workload=($2)
+  local best=""
+  local repetition
+  for ((repetition = 0; repetition < REPETITIONS; ++repetition)); do
+    local start end
+    start="$(date +%s%N)"
+    "${PIN[@]}" "${build_dir}/bin/${workload[0]}" "${workload[@]:1}" \
+        > /dev/null
+    end="$(date +%s%N)"
+    best="$(awk -v best="${best}" -v ns="$((end - start))" 'BEGIN {
+              s = ns / 1e9; print (best == "" || s < best) ? s : best }')"
+  done
+  echo "${best}"
+}
+
+# Builds a mode; the PGO modes first build, train and merge the profiles.
+build_mode() {
+  local mode="$1"
+  local build_dir="${BUILD_ROOT}/${mode}"
+  local options
+  read -r -a options <<< "$(mode_options "${mode}")"
+  mkdir -p "${build_dir}"
+  : > "${build_dir}.log"
+  if [[ "${mode}" == pgo* ]]; then
+    local profile_dir="${build_dir}/pgo_profiles"
+    rm -rf "${profile_dir}"
+    build "${build_dir}" "${options[@]}" -DBUILD_WITH_PGO=GENERATE \
+        -DPGO_PROFILE_DIR="${profile_dir}"
+    echo "  training ${mode}" >&2
+    local workload
+    for workload in "${TRAINING_WORKLOADS[@]}"; do
+      local args=(${workload})
+      "${build_dir}/bin/${args[0]}" "${args[@]:1}" > /dev/null
+    done
+    if ls "${profile_dir}"/*.profraw > /dev/null 2>&1; then
+      llvm-profdata merge -output="${profile_dir}/default.profdata" \
+          "${profile_dir}"/*.profraw
+    fi
+    build "${build_dir}" "${options[@]}" -DBUILD_WITH_PGO=USE \
+        -DPGO_PROFILE_DIR="${profile_dir}"
+  else
+    build "${build_dir}" "${options[@]}"
+  fi
+}
+
+echo "Compiler: $("${CXX:-c++}" --version | head -n 1)"
+echo "Build logs and directories: ${BUILD_ROOT}"
+
+declare -A SECONDS_OF
+for mode in "${MODES[@]}"; do
+  echo "Building ${mode}" >&2
+  build_mode "${mode}"
+  echo "Running ${mode}" >&2
+  for ((i = 0; i < ${#WORKLOADS[@]}; ++i)); do
+    SECONDS_OF["${mode},${i}"]="$(time_workload "${BUILD_ROOT}/${mode}" \
+                                                "${WORKLOADS[i]}")"
+  done
+done
+
+# The table: the seconds of the baseline and the speedup of every other mode
+# (baseline seconds / mode seconds), and their geometric means.
+readonly BASELINE="${MODES[0]}"
+printf "\n%-48s %10s" "workload" "${BASELINE} s"
+for mode in "${MODES[@]:1}"; do
+  printf " %15s" "${mode}"
+done
+printf "\n"
+for ((i = 0; i < ${#WORKLOADS[@]}; ++i)); do
+  printf "%-48s %10.3f" "${WORKLOADS[i]}" "${SECONDS_OF["${BASELINE},${i}"]}"
+  for mode in "${MODES[@]:1}"; do
+    printf " %14.2fx" "$(awk -v a="${SECONDS_OF["${BASELINE},${i}"]}" \
+                             -v b="${SECONDS_OF["${mode},${i}"]}" \
+                             'BEGIN { print a / b }')"
+  done
+  printf "\n"
+done
+printf "%-48s %10s" "geometric mean" ""
+for mode in "${MODES[@]:1}"; do
+  for ((i = 0; i < ${#WORKLOADS[@]}; ++i)); do
+    echo "${SECONDS_OF["${BASELINE},${i}"]} ${SECONDS_OF["${mode},${i}"]}"
+  done | awk '{ sum += log($1 / $2) } END { printf " %14.2fx", exp(sum / NR) }'
+done
+printf "\n"
@@ -0,0 +1,580 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_COMPRESSED_INT_SEQUENCE_H_
+#define CPP_LABS_COMPRESSED_INT_SEQUENCE_H_
+
+// Compressed sequences of 32-bit integers, for lists of ids that would waste
+// most of the 32 bits of a std::vector<int> (vector_example.cc).
+//
+// The sequence is split into blocks of kIntBlockSize (128) values, each
+// compressed on its own with one of these encodings:
+//
+// 1. kFrameOfReference: the values minus the smallest one of the block, in as
+// many bits as the largest difference needs. Good for values in a narrow
+// range; any value can be read without decoding the block.
+// 2. kDeltaBitPacked: the differences between consecutive values, bit packed
+// as above. Sorted ids that are close to each other take a few bits each.
+// 3. kStreamVByte: every value in 1 to 4 bytes, with a 2-bit length for each
+// one stored apart (Lemire, Kurz and Rupp, 2017). Good when the sizes of the
+// values vary.
+// 4. kDeltaStreamVByte: the differences, in StreamVByte.
+//
+// The bits are packed "vertically" (SIMD-BP128, Lemire and Boytsov, 2015):
+// value i goes to lane i % 4, so that SSE2 decodes 4 values per shift and
+// mask. StreamVByte decodes 4 values per byte shuffle with SSSE3 (build with
+// -DBUILD_WITH_NATIVE_ARCH=ON); the differences are summed 4 at a time with
+// SSE2. Without SSE2 (or SSSE3) scalar loops do the same.
+//
+// A skip index (a header per block with its first value and its offset)
+// gives random access and binary search (LowerBound) by decoding at most one
+// block.
+//
+// Usage:
+//
+//   CompressedIntSequence ids(sorted_ids.data(), sorted_ids.size(),
+//                             IntEncoding::kDeltaBitPacked);
+//   for (const uint32_t id : ids) { ... }  // As with a std::vector.
+//   const uint32_t tenth = ids[9];
+//   std::vector<uint32_t> all(ids.size());
+//   ids.Decode(all.data());  // The fastest way to read everything.
+//
+// Notes:
+//
+// 1. The sequence is immutable: build a new one to change it.
+// 2. The delta encodings work with any values (the differences wrap around),
+// but only compress sorted ones. LowerBound needs sorted values.
+// 3. Reading one value (operator[]) decodes its block with the delta and
+// StreamVByte encodings; iterate or Decode to read many.
+
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for uint32_t.
+#include <cstring>  // Header for std::memcpy.
+#include <iterator>  // Header for std::forward_iterator_tag.
+#include <vector>  // Header for std::vector.
+
+#if defined(__SSE2__) || defined(__SSSE3__)
+#include <immintrin.h>  // Header for the SIMD intrinsics.
+#endif
+
+namespace cpp_labs {
+
+enum class IntEncoding {
+  kFrameOfReference,
+  kDeltaBitPacked,
+  kStreamVByte,
+  kDeltaStreamVByte
+};
+
+inline const char* IntEncodingName(const IntEncoding encoding) {
+  switch (encoding) {
+    case IntEncoding::kFrameOfReference:
+      return "frame of reference";
+    case IntEncoding::kDeltaBitPacked:
+      return "delta + bit packing";
+    case IntEncoding::kStreamVByte:
+      return "StreamVByte";
+    case IntEncoding::kDeltaStreamVByte:
+      return "delta + StreamVByte";
+  }
+  return "unknown";
+}
+
+namespace internal {
+
+const std::size_t kIntBlockSize = 128;
+
+// SIMD loads may read up to this many bytes past the end of the data.
+const std::size_t kIntDataPadding = 16;
+
+inline uint32_t BitWidth(const uint32_t value) {
+  return value == 0 ? 0 : 32 - __builtin_clz(value);
+}
+
+// Packs 128 values of bits bits into 4 * bits words: value i goes to the lane
+// i % 4 of the 16-byte groups of words.
+inline void PackBlock(const uint32_t* values, const uint32_t bits,
+                      uint32_t* words) {
+  std::memset(words, 0, 4 * bits * sizeof(uint32_t));
+  for (std::size_t i = 0; i < kIntBlockSize; ++i) {
+    const std::size_t lane = i % 4;
+    const std::size_t bit = (i / 4) * bits;
+    const std::size_t word = bit / 32;
+    const std::size_t shift = bit % 32;
+    const uint64_t value = values[i];
+    words[4 * word + lane] |= static_cast<uint32_t>(value << shift);
+    if (shift + bits > 32) {
+      words[4 * (word + 1) + lane] |=
+          static_cast<uint32_t>(value >> (32 - shift));
+    }
+  }
+}
+
+// Reads value i of a block packed by PackBlock.
+inline uint32_t UnpackOne(const uint32_t* words, const uint32_t bits,
+                          const std::size_t i) {
+  if (bits == 0) {
+    return 0;
+  }
+  const std::size_t lane = i % 4;
+  const std::size_t bit = (i / 4) * bits;
+  const std::size_t word = bit / 32;
+  const std::size_t shift = bit % 32;
+  uint64_t value = words[4 * word + lane] >> shift;
+  if (shift + bits > 32) {
+    value |= static_cast<uint64_t>(words[4 * (word + 1) + lane])
+             << (32 - shift);
+  }
+  return static_cast<uint32_t>(value & ((uint64_t(1) << bits) - 1));
+}
+
+// output[i] = reference + value i of a block packed by PackBlock with Bits
+// bits. Bits is a template argument so that the compiler unrolls the loop
+// with constant shifts.
+template <uint32_t Bits>
+void UnpackBlockWithWidth(const uint32_t* words, const uint32_t reference,
+                          uint32_t* output) {
+#if defined(__SSE2__)
+  const __m128i base = _mm_set1_epi32(static_cast<int>(reference));
+  const __m128i mask = _mm_set1_epi32(
+      static_cast<int>(Bits == 32 ? ~0u : (1u << Bits) - 1));
+  const __m128i* in = reinterpret_cast<const __m128i*>(words);
+  __m128i* out = reinterpret_cast<__m128i*>(output);
+#pragma GCC unroll 32
+  for (uint32_t i = 0; i < kIntBlockSize / 4; ++i) {
+    if (Bits == 0) {
+      _mm_storeu_si128(out + i, base);
+      continue;
+    }
+    const uint32_t word = i * Bits / 32;
+    const uint32_t shift = i * Bits % 32;
+    // The value may continue in the next word. Taking its low bits either
+    // way avoids a branch: the mask drops them when it does not, and SSE2
+    // shifts by 32 give zero. The next word may be past the block (but not
+    // past the padded data).
+    const __m128i value = _mm_or_si128(
+        _mm_srli_epi32(_mm_loadu_si128(in + word), shift),
+        _mm_slli_epi32(_mm_loadu_si128(in + word + 1), 32 - shift));
+    _mm_storeu_si128(out + i, _mm_add_epi32(_mm_and_si128(value, mask), base));
+  }
+#else
+  for (std::size_t i = 0; i < kIntBlockSize; ++i) {
+    output[i] = reference + UnpackOne(words, Bits, i);
+  }
+#endif  // defined(__SSE2__)
+}
+
+inline void UnpackBlock(const uint32_t* words, const uint32_t bits,
+                        const uint32_t reference, uint32_t* output) {
+  typedef void (*UnpackFunction)(const uint32_t*, uint32_t, uint32_t*);
+  static const UnpackFunction kUnpackFunctions[33] = {
+      &UnpackBlockWithWidth<0>,  &UnpackBlockWithWidth<1>,
+      &UnpackBlockWithWidth<2>,  &UnpackBlockWithWidth<3>,
+      &UnpackBlockWithWidth<4>,  &UnpackBlockWithWidth<5>,
+      &UnpackBlockWithWidth<6>,  &UnpackBlockWithWidth<7>,
+      &UnpackBlockWithWidth<8>,  &UnpackBlockWithWidth<9>,
+      &UnpackBlockWithWidth<10>, &UnpackBlockWithWidth<11>,
+      &UnpackBlockWithWidth<12>, &UnpackBlockWithWidth<13>,
+      &UnpackBlockWithWidth<14>, &UnpackBlockWithWidth<15>,
+      &UnpackBlockWithWidth<16>, &UnpackBlockWithWidth<17>,
+      &UnpackBlockWithWidth<18>, &UnpackBlockWithWidth<19>,
+      &UnpackBlockWithWidth<20>, &UnpackBlockWithWidth<21>,
+      &UnpackBlockWithWidth<22>, &UnpackBlockWithWidth<23>,
+      &UnpackBlockWithWidth<24>, &UnpackBlockWithWidth<25>,
+      &UnpackBlockWithWidth<26>, &UnpackBlockWithWidth<27>,
+      &UnpackBlockWithWidth<28>, &UnpackBlockWithWidth<29>,
+      &UnpackBlockWithWidth<30>, &UnpackBlockWithWidth<31>,
+      &UnpackBlockWithWidth<32>};
+  kUnpackFunctions[bits](words, reference, output);
+}
+
+// Turns the 128 differences of values into values, starting from reference.
+inline void PrefixSum(const uint32_t reference, uint32_t* values) {
+#if defined(__SSE2__)
+  __m128i previous = _mm_set1_epi32(static_cast<int>(reference));
+  __m128i* data = reinterpret_cast<__m128i*>(values);
+  for (std::size_t i = 0; i < kIntBlockSize / 4; ++i) {
+    __m128i sum = _mm_loadu_si128(data + i);
+    // Sums of 1, then 2 lanes to the left: [a, a + b, a + b + c, ...].
+    sum = _mm_add_epi32(sum, _mm_slli_si128(sum, 4));
+    sum = _mm_add_epi32(sum, _mm_slli_si128(sum, 8));
+    sum = _mm_add_epi32(sum, previous);
+    _mm_storeu_si128(data + i, sum);
+    previous = _mm_shuffle_epi32(sum, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+#else
+  uint32_t sum = reference;
+  for (std::size_t i = 0; i < kIntBlockSize; ++i) {
+    sum += values[i];
+    values[i] = sum;
+  }
+#endif  // defined(__SSE2__)
+}
+
+// The bytes of a value in StreamVByte, minus 1 (its 2-bit code).
+inline uint32_t StreamVByteCode(const uint32_t value) {
+  return value < (1u << 8) ? 0 : value < (1u << 16) ? 1 : value < (1u << 24)
+                                                              ? 2
+                                                              : 3;
+}
+
+// Writes 128 values as 32 control bytes (4 codes each) and their bytes.
+// Returns the bytes written.
+inline std::size_t EncodeStreamVByte(const uint32_t* values, uint8_t* output) {
+  uint8_t* control = output;
+  uint8_t* data = output + kIntBlockSize / 4;
+  for (std::size_t i = 0; i < kIntBlockSize; i += 4) {
+    uint8_t codes = 0;
+    for (std::size_t k = 0; k < 4; ++k) {
+      const uint32_t code = StreamVByteCode(values[i + k]);
+      codes |= static_cast<uint8_t>(code << (2 * k));
+      // Little endian, as the decoder's shuffle expects.
+      for (uint32_t byte = 0; byte <= code; ++byte) {
+        *data++ = static_cast<uint8_t>(values[i + k] >> (8 * byte));
+      }
+    }
+    *control++ = codes;
+  }
+  return data - output;
+}
+
+// The shuffles that move the bytes of 4 values (given their control byte) to
+// their 4 lanes, and the number of bytes.
+struct StreamVByteTables {
+  StreamVByteTables() {
+    for (int control = 0; control < 256; ++control) {
+      uint8_t byte = 0;
+      for (int k = 0; k < 4; ++k) {
+        const int size = ((control >> (2 * k)) & 3) + 1;
+        for (int i = 0; i < 4; ++i) {
+          // 0x80 makes the shuffle write a zero.
+          shuffles[control][4 * k + i] = i < size ? byte++ : 0x80;
+        }
+      }
+      lengths[control] = byte;
+    }
+  }
+
+  uint8_t shuffles[256][16];
+  uint8_t lengths[256];
+};
+
+inline const StreamVByteTables& GetStreamVByteTables() {
+  static const StreamVByteTables tables;
+  return tables;
+}
+
+// Decodes 128 values written by EncodeStreamVByte.
+inline void DecodeStreamVByte(const uint8_t* input, uint32_t* output) {
+  const uint8_t* control = input;
+  const uint8_t* data = input + kIntBlockSize / 4;
+#if defined(__SSSE3__)
+  const StreamVByteTables& tables = GetStreamVByteTables();
+  for (std::size_t i = 0; i < kIntBlockSize; i += 4) {
+    const uint8_t codes = *control++;
+    const __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    const __m128i shuffle = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(tables.shuffles[codes]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i),
+                     _mm_shuffle_epi8(bytes, shuffle));
+    data += tables.lengths[codes];
+  }
+#else
+  // Reads 4 bytes (the data is padded) of a little-endian machine and keeps
+  // the ones of the value.
+  static const uint32_t kMasks[4] = {0xFF, 0xFFFF, 0xFFFFFF, 0xFFFFFFFF};
+  for (std::size_t i = 0; i < kIntBlockSize; i += 4) {
+    const uint8_t codes = *control++;
+    for (std::size_t k = 0; k < 4; ++k) {
+      const uint32_t code = (codes >> (2 * k)) & 3;
+      uint32_t value;
+      std::memcpy(&value, data, sizeof(value));
+      output[i + k] = value & kMasks[code];
+      data += code + 1;
+    }
+  }
+#endif  // defined(__SSSE3__)
+}
+
+}  // namespace internal
+
+class CompressedIntSequence {
+ public:
+  typedef uint32_t value_type;
+  typedef std::size_t size_type;
+
+  // Forward iterator; it decodes a block at a time into a buffer of its own.
+  class const_iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef uint32_t value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const uint32_t* pointer;
+    typedef const uint32_t& reference;
+
+    const_iterator(const CompressedIntSequence* sequence,
+                   const std::size_t index)
+        : sequence_(sequence), index_(index) {
+      if (index_ < sequence_->size_) {
+        sequence_->DecodeBlock(index_ / internal::kIntBlockSize, buffer_);
+      }
+    }
+
+    reference operator*() const {
+      return buffer_[index_ % internal::kIntBlockSize];
+    }
+    pointer operator->() const { return &**this; }
+
+    const_iterator& operator++() {
+      if (++index_ % internal::kIntBlockSize == 0 &&
+          index_ < sequence_->size_) {
+        sequence_->DecodeBlock(index_ / internal::kIntBlockSize, buffer_);
+      }
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      ++*this;
+      return old;
+    }
+    bool operator==(const const_iterator& other) const {
+      return index_ == other.index_;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return index_ != other.index_;
+    }
+
+   private:
+    const CompressedIntSequence* sequence_;
+    std::size_t index_;
+    uint32_t buffer_[internal::kIntBlockSize];
+  };
+
+  CompressedIntSequence()
+      : encoding_(IntEncoding::kFrameOfReference), size_(0) {}
+
+  CompressedIntSequence(const uint32_t* values, const std::size_t size,
+                        const IntEncoding encoding)
+      : encoding_(encoding), size_(size) {
+    const std::size_t num_blocks =
+        (size + internal::kIntBlockSize - 1) / internal::kIntBlockSize;
+    blocks_.reserve(num_blocks);
+    uint32_t block[internal::kIntBlockSize];
+    uint32_t encoded[internal::kIntBlockSize + internal::kIntBlockSize / 4];
+    uint32_t previous = 0;
+    for (std::size_t begin = 0; begin < size;
+         begin += internal::kIntBlockSize) {
+      // The last block is padded with its last value.
+      const std::size_t count = size - begin < internal::kIntBlockSize
+                                    ? size - begin
+                                    : internal::kIntBlockSize;
+      for (std::size_t i = 0; i < internal::kIntBlockSize; ++i) {
+        block[i] = values[begin + (i < count ? i : count - 1)];
+      }
+      BlockHeader header;
+      header.offset = data_.size();
+      header.first = block[0];
+      header.reference = 0;
+      header.bits = 0;
+      if (encoding_ == IntEncoding::kFrameOfReference) {
+        header.reference = block[0];
+        for (const uint32_t value : block) {
+          if (value < header.reference) {
+            header.reference = value;
+          }
+        }
+      } else if (IsDelta()) {
+        header.reference = previous;
+      }
+      previous = block[internal::kIntBlockSize - 1];
+      // The differences from the reference or the previous value.
+      for (std::size_t i = internal::kIntBlockSize; i-- > 0;) {
+        block[i] -= IsDelta() ? (i == 0 ? header.reference : block[i - 1])
+                              : header.reference;
+      }
+      std::size_t bytes = 0;
+      if (IsBitPacked()) {
+        uint32_t all_bits = 0;
+        for (const uint32_t value : block) {
+          all_bits |= value;
+        }
+        header.bits = internal::BitWidth(all_bits);
+        internal::PackBlock(block, header.bits, encoded);
+        bytes = 4 * header.bits * sizeof(uint32_t);
+      } else {
+        bytes = internal::EncodeStreamVByte(
+            block, reinterpret_cast<uint8_t*>(encoded));
+      }
+      data_.insert(data_.end(), reinterpret_cast<const uint8_t*>(encoded),
+                   reinterpret_cast<const uint8_t*>(encoded) + bytes);
+      blocks_.push_back(header);
+    }
+    data_.resize(data_.size() + internal::kIntDataPadding);
+    data_.shrink_to_fit();
+  }
+
+  explicit CompressedIntSequence(const std::vector<uint32_t>& values,
+                                 const IntEncoding encoding =
+                                     IntEncoding::kDeltaBitPacked)
+      : CompressedIntSequence(values.data(), values.size(), encoding) {}
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  IntEncoding encoding() const { return encoding_; }
+
+  // Bytes of the compressed data and of the skip index.
+  std::size_t bytes() const {
+    return data_.capacity() + blocks_.capacity() * sizeof(BlockHeader);
+  }
+
+  std::size_t num_blocks() const { return blocks_.size(); }
+
+  // Writes the kIntBlockSize values of a block to output (the last block is
+  // padded with its last value).
+  void DecodeBlock(const std::size_t block, uint32_t* output) const {
+    const BlockHeader& header = blocks_[block];
+    const uint8_t* data = data_.data() + header.offset;
+    if (IsBitPacked()) {
+      internal::UnpackBlock(reinterpret_cast<const uint32_t*>(data),
+                            header.bits, IsDelta() ? 0 : header.reference,
+                            output);
+    } else {
+      internal::DecodeStreamVByte(data, output);
+    }
+    if (IsDelta()) {
+      internal::PrefixSum(header.reference, output);
+    }
+  }
+
+  // Writes all the values to output, which has room for size() of them.
+  void Decode(uint32_t* output) const {
+    const std::size_t full_blocks = size_ / internal::kIntBlockSize;
+    for (std::size_t block = 0; block < full_blocks; ++block) {
+      DecodeBlock(block, output + block * internal::kIntBlockSize);
+    }
+    if (full_blocks < blocks_.size()) {
+      uint32_t last[internal::kIntBlockSize];
+      DecodeBlock(full_blocks, last);
+      std::memcpy(output + full_blocks * internal::kIntBlockSize, last,
+                  (size_ % internal::kIntBlockSize) * sizeof(uint32_t));
+    }
+  }
+
+  uint32_t operator[](const std::size_t index) const {
+    const std::size_t block = index / internal::kIntBlockSize;
+    const BlockHeader& header = blocks_[block];
+    if (encoding_ == IntEncoding::kFrameOfReference) {
+      return header.reference +
+             internal::UnpackOne(
+                 reinterpret_cast<const uint32_t*>(data_.data() +
+                                                   header.offset),
+                 header.bits, index % internal::kIntBlockSize);
+    }
+    uint32_t values[internal::kIntBlockSize];
+    DecodeBlock(block, values);
+    return values[index % internal::kIntBlockSize];
+  }
+
+  // For sorted values: the index of the first value >= value, or size().
+  // Binary search on the first values of the blocks, then in one block.
+  std::size_t LowerBound(const uint32_t value) const {
+    std::size_t low = 0;
+    std::size_t high = blocks_.size();
+    // The first block whose first value is >= value.
+    while (low < high) {
+      const std::size_t middle = low + (high - low) / 2;
+      if (blocks_[middle].first < value) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+    if (low == 0) {
+      return 0;
+    }
+    // The value is in the block before, or is the first of block low.
+    uint32_t values[internal::kIntBlockSize];
+    DecodeBlock(low - 1, values);
+    std::size_t i = 0;
+    while (i < internal::kIntBlockSize && values[i] < value) {
+      ++i;
+    }
+    const std::size_t index = (low - 1) * internal::kIntBlockSize + i;
+    return index < size_ ? index : size_;
+  }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size_); }
+
+  // Returns the values as a std::vector.
+  std::vector<uint32_t> ToVector() const {
+    std::vector<uint32_t> values(size_);
+    Decode(values.data());
+    return values;
+  }
+
+ private:
+  // An entry of the skip index.
+  struct BlockHeader {
+    // Where the block starts in data_.
+    uint64_t offset;
+    // The first value of the block.
+    uint32_t first;
+    // Frame of reference: the smallest value. Delta: the value before the
+    // block.
+    uint32_t reference;
+    // Bits per value of the bit-packed encodings.
+    uint32_t bits;
+  };
+
+  bool IsDelta() const {
+    return encoding_ == IntEncoding::kDeltaBitPacked ||
+           encoding_ == IntEncoding::kDeltaStreamVByte;
+  }
+  bool IsBitPacked() const {
+    return encoding_ == IntEncoding::kFrameOfReference ||
+           encoding_ == IntEncoding::kDeltaBitPacked;
+  }
+
+  IntEncoding encoding_;
+  std::size_t size_;
+  std::vector<BlockHeader> blocks_;
+  // The blocks, and kIntDataPadding bytes for the SIMD loads.
+  std::vector<uint8_t> data_;
+};
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_COMPRESSED_INT_SEQUENCE_H_
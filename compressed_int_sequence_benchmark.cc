@@ -0,0 +1,296 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary compares the encodings of compressed_int_sequence.h against a
+// plain std::vector of 32-bit integers.
+//
+// Usage: compressed_int_sequence_benchmark [num_ints]
+//   Default: num_ints = 16M.
+//
+// For four kinds of data:
+//
+// 1. sorted dense: sorted ids 1 to 7 apart (like the ids of a posting list).
+// 2. sorted sparse: sorted ids 1 to 2000 apart (less if they would not fit
+// in 32 bits).
+// 3. random small: random values below 1024.
+// 4. random: random 32-bit values.
+//
+// it reports, for each encoding:
+//
+// - bits per integer and the compression ratio against 32-bit integers,
+// - decoding speed in billions of integers per second: with Decode into an
+// array (which the memory bandwidth limits, as for a copy of the vector),
+// with DecodeBlock into a buffer that stays in the cache, and with the
+// iterator (summing the values),
+// - nanoseconds to read one value at a random index (operator[]), and for
+// sorted data to find one with LowerBound (std::lower_bound for the vector).
+//
+// A "mismatch" marks encodings that do not give back the original values.
+//
+// Build with -DBUILD_WITH_NATIVE_ARCH=ON for the SSSE3 decoding of
+// StreamVByte.
+
+#include <algorithm>  // Header for std::lower_bound.
+#include <cstdint>  // Header for uint32_t.
+#include <cstring>  // Header for std::memcpy.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <string>  // Header for std::string.
+#include <vector>  // Header for std::vector.
+
+#include "benchmark_utils.h"
+#include "compressed_int_sequence.h"
+
+namespace {
+
+typedef std::vector<uint32_t> Ints;
+
+// Fast random numbers.
+inline uint64_t NextRandom(uint64_t* state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+// Sorted values from 1 to max_gap apart.
+Ints SortedInts(const std::size_t n, const uint32_t max_gap, uint64_t seed) {
+  Ints values(n);
+  uint32_t value = 0;
+  for (uint32_t& v : values) {
+    value += 1 + static_cast<uint32_t>(NextRandom(&seed) % max_gap);
+    v = value;
+  }
+  return values;
+}
+
+// Random values below limit (or any 32-bit values when limit is 0).
+Ints RandomInts(const std::size_t n, const uint64_t limit, uint64_t seed) {
+  Ints values(n);
+  for (uint32_t& v : values) {
+    const uint64_t random = NextRandom(&seed);
+    v = static_cast<uint32_t>(limit == 0 ? random : random % limit);
+  }
+  return values;
+}
+
+// Seconds of the fastest of a few runs of function.
+template <typename Function>
+double BestSeconds(const Function& function) {
+  double best = 1e30;
+  for (int i = 0; i < 3; ++i) {
+    cpp_labs::Timer timer;
+    function();
+    best = std::min(best, timer.ElapsedSeconds());
+  }
+  return best;
+}
+
+const std::size_t kNumLookups = 1 << 20;
+
+// The measurements of one row.
+struct Row {
+  double bits_per_int;
+  double decode_seconds;
+  double block_decode_seconds;
+  double iterate_seconds;
+  double access_seconds;
+  double lower_bound_seconds;  // Negative if not applicable.
+  bool mismatch;
+};
+
+void PrintRow(const std::string& name, const std::size_t n, const Row& row) {
+  std::cout << std::setw(22) << name << std::fixed << std::setprecision(2)
+            << std::setw(9) << row.bits_per_int << std::setw(8)
+            << 32.0 / row.bits_per_int << std::setw(10)
+            << n / row.decode_seconds / 1e9 << std::setw(10)
+            << n / row.block_decode_seconds / 1e9 << std::setw(10)
+            << n / row.iterate_seconds / 1e9 << std::setw(10)
+            << row.access_seconds / kNumLookups * 1e9;
+  if (row.lower_bound_seconds < 0.0) {
+    std::cout << std::setw(13) << "-";
+  } else {
+    std::cout << std::setw(13)
+              << row.lower_bound_seconds / kNumLookups * 1e9;
+  }
+  std::cout << (row.mismatch ? "  mismatch" : "") << std::endl;
+}
+
+// Measures the plain vector: a copy is its "decoding".
+Row MeasureVector(const Ints& values, const Ints& indexes, const bool sorted,
+                  Ints* output) {
+  Row row;
+  row.bits_per_int = 32.0;
+  row.decode_seconds = BestSeconds([&]() {
+    std::memcpy(output->data(), values.data(),
+                values.size() * sizeof(uint32_t));
+    cpp_labs::DoNotOptimize(output->data());
+  });
+  row.block_decode_seconds = BestSeconds([&]() {
+    uint32_t buffer[cpp_labs::internal::kIntBlockSize];
+    for (std::size_t begin = 0; begin < values.size();
+         begin += cpp_labs::internal::kIntBlockSize) {
+      const std::size_t count =
+          std::min(values.size() - begin, cpp_labs::internal::kIntBlockSize);
+      std::memcpy(buffer, values.data() + begin, count * sizeof(uint32_t));
+      cpp_labs::DoNotOptimize(&buffer[0]);
+    }
+  });
+  row.iterate_seconds = BestSeconds([&]() {
+    uint32_t sum = 0;
+    for (const uint32_t value : values) {
+      sum += value;
+    }
+    cpp_labs::DoNotOptimize(sum);
+  });
+  row.access_seconds = BestSeconds([&]() {
+    uint32_t sum = 0;
+    for (const uint32_t index : indexes) {
+      sum += values[index];
+    }
+    cpp_labs::DoNotOptimize(sum);
+  });
+  row.lower_bound_seconds = -1.0;
+  if (sorted) {
+    row.lower_bound_seconds = BestSeconds([&]() {
+      std::size_t sum = 0;
+      for (const uint32_t index : indexes) {
+        sum += std::lower_bound(values.begin(), values.end(), values[index]) -
+               values.begin();
+      }
+      cpp_labs::DoNotOptimize(sum);
+    });
+  }
+  row.mismatch = false;
+  return row;
+}
+
+Row MeasureEncoding(const Ints& values, const Ints& indexes, const bool sorted,
+                    const cpp_labs::IntEncoding encoding, Ints* output) {
+  const cpp_labs::CompressedIntSequence sequence(values.data(), values.size(),
+                                                 encoding);
+  Row row;
+  row.bits_per_int = 8.0 * sequence.bytes() / values.size();
+  row.decode_seconds = BestSeconds([&]() {
+    sequence.Decode(output->data());
+    cpp_labs::DoNotOptimize(output->data());
+  });
+  row.mismatch = *output != values;
+  row.block_decode_seconds = BestSeconds([&]() {
+    uint32_t buffer[cpp_labs::internal::kIntBlockSize];
+    for (std::size_t block = 0; block < sequence.num_blocks(); ++block) {
+      sequence.DecodeBlock(block, buffer);
+      cpp_labs::DoNotOptimize(&buffer[0]);
+    }
+  });
+  uint32_t expected_sum = 0;
+  for (const uint32_t value : values) {
+    expected_sum += value;
+  }
+  uint32_t sum = 0;
+  row.iterate_seconds = BestSeconds([&]() {
+    uint32_t local_sum = 0;
+    for (const uint32_t value : sequence) {
+      local_sum += value;
+    }
+    sum = local_sum;
+    cpp_labs::DoNotOptimize(sum);
+  });
+  row.mismatch |= sum != expected_sum;
+  bool access_mismatch = false;
+  row.access_seconds = BestSeconds([&]() {
+    for (const uint32_t index : indexes) {
+      access_mismatch |= sequence[index] != values[index];
+    }
+  });
+  row.mismatch |= access_mismatch;
+  row.lower_bound_seconds = -1.0;
+  if (sorted) {
+    bool lower_bound_mismatch = false;
+    row.lower_bound_seconds = BestSeconds([&]() {
+      for (const uint32_t index : indexes) {
+        // The values are distinct, so the first >= values[index] is index.
+        lower_bound_mismatch |= sequence.LowerBound(values[index]) != index;
+      }
+    });
+    row.mismatch |= lower_bound_mismatch;
+  }
+  return row;
+}
+
+void CompareEncodings(const std::string& name, const Ints& values,
+                      const bool sorted) {
+  uint64_t seed = 42;
+  Ints indexes(kNumLookups);
+  for (uint32_t& index : indexes) {
+    index = static_cast<uint32_t>(NextRandom(&seed) % values.size());
+  }
+  Ints output(values.size());
+  std::cout << name << std::endl;
+  PrintRow("std::vector", values.size(),
+           MeasureVector(values, indexes, sorted, &output));
+  const cpp_labs::IntEncoding encodings[] = {
+      cpp_labs::IntEncoding::kFrameOfReference,
+      cpp_labs::IntEncoding::kDeltaBitPacked,
+      cpp_labs::IntEncoding::kStreamVByte,
+      cpp_labs::IntEncoding::kDeltaStreamVByte};
+  for (const cpp_labs::IntEncoding encoding : encodings) {
+    PrintRow(cpp_labs::IntEncodingName(encoding), values.size(),
+             MeasureEncoding(values, indexes, sorted, encoding, &output));
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t n = cpp_labs::ParseSizeArgument(argc, argv, 1, 1 << 24);
+  if (n == 0) {
+    std::cerr << "num_ints must be positive" << std::endl;
+    return 1;
+  }
+  std::cout << n << " integers; decoding in billions of integers per second, "
+            << "access and lower bound in nanoseconds" << std::endl;
+  std::cout << std::setw(22) << "encoding" << std::setw(9) << "bits/int"
+            << std::setw(8) << "ratio" << std::setw(10) << "decode"
+            << std::setw(10) << "in cache"
+            << std::setw(10) << "iterate" << std::setw(10) << "access"
+            << std::setw(13) << "lower bound" << std::endl;
+  CompareEncodings("sorted dense", SortedInts(n, 7, 1), true);
+  const uint64_t sparse_gap = std::min<uint64_t>(2000, UINT32_MAX / n);
+  CompareEncodings("sorted sparse",
+                   SortedInts(n, static_cast<uint32_t>(sparse_gap), 2), true);
+  CompareEncodings("random small", RandomInts(n, 1024, 3), false);
+  CompareEncodings("random", RandomInts(n, 0, 4), false);
+  return 0;
+}
@@ -0,0 +1,238 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_COMPRESSED_PTR_H_
+#define CPP_LABS_COMPRESSED_PTR_H_
+
+// CompressedPtr<T> is a 32-bit pointer. Instead of a 64-bit address it stores
+// the index of an object inside CompressedArena<T>, a region of virtual memory
+// reserved once for all the objects of type T. Dereferencing adds the index to
+// the base address of the arena, which is one extra addition per access.
+//
+// In node-based containers (trees, lists, hash chains) the pointers are most
+// of the memory of a node. For example, a tree node with an int key and two
+// children takes 24 bytes with raw pointers but 12 bytes with compressed
+// pointers, so twice as many nodes fit in each cache line and each page.
+//
+// CompressedPtr supports the operations that pointers_example.cc shows for raw
+// pointers: '*', '->', comparison against nullptr, and arithmetic (which moves
+// by whole objects inside the arena, as for arrays).
+//
+// Example:
+//   CompressedPtr<Node> node = CompressedArena<Node>::New();
+//   node->key = 4;
+//   CompressedArena<Node>::Delete(node);
+//
+// Limitations: there is one arena per type, it holds at most 2^32 - 1 objects
+// and it is not thread safe.
+
+#include <sys/mman.h>  // Header for mmap.
+
+#include <cassert>  // Header for assert.
+#include <cstddef>  // Header for std::size_t and std::nullptr_t.
+#include <cstdint>  // Header for uint32_t.
+#include <new>  // Header for std::bad_alloc and placement new.
+#include <utility>  // Header for std::forward.
+
+namespace cpp_labs {
+
+template <typename T>
+class CompressedPtr;
+
+// Owns the memory of all the objects of type T addressed by CompressedPtr<T>.
+// The whole index range is reserved up front as virtual memory, so the base
+// address never changes; physical pages are only used once they are touched.
+template <typename T>
+class CompressedArena {
+ public:
+  static_assert(sizeof(T) >= sizeof(uint32_t),
+                "Freed slots store the index of the next free slot.");
+
+  // Default number of slots reserved by the first allocation.
+  static const std::size_t kDefaultMaxObjects = std::size_t(1) << 28;
+
+  // Reserves room for max_objects objects. Only has an effect before the
+  // first allocation.
+  static void Reserve(const std::size_t max_objects) {
+    if (base_ == nullptr) {
+      assert(max_objects < (std::size_t(1) << 32));
+      max_objects_ = max_objects + 1;
+      void* memory = mmap(nullptr, max_objects_ * sizeof(T),
+                          PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if (memory == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+      base_ = static_cast<T*>(memory);
+      // Slot 0 is never used: index 0 is the null pointer.
+      next_unused_ = 1;
+    }
+  }
+
+  // Creates a T in the arena.
+  template <typename... Arguments>
+  static CompressedPtr<T> New(Arguments&&... arguments) {
+    Reserve(kDefaultMaxObjects);
+    uint32_t index = free_list_;
+    if (index != 0) {
+      free_list_ = *reinterpret_cast<uint32_t*>(base_ + index);
+    } else {
+      if (next_unused_ == max_objects_) {
+        throw std::bad_alloc();
+      }
+      index = static_cast<uint32_t>(next_unused_++);
+    }
+    ::new (static_cast<void*>(base_ + index))
+        T(std::forward<Arguments>(arguments)...);
+    ++num_objects_;
+    return CompressedPtr<T>::FromIndex(index);
+  }
+
+  // Destroys the object and recycles its slot.
+  static void Delete(const CompressedPtr<T> pointer) {
+    if (pointer == nullptr) {
+      return;
+    }
+    const uint32_t index = pointer.index();
+    base_[index].~T();
+    *reinterpret_cast<uint32_t*>(base_ + index) = free_list_;
+    free_list_ = index;
+    --num_objects_;
+  }
+
+  static T* Base() { return base_; }
+  static std::size_t num_objects() { return num_objects_; }
+  // Bytes of the slots handed out so far (live or recycled).
+  static std::size_t bytes_used() { return next_unused_ * sizeof(T); }
+
+ private:
+  static T* base_;
+  static std::size_t max_objects_;
+  static std::size_t next_unused_;
+  static std::size_t num_objects_;
+  // Index of the first recycled slot, 0 when there is none.
+  static uint32_t free_list_;
+};
+
+template <typename T>
+const std::size_t CompressedArena<T>::kDefaultMaxObjects;
+template <typename T>
+T* CompressedArena<T>::base_ = nullptr;
+template <typename T>
+std::size_t CompressedArena<T>::max_objects_ = 0;
+template <typename T>
+std::size_t CompressedArena<T>::next_unused_ = 0;
+template <typename T>
+std::size_t CompressedArena<T>::num_objects_ = 0;
+template <typename T>
+uint32_t CompressedArena<T>::free_list_ = 0;
+
+template <typename T>
+class CompressedPtr {
+ public:
+  CompressedPtr() : index_(0) {}
+  CompressedPtr(std::nullptr_t) : index_(0) {}
+
+  // pointer must point to an object of CompressedArena<T> (or be null).
+  explicit CompressedPtr(T* pointer)
+      : index_(pointer == nullptr
+                   ? 0
+                   : static_cast<uint32_t>(pointer -
+                                           CompressedArena<T>::Base())) {}
+
+  static CompressedPtr FromIndex(const uint32_t index) {
+    CompressedPtr pointer;
+    pointer.index_ = index;
+    return pointer;
+  }
+
+  // Expands the pointer into a raw pointer.
+  T* get() const {
+    return index_ == 0 ? nullptr : CompressedArena<T>::Base() + index_;
+  }
+  uint32_t index() const { return index_; }
+
+  T& operator*() const { return CompressedArena<T>::Base()[index_]; }
+  T* operator->() const { return CompressedArena<T>::Base() + index_; }
+  explicit operator bool() const { return index_ != 0; }
+
+  // Arithmetic moves by whole objects, as with raw pointers into an array.
+  CompressedPtr& operator++() { ++index_; return *this; }
+  CompressedPtr& operator--() { --index_; return *this; }
+  CompressedPtr operator++(int) {
+    const CompressedPtr old = *this;
+    ++index_;
+    return old;
+  }
+  CompressedPtr operator--(int) {
+    const CompressedPtr old = *this;
+    --index_;
+    return old;
+  }
+  CompressedPtr& operator+=(const std::ptrdiff_t offset) {
+    index_ = static_cast<uint32_t>(index_ + offset);
+    return *this;
+  }
+  CompressedPtr& operator-=(const std::ptrdiff_t offset) {
+    index_ = static_cast<uint32_t>(index_ - offset);
+    return *this;
+  }
+  CompressedPtr operator+(const std::ptrdiff_t offset) const {
+    return FromIndex(static_cast<uint32_t>(index_ + offset));
+  }
+  CompressedPtr operator-(const std::ptrdiff_t offset) const {
+    return FromIndex(static_cast<uint32_t>(index_ - offset));
+  }
+  std::ptrdiff_t operator-(const CompressedPtr& other) const {
+    return static_cast<std::ptrdiff_t>(index_) -
+           static_cast<std::ptrdiff_t>(other.index_);
+  }
+
+  bool operator==(const CompressedPtr& other) const {
+    return index_ == other.index_;
+  }
+  bool operator!=(const CompressedPtr& other) const {
+    return index_ != other.index_;
+  }
+  bool operator<(const CompressedPtr& other) const {
+    return index_ < other.index_;
+  }
+
+ private:
+  uint32_t index_;
+};
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_COMPRESSED_PTR_H_
@@ -0,0 +1,465 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_CONCURRENT_SKIP_LIST_H_
+#define CPP_LABS_CONCURRENT_SKIP_LIST_H_
+
+// An ordered map (and set) that many threads can use at once: lookups and
+// in-order iteration take no locks, and insertions and erasures lock only the
+// few nodes they change.
+//
+// std::set and std::map (set_example.cc, map_example.cc) are red-black trees;
+// an insertion may rotate nodes up to the root, so a shared tree needs a lock
+// around every operation (a std::shared_mutex lets readers share it, but they
+// still write the lock's counter, a cache line that every core fights over).
+// A skip list keeps the keys in a sorted linked list, plus sparser lists
+// above it (each node is in the lists of levels 0 to its random height) to
+// skip ahead in O(log n). Changes are local: an insertion links one node into
+// its predecessors at each level, so it only needs to lock those.
+//
+// This is the "lazy" skip list of Herlihy, Lev, Luchangco and Shavit (2007):
+// 1. A lookup walks the lists without locks and checks two flags of the node
+// it finds: fully_linked (the insertion finished) and marked (erased).
+// 2. An insertion locks the predecessors of the new node (bottom-up), checks
+// that they are still unmarked and still point to the successors it saw, and
+// links the node; otherwise it unlocks and retries.
+// 3. An erasure locks and marks the node (it is erased from then on), then
+// locks and validates the predecessors as above and unlinks it.
+// 4. Erased nodes are retired to an EpochDomain (memory_reclamation.h) and
+// deleted once no reader can still be looking at them.
+//
+// Usage (every thread has its own ThreadContext):
+//
+//   cpp_labs::ConcurrentSkipListSet<int> my_set;
+//   // In each thread:
+//   cpp_labs::ConcurrentSkipListSet<int>::ThreadContext context(
+//       my_set.domain());
+//   my_set.insert(&context, 4);
+//   if (my_set.contains(&context, 4)) { ... }
+//   my_set.ForEach(&context, [](const int key) { ... });  // In order.
+//   my_set.erase(&context, 4);
+//
+// Notes:
+//
+// 1. Iteration is weakly consistent, as with any lock-free structure: it sees
+// every key that is in the set for the whole iteration, in order, and may or
+// may not see keys inserted or erased meanwhile.
+// 2. Values are set by the insertion and never change, so reading them needs
+// no lock either. Keys and values must be default constructible (for the head
+// node) and copyable.
+// 3. The ThreadContexts must be destroyed before the skip list.
+
+#include <atomic>  // Header for std::atomic.
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for uint64_t.
+#include <new>  // Header for operator new and placement new.
+#include <thread>  // Header for std::this_thread::yield.
+
+#include "futex_event.h"
+#include "memory_reclamation.h"
+
+namespace cpp_labs {
+namespace internal {
+
+// A test-and-test-and-set lock for a node. It yields after a few spins, as
+// the holder may be waiting for a CPU.
+class NodeLock {
+ public:
+  NodeLock() : locked_(false) {}
+
+  void lock() {
+    int spins = 0;
+    while (locked_.load(std::memory_order_relaxed) ||
+           locked_.exchange(true, std::memory_order_acquire)) {
+      if (++spins < 64) {
+        CpuRelax();
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  void unlock() { locked_.store(false, std::memory_order_release); }
+
+ private:
+  std::atomic<bool> locked_;
+};
+
+// No value, for sets.
+struct EmptyValue {};
+
+}  // namespace internal
+
+template <typename Key, typename Value>
+class ConcurrentSkipListMap {
+ public:
+  typedef EpochDomain::ThreadContext ThreadContext;
+
+  // Levels 0 to kMaxHeight - 1; a node reaches level i with probability 4^-i,
+  // so 16 levels keep lookups logarithmic up to ~4 billion keys.
+  static const int kMaxHeight = 16;
+
+  ConcurrentSkipListMap() : head_(Node::Create(Key(), Value(), kMaxHeight)),
+                            size_(0) {
+    head_->fully_linked.store(true, std::memory_order_relaxed);
+  }
+
+  // Deletes every node; no thread may use the map anymore.
+  ~ConcurrentSkipListMap() {
+    Node* node = head_;
+    while (node != nullptr) {
+      Node* next = node->next(0).load(std::memory_order_relaxed);
+      delete node;
+      node = next;
+    }
+  }
+
+  ConcurrentSkipListMap(const ConcurrentSkipListMap&) = delete;
+  ConcurrentSkipListMap& operator=(const ConcurrentSkipListMap&) = delete;
+
+  // The domain to create the ThreadContexts from.
+  EpochDomain* domain() { return &domain_; }
+
+  // Inserts key with value, unless key is in the map already (its value does
+  // not change then). Returns whether it was inserted.
+  bool insert(ThreadContext* context, const Key& key, const Value& value) {
+    const int height = RandomHeight();
+    Node* preds[kMaxHeight];
+    Node* succs[kMaxHeight];
+    EpochDomain::Guard guard(context);
+    while (true) {
+      const int found_level = FindPath(key, preds, succs);
+      if (found_level >= 0) {
+        Node* node = succs[found_level];
+        if (!node->marked.load(std::memory_order_acquire)) {
+          // Being inserted by another thread: wait until it is in the map.
+          while (!node->fully_linked.load(std::memory_order_acquire)) {
+            CpuRelax();
+          }
+          return false;
+        }
+        // Being erased: try again once it is unlinked.
+        continue;
+      }
+      int num_locked = 0;
+      Node* locked[kMaxHeight];
+      bool valid = true;
+      for (int level = 0; valid && level < height; ++level) {
+        Node* pred = preds[level];
+        // The same node may precede the key at several levels.
+        if (num_locked == 0 || locked[num_locked - 1] != pred) {
+          pred->lock.lock();
+          locked[num_locked++] = pred;
+        }
+        Node* succ = succs[level];
+        valid = !pred->marked.load(std::memory_order_acquire) &&
+                (succ == nullptr ||
+                 !succ->marked.load(std::memory_order_acquire)) &&
+                pred->next(level).load(std::memory_order_acquire) == succ;
+      }
+      if (valid) {
+        Node* node = Node::Create(key, value, height);
+        for (int level = 0; level < height; ++level) {
+          node->next(level).store(succs[level], std::memory_order_relaxed);
+        }
+        // Readers may reach the node from here on.
+        for (int level = 0; level < height; ++level) {
+          preds[level]->next(level).store(node, std::memory_order_release);
+        }
+        node->fully_linked.store(true, std::memory_order_release);
+        size_.fetch_add(1, std::memory_order_relaxed);
+      }
+      Unlock(locked, num_locked);
+      if (valid) {
+        return true;
+      }
+    }
+  }
+
+  // Returns whether key was in the map (and erases it).
+  bool erase(ThreadContext* context, const Key& key) {
+    Node* preds[kMaxHeight];
+    Node* succs[kMaxHeight];
+    Node* victim = nullptr;
+    EpochDomain::Guard guard(context);
+    while (true) {
+      const int found_level = FindPath(key, preds, succs);
+      if (victim == nullptr) {
+        // Only a node that is fully inserted, and found at its top level
+        // (i.e., the search did not see a half-linked one), can be erased.
+        if (found_level < 0) {
+          return false;
+        }
+        Node* node = succs[found_level];
+        if (!node->fully_linked.load(std::memory_order_acquire) ||
+            node->height != found_level + 1 ||
+            node->marked.load(std::memory_order_acquire)) {
+          return false;
+        }
+        node->lock.lock();
+        if (node->marked.load(std::memory_order_relaxed)) {
+          node->lock.unlock();
+          return false;
+        }
+        // The key is erased from here on; the node stays locked so that no
+        // insertion links a node after it.
+        node->marked.store(true, std::memory_order_release);
+        victim = node;
+      }
+      int num_locked = 0;
+      Node* locked[kMaxHeight];
+      bool valid = true;
+      for (int level = 0; valid && level < victim->height; ++level) {
+        Node* pred = preds[level];
+        if (num_locked == 0 || locked[num_locked - 1] != pred) {
+          pred->lock.lock();
+          locked[num_locked++] = pred;
+        }
+        valid = !pred->marked.load(std::memory_order_acquire) &&
+                pred->next(level).load(std::memory_order_acquire) == victim;
+      }
+      if (valid) {
+        for (int level = victim->height - 1; level >= 0; --level) {
+          preds[level]->next(level).store(
+              victim->next(level).load(std::memory_order_relaxed),
+              std::memory_order_release);
+        }
+        size_.fetch_sub(1, std::memory_order_relaxed);
+      }
+      Unlock(locked, num_locked);
+      if (valid) {
+        victim->lock.unlock();
+        // Readers that entered before the unlinking may still read it.
+        context->retire(victim);
+        return true;
+      }
+    }
+  }
+
+  // Returns whether key is in the map, and its value in value (if not null).
+  bool find(ThreadContext* context, const Key& key, Value* value) const {
+    EpochDomain::Guard guard(context);
+    Node* pred = head_;
+    for (int level = kMaxHeight - 1; level >= 0; --level) {
+      Node* node = pred->next(level).load(std::memory_order_acquire);
+      while (node != nullptr && node->key < key) {
+        pred = node;
+        node = node->next(level).load(std::memory_order_acquire);
+      }
+      if (node != nullptr && !(key < node->key)) {
+        if (!node->fully_linked.load(std::memory_order_acquire) ||
+            node->marked.load(std::memory_order_acquire)) {
+          return false;
+        }
+        if (value != nullptr) {
+          *value = node->value;
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool contains(ThreadContext* context, const Key& key) const {
+    return find(context, key, nullptr);
+  }
+
+  // Calls function(key, value) for the keys in [low, high), in order.
+  template <typename Function>
+  void ForEachInRange(ThreadContext* context, const Key& low, const Key& high,
+                      Function function) const {
+    EpochDomain::Guard guard(context);
+    Node* pred = head_;
+    for (int level = kMaxHeight - 1; level >= 0; --level) {
+      Node* node = pred->next(level).load(std::memory_order_acquire);
+      while (node != nullptr && node->key < low) {
+        pred = node;
+        node = node->next(level).load(std::memory_order_acquire);
+      }
+    }
+    for (Node* node = pred->next(0).load(std::memory_order_acquire);
+         node != nullptr && node->key < high;
+         node = node->next(0).load(std::memory_order_acquire)) {
+      if (node->fully_linked.load(std::memory_order_acquire) &&
+          !node->marked.load(std::memory_order_acquire)) {
+        function(node->key, node->value);
+      }
+    }
+  }
+
+  // Calls function(key, value) for every key, in order.
+  template <typename Function>
+  void ForEach(ThreadContext* context, Function function) const {
+    EpochDomain::Guard guard(context);
+    for (Node* node = head_->next(0).load(std::memory_order_acquire);
+         node != nullptr;
+         node = node->next(0).load(std::memory_order_acquire)) {
+      if (node->fully_linked.load(std::memory_order_acquire) &&
+          !node->marked.load(std::memory_order_acquire)) {
+        function(node->key, node->value);
+      }
+    }
+  }
+
+  // Exact when no thread is changing the map.
+  std::size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+ private:
+  // A node with height levels; its next pointers follow it in memory.
+  struct Node {
+    static Node* Create(const Key& key, const Value& value, const int height) {
+      void* memory =
+          ::operator new(sizeof(Node) + height * sizeof(std::atomic<Node*>));
+      Node* node = new (memory) Node(key, value, height);
+      for (int level = 0; level < height; ++level) {
+        new (&node->next(level)) std::atomic<Node*>(nullptr);
+      }
+      return node;
+    }
+
+    // Nodes are allocated with their next pointers, by Create.
+    static void operator delete(void* memory) { ::operator delete(memory); }
+
+    std::atomic<Node*>& next(const int level) {
+      return reinterpret_cast<std::atomic<Node*>*>(this + 1)[level];
+    }
+
+    const Key key;
+    const Value value;
+    const int height;
+    internal::NodeLock lock;
+    std::atomic<bool> marked;
+    std::atomic<bool> fully_linked;
+
+   private:
+    Node(const Key& new_key, const Value& new_value, const int new_height)
+        : key(new_key), value(new_value), height(new_height), marked(false),
+          fully_linked(false) {}
+  };
+
+  // Finds, at every level, the last node before key (preds) and the node
+  // after it (succs). Returns the highest level where succs is key, or -1.
+  int FindPath(const Key& key, Node** preds, Node** succs) const {
+    int found_level = -1;
+    Node* pred = head_;
+    for (int level = kMaxHeight - 1; level >= 0; --level) {
+      Node* node = pred->next(level).load(std::memory_order_acquire);
+      while (node != nullptr && node->key < key) {
+        pred = node;
+        node = node->next(level).load(std::memory_order_acquire);
+      }
+      if (found_level < 0 && node != nullptr && !(key < node->key)) {
+        found_level = level;
+      }
+      preds[level] = pred;
+      succs[level] = node;
+    }
+    return found_level;
+  }
+
+  static void Unlock(Node** locked, const int num_locked) {
+    for (int i = 0; i < num_locked; ++i) {
+      locked[i]->lock.unlock();
+    }
+  }
+
+  // 1 + the number of successes in a row of a coin with probability 1/4.
+  static int RandomHeight() {
+    thread_local uint64_t state =
+        0x9E3779B97F4A7C15ull ^
+        reinterpret_cast<uint64_t>(&state);
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    int height = 1;
+    uint64_t bits = state;
+    while (height < kMaxHeight && (bits & 3) == 0) {
+      ++height;
+      bits >>= 2;
+    }
+    return height;
+  }
+
+  // Destroyed last: it deletes the nodes still retired then, which are not in
+  // the list anymore.
+  EpochDomain domain_;
+  Node* const head_;
+  std::atomic<std::size_t> size_;
+};
+
+// A set of keys, with the interface of the map without values.
+template <typename Key>
+class ConcurrentSkipListSet {
+ public:
+  typedef EpochDomain::ThreadContext ThreadContext;
+
+  EpochDomain* domain() { return map_.domain(); }
+
+  bool insert(ThreadContext* context, const Key& key) {
+    return map_.insert(context, key, internal::EmptyValue());
+  }
+  bool erase(ThreadContext* context, const Key& key) {
+    return map_.erase(context, key);
+  }
+  bool contains(ThreadContext* context, const Key& key) const {
+    return map_.contains(context, key);
+  }
+
+  // Calls function(key) for the keys in [low, high), in order.
+  template <typename Function>
+  void ForEachInRange(ThreadContext* context, const Key& low, const Key& high,
+                      Function function) const {
+    map_.ForEachInRange(context, low, high,
+                        [&function](const Key& key, internal::EmptyValue) {
+                          function(key);
+                        });
+  }
+
+  // Calls function(key) for every key, in order.
+  template <typename Function>
+  void ForEach(ThreadContext* context, Function function) const {
+    map_.ForEach(context, [&function](const Key& key, internal::EmptyValue) {
+      function(key);
+    });
+  }
+
+  std::size_t size() const { return map_.size(); }
+
+ private:
+  ConcurrentSkipListMap<Key, internal::EmptyValue> map_;
+};
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_CONCURRENT_SKIP_LIST_H_
@@ -0,0 +1,334 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary compares the concurrent skip list of concurrent_skip_list.h
+// against a std::set behind a std::shared_mutex on a mixed workload, and
+// stress tests the skip list.
+//
+// Usage: concurrent_skip_list_benchmark [max_threads] [milliseconds] [keys]
+//        concurrent_skip_list_benchmark --stress [max_threads] [milliseconds]
+//   Defaults: max_threads = 64, milliseconds = 200 (per measurement),
+//             keys = 1M (the key range; half of it is in the set).
+//
+// Workload: each thread picks a key at random and, out of 100 operations,
+// runs 88 lookups, 5 insertions, 5 erasures and 2 range scans of
+// kScanLength keys. With the std::set, lookups and scans take the mutex in
+// shared mode and the rest in exclusive mode; with the skip list, lookups and
+// scans take no locks and the rest lock the nodes next to the key.
+//
+// The stress mode has every thread insert and erase its own keys (the ones
+// equal to its index modulo the number of threads) while it scans the whole
+// range. It fails if a scan is out of order, or if the set does not hold
+// exactly the keys that the threads left in it at the end.
+
+#include <atomic>  // Header for std::atomic.
+#include <cstdint>  // Header for uint64_t.
+#include <cstring>  // Header for std::strcmp.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <mutex>  // Header for std::unique_lock.
+#include <set>  // Header for std::set.
+#include <shared_mutex>  // Header for std::shared_mutex (C++17).
+#include <thread>  // Header for std::thread.
+#include <vector>  // Header for std::vector.
+
+#include "benchmark_utils.h"
+#include "concurrent_skip_list.h"
+
+namespace {
+
+// Keys read by a range scan.
+const uint64_t kScanLength = 100;
+
+// Fast per-thread random numbers.
+inline uint64_t NextRandom(uint64_t* state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+struct ThreadResult {
+  uint64_t num_operations;
+  uint64_t num_errors;
+};
+
+// Runs body(thread_index, &stop, &result) in num_threads threads for the given
+// time, and returns the sum of their results.
+template <typename Body>
+ThreadResult RunThreads(const int num_threads, const int milliseconds,
+                        const Body& body) {
+  std::atomic<bool> stop(false);
+  std::vector<ThreadResult> results(num_threads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.push_back(std::thread([&, i]() { body(i, &stop, &results[i]); }));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+  stop.store(true);
+  ThreadResult total = {0, 0};
+  for (int i = 0; i < num_threads; ++i) {
+    threads[i].join();
+    total.num_operations += results[i].num_operations;
+    total.num_errors += results[i].num_errors;
+  }
+  return total;
+}
+
+// The operations of the mixed workload, out of 100.
+enum Operation { kFind, kInsert, kErase, kScan };
+
+inline Operation PickOperation(const uint64_t random) {
+  const uint64_t percent = (random >> 32) % 100;
+  if (percent < 88) {
+    return kFind;
+  }
+  if (percent < 93) {
+    return kInsert;
+  }
+  return percent < 98 ? kErase : kScan;
+}
+
+// The baseline: one reader-writer lock around the whole tree.
+class SharedMutexSet {
+ public:
+  // Nothing per thread; for the same interface as the skip list.
+  struct ThreadContext {
+    explicit ThreadContext(SharedMutexSet*) {}
+  };
+
+  bool insert(ThreadContext*, const uint64_t key) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    return set_.insert(key).second;
+  }
+  bool erase(ThreadContext*, const uint64_t key) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    return set_.erase(key) > 0;
+  }
+  bool contains(ThreadContext*, const uint64_t key) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return set_.count(key) > 0;
+  }
+  template <typename Function>
+  void ForEachInRange(ThreadContext*, const uint64_t low, const uint64_t high,
+                      Function function) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    for (auto it = set_.lower_bound(low); it != set_.end() && *it < high;
+         ++it) {
+      function(*it);
+    }
+  }
+
+ private:
+  mutable std::shared_mutex mutex_;
+  std::set<uint64_t> set_;
+};
+
+// The skip list, with ThreadContexts created from the set like above.
+class SkipListSet : public cpp_labs::ConcurrentSkipListSet<uint64_t> {
+ public:
+  struct ThreadContext
+      : public cpp_labs::ConcurrentSkipListSet<uint64_t>::ThreadContext {
+    explicit ThreadContext(SkipListSet* set)
+        : cpp_labs::ConcurrentSkipListSet<uint64_t>::ThreadContext(
+              set->domain()) {}
+  };
+};
+
+// Millions of operations per second of the mixed workload on Set.
+template <typename Set>
+double MixedWorkload(const int num_threads, const int milliseconds,
+                     const uint64_t num_keys) {
+  Set set;
+  {
+    typename Set::ThreadContext context(&set);
+    for (uint64_t key = 0; key < num_keys; key += 2) {
+      set.insert(&context, key);
+    }
+  }
+  const ThreadResult total = RunThreads(
+      num_threads, milliseconds,
+      [&](const int thread_index, std::atomic<bool>* stop,
+          ThreadResult* result) {
+    typename Set::ThreadContext context(&set);
+    uint64_t random_state = 88172645463325252ULL + thread_index;
+    ThreadResult local = {0, 0};
+    uint64_t found = 0;
+    while (!stop->load(std::memory_order_relaxed)) {
+      const uint64_t random = NextRandom(&random_state);
+      const uint64_t key = random % num_keys;
+      switch (PickOperation(random)) {
+        case kFind:
+          found += set.contains(&context, key) ? 1 : 0;
+          break;
+        case kInsert:
+          found += set.insert(&context, key) ? 1 : 0;
+          break;
+        case kErase:
+          found += set.erase(&context, key) ? 1 : 0;
+          break;
+        case kScan:
+          set.ForEachInRange(&context, key, key + kScanLength,
+                             [&found](const uint64_t) { ++found; });
+          break;
+      }
+      ++local.num_operations;
+    }
+    cpp_labs::DoNotOptimize(found);
+    *result = local;
+  });
+  return total.num_operations / (milliseconds / 1000.0) / 1e6;
+}
+
+void RunBenchmark(const int max_threads, const int milliseconds,
+                  const uint64_t num_keys) {
+  std::cout << "Mixed workload on " << num_keys << " keys (88% find, 5% "
+            << "insert, 5% erase, 2% scan of " << kScanLength << " keys), "
+            << "million operations per second\n"
+            << std::setw(9) << "threads" << std::setw(24)
+            << "set + shared_mutex" << std::setw(14) << "skip list"
+            << std::setw(10) << "ratio" << std::endl;
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    const double locked =
+        MixedWorkload<SharedMutexSet>(threads, milliseconds, num_keys);
+    const double skip_list =
+        MixedWorkload<SkipListSet>(threads, milliseconds, num_keys);
+    std::cout << std::setw(9) << threads << std::setw(24) << locked
+              << std::setw(14) << skip_list << std::setw(10)
+              << skip_list / locked << std::endl;
+  }
+}
+
+// Runs the stress workload with num_threads threads; returns the errors.
+uint64_t StressTest(const int num_threads, const int milliseconds,
+                    const uint64_t num_keys) {
+  SkipListSet set;
+  // The keys each thread left in the set.
+  std::vector<std::set<uint64_t> > expected(num_threads);
+  ThreadResult total = RunThreads(
+      num_threads, milliseconds,
+      [&](const int thread_index, std::atomic<bool>* stop,
+          ThreadResult* result) {
+    SkipListSet::ThreadContext context(&set);
+    std::set<uint64_t>& mine = expected[thread_index];
+    uint64_t random_state = 88172645463325252ULL + thread_index;
+    ThreadResult local = {0, 0};
+    while (!stop->load(std::memory_order_relaxed)) {
+      const uint64_t random = NextRandom(&random_state);
+      const uint64_t key =
+          (random % (num_keys / num_threads)) * num_threads + thread_index;
+      const uint64_t percent = (random >> 32) % 100;
+      if (percent < 45) {
+        // Only this thread changes its keys, so the answers are known.
+        local.num_errors +=
+            set.insert(&context, key) != mine.insert(key).second ? 1 : 0;
+      } else if (percent < 90) {
+        local.num_errors +=
+            set.erase(&context, key) != (mine.erase(key) > 0) ? 1 : 0;
+      } else if (percent < 99) {
+        local.num_errors +=
+            set.contains(&context, key) != (mine.count(key) > 0) ? 1 : 0;
+      } else {
+        bool first = true;
+        uint64_t previous = 0;
+        set.ForEach(&context, [&](const uint64_t other) {
+          local.num_errors += !first && other <= previous ? 1 : 0;
+          first = false;
+          previous = other;
+        });
+      }
+      ++local.num_operations;
+    }
+    *result = local;
+  });
+  std::set<uint64_t> all;
+  for (const std::set<uint64_t>& mine : expected) {
+    all.insert(mine.begin(), mine.end());
+  }
+  std::vector<uint64_t> found;
+  {
+    SkipListSet::ThreadContext context(&set);
+    set.ForEach(&context, [&found](const uint64_t key) {
+      found.push_back(key);
+    });
+  }
+  if (set.size() != all.size() ||
+      found != std::vector<uint64_t>(all.begin(), all.end())) {
+    ++total.num_errors;
+  }
+  std::cout << std::setw(9) << num_threads << std::setw(14)
+            << total.num_operations << std::setw(10) << all.size()
+            << std::setw(10) << total.num_errors
+            << (total.num_errors == 0 ? "" : "  FAILED") << std::endl;
+  return total.num_errors;
+}
+
+bool RunStressTest(const int max_threads, const int milliseconds) {
+  // Small, so that threads often work next to each other's keys.
+  const uint64_t num_keys = 4096;
+  std::cout << std::setw(9) << "threads" << std::setw(14) << "operations"
+            << std::setw(10) << "keys" << std::setw(10) << "errors"
+            << std::endl;
+  uint64_t errors = 0;
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    errors += StressTest(threads, milliseconds, num_keys);
+  }
+  std::cout << (errors == 0 ? "Stress test passed." : "Stress test FAILED.")
+            << std::endl;
+  return errors == 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool stress = false;
+  int first_number = 1;
+  if (argc > 1 && std::strcmp(argv[1], "--stress") == 0) {
+    stress = true;
+    first_number = 2;
+  }
+  const int max_threads = static_cast<int>(
+      cpp_labs::ParseSizeArgument(argc, argv, first_number, 64));
+  const int milliseconds = static_cast<int>(
+      cpp_labs::ParseSizeArgument(argc, argv, first_number + 1, 200));
+  std::cout << "Hardware threads: " << std::thread::hardware_concurrency()
+            << std::endl;
+  if (stress) {
+    return RunStressTest(max_threads, milliseconds) ? 0 : 1;
+  }
+  const uint64_t num_keys =
+      cpp_labs::ParseSizeArgument(argc, argv, first_number + 2, 1 << 20);
+  RunBenchmark(max_threads, milliseconds, num_keys);
+  return 0;
+}
@@ -0,0 +1,238 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary measures the work that constexpr_utils.h moves from run time to
+// compile time: the tables that a program would otherwise build at startup,
+// and the hot loops that use them.
+//
+// Usage: constexpr_benchmark [num_lookups] [buffer_megabytes]
+//   Defaults: num_lookups = 10000000, buffer_megabytes = 256.
+//
+// Notes:
+//
+// 1. Startup: the CRC-32 table and the user name index are computed at run
+// time (as a program without constexpr would do in main or in a static
+// initializer) and compared with their constexpr versions, which cost nothing
+// at run time: they are data in the binary.
+// 2. Hot loops: the CRC-32 of a buffer uses the same table either way, so it
+// runs at the same speed; the difference is only the startup work. Looking up
+// user names, however, is faster with the perfect hash table than with
+// std::map or std::unordered_map: a hash of four values instead of the whole
+// string, no probing and one comparison.
+// 3. Lookups of string literals (e.g., kUserNameIndex.Find("john")) are
+// resolved by the compiler; see the static_asserts below.
+
+#include <cstdint>  // Header for uint32_t.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <map>  // Header for std::map.
+#include <random>  // Header for std::mt19937.
+#include <string>  // Header for std::string.
+#include <unordered_map>  // Header for std::unordered_map.
+#include <vector>  // Header for std::vector.
+
+#include "benchmark_utils.h"
+#include "constexpr_utils.h"
+
+namespace {
+
+// Number of query names, a power of two; they fit in the L1 cache, so the
+// lookups measure the containers and not the memory.
+const std::size_t kNumNames = 1024;
+
+// The users of map_example.cc.
+constexpr const char* kUserNames[] = {"victor", "john"};
+constexpr int kUserIds[] = {1, 2};
+constexpr cpp_labs::PerfectHashTable<2> kUserNameIndex(kUserNames);
+
+static_assert(kUserNameIndex.ok(), "No perfect hash seed for kUserNames.");
+static_assert(kUserNameIndex.Find("victor") == 0, "victor is key 0.");
+static_assert(kUserNameIndex.Find("john") == 1, "john is key 1.");
+static_assert(kUserNameIndex.Find("alice") == -1, "alice is not a key.");
+static_assert(cpp_labs::Sum(1, 2, 3, 4) == 10, "Sum at compile time.");
+static_assert(cpp_labs::StaticTable<cpp_labs::Crc32TableGenerator,
+                                    256>::kValues[1] == 0x77073096u,
+              "Second entry of the CRC-32 table.");
+
+// What a program without constexpr does at startup.
+void BuildCrc32Table(uint32_t* table) {
+  for (uint32_t byte = 0; byte < 256; ++byte) {
+    uint32_t crc = byte;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc & 1) != 0 ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+    }
+    table[byte] = crc;
+  }
+}
+
+uint32_t Crc32WithTable(const uint32_t* table, const unsigned char* bytes,
+                        const std::size_t size) {
+  uint32_t crc = 0xFFFFFFFFu;
+  for (std::size_t i = 0; i < size; ++i) {
+    crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFFu;
+}
+
+template <typename Map>
+Map BuildUserMap() {
+  Map map;
+  for (std::size_t i = 0; i < kUserNameIndex.size(); ++i) {
+    map[kUserNames[i]] = kUserIds[i];
+  }
+  return map;
+}
+
+// Returns the average nanoseconds of build().
+template <typename Build>
+double MeasureStartup(const Build& build) {
+  const int kRepetitions = 10000;
+  cpp_labs::Timer timer;
+  for (int i = 0; i < kRepetitions; ++i) {
+    build();
+    cpp_labs::ClobberMemory();
+  }
+  return timer.ElapsedNanoseconds() / kRepetitions;
+}
+
+template <typename Map>
+int64_t LookupWithMap(const Map& map, const std::vector<std::string>& names,
+                      const std::size_t num_lookups) {
+  int64_t sum = 0;
+  for (std::size_t i = 0; i < num_lookups; ++i) {
+    const typename Map::const_iterator it =
+        map.find(names[i & (kNumNames - 1)]);
+    sum += it == map.end() ? -1 : it->second;
+  }
+  return sum;
+}
+
+int64_t LookupWithPerfectHash(const std::vector<std::string>& names,
+                              const std::size_t num_lookups) {
+  int64_t sum = 0;
+  for (std::size_t i = 0; i < num_lookups; ++i) {
+    const std::string& name = names[i & (kNumNames - 1)];
+    const int index = kUserNameIndex.Find(name.data(), name.size());
+    sum += index < 0 ? -1 : kUserIds[index];
+  }
+  return sum;
+}
+
+void PrintRow(const std::string& name, const double value,
+              const std::string& unit) {
+  std::cout << std::setw(40) << name << std::setw(12) << value << " " << unit
+            << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t num_lookups =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, 10000000);
+  const std::size_t buffer_size =
+      cpp_labs::ParseSizeArgument(argc, argv, 2, 256) << 20;
+  if (num_lookups == 0 || buffer_size == 0) {
+    std::cerr << "num_lookups and buffer_megabytes must be positive."
+              << std::endl;
+    return 1;
+  }
+
+  std::cout << "Startup work (once per process)" << std::endl;
+  uint32_t runtime_table[256];
+  PrintRow("CRC-32 table, computed at run time",
+           MeasureStartup([&]() { BuildCrc32Table(runtime_table); }), "ns");
+  PrintRow("CRC-32 table, constexpr", 0.0, "ns (data in the binary)");
+  PrintRow("user index, std::map",
+           MeasureStartup([]() {
+             cpp_labs::DoNotOptimize(
+                 BuildUserMap<std::map<std::string, int> >());
+           }),
+           "ns");
+  PrintRow("user index, std::unordered_map",
+           MeasureStartup([]() {
+             cpp_labs::DoNotOptimize(
+                 BuildUserMap<std::unordered_map<std::string, int> >());
+           }),
+           "ns");
+  PrintRow("user index, constexpr perfect hash", 0.0,
+           "ns (data in the binary)");
+
+  std::cout << "\nHot loops" << std::endl;
+  std::vector<unsigned char> buffer(buffer_size);
+  std::mt19937 rng(1234);
+  for (unsigned char& byte : buffer) {
+    byte = static_cast<unsigned char>(rng());
+  }
+  cpp_labs::Timer timer;
+  const uint32_t runtime_crc =
+      Crc32WithTable(runtime_table, buffer.data(), buffer.size());
+  PrintRow("CRC-32, run time table",
+           buffer.size() / timer.ElapsedSeconds() / 1e9, "GB/s");
+  timer.Reset();
+  const uint32_t constexpr_crc = cpp_labs::Crc32(buffer.data(), buffer.size());
+  PrintRow("CRC-32, constexpr table",
+           buffer.size() / timer.ElapsedSeconds() / 1e9, "GB/s");
+  if (runtime_crc != constexpr_crc) {
+    std::cout << "  (CRC mismatch!)" << std::endl;
+  }
+
+  // Mostly users, with some unknown names.
+  const char* kQueries[] = {"victor", "john", "victor", "john", "alice"};
+  std::vector<std::string> names(kNumNames);
+  for (std::string& name : names) {
+    name = kQueries[rng() % 5];
+  }
+  const std::map<std::string, int> map =
+      BuildUserMap<std::map<std::string, int> >();
+  const std::unordered_map<std::string, int> unordered_map =
+      BuildUserMap<std::unordered_map<std::string, int> >();
+
+  timer.Reset();
+  const int64_t map_sum = LookupWithMap(map, names, num_lookups);
+  PrintRow("user lookup, std::map", timer.ElapsedNanoseconds() / num_lookups,
+           "ns");
+  timer.Reset();
+  const int64_t unordered_map_sum =
+      LookupWithMap(unordered_map, names, num_lookups);
+  PrintRow("user lookup, std::unordered_map",
+           timer.ElapsedNanoseconds() / num_lookups, "ns");
+  timer.Reset();
+  const int64_t perfect_hash_sum = LookupWithPerfectHash(names, num_lookups);
+  PrintRow("user lookup, constexpr perfect hash",
+           timer.ElapsedNanoseconds() / num_lookups, "ns");
+  if (map_sum != unordered_map_sum || map_sum != perfect_hash_sum) {
+    std::cout << "  (lookup mismatch!)" << std::endl;
+  }
+  return 0;
+}
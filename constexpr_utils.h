@@ -0,0 +1,344 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_CONSTEXPR_UTILS_H_
+#define CPP_LABS_CONSTEXPR_UTILS_H_
+
+// Helpers to move work from run time to compile time with C++11 constexpr:
+//
+// 1. AddNumbers/SubtractNumbers/Sum: the numeric helpers of
+// templates_example.cc and functions_example.cc, usable in constant
+// expressions (e.g., array sizes, static_assert) and still at run time. They
+// work with any type that has the arithmetic operators, such as Fixed
+// (fixed_point.h) and Float16 (half_float.h), e.g., AddNumbers(Float16(1.5f),
+// Float16(2.0f)).
+// 2. ConstArray and MakeArray: arrays whose elements are computed by the
+// compiler, e.g., the CRC-32 table below. The table is part of the binary
+// (read-only data), so there is nothing to build at startup.
+// 3. Fnv1a: a string hash that can hash literals at compile time (e.g., to
+// derive hash seeds or switch on string hashes).
+// 4. PerfectHashTable: a lookup table for a key set known at compile time,
+// e.g., {"victor", "john"}. The compiler searches for a hash seed under which
+// no two keys share a slot, so a lookup is one (constant time) hash, one slot
+// read and one string comparison, with no probing and no allocation.
+//
+// C++11 constexpr functions consist of a single return statement, which is
+// why the functions below use recursion and the conditional operator instead
+// of loops. The compiler turns the tail recursion into loops when they run at
+// run time.
+//
+// Example:
+//   constexpr const char* kUserNames[] = {"victor", "john"};
+//   constexpr PerfectHashTable<2> kUserNameIndex(kUserNames);
+//   static_assert(kUserNameIndex.ok(), "No perfect hash seed found.");
+//   static_assert(kUserNameIndex.Find("john") == 1, "Found by the compiler.");
+//   const int index = kUserNameIndex.Find(name.data(), name.size());  // Or -1.
+
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for uint32_t and uint64_t.
+#include <cstring>  // Header for std::memcmp.
+
+#include "index_sequence.h"
+
+namespace cpp_labs {
+
+template <typename T>
+constexpr T AddNumbers(const T a, const T b) {
+  return a + b;
+}
+
+template <typename T>
+constexpr T SubtractNumbers(const T a, const T b) {
+  return a - b;
+}
+
+// Sum(1, 2, 3) == 6.
+template <typename T>
+constexpr T Sum(const T value) {
+  return value;
+}
+
+template <typename T, typename... Ts>
+constexpr T Sum(const T first, const Ts... rest) {
+  return AddNumbers(first, static_cast<T>(Sum(rest...)));
+}
+
+// A fixed-size array that can be built and read in constant expressions
+// (std::array's operator[] is not constexpr until C++14).
+template <typename T, std::size_t N>
+struct ConstArray {
+  T values[N];
+
+  constexpr const T& operator[](const std::size_t i) const { return values[i]; }
+  static constexpr std::size_t size() { return N; }
+  const T* begin() const { return values; }
+  const T* end() const { return values + N; }
+};
+
+namespace internal {
+template <typename Generator, std::size_t... Indices>
+constexpr ConstArray<typename Generator::value_type, sizeof...(Indices)>
+MakeArrayImpl(IndexSequence<Indices...>) {
+  return {{Generator::Value(Indices)...}};
+}
+}  // namespace internal
+
+// Returns {Generator::Value(0), ..., Generator::Value(N - 1)}, where Generator
+// is a type with a value_type typedef and a static constexpr Value(index).
+template <typename Generator, std::size_t N>
+constexpr ConstArray<typename Generator::value_type, N> MakeArray() {
+  return internal::MakeArrayImpl<Generator>(MakeIndexSequence<N>());
+}
+
+// The array MakeArray<Generator, N>() as a static constant, so that every
+// translation unit shares one copy.
+template <typename Generator, std::size_t N>
+struct StaticTable {
+  static constexpr ConstArray<typename Generator::value_type, N> kValues =
+      MakeArray<Generator, N>();
+};
+
+template <typename Generator, std::size_t N>
+constexpr ConstArray<typename Generator::value_type, N>
+    StaticTable<Generator, N>::kValues;
+
+// Generator of the table of the (reflected) CRC-32 of every byte.
+struct Crc32TableGenerator {
+  typedef uint32_t value_type;
+
+  static constexpr uint32_t Value(const std::size_t byte) {
+    return Step(static_cast<uint32_t>(byte), 8);
+  }
+
+ private:
+  // Processes the remaining num_bits bits of the byte.
+  static constexpr uint32_t Step(const uint32_t crc, const int num_bits) {
+    return num_bits == 0
+               ? crc
+               : Step((crc & 1) != 0 ? 0xEDB88320u ^ (crc >> 1) : crc >> 1,
+                      num_bits - 1);
+  }
+};
+
+// CRC-32 (as in zlib) of size bytes, one table lookup per byte.
+inline uint32_t Crc32(const void* data, const std::size_t size) {
+  const ConstArray<uint32_t, 256>& table =
+      StaticTable<Crc32TableGenerator, 256>::kValues;
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  uint32_t crc = 0xFFFFFFFFu;
+  for (std::size_t i = 0; i < size; ++i) {
+    crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFFu;
+}
+
+const uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+const uint64_t kFnvPrime = 1099511628211ull;
+
+// 64-bit FNV-1a hash of a null-terminated string.
+constexpr uint64_t Fnv1a(const char* text,
+                         const uint64_t hash = kFnvOffsetBasis) {
+  return *text == '\0'
+             ? hash
+             : Fnv1a(text + 1,
+                     (hash ^ static_cast<unsigned char>(*text)) * kFnvPrime);
+}
+
+constexpr bool StringEqual(const char* a, const char* b) {
+  return *a == *b && (*a == '\0' || StringEqual(a + 1, b + 1));
+}
+
+namespace internal {
+
+constexpr std::size_t NextPowerOfTwo(const std::size_t value,
+                                     const std::size_t power = 1) {
+  return power >= value ? power : NextPowerOfTwo(value, 2 * power);
+}
+
+// With N * N slots a random seed has no collisions with probability of about
+// exp(-1/2), so the seed search below ends after a few attempts.
+constexpr std::size_t PerfectHashTableSize(const std::size_t num_keys) {
+  return NextPowerOfTwo(num_keys * num_keys < 4 ? 4 : num_keys * num_keys);
+}
+
+}  // namespace internal
+
+// Maps each key of a set fixed at compile time to its index in the set, using
+// a hash function without collisions on those keys. Declare it constexpr so
+// that the seed search and the table are computed by the compiler, and check
+// ok().
+//
+// As gperf does, the hash reads only the length of the key and three of its
+// characters (the first, the middle and the last one), so it costs the same
+// for any key and has no loop whose length the processor must predict. Keys
+// that agree on all four cannot be told apart and make ok() false; use a
+// std::unordered_map for such key sets.
+template <std::size_t N,
+          std::size_t TableSize = internal::PerfectHashTableSize(N)>
+class PerfectHashTable {
+ public:
+  static_assert(N > 0 && N < 255, "The table stores indices in a byte.");
+  static_assert((TableSize & (TableSize - 1)) == 0,
+                "TableSize must be a power of two.");
+
+  // keys must have static storage duration (e.g., a constexpr array).
+  constexpr explicit PerfectHashTable(const char* const (&keys)[N])
+      : PerfectHashTable(keys, FindSeed(keys, 0), MakeIndexSequence<N>(),
+                         MakeIndexSequence<TableSize>()) {}
+
+  constexpr bool ok() const { return seed_ != kNoSeed; }
+
+  // Returns the index of key in the key set, or -1 if it is not a key. Works
+  // in constant expressions, e.g., Find("john").
+  constexpr int Find(const char* key) const {
+    return FindWithLength(key, StringLength(key));
+  }
+
+  // Same as Find, for keys whose length is known (e.g., a std::string).
+  int Find(const char* key, const std::size_t length) const {
+    const unsigned char entry = slots_[Slot(key, length, seed_)];
+    return entry != 0 && lengths_[entry - 1] == length &&
+                   std::memcmp(keys_[entry - 1], key, length) == 0
+               ? entry - 1
+               : -1;
+  }
+
+  static constexpr std::size_t size() { return N; }
+  constexpr const char* key(const std::size_t index) const {
+    return keys_[index];
+  }
+
+ private:
+  static constexpr uint64_t kMaxSeeds = 200;
+  static constexpr uint64_t kNoSeed = ~0ull;
+
+  template <std::size_t... Keys, std::size_t... Slots>
+  constexpr PerfectHashTable(const char* const (&keys)[N], const uint64_t seed,
+                             IndexSequence<Keys...>, IndexSequence<Slots...>)
+      : keys_(keys),
+        seed_(seed),
+        lengths_{StringLength(keys[Keys])...},
+        slots_{SlotEntry(keys, seed, Slots, 0)...} {}
+
+  static constexpr std::size_t StringLength(const char* text) {
+    return *text == '\0' ? 0 : 1 + StringLength(text + 1);
+  }
+
+  static constexpr std::size_t Slot(const char* key, const std::size_t length,
+                                    const uint64_t seed) {
+    return length == 0
+               ? Mix(seed, 0)
+               : Mix(seed,
+                     length ^
+                         (static_cast<uint64_t>(
+                              static_cast<unsigned char>(key[0]))
+                          << 16) ^
+                         (static_cast<uint64_t>(
+                              static_cast<unsigned char>(key[length / 2]))
+                          << 24) ^
+                         (static_cast<uint64_t>(
+                              static_cast<unsigned char>(key[length - 1]))
+                          << 32));
+  }
+
+  static constexpr std::size_t Mix(const uint64_t seed, const uint64_t value) {
+    return MixBits((value + seed * 0x9E3779B97F4A7C15ull) *
+                   0xFF51AFD7ED558CCDull);
+  }
+
+  static constexpr std::size_t MixBits(const uint64_t hash) {
+    return static_cast<std::size_t>(hash ^ (hash >> 32)) & (TableSize - 1);
+  }
+
+  constexpr int FindWithLength(const char* key,
+                               const std::size_t length) const {
+    return IndexAt(slots_[Slot(key, length, seed_)], key);
+  }
+
+  constexpr int IndexAt(const unsigned char entry, const char* key) const {
+    return entry != 0 && StringEqual(keys_[entry - 1], key) ? entry - 1 : -1;
+  }
+
+  static constexpr std::size_t KeySlot(const char* key, const uint64_t seed) {
+    return Slot(key, StringLength(key), seed);
+  }
+
+  // Whether keys[i] shares its slot with any of keys[j], ..., keys[N - 1].
+  static constexpr bool CollidesWithLater(const char* const (&keys)[N],
+                                          const uint64_t seed,
+                                          const std::size_t i,
+                                          const std::size_t j) {
+    return j < N && (KeySlot(keys[i], seed) == KeySlot(keys[j], seed) ||
+                     CollidesWithLater(keys, seed, i, j + 1));
+  }
+
+  static constexpr bool HasCollision(const char* const (&keys)[N],
+                                     const uint64_t seed,
+                                     const std::size_t i) {
+    return i < N && (CollidesWithLater(keys, seed, i, i + 1) ||
+                     HasCollision(keys, seed, i + 1));
+  }
+
+  static constexpr uint64_t FindSeed(const char* const (&keys)[N],
+                                     const uint64_t seed) {
+    return seed == kMaxSeeds ? kNoSeed
+           : !HasCollision(keys, seed, 0) ? seed
+                                          : FindSeed(keys, seed + 1);
+  }
+
+  // 1 + the index of the key in slot, or 0 if the slot is empty.
+  static constexpr unsigned char SlotEntry(const char* const (&keys)[N],
+                                           const uint64_t seed,
+                                           const std::size_t slot,
+                                           const std::size_t i) {
+    return i == N ? 0
+           : seed != kNoSeed && KeySlot(keys[i], seed) == slot
+               ? static_cast<unsigned char>(i + 1)
+               : SlotEntry(keys, seed, slot, i + 1);
+  }
+
+  const char* const* keys_;
+  uint64_t seed_;
+  std::size_t lengths_[N];
+  unsigned char slots_[TableSize];
+};
+
+template <std::size_t N, std::size_t TableSize>
+constexpr uint64_t PerfectHashTable<N, TableSize>::kMaxSeeds;
+template <std::size_t N, std::size_t TableSize>
+constexpr uint64_t PerfectHashTable<N, TableSize>::kNoSeed;
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_CONSTEXPR_UTILS_H_
@@ -0,0 +1,302 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_COROUTINE_LOOKUP_H_
+#define CPP_LABS_COROUTINE_LOOKUP_H_
+
+// Interleaved lookups with C++20 coroutines: many independent lookups run at
+// once on one thread, and each one suspends where it would wait for memory.
+//
+// A lookup in a table much larger than the last-level cache misses the cache
+// at (almost) every node or slot it reads, and the CPU waits ~100 ns for each
+// miss. A std::set::find or std::unordered_map::find does nothing else
+// meanwhile. Written as a coroutine, a lookup instead prefetches the line it
+// needs next and suspends (PrefetchAndSuspend); InterleavedLookups then
+// resumes the other lookups of its group, and by the time it comes back the
+// line has arrived. With a group of G lookups up to G misses are in flight at
+// once, so the memory latency is paid about once per G lookups (until the
+// memory system runs out of parallelism, at about 10-20 misses per core).
+// This pays off for chains of dependent misses, such as the path from the
+// root of a tree; independent single misses, such as the slots of consecutive
+// hash lookups, are overlapped by the out-of-order CPU already.
+//
+// Usage:
+//
+//   TreeSet<uint64_t> my_set;  // See tree_set.h.
+//   ...
+//   InterleavedLookups(
+//       keys.data(), keys.size(), 16,
+//       [&](const uint64_t key) { return TreeSetContains(my_set, key); },
+//       [&](const std::size_t index, const bool found) { ... });
+//
+// Lookups for TreeSet (all node policies) and IncrementalHashMap are below;
+// any function that returns a LookupTask and co_awaits PrefetchAndSuspend
+// before it reads memory works the same way.
+//
+// Notes:
+//
+// 1. This header needs C++20 (cmake -DBUILD_WITH_CXX20=ON); the containers
+// stay C++11.
+// 2. Every lookup allocates a coroutine frame. The frames come from a free
+// list of the thread (CoroutineFramePool), so that malloc does not cost as
+// much as the misses it hides.
+// 3. The containers (and the keys) must outlive the lookups: the coroutines
+// keep references to them while suspended.
+// 4. Results are delivered as lookups finish, not in the order of the keys;
+// output gets the index of the key.
+
+#if __cplusplus < 202002L
+#error "coroutine_lookup.h needs C++20: configure with -DBUILD_WITH_CXX20=ON."
+#endif
+
+#include <algorithm>  // Header for std::max.
+#include <coroutine>  // Header for std::coroutine_handle.
+#include <cstddef>  // Header for std::size_t.
+#include <exception>  // Header for std::terminate.
+#include <new>  // Header for operator new.
+#include <utility>  // Header for std::exchange.
+#include <vector>  // Header for std::vector.
+
+#include "aligned_memory.h"
+#include "incremental_hash_map.h"
+#include "tree_set.h"
+
+namespace cpp_labs {
+namespace internal {
+
+// Per-thread free lists of coroutine frames, by size class of 64 bytes. The
+// blocks are returned to the system when the thread exits.
+class CoroutineFramePool {
+ public:
+  static void* Allocate(const std::size_t bytes) {
+    const std::size_t size_class = SizeClass(bytes);
+    if (size_class >= kNumSizeClasses) {
+      return ::operator new(bytes);
+    }
+    FreeBlock*& head = Lists().heads[size_class];
+    if (head == nullptr) {
+      return ::operator new(size_class * kBlockGranularity);
+    }
+    FreeBlock* block = head;
+    head = block->next;
+    return block;
+  }
+
+  static void Free(void* memory, const std::size_t bytes) {
+    const std::size_t size_class = SizeClass(bytes);
+    if (size_class >= kNumSizeClasses) {
+      ::operator delete(memory);
+      return;
+    }
+    FreeBlock* block = static_cast<FreeBlock*>(memory);
+    FreeBlock*& head = Lists().heads[size_class];
+    block->next = head;
+    head = block;
+  }
+
+ private:
+  // Frame sizes are rounded up to multiples of it; the blocks keep the
+  // alignment of operator new.
+  static const std::size_t kBlockGranularity = 64;
+  static const std::size_t kNumSizeClasses = 32;
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct FreeLists {
+    FreeLists() : heads() {}
+    ~FreeLists() {
+      for (FreeBlock* head : heads) {
+        while (head != nullptr) {
+          FreeBlock* next = head->next;
+          ::operator delete(head);
+          head = next;
+        }
+      }
+    }
+    FreeBlock* heads[kNumSizeClasses];
+  };
+
+  static std::size_t SizeClass(const std::size_t bytes) {
+    return (bytes + kBlockGranularity - 1) / kBlockGranularity;
+  }
+
+  static FreeLists& Lists() {
+    thread_local FreeLists lists;
+    return lists;
+  }
+};
+
+}  // namespace internal
+
+// The coroutine of one lookup, with a result of type T (default
+// constructible). It starts suspended; Resume runs it to its next suspension.
+template <typename T>
+class LookupTask {
+ public:
+  struct promise_type {
+    static void* operator new(const std::size_t bytes) {
+      return internal::CoroutineFramePool::Allocate(bytes);
+    }
+    static void operator delete(void* memory, const std::size_t bytes) {
+      internal::CoroutineFramePool::Free(memory, bytes);
+    }
+
+    LookupTask get_return_object() {
+      return LookupTask(
+          std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_value(const T& value) { result = value; }
+    void unhandled_exception() { std::terminate(); }
+
+    T result;
+  };
+
+  LookupTask() : handle_(nullptr) {}
+  LookupTask(LookupTask&& other) noexcept
+      : handle_(std::exchange(other.handle_, nullptr)) {}
+  LookupTask& operator=(LookupTask&& other) noexcept {
+    if (this != &other) {
+      if (handle_) {
+        handle_.destroy();
+      }
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+  ~LookupTask() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  bool valid() const { return static_cast<bool>(handle_); }
+
+  // Runs the lookup until it suspends again; returns true once it is done.
+  bool Resume() {
+    handle_.resume();
+    return handle_.done();
+  }
+
+  const T& result() const { return handle_.promise().result; }
+
+ private:
+  explicit LookupTask(const std::coroutine_handle<promise_type> handle)
+      : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+// co_await PrefetchAndSuspend{address} starts loading the cache line of
+// address and suspends the lookup until the executor resumes it.
+struct PrefetchAndSuspend {
+  bool await_ready() const noexcept {
+    PrefetchCacheLine(address);
+    return false;
+  }
+  void await_suspend(std::coroutine_handle<>) const noexcept {}
+  void await_resume() const noexcept {}
+
+  const void* address;
+};
+
+// TreeSet::contains, suspending before every node it reads.
+template <typename Key, typename NodePolicy>
+LookupTask<bool> TreeSetContains(const TreeSet<Key, NodePolicy>& set,
+                                 const Key key) {
+  typename TreeSet<Key, NodePolicy>::Pointer node = set.root();
+  while (node) {
+    co_await PrefetchAndSuspend{&*node};
+    if (key < node->key()) {
+      node = node->left();
+    } else if (node->key() < key) {
+      node = node->right();
+    } else {
+      co_return true;
+    }
+  }
+  co_return false;
+}
+
+// IncrementalHashMap::find, suspending once after prefetching the slot where
+// the probe starts (linear probing rarely goes past its cache line).
+template <typename Key, typename Value, typename Hash>
+LookupTask<const Value*> IncrementalHashMapFind(
+    const IncrementalHashMap<Key, Value, Hash>& map, const Key key) {
+  map.prefetch(key);
+  co_await std::suspend_always();
+  co_return map.find(key);
+}
+
+// Runs lookup(keys[i]) for every key, with up to group_size lookups in flight
+// at once (at least one), and calls output(i, result) as each one finishes.
+// lookup returns a LookupTask.
+template <typename Key, typename Lookup, typename Output>
+void InterleavedLookups(const Key* keys, const std::size_t num_keys,
+                        const std::size_t group_size, Lookup lookup,
+                        Output output) {
+  typedef decltype(lookup(keys[0])) Task;
+  const std::size_t max_in_flight = std::max<std::size_t>(group_size, 1);
+  std::vector<Task> tasks;
+  std::vector<std::size_t> indices;
+  std::size_t next_key = 0;
+  for (; next_key < num_keys && tasks.size() < max_in_flight; ++next_key) {
+    tasks.push_back(lookup(keys[next_key]));
+    indices.push_back(next_key);
+  }
+  // Round robin over the group: each lookup advances to its next miss.
+  std::size_t num_active = tasks.size();
+  while (num_active > 0) {
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+      if (!tasks[i].valid() || !tasks[i].Resume()) {
+        continue;
+      }
+      output(indices[i], tasks[i].result());
+      if (next_key < num_keys) {
+        tasks[i] = lookup(keys[next_key]);
+        indices[i] = next_key++;
+      } else {
+        tasks[i] = Task();
+        --num_active;
+      }
+    }
+  }
+}
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_COROUTINE_LOOKUP_H_
@@ -0,0 +1,213 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary measures random lookups in tables far larger than the
+// last-level cache, one at a time (find, as in set_example.cc and
+// unordered_map_example.cc) and interleaved with coroutines (see
+// coroutine_lookup.h).
+//
+// Usage: coroutine_lookup_benchmark [num_keys] [num_lookups]
+//   Defaults: num_keys = 16000000, num_lookups = 4000000.
+//   Built only with cmake -DBUILD_WITH_CXX20=ON.
+//
+// The tables hold num_keys random 64-bit keys (about 0.5-1 GB each), and the
+// lookups are for keys of the table in a random order. For each table it
+// reports the millions of lookups per second of:
+//
+// 1. find: one lookup after the other.
+// 2. coroutines, group of G: G lookups in flight, each one suspended at every
+// node (TreeSet) or once before its slot (IncrementalHashMap). A group of 1
+// shows the overhead of the coroutines alone.
+//
+// Notes:
+//
+// 1. std::set and std::unordered_map are there for reference: their nodes and
+// buckets are not reachable from outside, so they cannot be interleaved.
+// 2. Coroutines pay off when every lookup is a chain of dependent misses (a
+// tree: ~25 levels here), which the CPU cannot overlap by itself. A lookup in
+// an open-addressing hash table is a single miss, and out-of-order execution
+// already overlaps the misses of several consecutive find calls, since they
+// are independent; there the coroutines (~20 ns of overhead per lookup) can
+// be slower than the plain loop.
+// 3. Every row checks that all the keys are found.
+
+#include <cstdint>  // Header for uint64_t.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <random>  // Header for std::mt19937_64.
+#include <set>  // Header for std::set.
+#include <string>  // Header for std::string.
+#include <unordered_map>  // Header for std::unordered_map.
+#include <vector>  // Header for std::vector.
+
+#include "benchmark_utils.h"
+#include "coroutine_lookup.h"
+#include "incremental_hash_map.h"
+#include "tree_set.h"
+
+namespace {
+
+const std::size_t kGroupSizes[] = {1, 4, 8, 16, 32};
+
+void PrintRow(const std::string& table, const std::string& method,
+              const double seconds, const std::size_t num_lookups,
+              const double baseline_seconds, const std::size_t num_found) {
+  std::cout << std::setw(30) << table << std::setw(26) << method
+            << std::setw(12) << num_lookups / seconds / 1e6 << std::setw(10)
+            << baseline_seconds / seconds
+            << (num_found == num_lookups ? "" : "   MISSING KEYS")
+            << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t num_keys =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, 16000000);
+  const std::size_t num_lookups =
+      cpp_labs::ParseSizeArgument(argc, argv, 2, 4000000);
+  if (num_keys == 0) {
+    std::cerr << "num_keys must be positive." << std::endl;
+    return 1;
+  }
+
+  std::mt19937_64 random(47);
+  std::vector<uint64_t> keys(num_keys);
+  for (uint64_t& key : keys) {
+    key = random();
+  }
+  std::vector<uint64_t> lookups(num_lookups);
+  for (uint64_t& key : lookups) {
+    key = keys[random() % num_keys];
+  }
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << num_keys << " keys, " << num_lookups << " lookups\n";
+  std::cout << std::setw(30) << "table" << std::setw(26) << "method"
+            << std::setw(12) << "M lookups/s" << std::setw(10) << "speedup"
+            << std::endl;
+  cpp_labs::Timer timer;
+
+  {
+    std::set<uint64_t> set(keys.begin(), keys.end());
+    std::size_t num_found = 0;
+    timer.Reset();
+    for (const uint64_t key : lookups) {
+      num_found += set.find(key) != set.end() ? 1 : 0;
+    }
+    const double seconds = timer.ElapsedSeconds();
+    PrintRow("std::set", "find", seconds, num_lookups, seconds, num_found);
+  }
+
+  {
+    cpp_labs::TreeSet<uint64_t> set;
+    for (const uint64_t key : keys) {
+      set.insert(key);
+    }
+    std::size_t num_found = 0;
+    timer.Reset();
+    for (const uint64_t key : lookups) {
+      num_found += set.contains(key) ? 1 : 0;
+    }
+    const double find_seconds = timer.ElapsedSeconds();
+    PrintRow("TreeSet", "find", find_seconds, num_lookups, find_seconds,
+             num_found);
+    for (const std::size_t group_size : kGroupSizes) {
+      num_found = 0;
+      timer.Reset();
+      cpp_labs::InterleavedLookups(
+          lookups.data(), lookups.size(), group_size,
+          [&set](const uint64_t key) {
+            return cpp_labs::TreeSetContains(set, key);
+          },
+          [&num_found](const std::size_t, const bool found) {
+            num_found += found ? 1 : 0;
+          });
+      PrintRow("TreeSet",
+               "coroutines, group of " + std::to_string(group_size),
+               timer.ElapsedSeconds(), num_lookups, find_seconds, num_found);
+    }
+  }
+
+  {
+    std::unordered_map<uint64_t, uint64_t> map;
+    map.reserve(num_keys);
+    for (const uint64_t key : keys) {
+      map.emplace(key, key);
+    }
+    std::size_t num_found = 0;
+    timer.Reset();
+    for (const uint64_t key : lookups) {
+      num_found += map.find(key) != map.end() ? 1 : 0;
+    }
+    const double seconds = timer.ElapsedSeconds();
+    PrintRow("std::unordered_map", "find", seconds, num_lookups, seconds,
+             num_found);
+  }
+
+  {
+    cpp_labs::IncrementalHashMap<uint64_t, uint64_t> map;
+    for (const uint64_t key : keys) {
+      map.insert(key, key);
+    }
+    // Finishes any migration, so that every lookup probes one table.
+    while (map.is_migrating()) {
+      map.insert(keys[0], keys[0]);
+    }
+    std::size_t num_found = 0;
+    timer.Reset();
+    for (const uint64_t key : lookups) {
+      num_found += map.find(key) != nullptr ? 1 : 0;
+    }
+    const double find_seconds = timer.ElapsedSeconds();
+    PrintRow("IncrementalHashMap", "find", find_seconds, num_lookups,
+             find_seconds, num_found);
+    for (const std::size_t group_size : kGroupSizes) {
+      num_found = 0;
+      timer.Reset();
+      cpp_labs::InterleavedLookups(
+          lookups.data(), lookups.size(), group_size,
+          [&map](const uint64_t key) {
+            return cpp_labs::IncrementalHashMapFind(map, key);
+          },
+          [&num_found](const std::size_t, const uint64_t* value) {
+            num_found += value != nullptr ? 1 : 0;
+          });
+      PrintRow("IncrementalHashMap",
+               "coroutines, group of " + std::to_string(group_size),
+               timer.ElapsedSeconds(), num_lookups, find_seconds, num_found);
+    }
+  }
+  return 0;
+}
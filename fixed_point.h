@@ -0,0 +1,188 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_FIXED_POINT_H_
+#define CPP_LABS_FIXED_POINT_H_
+
+// Fixed<IntBits, FracBits> is a signed fixed-point number: an integer that
+// counts units of 2^-FracBits. IntBits includes the sign bit, and
+// IntBits + FracBits must be 8, 16, 32 or 64, the size of the integer that
+// stores it. For example, Fixed<8, 8> takes 2 bytes and represents values in
+// [-128, 128) in steps of 1/256.
+//
+// Compared with float:
+//
+// 1. It can take less memory (Fixed<8, 8> is half of a float), which matters
+// when a loop is bound by memory bandwidth.
+// 2. Addition and subtraction are integer operations, so they are exact and
+// associative: summing a column in any order (e.g., with SIMD) gives the same
+// result, unlike float.
+// 3. The range is fixed: results of arithmetic outside of it wrap around, like
+// int, while conversions from double saturate to the closest end of the range
+// (NaN becomes 0). Multiplication and division round toward zero.
+
+#include <cstdint>  // Header for int8_t, ..., int64_t.
+#include <limits>  // Header for std::numeric_limits.
+#include <type_traits>  // Header for std::make_unsigned.
+
+namespace cpp_labs {
+namespace internal {
+
+// The signed integer type of the given number of bits.
+template <int NumBits>
+struct FixedStorage;
+template <>
+struct FixedStorage<8> {
+  typedef int8_t type;
+  typedef int16_t wide_type;
+};
+template <>
+struct FixedStorage<16> {
+  typedef int16_t type;
+  typedef int32_t wide_type;
+};
+template <>
+struct FixedStorage<32> {
+  typedef int32_t type;
+  typedef int64_t wide_type;
+};
+template <>
+struct FixedStorage<64> {
+  typedef int64_t type;
+  typedef __int128 wide_type;
+};
+
+// Rounds scaled to the nearest Raw, saturating values out of the range of Raw
+// (converting them directly would be undefined behavior).
+template <typename Raw>
+constexpr Raw RoundAndSaturate(const double scaled) {
+  return scaled != scaled
+             ? Raw(0)
+             : scaled <= static_cast<double>(std::numeric_limits<Raw>::min())
+                   ? std::numeric_limits<Raw>::min()
+                   : scaled >= static_cast<double>(
+                                   std::numeric_limits<Raw>::max())
+                         ? std::numeric_limits<Raw>::max()
+                         : static_cast<Raw>(scaled +
+                                            (scaled < 0 ? -0.5 : 0.5));
+}
+
+}  // namespace internal
+
+template <int IntBits, int FracBits>
+class Fixed {
+ public:
+  static_assert(IntBits >= 1 && FracBits >= 0,
+                "A fixed-point type needs at least the sign bit.");
+
+  // The integer that stores the value, and a twice as wide one for products.
+  typedef typename internal::FixedStorage<IntBits + FracBits>::type raw_type;
+  typedef typename internal::FixedStorage<IntBits + FracBits>::wide_type
+      wide_type;
+
+  static constexpr int kIntBits = IntBits;
+  static constexpr int kFracBits = FracBits;
+
+  constexpr Fixed() : raw_(0) {}
+  // Rounds to the nearest representable value (see note 3).
+  constexpr explicit Fixed(const double value)
+      : raw_(internal::RoundAndSaturate<raw_type>(value * kScale)) {}
+  constexpr explicit Fixed(const int value)
+      : raw_(static_cast<raw_type>(static_cast<wide_type>(value) *
+                                   (static_cast<wide_type>(1) << FracBits))) {}
+
+  // Builds the number whose stored integer is raw.
+  static constexpr Fixed FromRaw(const raw_type raw) { return Fixed(raw, 0); }
+
+  constexpr raw_type raw() const { return raw_; }
+  constexpr float ToFloat() const { return static_cast<float>(raw_ / kScale); }
+  constexpr double ToDouble() const { return raw_ / kScale; }
+  constexpr explicit operator float() const { return ToFloat(); }
+  constexpr explicit operator double() const { return ToDouble(); }
+
+  // Addition and subtraction wrap around (through the unsigned type, as
+  // signed overflow is undefined).
+  constexpr Fixed operator+(const Fixed rhs) const {
+    return FromRaw(static_cast<raw_type>(static_cast<unsigned_type>(raw_) +
+                                         static_cast<unsigned_type>(rhs.raw_)));
+  }
+  constexpr Fixed operator-(const Fixed rhs) const {
+    return FromRaw(static_cast<raw_type>(static_cast<unsigned_type>(raw_) -
+                                         static_cast<unsigned_type>(rhs.raw_)));
+  }
+  constexpr Fixed operator-() const {
+    return FromRaw(static_cast<raw_type>(-static_cast<unsigned_type>(raw_)));
+  }
+  constexpr Fixed operator*(const Fixed rhs) const {
+    return FromRaw(static_cast<raw_type>(
+        static_cast<wide_type>(raw_) * rhs.raw_ / (static_cast<wide_type>(1)
+                                                   << FracBits)));
+  }
+  constexpr Fixed operator/(const Fixed rhs) const {
+    return FromRaw(static_cast<raw_type>(
+        static_cast<wide_type>(raw_) * (static_cast<wide_type>(1) << FracBits) /
+        rhs.raw_));
+  }
+
+  Fixed& operator+=(const Fixed rhs) { return *this = *this + rhs; }
+  Fixed& operator-=(const Fixed rhs) { return *this = *this - rhs; }
+  Fixed& operator*=(const Fixed rhs) { return *this = *this * rhs; }
+  Fixed& operator/=(const Fixed rhs) { return *this = *this / rhs; }
+
+  constexpr bool operator==(const Fixed rhs) const { return raw_ == rhs.raw_; }
+  constexpr bool operator!=(const Fixed rhs) const { return raw_ != rhs.raw_; }
+  constexpr bool operator<(const Fixed rhs) const { return raw_ < rhs.raw_; }
+  constexpr bool operator<=(const Fixed rhs) const { return raw_ <= rhs.raw_; }
+  constexpr bool operator>(const Fixed rhs) const { return raw_ > rhs.raw_; }
+  constexpr bool operator>=(const Fixed rhs) const { return raw_ >= rhs.raw_; }
+
+  // The smallest step between two values, 2^-FracBits.
+  static constexpr double Resolution() { return 1.0 / kScale; }
+
+ private:
+  typedef typename std::make_unsigned<raw_type>::type unsigned_type;
+
+  static constexpr double kScale = static_cast<double>(1ull << FracBits);
+
+  constexpr Fixed(const raw_type raw, int) : raw_(raw) {}
+
+  raw_type raw_;
+};
+
+template <int IntBits, int FracBits>
+constexpr double Fixed<IntBits, FracBits>::kScale;
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_FIXED_POINT_H_
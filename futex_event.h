@@ -0,0 +1,161 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_FUTEX_EVENT_H_
+#define CPP_LABS_FUTEX_EVENT_H_
+
+// FutexEvent lets a thread sleep until another thread signals that something
+// changed (e.g., a queue is no longer empty), without a mutex.
+//
+// On Linux the sleep is a futex: the kernel puts the thread to sleep only if
+// a 32-bit counter still has the value the thread saw, so a signal that
+// arrives between the check and the sleep is never lost. Signaling is a fence
+// and an atomic load unless a thread went to sleep since the last signal,
+// which keeps the fast path of a lock-free queue free of system calls. On
+// other systems waiting falls back to yielding the processor.
+//
+// Usage (waiter):
+//   while (!queue.try_pop(&value)) {
+//     const uint32_t key = event.PrepareWait();
+//     if (queue.try_pop(&value)) {   // Check again after PrepareWait.
+//       event.CancelWait();
+//       break;
+//     }
+//     event.Wait(key);               // Returns after a Notify (or spuriously).
+//   }
+// Usage (notifier):
+//   if (queue.try_push(value)) {
+//     event.Notify();
+//   }
+
+#include <atomic>  // Header for std::atomic.
+#include <climits>  // Header for INT_MAX.
+#include <cstdint>  // Header for uint32_t.
+#include <thread>  // Header for std::this_thread::yield.
+
+#if defined(__linux__)
+#include <linux/futex.h>  // Header for FUTEX_WAIT and FUTEX_WAKE.
+#include <sys/syscall.h>  // Header for SYS_futex.
+#include <unistd.h>  // Header for syscall.
+#endif
+
+namespace cpp_labs {
+
+// Hints the processor that this is a spin-wait loop.
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+class FutexEvent {
+ public:
+  FutexEvent() : epoch_(0), has_waiters_(false) {}
+
+  FutexEvent(const FutexEvent&) = delete;
+  FutexEvent& operator=(const FutexEvent&) = delete;
+
+  // Registers the calling thread as a waiter. The caller must check its
+  // condition again afterwards and then call Wait or CancelWait.
+  uint32_t PrepareWait() {
+    has_waiters_.store(true, std::memory_order_seq_cst);
+    return epoch_.load(std::memory_order_seq_cst);
+  }
+
+  // Sleeps until Notify is called after PrepareWait returned key.
+  void Wait(const uint32_t key) {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_),
+            FUTEX_WAIT_PRIVATE, key, nullptr, nullptr, 0);
+#else
+    if (epoch_.load(std::memory_order_acquire) == key) {
+      std::this_thread::yield();
+    }
+#endif
+  }
+
+  // Leaves has_waiters_ set: at worst the next Notify makes one system call
+  // that wakes nobody.
+  void CancelWait() {}
+
+  // Wakes up all the waiting threads. Call it after making the condition
+  // true. Only the first Notify after the waiters went to sleep makes a
+  // system call; the others (and all of them when nobody waits) cost a
+  // sequentially consistent fence and an atomic load.
+  void Notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (has_waiters_.load(std::memory_order_relaxed) &&
+        has_waiters_.exchange(false, std::memory_order_seq_cst)) {
+      epoch_.fetch_add(1, std::memory_order_seq_cst);
+#if defined(__linux__)
+      syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_),
+              FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+    }
+  }
+
+ private:
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+                "The futex word must be a plain 32-bit integer.");
+
+  std::atomic<uint32_t> epoch_;
+  // Set by every waiter and cleared by the Notify that wakes them up. A
+  // woken thread that still cannot proceed sets it again before sleeping.
+  std::atomic<bool> has_waiters_;
+};
+
+// Blocks until try_operation() succeeds: spins a little (cheap when the other
+// side is about to act) and then sleeps on event.
+template <typename TryOperation>
+void WaitUntil(FutexEvent* event, const TryOperation& try_operation) {
+  const int kNumSpins = 64;
+  for (int i = 0; i < kNumSpins; ++i) {
+    if (try_operation()) {
+      return;
+    }
+    CpuRelax();
+  }
+  while (!try_operation()) {
+    const uint32_t key = event->PrepareWait();
+    if (try_operation()) {
+      event->CancelWait();
+      return;
+    }
+    event->Wait(key);
+  }
+}
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_FUTEX_EVENT_H_
@@ -0,0 +1,569 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_GROWABLE_VECTOR_H_
+#define CPP_LABS_GROWABLE_VECTOR_H_
+
+// GrowableVector<T, GrowthPolicy> is a std::vector-like container whose growth
+// can be controlled and observed.
+//
+// vector_example.cc explains that push_back on a full std::vector allocates a
+// bigger buffer and copies the old elements into it. std::vector does not let
+// us pick how much bigger the new buffer is, nor see when that happens.
+// GrowableVector fixes both:
+//
+// 1. The GrowthPolicy template argument computes the next capacity. The
+// policies below grow by 2x, by 1.5x, by 1.5x rounded to whole pages, or by
+// 1.5x rounded to whole 2 MB huge pages.
+// 2. For types that can be moved with memcpy (trivially relocatable types, see
+// trivially_relocatable.h), the buffer grows with realloc while small and with
+// mremap once it is large. insert and erase shift them with memmove.
+// mremap moves the pages of the buffer to a new virtual address without
+// copying a single byte, so growing a 4 GB buffer costs almost nothing.
+// 3. An optional ReallocationTrace records every reallocation: the old and new
+// capacities and the number of bytes that were copied.
+//
+// Example:
+//   ReallocationTrace trace;
+//   GrowableVector<int, OneAndHalfGrowthPolicy> my_vector;
+//   my_vector.set_trace(&trace);
+//   for (int i = 0; i < 1000; ++i) {
+//     my_vector.push_back(i);
+//   }
+//   trace.Print(std::cout);
+
+#include <algorithm>  // Header for std::max.
+#include <cassert>  // Header for assert.
+#include <cstddef>  // Header for std::size_t.
+#include <cstdlib>  // Header for malloc, realloc and free.
+#include <cstring>  // Header for std::memcpy.
+#include <new>  // Header for std::bad_alloc and placement new.
+#include <ostream>  // Header for std::ostream.
+#include <stdexcept>  // Header for std::out_of_range.
+#include <utility>  // Header for std::move and std::swap.
+#include <vector>  // Header for std::vector.
+
+#if defined(__linux__)
+#include <sys/mman.h>  // Header for mmap, mremap and madvise.
+#include <unistd.h>  // Header for sysconf.
+#endif
+
+#include "trivially_relocatable.h"
+
+namespace cpp_labs {
+namespace internal {
+
+const std::size_t kHugePageSize = 2 * 1024 * 1024;
+
+inline std::size_t PageSize() {
+#if defined(__linux__)
+  static const std::size_t page_size = sysconf(_SC_PAGESIZE);
+  return page_size;
+#else
+  return 4096;
+#endif
+}
+
+inline std::size_t RoundUp(const std::size_t value,
+                           const std::size_t multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+// Smallest non-zero capacity: one cache line worth of elements.
+inline std::size_t MinCapacity(const std::size_t element_size) {
+  return std::max<std::size_t>(1, 64 / element_size);
+}
+
+}  // namespace internal
+
+// Growth policies. NextCapacity returns the new capacity (in elements) when
+// the vector is full and needs room for at least required elements.
+// kAdviseHugePages asks the kernel to back large buffers with huge pages.
+
+// Doubles the capacity, as libstdc++ and libc++ do.
+struct DoublingGrowthPolicy {
+  static const bool kAdviseHugePages = false;
+  static const char* Name() { return "2x"; }
+  static std::size_t NextCapacity(const std::size_t capacity,
+                                  const std::size_t required,
+                                  const std::size_t element_size) {
+    return std::max(required, capacity == 0
+                                  ? internal::MinCapacity(element_size)
+                                  : 2 * capacity);
+  }
+};
+
+// Grows by 1.5x, as MSVC and folly::fbvector do. Wastes less memory than 2x
+// and lets the allocator reuse previously freed blocks.
+struct OneAndHalfGrowthPolicy {
+  static const bool kAdviseHugePages = false;
+  static const char* Name() { return "1.5x"; }
+  static std::size_t NextCapacity(const std::size_t capacity,
+                                  const std::size_t required,
+                                  const std::size_t element_size) {
+    return std::max(required, capacity < 2
+                                  ? internal::MinCapacity(element_size)
+                                  : capacity + capacity / 2);
+  }
+};
+
+// Grows by 1.5x and, once the buffer is larger than a page, rounds the buffer
+// up to a whole number of pages. The kernel hands out whole pages anyway, so
+// the rounding turns the slack at the end of the last page into capacity.
+struct PageAlignedGrowthPolicy {
+  static const bool kAdviseHugePages = false;
+  static const char* Name() { return "1.5x page-aligned"; }
+  static std::size_t NextCapacity(const std::size_t capacity,
+                                  const std::size_t required,
+                                  const std::size_t element_size) {
+    const std::size_t new_capacity = OneAndHalfGrowthPolicy::NextCapacity(
+        capacity, required, element_size);
+    const std::size_t bytes = new_capacity * element_size;
+    if (bytes < internal::PageSize()) {
+      return new_capacity;
+    }
+    return internal::RoundUp(bytes, internal::PageSize()) / element_size;
+  }
+};
+
+// Like PageAlignedGrowthPolicy, but once the buffer reaches 2 MB it is rounded
+// up to whole 2 MB huge pages and the kernel is asked to back it with
+// transparent huge pages, which cuts TLB misses on large vectors.
+struct HugePageAwareGrowthPolicy {
+  static const bool kAdviseHugePages = true;
+  static const char* Name() { return "1.5x huge-page-aware"; }
+  static std::size_t NextCapacity(const std::size_t capacity,
+                                  const std::size_t required,
+                                  const std::size_t element_size) {
+    const std::size_t new_capacity = PageAlignedGrowthPolicy::NextCapacity(
+        capacity, required, element_size);
+    const std::size_t bytes = new_capacity * element_size;
+    if (bytes < internal::kHugePageSize) {
+      return new_capacity;
+    }
+    return internal::RoundUp(bytes, internal::kHugePageSize) / element_size;
+  }
+};
+
+// How the buffer was grown.
+enum class ReallocationMethod {
+  // New buffer, elements moved one by one, old buffer released.
+  kMoveElements,
+  // Elements copied with memcpy into a new buffer (e.g., malloc to mmap).
+  kCopyBytes,
+  // realloc, which may extend the buffer in place.
+  kRealloc,
+  // mremap, which moves pages instead of bytes.
+  kMremap,
+};
+
+inline const char* ReallocationMethodName(const ReallocationMethod method) {
+  switch (method) {
+    case ReallocationMethod::kMoveElements: return "move";
+    case ReallocationMethod::kCopyBytes: return "memcpy";
+    case ReallocationMethod::kRealloc: return "realloc";
+    case ReallocationMethod::kMremap: return "mremap";
+  }
+  return "unknown";
+}
+
+struct ReallocationEvent {
+  std::size_t old_capacity;
+  std::size_t new_capacity;
+  // Number of elements in the vector when it was reallocated.
+  std::size_t size;
+  // Bytes copied by the reallocation. realloc reports an upper bound: the
+  // size of the elements if the buffer moved, zero if it grew in place.
+  // mremap always reports zero.
+  std::size_t bytes_moved;
+  ReallocationMethod method;
+};
+
+// Log of the reallocations of one or more vectors.
+class ReallocationTrace {
+ public:
+  void Record(const ReallocationEvent& event) { events_.push_back(event); }
+
+  const std::vector<ReallocationEvent>& events() const { return events_; }
+
+  std::size_t TotalBytesMoved() const {
+    std::size_t total = 0;
+    for (const ReallocationEvent& event : events_) {
+      total += event.bytes_moved;
+    }
+    return total;
+  }
+
+  void Clear() { events_.clear(); }
+
+  // Writes one line per reallocation.
+  void Print(std::ostream& stream) const {
+    for (const ReallocationEvent& event : events_) {
+      stream << "capacity " << event.old_capacity << " -> "
+             << event.new_capacity << " size " << event.size << " moved "
+             << event.bytes_moved << " bytes ("
+             << ReallocationMethodName(event.method) << ")\n";
+    }
+  }
+
+ private:
+  std::vector<ReallocationEvent> events_;
+};
+
+template <typename T, typename GrowthPolicy = DoublingGrowthPolicy>
+class GrowableVector {
+ public:
+  typedef T value_type;
+  typedef T* iterator;
+  typedef const T* const_iterator;
+  typedef std::size_t size_type;
+
+  // Types that can be moved with memcpy use realloc and mremap to grow.
+  static const bool kRelocatable = IsTriviallyRelocatable<T>::value;
+
+  // Buffers of at least this many bytes are allocated with mmap, so that they
+  // can grow with mremap.
+  static const std::size_t kMapThreshold = 1024 * 1024;
+
+  GrowableVector()
+      : data_(nullptr), size_(0), capacity_(0), mapped_bytes_(0),
+        trace_(nullptr) {}
+
+  explicit GrowableVector(const std::size_t size, const T& value = T())
+      : data_(nullptr), size_(0), capacity_(0), mapped_bytes_(0),
+        trace_(nullptr) {
+    resize(size, value);
+  }
+
+  GrowableVector(const GrowableVector& other)
+      : data_(nullptr), size_(0), capacity_(0), mapped_bytes_(0),
+        trace_(nullptr) {
+    reserve(other.size_);
+    for (std::size_t i = 0; i < other.size_; ++i) {
+      ::new (static_cast<void*>(data_ + i)) T(other.data_[i]);
+    }
+    size_ = other.size_;
+  }
+
+  GrowableVector(GrowableVector&& other)
+      : data_(other.data_), size_(other.size_), capacity_(other.capacity_),
+        mapped_bytes_(other.mapped_bytes_), trace_(other.trace_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.capacity_ = 0;
+    other.mapped_bytes_ = 0;
+  }
+
+  GrowableVector& operator=(GrowableVector other) {
+    swap(other);
+    return *this;
+  }
+
+  ~GrowableVector() {
+    clear();
+    Release(data_, mapped_bytes_);
+  }
+
+  void swap(GrowableVector& other) {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(mapped_bytes_, other.mapped_bytes_);
+    std::swap(trace_, other.trace_);
+  }
+
+  // Every reallocation is recorded into trace (if not null). The trace must
+  // outlive the vector or be reset with set_trace(nullptr).
+  void set_trace(ReallocationTrace* trace) { trace_ = trace; }
+
+  std::size_t size() const { return size_; }
+  std::size_t capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+
+  T* data() { return data_; }
+  const T* data() const { return data_; }
+  T* begin() { return data_; }
+  T* end() { return data_ + size_; }
+  const T* begin() const { return data_; }
+  const T* end() const { return data_ + size_; }
+
+  T& operator[](const std::size_t index) {
+    assert(index < size_);
+    return data_[index];
+  }
+  const T& operator[](const std::size_t index) const {
+    assert(index < size_);
+    return data_[index];
+  }
+
+  T& at(const std::size_t index) {
+    if (index >= size_) {
+      throw std::out_of_range("GrowableVector::at");
+    }
+    return data_[index];
+  }
+
+  T& front() { return data_[0]; }
+  T& back() { return data_[size_ - 1]; }
+  const T& front() const { return data_[0]; }
+  const T& back() const { return data_[size_ - 1]; }
+
+  // Unlike growing through push_back, reserve allocates exactly what is asked
+  // (rounded up to whole pages for mapped buffers).
+  void reserve(const std::size_t new_capacity) {
+    if (new_capacity > capacity_) {
+      Reallocate(new_capacity);
+    }
+  }
+
+  void push_back(const T& value) {
+    if (size_ == capacity_) {
+      // value may alias an element of this vector, so copy it first.
+      T copy(value);
+      Grow(size_ + 1);
+      ::new (static_cast<void*>(data_ + size_)) T(std::move(copy));
+    } else {
+      ::new (static_cast<void*>(data_ + size_)) T(value);
+    }
+    ++size_;
+  }
+
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <typename... Arguments>
+  T& emplace_back(Arguments&&... arguments) {
+    if (size_ == capacity_) {
+      // The arguments may refer to an element of this vector, which Grow
+      // frees: build the element first.
+      T value(std::forward<Arguments>(arguments)...);
+      Grow(size_ + 1);
+      ::new (static_cast<void*>(data_ + size_)) T(std::move(value));
+    } else {
+      ::new (static_cast<void*>(data_ + size_))
+          T(std::forward<Arguments>(arguments)...);
+    }
+    return data_[size_++];
+  }
+
+  void pop_back() {
+    assert(size_ > 0);
+    data_[--size_].~T();
+  }
+
+  // Inserts value before position. The elements after position are shifted
+  // with one memmove for relocatable types.
+  T* insert(const T* position, const T& value) {
+    T copy(value);
+    return emplace(position, std::move(copy));
+  }
+
+  T* insert(const T* position, T&& value) {
+    return emplace(position, std::move(value));
+  }
+
+  template <typename... Arguments>
+  T* emplace(const T* position, Arguments&&... arguments) {
+    const std::size_t index = position - data_;
+    assert(index <= size_);
+    // Build the element first: the arguments may refer to this vector.
+    T value(std::forward<Arguments>(arguments)...);
+    if (size_ == capacity_) {
+      Grow(size_ + 1);
+    }
+    RelocateRange(data_ + index, size_ - index, data_ + index + 1);
+    ::new (static_cast<void*>(data_ + index)) T(std::move(value));
+    ++size_;
+    return data_ + index;
+  }
+
+  // Removes the elements in [first, last) and shifts the tail down.
+  T* erase(const T* first, const T* last) {
+    const std::size_t begin = first - data_;
+    const std::size_t end = last - data_;
+    assert(begin <= end && end <= size_);
+    for (std::size_t i = begin; i < end; ++i) {
+      data_[i].~T();
+    }
+    RelocateRange(data_ + end, size_ - end, data_ + begin);
+    size_ -= end - begin;
+    return data_ + begin;
+  }
+
+  T* erase(const T* position) { return erase(position, position + 1); }
+
+  void resize(const std::size_t new_size, const T& value = T()) {
+    if (new_size > capacity_) {
+      // value may alias an element of this vector, so copy it first.
+      const T copy(value);
+      Grow(new_size);
+      for (std::size_t i = size_; i < new_size; ++i) {
+        ::new (static_cast<void*>(data_ + i)) T(copy);
+      }
+      size_ = new_size;
+      return;
+    }
+    for (std::size_t i = size_; i < new_size; ++i) {
+      ::new (static_cast<void*>(data_ + i)) T(value);
+    }
+    for (std::size_t i = new_size; i < size_; ++i) {
+      data_[i].~T();
+    }
+    size_ = new_size;
+  }
+
+  void clear() {
+    for (std::size_t i = 0; i < size_; ++i) {
+      data_[i].~T();
+    }
+    size_ = 0;
+  }
+
+ private:
+  static_assert(alignof(T) <= alignof(std::max_align_t),
+                "GrowableVector does not support over-aligned types.");
+
+  void Grow(const std::size_t required) {
+    Reallocate(GrowthPolicy::NextCapacity(capacity_, required, sizeof(T)));
+  }
+
+  void Reallocate(const std::size_t new_capacity) {
+    ReallocationEvent event;
+    event.old_capacity = capacity_;
+    event.size = size_;
+    const std::size_t new_bytes = new_capacity * sizeof(T);
+    if (new_bytes / sizeof(T) != new_capacity) {
+      throw std::bad_alloc();
+    }
+    if (kRelocatable && new_bytes >= kMapThreshold && CanMap()) {
+      ReallocateMapped(new_bytes, &event);
+    } else if (kRelocatable && mapped_bytes_ == 0) {
+      T* new_data = static_cast<T*>(
+          std::realloc(static_cast<void*>(data_), new_bytes));
+      if (new_data == nullptr) {
+        throw std::bad_alloc();
+      }
+      event.method = ReallocationMethod::kRealloc;
+      event.bytes_moved = new_data == data_ ? 0 : size_ * sizeof(T);
+      data_ = new_data;
+      capacity_ = new_capacity;
+    } else {
+      T* new_data = static_cast<T*>(std::malloc(new_bytes));
+      if (new_data == nullptr) {
+        throw std::bad_alloc();
+      }
+      RelocateRange(data_, size_, new_data);
+      event.method = ReallocationMethod::kMoveElements;
+      event.bytes_moved = size_ * sizeof(T);
+      Release(data_, mapped_bytes_);
+      data_ = new_data;
+      mapped_bytes_ = 0;
+      capacity_ = new_capacity;
+    }
+    event.new_capacity = capacity_;
+    if (trace_ != nullptr) {
+      trace_->Record(event);
+    }
+  }
+
+  static bool CanMap() {
+#if defined(__linux__)
+    return true;
+#else
+    return false;
+#endif
+  }
+
+#if defined(__linux__)
+  // Grows (or creates) an mmap-ed buffer. Only called for relocatable types.
+  void ReallocateMapped(const std::size_t requested_bytes,
+                        ReallocationEvent* event) {
+    const std::size_t new_bytes = internal::RoundUp(
+        requested_bytes, GrowthPolicy::kAdviseHugePages
+                             ? internal::kHugePageSize
+                             : internal::PageSize());
+    void* new_data = nullptr;
+    if (mapped_bytes_ != 0) {
+      new_data = mremap(data_, mapped_bytes_, new_bytes, MREMAP_MAYMOVE);
+      if (new_data == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+      event->method = ReallocationMethod::kMremap;
+      event->bytes_moved = 0;
+    } else {
+      new_data = mmap(nullptr, new_bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (new_data == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+      if (size_ > 0) {
+        std::memcpy(new_data, static_cast<void*>(data_), size_ * sizeof(T));
+      }
+      event->method = ReallocationMethod::kCopyBytes;
+      event->bytes_moved = size_ * sizeof(T);
+      std::free(static_cast<void*>(data_));
+    }
+    if (GrowthPolicy::kAdviseHugePages) {
+      madvise(new_data, new_bytes, MADV_HUGEPAGE);
+    }
+    data_ = static_cast<T*>(new_data);
+    mapped_bytes_ = new_bytes;
+    // Whole pages are mapped, so the slack of the last page is capacity too.
+    capacity_ = new_bytes / sizeof(T);
+  }
+#else
+  void ReallocateMapped(const std::size_t requested_bytes,
+                        ReallocationEvent* event) {}
+#endif
+
+  static void Release(T* data, const std::size_t mapped_bytes) {
+#if defined(__linux__)
+    if (mapped_bytes != 0) {
+      munmap(data, mapped_bytes);
+      return;
+    }
+#endif
+    std::free(static_cast<void*>(data));
+  }
+
+  T* data_;
+  std::size_t size_;
+  std::size_t capacity_;
+  // Size of the mapping when the buffer comes from mmap, zero otherwise.
+  std::size_t mapped_bytes_;
+  ReallocationTrace* trace_;
+};
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_GROWABLE_VECTOR_H_
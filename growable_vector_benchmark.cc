@@ -0,0 +1,172 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary measures append (push_back) throughput and peak memory of
+// std::vector against GrowableVector with each of its growth policies.
+//
+// Usage: growable_vector_benchmark [max_elements]  (default: 1000000000)
+//
+// Notes:
+//
+// 1. Every measurement runs in a child process (fork), so the peak resident
+// memory reported by the kernel for that child belongs to that container only.
+// 2. std::vector grows by 2x and copies the elements on every reallocation.
+// Right after the copy both the old and the new buffer are alive, so the peak
+// is about 3x the data size just before the last growth.
+// 3. GrowableVector grows large buffers of ints with mremap, which does not
+// copy, so the old and the new buffers never coexist.
+// 4. Appending 1B ints needs ~4 GB for the data alone. Pass a smaller
+// max_elements on machines with less memory.
+
+#include <cstdint>  // Header for int32_t.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <string>  // Header for std::string.
+#include <vector>  // Header for std::vector.
+
+#include "benchmark_utils.h"
+#include "growable_vector.h"
+
+namespace {
+
+// Results sent from the child process to the parent through a pipe.
+struct Result {
+  double seconds;
+  std::size_t num_reallocations;
+  std::size_t bytes_moved;
+  std::size_t final_capacity;
+};
+
+Result AppendToStdVector(const std::size_t num_elements, const bool reserve) {
+  cpp_labs::Timer timer;
+  std::vector<int32_t> my_vector;
+  if (reserve) {
+    my_vector.reserve(num_elements);
+  }
+  std::size_t num_reallocations = 0;
+  std::size_t bytes_moved = 0;
+  for (std::size_t i = 0; i < num_elements; ++i) {
+    if (my_vector.size() == my_vector.capacity()) {
+      ++num_reallocations;
+      bytes_moved += my_vector.size() * sizeof(int32_t);
+    }
+    my_vector.push_back(static_cast<int32_t>(i));
+  }
+  cpp_labs::DoNotOptimize(my_vector.data());
+  Result result;
+  result.seconds = timer.ElapsedSeconds();
+  result.num_reallocations = num_reallocations;
+  result.bytes_moved = bytes_moved;
+  result.final_capacity = my_vector.capacity();
+  return result;
+}
+
+template <typename GrowthPolicy>
+Result AppendToGrowableVector(const std::size_t num_elements) {
+  cpp_labs::ReallocationTrace trace;
+  cpp_labs::Timer timer;
+  cpp_labs::GrowableVector<int32_t, GrowthPolicy> my_vector;
+  my_vector.set_trace(&trace);
+  for (std::size_t i = 0; i < num_elements; ++i) {
+    my_vector.push_back(static_cast<int32_t>(i));
+  }
+  cpp_labs::DoNotOptimize(my_vector.data());
+  Result result;
+  result.seconds = timer.ElapsedSeconds();
+  result.num_reallocations = trace.events().size();
+  result.bytes_moved = trace.TotalBytesMoved();
+  result.final_capacity = my_vector.capacity();
+  return result;
+}
+
+template <typename Function>
+void Measure(const std::string& name, const std::size_t num_elements,
+             const Function& function) {
+  Result result;
+  long peak_memory_kb = 0;
+  std::cout << std::setw(36) << name;
+  if (!cpp_labs::RunInChildProcess(function, &result, &peak_memory_kb)) {
+    std::cout << "  failed (out of memory?)" << std::endl;
+    return;
+  }
+  const double data_mb = num_elements * sizeof(int32_t) / 1048576.0;
+  std::cout << std::setw(12) << num_elements / result.seconds / 1e6
+            << std::setw(12) << peak_memory_kb / 1024.0 << std::setw(11)
+            << peak_memory_kb / 1024.0 / data_mb << std::setw(10)
+            << result.num_reallocations << std::setw(14)
+            << result.bytes_moved / 1048576.0 << std::endl;
+}
+
+template <typename GrowthPolicy>
+void MeasurePolicy(const std::size_t num_elements) {
+  Measure(std::string("GrowableVector ") + GrowthPolicy::Name(), num_elements,
+          [&]() { return AppendToGrowableVector<GrowthPolicy>(num_elements); });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t max_elements =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, 1000000000);
+
+  // Show what a trace looks like for a small vector.
+  cpp_labs::ReallocationTrace trace;
+  cpp_labs::GrowableVector<int32_t, cpp_labs::HugePageAwareGrowthPolicy>
+      small_vector;
+  small_vector.set_trace(&trace);
+  for (int i = 0; i < 1000000; ++i) {
+    small_vector.push_back(i);
+  }
+  std::cout << "Reallocation trace of 1M push_back with the "
+            << cpp_labs::HugePageAwareGrowthPolicy::Name() << " policy:\n";
+  trace.Print(std::cout);
+
+  for (std::size_t num_elements = 1000000; num_elements <= max_elements;
+       num_elements *= 10) {
+    std::cout << "\nAppending " << num_elements << " int32_t\n"
+              << std::setw(36) << "container" << std::setw(12) << "M/s"
+              << std::setw(12) << "peak MB" << std::setw(11) << "peak/data"
+              << std::setw(10) << "reallocs" << std::setw(14) << "MB moved"
+              << std::endl;
+    Measure("std::vector", num_elements,
+            [&]() { return AppendToStdVector(num_elements, false); });
+    Measure("std::vector + reserve", num_elements,
+            [&]() { return AppendToStdVector(num_elements, true); });
+    MeasurePolicy<cpp_labs::DoublingGrowthPolicy>(num_elements);
+    MeasurePolicy<cpp_labs::OneAndHalfGrowthPolicy>(num_elements);
+    MeasurePolicy<cpp_labs::PageAlignedGrowthPolicy>(num_elements);
+    MeasurePolicy<cpp_labs::HugePageAwareGrowthPolicy>(num_elements);
+  }
+  return 0;
+}
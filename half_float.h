@@ -0,0 +1,326 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_HALF_FLOAT_H_
+#define CPP_LABS_HALF_FLOAT_H_
+
+// 16-bit floating point storage types:
+//
+// 1. Float16 (IEEE 754 half precision): 5 exponent bits and 10 mantissa bits.
+// About 3 significant decimal digits, values up to 65504.
+// 2. BFloat16 ("brain" float): the upper half of a float, with 8 exponent bits
+// and 7 mantissa bits. The range of a float with about 2 significant digits;
+// converting to float is a shift.
+//
+// Both halve the memory (and the memory bandwidth) of a float column. They
+// are storage types: arithmetic converts to float, computes, and rounds the
+// result back (round to nearest even). To process a column, convert blocks of
+// it with ConvertToFloat/ConvertFromFloat, which use F16C or AVX-512 when the
+// compiler targets them (build with -DBUILD_WITH_NATIVE_ARCH=ON) and a scalar
+// loop otherwise.
+//
+// Note: the AVX-512 BF16 instruction that converts float to BFloat16 flushes
+// subnormal values to zero, so with it ConvertFromFloat may differ from the
+// BFloat16(float) constructor for values below about 1e-38.
+
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for uint16_t and uint32_t.
+#include <cstring>  // Header for std::memcpy.
+#include <type_traits>  // Header for std::enable_if.
+
+#if defined(__AVX512F__) || defined(__F16C__) || defined(__AVX2__)
+#include <immintrin.h>  // Header for the SIMD intrinsics.
+#endif
+
+namespace cpp_labs {
+namespace internal {
+
+inline uint32_t FloatBits(const float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+inline float BitsToFloat(const uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Float to half precision, rounding to nearest even; overflows become
+// infinity and NaNs stay NaNs. The subnormal case lets the floating point
+// addition do the rounding (F. Giesen's float_to_half_fast3_rtne).
+inline uint16_t FloatToHalfBits(const float value) {
+  const uint32_t kFloatInfinity = 255u << 23;
+  const uint32_t kHalfOverflow = (127u + 16) << 23;  // 65536.0f.
+  const uint32_t kSubnormalMagic = ((127u - 15) + (23 - 10) + 1) << 23;
+  const uint32_t kSmallestNormal = 113u << 23;  // 2^-14.
+
+  uint32_t bits = FloatBits(value);
+  const uint32_t sign = bits & 0x80000000u;
+  bits ^= sign;
+  uint32_t half;
+  if (bits >= kHalfOverflow) {
+    half = bits > kFloatInfinity ? 0x7E00 : 0x7C00;
+  } else if (bits < kSmallestNormal) {
+    half = FloatBits(BitsToFloat(bits) + BitsToFloat(kSubnormalMagic)) -
+           kSubnormalMagic;
+  } else {
+    const uint32_t mantissa_odd = (bits >> 13) & 1;
+    bits += ((15u - 127) << 23) + 0xFFF;
+    bits += mantissa_odd;
+    half = bits >> 13;
+  }
+  return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+inline float HalfBitsToFloat(const uint16_t half) {
+  const uint32_t kShiftedExponent = 0x7C00u << 13;
+  const uint32_t kMagic = 113u << 23;
+
+  uint32_t bits = (half & 0x7FFFu) << 13;
+  const uint32_t exponent = bits & kShiftedExponent;
+  bits += (127u - 15) << 23;
+  if (exponent == kShiftedExponent) {
+    // Infinity or NaN.
+    bits += (128u - 16) << 23;
+  } else if (exponent == 0) {
+    // Zero or subnormal: renormalize through a floating point subtraction.
+    bits = FloatBits(BitsToFloat(bits + (1u << 23)) - BitsToFloat(kMagic));
+  }
+  return BitsToFloat(bits | ((half & 0x8000u) << 16));
+}
+
+// Float to BFloat16, rounding to nearest even; NaNs stay (quiet) NaNs.
+inline uint16_t FloatToBFloat16Bits(const float value) {
+  const uint32_t bits = FloatBits(value);
+  if ((bits & 0x7FFFFFFFu) > 0x7F800000u) {
+    return static_cast<uint16_t>((bits >> 16) | 0x40);
+  }
+  return static_cast<uint16_t>((bits + 0x7FFF + ((bits >> 16) & 1)) >> 16);
+}
+
+inline float BFloat16BitsToFloat(const uint16_t bits) {
+  return BitsToFloat(static_cast<uint32_t>(bits) << 16);
+}
+
+}  // namespace internal
+
+class Float16 {
+ public:
+  Float16() : bits_(0) {}
+  explicit Float16(const float value)
+      : bits_(internal::FloatToHalfBits(value)) {}
+
+  static Float16 FromBits(const uint16_t bits) {
+    Float16 result;
+    result.bits_ = bits;
+    return result;
+  }
+
+  uint16_t bits() const { return bits_; }
+  float ToFloat() const { return internal::HalfBitsToFloat(bits_); }
+  explicit operator float() const { return ToFloat(); }
+
+ private:
+  uint16_t bits_;
+};
+
+class BFloat16 {
+ public:
+  BFloat16() : bits_(0) {}
+  explicit BFloat16(const float value)
+      : bits_(internal::FloatToBFloat16Bits(value)) {}
+
+  static BFloat16 FromBits(const uint16_t bits) {
+    BFloat16 result;
+    result.bits_ = bits;
+    return result;
+  }
+
+  uint16_t bits() const { return bits_; }
+  float ToFloat() const { return internal::BFloat16BitsToFloat(bits_); }
+  explicit operator float() const { return ToFloat(); }
+
+ private:
+  uint16_t bits_;
+};
+
+static_assert(sizeof(Float16) == 2 && sizeof(BFloat16) == 2,
+              "The 16-bit types must not have padding.");
+
+namespace internal {
+template <typename T>
+struct IsFloatStorage : std::false_type {};
+template <>
+struct IsFloatStorage<Float16> : std::true_type {};
+template <>
+struct IsFloatStorage<BFloat16> : std::true_type {};
+}  // namespace internal
+
+// Arithmetic and comparisons of the 16-bit types, computed in float.
+template <typename T>
+typename std::enable_if<internal::IsFloatStorage<T>::value, T>::type
+operator+(const T a, const T b) {
+  return T(a.ToFloat() + b.ToFloat());
+}
+
+template <typename T>
+typename std::enable_if<internal::IsFloatStorage<T>::value, T>::type
+operator-(const T a, const T b) {
+  return T(a.ToFloat() - b.ToFloat());
+}
+
+template <typename T>
+typename std::enable_if<internal::IsFloatStorage<T>::value, T>::type
+operator*(const T a, const T b) {
+  return T(a.ToFloat() * b.ToFloat());
+}
+
+template <typename T>
+typename std::enable_if<internal::IsFloatStorage<T>::value, T>::type
+operator/(const T a, const T b) {
+  return T(a.ToFloat() / b.ToFloat());
+}
+
+template <typename T>
+typename std::enable_if<internal::IsFloatStorage<T>::value, bool>::type
+operator==(const T a, const T b) {
+  return a.ToFloat() == b.ToFloat();
+}
+
+template <typename T>
+typename std::enable_if<internal::IsFloatStorage<T>::value, bool>::type
+operator!=(const T a, const T b) {
+  return a.ToFloat() != b.ToFloat();
+}
+
+template <typename T>
+typename std::enable_if<internal::IsFloatStorage<T>::value, bool>::type
+operator<(const T a, const T b) {
+  return a.ToFloat() < b.ToFloat();
+}
+
+template <typename T>
+typename std::enable_if<internal::IsFloatStorage<T>::value, bool>::type
+operator>(const T a, const T b) {
+  return a.ToFloat() > b.ToFloat();
+}
+
+// Converts size values of a column. The SIMD loops handle 16 (AVX-512) or 8
+// (F16C/AVX2) values per iteration and the scalar code the rest.
+inline void ConvertToFloat(const Float16* input, const std::size_t size,
+                           float* output) {
+  std::size_t i = 0;
+#if defined(__AVX512F__)
+  for (; i + 16 <= size; i += 16) {
+    const __m256i half = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(input + i));
+    _mm512_storeu_ps(output + i, _mm512_cvtph_ps(half));
+  }
+#elif defined(__F16C__)
+  for (; i + 8 <= size; i += 8) {
+    const __m128i half =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+    _mm256_storeu_ps(output + i, _mm256_cvtph_ps(half));
+  }
+#endif
+  for (; i < size; ++i) {
+    output[i] = input[i].ToFloat();
+  }
+}
+
+inline void ConvertFromFloat(const float* input, const std::size_t size,
+                             Float16* output) {
+  std::size_t i = 0;
+#if defined(__AVX512F__)
+  for (; i + 16 <= size; i += 16) {
+    const __m256i half = _mm512_cvtps_ph(_mm512_loadu_ps(input + i),
+                                         _MM_FROUND_TO_NEAREST_INT);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), half);
+  }
+#elif defined(__F16C__)
+  for (; i + 8 <= size; i += 8) {
+    const __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(input + i),
+                                         _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), half);
+  }
+#endif
+  for (; i < size; ++i) {
+    output[i] = Float16(input[i]);
+  }
+}
+
+inline void ConvertToFloat(const BFloat16* input, const std::size_t size,
+                           float* output) {
+  std::size_t i = 0;
+#if defined(__AVX512F__)
+  for (; i + 16 <= size; i += 16) {
+    const __m256i bits = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(input + i));
+    _mm512_storeu_si512(output + i,
+                        _mm512_slli_epi32(_mm512_cvtepu16_epi32(bits), 16));
+  }
+#elif defined(__AVX2__)
+  for (; i + 8 <= size; i += 8) {
+    const __m128i bits =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i),
+                        _mm256_slli_epi32(_mm256_cvtepu16_epi32(bits), 16));
+  }
+#endif
+  for (; i < size; ++i) {
+    output[i] = input[i].ToFloat();
+  }
+}
+
+// Without AVX-512 BF16 the scalar loop is integer arithmetic, which the
+// compiler vectorizes.
+inline void ConvertFromFloat(const float* input, const std::size_t size,
+                             BFloat16* output) {
+  std::size_t i = 0;
+#if defined(__AVX512BF16__)
+  for (; i + 16 <= size; i += 16) {
+    const __m256bh bfloat = _mm512_cvtneps_pbh(_mm512_loadu_ps(input + i));
+    std::memcpy(output + i, &bfloat, sizeof(bfloat));
+  }
+#endif
+  for (; i < size; ++i) {
+    output[i] = BFloat16(input[i]);
+  }
+}
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_HALF_FLOAT_H_
@@ -0,0 +1,401 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_HUGE_PAGE_ARENA_H_
+#define CPP_LABS_HUGE_PAGE_ARENA_H_
+
+// Memory backed by huge pages, for large tables read at random.
+//
+// Every access to memory translates a virtual address through the TLB, a
+// small cache of page table entries (about 1500-3000 of them). With 4 KB pages
+// the TLB covers a few MB, so random lookups into a table of several GB (the
+// 'new int[...]' buffers of heap_memory_example.cc, or the std::vector of
+// vector_example.cc, grown large) miss the TLB on almost every access, and
+// each miss walks the page tables: up to four more memory accesses. With 2 MB
+// pages the TLB covers GBs, and with 1 GB pages the page walk is one level.
+//
+// AllocateHugePages tries, in order:
+//
+// 1. kHugeTlb1Gb, kHugeTlb2Mb: mmap with MAP_HUGETLB from the pool of
+// reserved huge pages (e.g., echo 512 > /proc/sys/vm/nr_hugepages). These are
+// guaranteed, but only if the administrator reserved them.
+// 2. kTransparentHugePages: regular memory aligned to 2 MB with
+// madvise(MADV_HUGEPAGE), which lets the kernel use 2 MB pages when it finds
+// free contiguous memory (TransparentHugePageBytes reports how much it did).
+// 3. kSmallPages: regular 4 KB pages, if nothing else works or if requested.
+//
+// HugePageArena hands out memory from such regions (a bump allocator), and
+// HugePageAllocator lets STL containers use an arena. DtlbMissCounter counts
+// the TLB misses of the calling thread with perf_event_open, to check that
+// huge pages actually help.
+
+#include <algorithm>  // Header for std::min and std::max.
+#include <cstddef>  // Header for std::size_t and std::max_align_t.
+#include <cstdint>  // Header for uint64_t.
+#include <cstdio>  // Header for std::sscanf.
+#include <cstring>  // Header for std::memset.
+#include <fstream>  // Header for std::ifstream.
+#include <new>  // Header for std::bad_alloc.
+#include <string>  // Header for std::string.
+#include <vector>  // Header for std::vector.
+
+#include <sys/mman.h>  // Header for mmap, munmap and madvise.
+#if defined(__linux__)
+#include <linux/perf_event.h>  // Header for perf_event_attr.
+#include <sys/ioctl.h>  // Header for ioctl.
+#include <sys/syscall.h>  // Header for SYS_perf_event_open.
+#include <unistd.h>  // Header for syscall, read and close.
+#endif
+
+namespace cpp_labs {
+
+// The pages behind a region, from the largest to the smallest.
+enum class PageBacking {
+  kHugeTlb1Gb,
+  kHugeTlb2Mb,
+  kTransparentHugePages,
+  kSmallPages
+};
+
+inline const char* PageBackingName(const PageBacking backing) {
+  switch (backing) {
+    case PageBacking::kHugeTlb1Gb:
+      return "hugetlb 1 GB";
+    case PageBacking::kHugeTlb2Mb:
+      return "hugetlb 2 MB";
+    case PageBacking::kTransparentHugePages:
+      return "THP 2 MB";
+    case PageBacking::kSmallPages:
+      return "4 KB pages";
+  }
+  return "unknown";
+}
+
+struct HugePageRegion {
+  HugePageRegion()
+      : data(nullptr), bytes(0), backing(PageBacking::kSmallPages) {}
+
+  void* data;
+  // The size of the mapping: the requested bytes rounded up to whole pages.
+  std::size_t bytes;
+  PageBacking backing;
+};
+
+namespace internal {
+
+const std::size_t k2Mb = std::size_t(1) << 21;
+const std::size_t k1Gb = std::size_t(1) << 30;
+// The page size of MAP_HUGETLB goes in the bits above MAP_HUGE_SHIFT (26).
+const int kMapHuge2Mb = 21 << 26;
+const int kMapHuge1Gb = 30 << 26;
+
+inline std::size_t RoundUpTo(const std::size_t value,
+                             const std::size_t multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+inline void* MapHugeTlb(const std::size_t bytes, const int page_flag) {
+#if defined(__linux__) && defined(MAP_HUGETLB)
+  void* memory =
+      mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | page_flag, -1, 0);
+  return memory == MAP_FAILED ? nullptr : memory;
+#else
+  return nullptr;
+#endif
+}
+
+// Maps bytes aligned to alignment, by mapping more and unmapping the rest.
+inline void* MapAligned(const std::size_t bytes, const std::size_t alignment) {
+  void* memory = mmap(nullptr, bytes + alignment, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  char* begin = static_cast<char*>(memory);
+  char* aligned = reinterpret_cast<char*>(
+      RoundUpTo(reinterpret_cast<std::size_t>(begin), alignment));
+  if (aligned != begin) {
+    munmap(begin, aligned - begin);
+  }
+  const std::size_t tail = (begin + bytes + alignment) - (aligned + bytes);
+  if (tail != 0) {
+    munmap(aligned + bytes, tail);
+  }
+  return aligned;
+}
+
+}  // namespace internal
+
+// Maps at least bytes of memory with the largest pages available, starting
+// from max_backing (kSmallPages asks for 4 KB pages only, even when the kernel
+// would use transparent huge pages for all memory). The pages are not
+// touched. Throws std::bad_alloc if no memory can be mapped at all.
+inline HugePageRegion AllocateHugePages(
+    const std::size_t bytes,
+    const PageBacking max_backing = PageBacking::kHugeTlb1Gb) {
+  HugePageRegion region;
+  // 1 GB pages only for regions of at least 1 GB, to waste at most half.
+  if (max_backing == PageBacking::kHugeTlb1Gb && bytes >= internal::k1Gb) {
+    region.bytes = internal::RoundUpTo(bytes, internal::k1Gb);
+    region.data = internal::MapHugeTlb(region.bytes, internal::kMapHuge1Gb);
+    region.backing = PageBacking::kHugeTlb1Gb;
+  }
+  if (region.data == nullptr && max_backing <= PageBacking::kHugeTlb2Mb) {
+    region.bytes = internal::RoundUpTo(bytes, internal::k2Mb);
+    region.data = internal::MapHugeTlb(region.bytes, internal::kMapHuge2Mb);
+    region.backing = PageBacking::kHugeTlb2Mb;
+  }
+  if (region.data == nullptr) {
+    region.bytes = internal::RoundUpTo(bytes == 0 ? 1 : bytes, internal::k2Mb);
+    region.data = internal::MapAligned(region.bytes, internal::k2Mb);
+    region.backing = PageBacking::kSmallPages;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (max_backing != PageBacking::kSmallPages) {
+      // Fails if the kernel has transparent huge pages disabled.
+      if (madvise(region.data, region.bytes, MADV_HUGEPAGE) == 0) {
+        region.backing = PageBacking::kTransparentHugePages;
+      }
+    } else {
+      madvise(region.data, region.bytes, MADV_NOHUGEPAGE);
+    }
+#endif
+  }
+  return region;
+}
+
+inline void FreeHugePages(const HugePageRegion& region) {
+  if (region.data != nullptr) {
+    munmap(region.data, region.bytes);
+  }
+}
+
+// Returns how many bytes of [data, data + bytes) are currently backed by
+// transparent huge pages (the AnonHugePages of /proc/self/smaps), or 0 if the
+// system does not say. Only touched memory is backed by pages at all.
+// smaps counts whole mappings, so the count of each mapping is clipped to its
+// overlap with the range; a mapping that extends past the range may still
+// have its huge pages outside of it, so the result is an upper bound then.
+inline std::size_t TransparentHugePageBytes(const void* data,
+                                            const std::size_t bytes) {
+  const unsigned long begin = reinterpret_cast<unsigned long>(data);
+  const unsigned long end = begin + bytes;
+  std::ifstream smaps("/proc/self/smaps");
+  std::string line;
+  bool in_region = false;
+  std::size_t overlap_bytes = 0;
+  std::size_t total_bytes = 0;
+  while (std::getline(smaps, line)) {
+    unsigned long map_begin = 0;
+    unsigned long map_end = 0;
+    std::size_t kb = 0;
+    // Mapping lines start with "begin-end "; field lines with "Name: ".
+    if (std::sscanf(line.c_str(), "%lx-%lx ", &map_begin, &map_end) == 2 &&
+        line.find(':') > line.find(' ')) {
+      in_region = map_begin < end && begin < map_end;
+      if (in_region) {
+        overlap_bytes = std::min(end, map_end) - std::max(begin, map_begin);
+      }
+    } else if (in_region &&
+               std::sscanf(line.c_str(), "AnonHugePages: %zu kB", &kb) == 1) {
+      total_bytes += std::min(kb * 1024, overlap_bytes);
+    }
+  }
+  return total_bytes;
+}
+
+// A bump allocator over huge page regions of chunk_bytes each. Allocations
+// larger than a quarter of a chunk get a region of their own, and the others
+// move on to a new chunk when they do not fit in the current one, so at most a
+// quarter of a chunk is left unused at its end. Memory is only released all at
+// once, by Reset or the destructor.
+class HugePageArena {
+ public:
+  explicit HugePageArena(
+      const std::size_t chunk_bytes = internal::k1Gb,
+      const PageBacking max_backing = PageBacking::kHugeTlb1Gb)
+      : chunk_bytes_(chunk_bytes), max_backing_(max_backing), used_(0),
+        bytes_allocated_(0) {}
+  ~HugePageArena() { Reset(); }
+  HugePageArena(const HugePageArena&) = delete;
+  HugePageArena& operator=(const HugePageArena&) = delete;
+
+  // Returns bytes of memory aligned to alignment (a power of two).
+  void* Allocate(const std::size_t bytes,
+                 const std::size_t alignment = alignof(std::max_align_t)) {
+    if (bytes > chunk_bytes_ / 4) {
+      // A region of its own (aligned to at least 2 MB), kept before the
+      // current chunk so that the chunk stays the last region.
+      const HugePageRegion region = AllocateHugePages(bytes, max_backing_);
+      if (regions_.empty()) {
+        regions_.push_back(region);
+        used_ = region.bytes;
+      } else {
+        regions_.insert(regions_.end() - 1, region);
+      }
+      bytes_allocated_ += bytes;
+      return region.data;
+    }
+    std::size_t offset = internal::RoundUpTo(used_, alignment);
+    if (regions_.empty() || offset + bytes > regions_.back().bytes) {
+      regions_.push_back(AllocateHugePages(chunk_bytes_, max_backing_));
+      offset = 0;
+    }
+    used_ = offset + bytes;
+    bytes_allocated_ += bytes;
+    return static_cast<char*>(regions_.back().data) + offset;
+  }
+
+  // Releases all the memory.
+  void Reset() {
+    for (const HugePageRegion& region : regions_) {
+      FreeHugePages(region);
+    }
+    regions_.clear();
+    used_ = 0;
+    bytes_allocated_ = 0;
+  }
+
+  std::size_t bytes_allocated() const { return bytes_allocated_; }
+  // The regions mapped so far, with the pages each one got.
+  const std::vector<HugePageRegion>& regions() const { return regions_; }
+
+ private:
+  const std::size_t chunk_bytes_;
+  const PageBacking max_backing_;
+  std::vector<HugePageRegion> regions_;
+  // Bytes handed out from the last region.
+  std::size_t used_;
+  std::size_t bytes_allocated_;
+};
+
+// An STL allocator that takes memory from a HugePageArena. deallocate does
+// nothing (the arena releases everything at once), so a growing std::vector
+// leaves its old buffers in the arena: reserve the final size up front.
+template <typename T>
+class HugePageAllocator {
+ public:
+  typedef T value_type;
+
+  explicit HugePageAllocator(HugePageArena* arena) : arena_(arena) {}
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U>& other)
+      : arena_(other.arena()) {}
+
+  T* allocate(const std::size_t n) {
+    return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T*, std::size_t) {}
+
+  HugePageArena* arena() const { return arena_; }
+
+ private:
+  HugePageArena* arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const HugePageAllocator<T>& lhs,
+                const HugePageAllocator<U>& rhs) {
+  return lhs.arena() == rhs.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const HugePageAllocator<T>& lhs,
+                const HugePageAllocator<U>& rhs) {
+  return !(lhs == rhs);
+}
+
+// Counts the data TLB load misses of the calling thread in user space. Not
+// available on every system (e.g., in most VMs, or if
+// /proc/sys/kernel/perf_event_paranoid is above 2).
+class DtlbMissCounter {
+ public:
+  DtlbMissCounter() : fd_(-1) {
+#if defined(__linux__) && defined(SYS_perf_event_open)
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+    attributes.type = PERF_TYPE_HW_CACHE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_HW_CACHE_DTLB |
+                        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    fd_ = static_cast<int>(
+        syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+  }
+  ~DtlbMissCounter() {
+#if defined(__linux__)
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+#endif
+  }
+  DtlbMissCounter(const DtlbMissCounter&) = delete;
+  DtlbMissCounter& operator=(const DtlbMissCounter&) = delete;
+
+  bool available() const { return fd_ >= 0; }
+
+  void Start() {
+#if defined(__linux__)
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  // Returns the misses since Start, or 0 if the counter is not available.
+  uint64_t Stop() {
+    uint64_t count = 0;
+#if defined(__linux__)
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+        count = 0;
+      }
+    }
+#endif
+    return count;
+  }
+
+ private:
+  int fd_;
+};
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_HUGE_PAGE_ARENA_H_
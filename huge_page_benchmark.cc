@@ -0,0 +1,193 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary measures the latency of random loads from a large array on
+// 4 KB pages and on huge pages (see huge_page_arena.h).
+//
+// Usage: huge_page_benchmark [min_megabytes] [max_megabytes] [num_loads]
+//   Defaults: min_megabytes = 1024, max_megabytes = 32768, num_loads = 16M.
+//   The working sets double from min_megabytes to max_megabytes, and stop at
+//   half of the physical memory.
+//
+// For every working set the array is mapped with each backing (hugetlb pages
+// only if the system has them reserved), filled sequentially, and then read
+// by a chain of dependent loads: the address of every load depends on the
+// value of the previous one, as when following pointers or probing a hash
+// table, so the loads cannot overlap and each one pays its full latency.
+//
+// For each one it reports:
+//
+// 1. backing: the pages the region got, and for regular memory how much of it
+// the kernel actually backed by transparent huge pages.
+// 2. fill: the time to initialize the array (and fault its pages in).
+// 3. ns per load.
+// 4. dTLB misses per load, if the CPU counters are available (not in most
+// VMs).
+//
+// Notes:
+//
+// 1. On 4 KB pages nearly every load of a GB-sized array misses the TLB, and
+// the page walk costs up to four more memory accesses; on 2 MB pages the TLB
+// covers a few GB and the page walk is shorter, so the loads are faster.
+// 2. To get hugetlb pages reserve them first, e.g.,
+// echo 16384 | sudo tee /proc/sys/vm/nr_hugepages (32 GB of 2 MB pages).
+
+#include <cstdint>  // Header for uint64_t.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <sstream>  // Header for std::ostringstream.
+#include <string>  // Header for std::string.
+
+#include <unistd.h>  // Header for sysconf.
+
+#include "benchmark_utils.h"
+#include "huge_page_arena.h"
+
+namespace {
+
+const cpp_labs::PageBacking kBackings[] = {
+    cpp_labs::PageBacking::kSmallPages,
+    cpp_labs::PageBacking::kTransparentHugePages,
+    cpp_labs::PageBacking::kHugeTlb2Mb, cpp_labs::PageBacking::kHugeTlb1Gb};
+
+// Fills the array with pseudo-random values, sequentially.
+double Fill(uint64_t* data, const std::size_t size) {
+  cpp_labs::Timer timer;
+  uint64_t state = 0x9E3779B97F4A7C15ull;
+  for (std::size_t i = 0; i < size; ++i) {
+    // xorshift64.
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    data[i] = state;
+  }
+  cpp_labs::ClobberMemory();
+  return timer.ElapsedSeconds();
+}
+
+// Follows num_loads dependent loads; returns the nanoseconds per load. The
+// step number is mixed into every address so the chain never falls into a
+// short cycle (which would fit in the caches).
+double ChaseLoads(const uint64_t* data, const std::size_t size,
+                  const std::size_t num_loads) {
+  cpp_labs::Timer timer;
+  std::size_t index = 0;
+  for (std::size_t i = 0; i < num_loads; ++i) {
+    const uint64_t value = data[index] ^ (i * 0x9E3779B97F4A7C15ull);
+    // Maps the value to [0, size) with a multiply.
+    index = static_cast<std::size_t>(
+        (static_cast<unsigned __int128>(value) * size) >> 64);
+  }
+  const double seconds = timer.ElapsedSeconds();
+  cpp_labs::DoNotOptimize(index);
+  return seconds * 1e9 / num_loads;
+}
+
+void Measure(const std::size_t megabytes, const cpp_labs::PageBacking backing,
+             const std::size_t num_loads) {
+  const std::size_t bytes = megabytes << 20;
+  const cpp_labs::HugePageRegion region =
+      cpp_labs::AllocateHugePages(bytes, backing);
+  std::cout << std::setw(8) << megabytes << std::setw(16)
+            << cpp_labs::PageBackingName(backing);
+  if (region.backing != backing) {
+    // Asked for hugetlb pages, but there are none reserved.
+    std::cout << "   unavailable" << std::endl;
+    cpp_labs::FreeHugePages(region);
+    return;
+  }
+  uint64_t* data = static_cast<uint64_t*>(region.data);
+  const std::size_t size = bytes / sizeof(uint64_t);
+  const double fill_seconds = Fill(data, size);
+
+  std::ostringstream backing_text;
+  if (backing == cpp_labs::PageBacking::kSmallPages ||
+      backing == cpp_labs::PageBacking::kTransparentHugePages) {
+    const std::size_t huge_bytes =
+        cpp_labs::TransparentHugePageBytes(region.data, region.bytes);
+    backing_text << 100 * huge_bytes / region.bytes << "% THP";
+  } else {
+    backing_text << "100% hugetlb";
+  }
+
+  cpp_labs::DtlbMissCounter tlb_misses;
+  tlb_misses.Start();
+  const double nanoseconds = ChaseLoads(data, size, num_loads);
+  const uint64_t misses = tlb_misses.Stop();
+  std::cout << std::setw(14) << backing_text.str() << std::setw(10)
+            << fill_seconds * 1e3 << std::setw(10) << nanoseconds;
+  if (tlb_misses.available()) {
+    std::cout << std::setw(16) << static_cast<double>(misses) / num_loads;
+  } else {
+    std::cout << std::setw(16) << "n/a";
+  }
+  std::cout << std::endl;
+  cpp_labs::FreeHugePages(region);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t min_megabytes =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, 1024);
+  std::size_t max_megabytes =
+      cpp_labs::ParseSizeArgument(argc, argv, 2, 32768);
+  const std::size_t num_loads =
+      cpp_labs::ParseSizeArgument(argc, argv, 3, 1 << 24);
+  if (min_megabytes == 0 || num_loads == 0) {
+    std::cerr << "min_megabytes and num_loads must be positive." << std::endl;
+    return 1;
+  }
+  const std::size_t physical_megabytes =
+      static_cast<std::size_t>(sysconf(_SC_PHYS_PAGES)) *
+      static_cast<std::size_t>(sysconf(_SC_PAGE_SIZE)) >> 20;
+  if (max_megabytes > physical_megabytes / 2) {
+    max_megabytes = physical_megabytes / 2;
+    std::cout << "Working sets limited to " << max_megabytes
+              << " MB (half of the physical memory).\n";
+  }
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << std::setw(8) << "MB" << std::setw(16) << "pages"
+            << std::setw(14) << "backing" << std::setw(10) << "fill ms"
+            << std::setw(10) << "ns/load" << std::setw(16) << "dTLB miss/load"
+            << std::endl;
+  for (std::size_t megabytes = min_megabytes; megabytes <= max_megabytes;
+       megabytes *= 2) {
+    for (const cpp_labs::PageBacking backing : kBackings) {
+      Measure(megabytes, backing, num_loads);
+    }
+  }
+  return 0;
+}
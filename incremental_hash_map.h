@@ -0,0 +1,423 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_INCREMENTAL_HASH_MAP_H_
+#define CPP_LABS_INCREMENTAL_HASH_MAP_H_
+
+// IncrementalHashMap is a hash map that grows without stopping the world.
+//
+// When std::unordered_map (see unordered_map_example.cc) exceeds its maximum
+// load factor, the insertion that crossed it rehashes every element before it
+// returns: with hundreds of millions of entries that single insertion takes
+// seconds, while the others take tens of nanoseconds.
+//
+// IncrementalHashMap spreads that work over the following operations:
+//
+// 1. The entries live in a table with open addressing (linear probing) and a
+// control byte per slot: empty, deleted, or 7 bits of the hash of the key, so
+// that most probes skip the slot without comparing keys.
+// 2. When the table is 3/4 used, a table twice as large becomes the current
+// one and the old one is kept. Every insertion or erase then moves the entries
+// of the next kMigrationStep slots of the old table to the new one, and
+// lookups search both tables, until the old table is empty and released.
+// The new table is done long before it needs to grow again.
+// 3. Large tables come straight from mmap: the kernel zero-fills their pages
+// on first touch, so a new table costs no up-front memset, and the pages of
+// the old table are returned to the system as the migration leaves them.
+//
+// Pointers to values are invalidated by any insertion or erase.
+
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for uint8_t and uint64_t.
+#include <cstdlib>  // Header for std::calloc and std::free.
+#include <functional>  // Header for std::hash.
+#include <new>  // Header for std::bad_alloc and placement new.
+#include <tuple>  // Header for std::forward_as_tuple.
+#include <type_traits>  // Header for std::is_trivially_destructible.
+#include <utility>  // Header for std::pair and std::forward.
+
+#if defined(__linux__)
+#include <sys/mman.h>  // Header for mmap, munmap and madvise.
+#endif
+
+#include "aligned_memory.h"
+#include "growable_vector.h"
+
+namespace cpp_labs {
+namespace internal {
+
+// Blocks of at least this many bytes are allocated with mmap.
+const std::size_t kTableMapThreshold = 1024 * 1024;
+
+// Allocates bytes of zeroed memory.
+inline void* AllocateTableMemory(const std::size_t bytes) {
+#if defined(__linux__)
+  if (bytes >= kTableMapThreshold) {
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    return memory;
+  }
+#endif
+  void* memory = std::calloc(bytes, 1);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+inline void FreeTableMemory(void* memory, const std::size_t bytes) {
+#if defined(__linux__)
+  if (bytes >= kTableMapThreshold) {
+    munmap(memory, bytes);
+    return;
+  }
+#endif
+  std::free(memory);
+}
+
+// Returns the whole pages in [begin, end) of a block of bytes to the system
+// (the memory stays valid, but it may read as zeros). Only mmap-ed blocks are
+// released; for the others this does nothing.
+inline void DiscardTableMemory(void* memory, const std::size_t bytes,
+                               const std::size_t begin, const std::size_t end) {
+#if defined(__linux__)
+  const std::size_t first = RoundUp(begin, PageSize());
+  const std::size_t last = end / PageSize() * PageSize();
+  if (bytes >= kTableMapThreshold && first < last) {
+    madvise(static_cast<char*>(memory) + first, last - first, MADV_DONTNEED);
+  }
+#endif
+}
+
+}  // namespace internal
+
+template <typename Key, typename Value, typename Hash = std::hash<Key> >
+class IncrementalHashMap {
+ public:
+  typedef std::pair<Key, Value> value_type;
+
+  // Slots of the old table moved per insertion or erase.
+  static const std::size_t kMigrationStep = 16;
+
+  IncrementalHashMap() : size_(0), migrate_position_(0), discarded_bytes_(0) {
+    current_ = NewTable(kMinCapacity);
+    old_ = Table();
+  }
+  ~IncrementalHashMap() {
+    DestroyTable(&current_);
+    DestroyTable(&old_);
+  }
+  IncrementalHashMap(const IncrementalHashMap&) = delete;
+  IncrementalHashMap& operator=(const IncrementalHashMap&) = delete;
+
+  // Returns the value of key, or nullptr if key is not in the map.
+  Value* find(const Key& key) {
+    value_type* slot = FindSlot(key, HashOf(key));
+    return slot == nullptr ? nullptr : &slot->second;
+  }
+  const Value* find(const Key& key) const {
+    const value_type* slot =
+        const_cast<IncrementalHashMap*>(this)->FindSlot(key, HashOf(key));
+    return slot == nullptr ? nullptr : &slot->second;
+  }
+  bool contains(const Key& key) const { return find(key) != nullptr; }
+
+  // Starts loading the control byte and the slot where find(key) begins, so
+  // that a find issued a little later does not wait for memory (see
+  // coroutine_lookup.h).
+  void prefetch(const Key& key) const {
+    const uint64_t hash = HashOf(key);
+    PrefetchIn(current_, hash);
+    if (is_migrating()) {
+      PrefetchIn(old_, hash);
+    }
+  }
+
+  // Inserts key with the value built from args, unless key is already in the
+  // map. Returns the value of key, and whether it was inserted.
+  template <typename... Args>
+  std::pair<Value*, bool> try_emplace(const Key& key, Args&&... args) {
+    MigrateStep();
+    const uint64_t hash = HashOf(key);
+    value_type* slot = FindSlot(key, hash);
+    if (slot != nullptr) {
+      return std::make_pair(&slot->second, false);
+    }
+    if (current_.num_used + 1 > MaxUsed(current_.capacity)) {
+      Grow();
+    }
+    slot = InsertNew(&current_, hash, std::piecewise_construct,
+                     std::forward_as_tuple(key),
+                     std::forward_as_tuple(std::forward<Args>(args)...));
+    ++size_;
+    return std::make_pair(&slot->second, true);
+  }
+
+  // Returns true if key was inserted, false if it was already in the map (its
+  // value does not change).
+  bool insert(const Key& key, const Value& value) {
+    return try_emplace(key, value).second;
+  }
+
+  Value& operator[](const Key& key) { return *try_emplace(key).first; }
+
+  // Returns true if key was in the map.
+  bool erase(const Key& key) {
+    MigrateStep();
+    const uint64_t hash = HashOf(key);
+    if (EraseFrom(&current_, key, hash) ||
+        (is_migrating() && EraseFrom(&old_, key, hash))) {
+      --size_;
+      return true;
+    }
+    return false;
+  }
+
+  // Calls function(key, value) for every entry, in no particular order.
+  template <typename Function>
+  void ForEach(const Function& function) const {
+    ForEachIn(old_, function);
+    ForEachIn(current_, function);
+  }
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  // Number of slots of the current table.
+  std::size_t capacity() const { return current_.capacity; }
+  // Whether entries are still being moved from an old table.
+  bool is_migrating() const { return old_.capacity != 0; }
+
+ private:
+  static const std::size_t kMinCapacity = 16;
+  // Control bytes; full slots have the top bit set.
+  static const uint8_t kEmpty = 0;
+  static const uint8_t kDeleted = 1;
+
+  struct Table {
+    Table() : control(nullptr), slots(nullptr), capacity(0), num_used(0) {}
+    uint8_t* control;
+    value_type* slots;
+    // A power of two, or zero for no table.
+    std::size_t capacity;
+    // Full and deleted slots: deleted ones still lengthen the probes.
+    std::size_t num_used;
+  };
+
+  static std::size_t MaxUsed(const std::size_t capacity) {
+    return capacity / 4 * 3;
+  }
+
+  // Mixes the bits of the hash (std::hash of an integer is the integer), so
+  // that both the low bits (the slot) and the top ones (the control byte)
+  // depend on the whole key.
+  static uint64_t HashOf(const Key& key) {
+    uint64_t hash = static_cast<uint64_t>(Hash()(key));
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    return hash;
+  }
+
+  static uint8_t ControlOf(const uint64_t hash) {
+    return static_cast<uint8_t>(0x80 | (hash >> 57));
+  }
+
+  static Table NewTable(const std::size_t capacity) {
+    Table table;
+    table.control =
+        static_cast<uint8_t*>(internal::AllocateTableMemory(capacity));
+    table.slots = static_cast<value_type*>(
+        internal::AllocateTableMemory(capacity * sizeof(value_type)));
+    table.capacity = capacity;
+    return table;
+  }
+
+  static void DestroyTable(Table* table) {
+    if (!std::is_trivially_destructible<value_type>::value) {
+      for (std::size_t i = 0; i < table->capacity; ++i) {
+        if (table->control[i] & 0x80) {
+          table->slots[i].~value_type();
+        }
+      }
+    }
+    FreeTable(table);
+  }
+
+  // Releases the memory of a table whose entries are gone.
+  static void FreeTable(Table* table) {
+    if (table->capacity == 0) {
+      return;
+    }
+    internal::FreeTableMemory(table->control, table->capacity);
+    internal::FreeTableMemory(table->slots,
+                              table->capacity * sizeof(value_type));
+    *table = Table();
+  }
+
+  static value_type* FindIn(const Table& table, const Key& key,
+                            const uint64_t hash) {
+    const uint8_t control = ControlOf(hash);
+    const std::size_t mask = table.capacity - 1;
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+      if (table.control[i] == kEmpty) {
+        return nullptr;
+      }
+      if (table.control[i] == control && table.slots[i].first == key) {
+        return &table.slots[i];
+      }
+    }
+  }
+
+  static void PrefetchIn(const Table& table, const uint64_t hash) {
+    const std::size_t i = hash & (table.capacity - 1);
+    PrefetchCacheLine(table.control + i);
+    PrefetchCacheLine(table.slots + i);
+  }
+
+  value_type* FindSlot(const Key& key, const uint64_t hash) {
+    value_type* slot = FindIn(current_, key, hash);
+    if (slot == nullptr && is_migrating()) {
+      slot = FindIn(old_, key, hash);
+    }
+    return slot;
+  }
+
+  // Constructs an entry for a key that is in neither table.
+  template <typename... Args>
+  static value_type* InsertNew(Table* table, const uint64_t hash,
+                               Args&&... args) {
+    const std::size_t mask = table->capacity - 1;
+    std::size_t i = hash & mask;
+    while (table->control[i] & 0x80) {
+      i = (i + 1) & mask;
+    }
+    if (table->control[i] == kEmpty) {
+      ++table->num_used;
+    }
+    value_type* slot =
+        new (&table->slots[i]) value_type(std::forward<Args>(args)...);
+    table->control[i] = ControlOf(hash);
+    return slot;
+  }
+
+  static bool EraseFrom(Table* table, const Key& key, const uint64_t hash) {
+    value_type* slot = FindIn(*table, key, hash);
+    if (slot == nullptr) {
+      return false;
+    }
+    const std::size_t i = slot - table->slots;
+    slot->~value_type();
+    // A slot followed by an empty one ends no probe sequence of another key,
+    // so it can be empty again instead of deleted.
+    if (table->control[(i + 1) & (table->capacity - 1)] == kEmpty) {
+      table->control[i] = kEmpty;
+      --table->num_used;
+    } else {
+      table->control[i] = kDeleted;
+    }
+    return true;
+  }
+
+  template <typename Function>
+  static void ForEachIn(const Table& table, const Function& function) {
+    for (std::size_t i = 0; i < table.capacity; ++i) {
+      if (table.control[i] & 0x80) {
+        function(table.slots[i].first, table.slots[i].second);
+      }
+    }
+  }
+
+  // Starts moving the entries to a new table: twice as large, or as large if
+  // the table is mostly deleted slots.
+  void Grow() {
+    while (is_migrating()) {
+      MigrateStep();
+    }
+    const std::size_t capacity = size_ >= current_.capacity / 2
+                                     ? 2 * current_.capacity
+                                     : current_.capacity;
+    old_ = current_;
+    current_ = NewTable(capacity);
+    migrate_position_ = 0;
+    discarded_bytes_ = 0;
+  }
+
+  // Moves the entries of the next kMigrationStep slots of the old table.
+  void MigrateStep() {
+    if (!is_migrating()) {
+      return;
+    }
+    const std::size_t end = migrate_position_ + kMigrationStep < old_.capacity
+                                ? migrate_position_ + kMigrationStep
+                                : old_.capacity;
+    for (std::size_t i = migrate_position_; i < end; ++i) {
+      if (old_.control[i] & 0x80) {
+        value_type& entry = old_.slots[i];
+        InsertNew(&current_, HashOf(entry.first), std::move(entry));
+        entry.~value_type();
+        // Lookups of other keys must keep probing past this slot.
+        old_.control[i] = kDeleted;
+      }
+    }
+    migrate_position_ = end;
+    if (migrate_position_ == old_.capacity) {
+      FreeTable(&old_);
+      return;
+    }
+    // Release the slots left behind, a megabyte at a time.
+    const std::size_t migrated_bytes = migrate_position_ * sizeof(value_type);
+    if (migrated_bytes - discarded_bytes_ >= internal::kTableMapThreshold) {
+      internal::DiscardTableMemory(old_.slots,
+                                   old_.capacity * sizeof(value_type),
+                                   discarded_bytes_, migrated_bytes);
+      discarded_bytes_ = migrated_bytes;
+    }
+  }
+
+  Table current_;
+  // The table being migrated, or no table.
+  Table old_;
+  std::size_t size_;
+  // Slots of the old table before this one have been moved.
+  std::size_t migrate_position_;
+  // Bytes at the beginning of the old slots returned to the system.
+  std::size_t discarded_bytes_;
+};
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_INCREMENTAL_HASH_MAP_H_
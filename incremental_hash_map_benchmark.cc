@@ -0,0 +1,205 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary measures the latency of every insertion while a hash map grows
+// from empty to num_inserts entries, to show the stalls of the rehashes of
+// std::unordered_map and how IncrementalHashMap avoids them.
+//
+// Usage: incremental_hash_map_benchmark [num_inserts]
+//   Defaults: num_inserts = 100000000 (about 4 GB for std::unordered_map).
+//
+// The maps are:
+//
+// 1. std::unordered_map, which rehashes all its entries whenever it grows.
+// 2. std::unordered_map after reserve(num_inserts): no rehash at all, the
+// reference for a map whose final size is known in advance.
+// 3. IncrementalHashMap, which moves a few entries per insertion.
+//
+// Notes:
+//
+// 1. Each map runs in its own child process (RunInChildProcess), so that the
+// peak memory of each one can be measured.
+// 2. The latencies go to a LatencyHistogram (instrumentation.h), with 32
+// buckets per power of two, so the percentiles are accurate to about 3%; "max"
+// is exact.
+// 3. The percentiles include the cost of the clock (about 20 ns).
+// 4. Stalls are insertions of more than kStallNanoseconds.
+
+#include <chrono>  // Header for std::chrono::steady_clock.
+#include <cstdint>  // Header for uint64_t.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <random>  // Header for std::mt19937_64.
+#include <string>  // Header for std::string.
+#include <unordered_map>  // Header for std::unordered_map.
+
+#include "benchmark_utils.h"
+#include "incremental_hash_map.h"
+#include "instrumentation.h"
+
+namespace {
+
+const uint64_t kStallNanoseconds = 1000000;
+const std::size_t kNumChecks = 1000000;
+
+struct Result {
+  double seconds;
+  uint64_t p50;
+  uint64_t p99;
+  uint64_t p999;
+  uint64_t p9999;
+  uint64_t max;
+  uint64_t num_stalls;
+  uint64_t checksum;
+};
+
+uint64_t* Find(std::unordered_map<uint64_t, uint64_t>* map,
+               const uint64_t key) {
+  const std::unordered_map<uint64_t, uint64_t>::iterator it = map->find(key);
+  return it == map->end() ? nullptr : &it->second;
+}
+
+uint64_t* Find(cpp_labs::IncrementalHashMap<uint64_t, uint64_t>* map,
+               const uint64_t key) {
+  return map->find(key);
+}
+
+// Inserts num_inserts random keys (map[key] = i), timing each insertion.
+template <typename Map>
+Result MeasureInserts(Map* map, const std::size_t num_inserts) {
+  cpp_labs::LatencyHistogram histogram;
+  std::mt19937_64 rng(1234);
+  Result result = Result();
+  const std::chrono::steady_clock::time_point begin =
+      std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < num_inserts; ++i) {
+    const uint64_t key = rng();
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    (*map)[key] = i;
+    const uint64_t nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    histogram.Add(nanoseconds);
+    result.num_stalls += nanoseconds > kStallNanoseconds ? 1 : 0;
+  }
+  result.seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - begin).count();
+  result.p50 = histogram.Percentile(50.0);
+  result.p99 = histogram.Percentile(99.0);
+  result.p999 = histogram.Percentile(99.9);
+  result.p9999 = histogram.Percentile(99.99);
+  result.max = histogram.max();
+
+  // The same keys must map to the same values in every map.
+  rng.seed(1234);
+  for (std::size_t i = 0; i < num_inserts && i < kNumChecks; ++i) {
+    const uint64_t* value = Find(map, rng());
+    result.checksum = result.checksum * 31 + (value == nullptr ? 0 : *value);
+  }
+  return result;
+}
+
+void PrintRow(const std::string& name, const Result& result,
+              const long peak_memory_kb) {
+  std::cout << std::setw(30) << name << std::setw(10) << result.seconds
+            << std::setw(8) << result.p50 << std::setw(8) << result.p99
+            << std::setw(9) << result.p999 << std::setw(10) << result.p9999
+            << std::setw(14) << result.max << std::setw(8)
+            << result.num_stalls << std::setw(10) << peak_memory_kb / 1024
+            << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t num_inserts =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, 100000000);
+  if (num_inserts == 0) {
+    std::cerr << "num_inserts must be positive." << std::endl;
+    return 1;
+  }
+
+  std::cout << num_inserts << " insertions, latencies in ns\n"
+            << std::setw(30) << "map" << std::setw(10) << "total s"
+            << std::setw(8) << "p50" << std::setw(8) << "p99" << std::setw(9)
+            << "p99.9" << std::setw(10) << "p99.99" << std::setw(14) << "max"
+            << std::setw(8) << "stalls" << std::setw(10) << "peak MB"
+            << std::endl;
+
+  Result unordered_map_result;
+  long peak_memory_kb = 0;
+  if (!cpp_labs::RunInChildProcess(
+          [num_inserts]() {
+            std::unordered_map<uint64_t, uint64_t> map;
+            return MeasureInserts(&map, num_inserts);
+          },
+          &unordered_map_result, &peak_memory_kb)) {
+    std::cerr << "std::unordered_map run failed." << std::endl;
+    return 1;
+  }
+  PrintRow("std::unordered_map", unordered_map_result, peak_memory_kb);
+
+  Result reserved_result;
+  if (!cpp_labs::RunInChildProcess(
+          [num_inserts]() {
+            std::unordered_map<uint64_t, uint64_t> map;
+            map.reserve(num_inserts);
+            return MeasureInserts(&map, num_inserts);
+          },
+          &reserved_result, &peak_memory_kb)) {
+    std::cerr << "std::unordered_map (reserved) run failed." << std::endl;
+    return 1;
+  }
+  PrintRow("std::unordered_map, reserved", reserved_result, peak_memory_kb);
+
+  Result incremental_result;
+  if (!cpp_labs::RunInChildProcess(
+          [num_inserts]() {
+            cpp_labs::IncrementalHashMap<uint64_t, uint64_t> map;
+            return MeasureInserts(&map, num_inserts);
+          },
+          &incremental_result, &peak_memory_kb)) {
+    std::cerr << "IncrementalHashMap run failed." << std::endl;
+    return 1;
+  }
+  PrintRow("IncrementalHashMap", incremental_result, peak_memory_kb);
+
+  if (incremental_result.checksum != unordered_map_result.checksum ||
+      reserved_result.checksum != unordered_map_result.checksum) {
+    std::cout << "  (contents mismatch!)" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,73 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_INDEX_SEQUENCE_H_
+#define CPP_LABS_INDEX_SEQUENCE_H_
+
+// C++11 does not ship std::index_sequence (it arrived in C++14). This header
+// provides a minimal equivalent so that the headers in this repository can
+// expand parameter packs over tuple elements and compile-time arrays.
+
+#include <cstddef>  // Header for std::size_t.
+
+namespace cpp_labs {
+
+// A compile-time list of indices, e.g., IndexSequence<0, 1, 2>.
+template <std::size_t... Indices>
+struct IndexSequence {
+  static constexpr std::size_t size() { return sizeof...(Indices); }
+};
+
+namespace internal {
+template <std::size_t N, std::size_t... Indices>
+struct MakeIndexSequenceImpl
+    : MakeIndexSequenceImpl<N - 1, N - 1, Indices...> {};
+
+template <std::size_t... Indices>
+struct MakeIndexSequenceImpl<0, Indices...> {
+  typedef IndexSequence<Indices...> type;
+};
+}  // namespace internal
+
+// MakeIndexSequence<3> is IndexSequence<0, 1, 2>.
+template <std::size_t N>
+using MakeIndexSequence = typename internal::MakeIndexSequenceImpl<N>::type;
+
+// Helper to expand an expression over a parameter pack in C++11, e.g.,
+//   Swallow{0, (DoSomething<Indices>(), 0)...};
+typedef int Swallow[];
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_INDEX_SEQUENCE_H_
@@ -0,0 +1,571 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_INSTRUMENTATION_H_
+#define CPP_LABS_INSTRUMENTATION_H_
+
+// Low-overhead instrumentation of hot paths: scoped timers that record
+// latency histograms, and named counters.
+//
+// Usage:
+//
+//   {
+//     CPP_LABS_SCOPED_TIMER("std::set::insert");  // Times the whole scope.
+//     my_set.insert(value);
+//   }
+//   iterator = CPP_LABS_TIMED("std::set::find", my_set.find(value));
+//   CPP_LABS_COUNTER_ADD("std::vector reallocations", 1);
+//
+// The macros only do something when CPP_LABS_ENABLE_INSTRUMENTATION is
+// defined (cmake -DBUILD_WITH_INSTRUMENTATION=ON). Otherwise they compile to
+// nothing: CPP_LABS_TIMED(name, expression) is just (expression), and the
+// value of CPP_LABS_COUNTER_ADD is not evaluated.
+//
+// Notes:
+//
+// 1. Timers read the time stamp counter of the CPU (rdtsc, a few nanoseconds)
+// on x86, and std::chrono::steady_clock elsewhere. Ticks are converted to
+// nanoseconds when the report is written.
+// 2. Every thread records into its own histograms and counters, so recording
+// takes no lock and no atomic read-modify-write; the report merges the
+// threads. Each metric is registered once per call site (a function-local
+// static), so names are not looked up on the hot path.
+// 3. The histograms (LatencyHistogram) are HDR-style: 32 buckets per power of
+// two, i.e., percentiles within about 3% for any value up to 2^64.
+// 4. The report is written when the program exits: to the file named by the
+// environment variable CPP_LABS_INSTRUMENTATION_FILE (JSON if the name ends in
+// ".json", text otherwise), or to stderr. If
+// CPP_LABS_INSTRUMENTATION_INTERVAL_SECONDS is also set, the file is
+// rewritten periodically as well (see StartPeriodicExport).
+
+#include <algorithm>  // Header for std::min.
+#include <atomic>  // Header for std::atomic.
+#include <chrono>  // Header for std::chrono::steady_clock.
+#include <condition_variable>  // Header for std::condition_variable.
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for uint64_t.
+#include <cstdlib>  // Header for std::atexit and std::getenv.
+#include <fstream>  // Header for std::ofstream.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for std::cerr.
+#include <mutex>  // Header for std::mutex.
+#include <ostream>  // Header for std::ostream.
+#include <string>  // Header for std::string.
+#include <thread>  // Header for std::thread.
+#include <vector>  // Header for std::vector.
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>  // Header for __rdtsc.
+#endif
+
+namespace cpp_labs {
+
+// Returns the current time in ticks: CPU cycles of the time stamp counter on
+// x86, nanoseconds elsewhere.
+inline uint64_t ReadTimestamp() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+// A histogram of non-negative integers (e.g., nanoseconds or ticks). Values
+// below 2^kSubBucketBits have a bucket each; larger ones are split by their
+// highest bit and the kSubBucketBits bits after it, so a bucket is at most
+// 1/32 of its values wide. One thread may Add while others read.
+class LatencyHistogram {
+ public:
+  static const int kSubBucketBits = 5;
+  static const std::size_t kNumBuckets = (64 - kSubBucketBits + 1)
+                                         << kSubBucketBits;
+
+  LatencyHistogram() {
+    for (std::size_t bucket = 0; bucket < kNumBuckets; ++bucket) {
+      counts_[bucket].store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+  }
+
+  // Only one thread may add values: the counters are updated with a load and
+  // a store instead of the (much slower) atomic increments.
+  void Add(const uint64_t value) {
+    Increment(&counts_[BucketOf(value)], 1);
+    Increment(&count_, 1);
+    Increment(&sum_, value);
+    if (value > max_.load(std::memory_order_relaxed)) {
+      max_.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  // Adds the values of other; this histogram must not be written meanwhile.
+  void Merge(const LatencyHistogram& other) {
+    for (std::size_t bucket = 0; bucket < kNumBuckets; ++bucket) {
+      Increment(&counts_[bucket],
+                other.counts_[bucket].load(std::memory_order_relaxed));
+    }
+    Increment(&count_, other.count());
+    Increment(&sum_, other.sum());
+    if (other.max() > max()) {
+      max_.store(other.max(), std::memory_order_relaxed);
+    }
+  }
+
+  uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+  uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+  uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+  // Returns the lower bound of the bucket of the given percentile (0-100).
+  uint64_t Percentile(const double percentage) const {
+    const uint64_t rank = static_cast<uint64_t>(count() * percentage / 100.0);
+    uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < kNumBuckets; ++bucket) {
+      seen += counts_[bucket].load(std::memory_order_relaxed);
+      if (seen > rank) {
+        return std::min(BucketLowerBound(bucket), max());
+      }
+    }
+    return max();
+  }
+
+  static std::size_t BucketOf(const uint64_t value) {
+    if (value < (1u << kSubBucketBits)) {
+      return static_cast<std::size_t>(value);
+    }
+    const int shift = 63 - __builtin_clzll(value) - kSubBucketBits;
+    return ((shift + 1) << kSubBucketBits) +
+           static_cast<std::size_t>((value >> shift) &
+                                    ((1u << kSubBucketBits) - 1));
+  }
+
+  static uint64_t BucketLowerBound(const std::size_t bucket) {
+    if (bucket < (1u << kSubBucketBits)) {
+      return bucket;
+    }
+    const int shift = static_cast<int>(bucket >> kSubBucketBits) - 1;
+    return ((1ull << kSubBucketBits) |
+            (bucket & ((1u << kSubBucketBits) - 1)))
+           << shift;
+  }
+
+ private:
+  static void Increment(std::atomic<uint64_t>* counter, const uint64_t value) {
+    counter->store(counter->load(std::memory_order_relaxed) + value,
+                   std::memory_order_relaxed);
+  }
+
+  std::atomic<uint64_t> counts_[kNumBuckets];
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> sum_;
+  std::atomic<uint64_t> max_;
+};
+
+enum class MetricType { kHistogram, kCounter };
+
+// The process-wide set of metrics, and the per-thread data they record to.
+class InstrumentationRegistry {
+ public:
+  static const int kMaxMetrics = 256;
+
+  // The registry is never destroyed, so that threads and the at-exit report
+  // can use it while static objects are being destroyed.
+  static InstrumentationRegistry& Get() {
+    static InstrumentationRegistry* registry = Create();
+    return *registry;
+  }
+
+  // Returns the id of the metric with the given name and type, registering
+  // it if needed, or -1 if there are already kMaxMetrics metrics.
+  int Register(const std::string& name, const MetricType type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t id = 0; id < metrics_.size(); ++id) {
+      if (metrics_[id].name == name && metrics_[id].type == type) {
+        return static_cast<int>(id);
+      }
+    }
+    if (metrics_.size() == static_cast<std::size_t>(kMaxMetrics)) {
+      return -1;
+    }
+    const Metric metric = {name, type};
+    metrics_.push_back(metric);
+    return static_cast<int>(metrics_.size() - 1);
+  }
+
+  void RecordTicks(const int id, const uint64_t ticks) {
+    if (id < 0) {
+      return;
+    }
+    ThreadMetrics* metrics = LocalMetrics();
+    LatencyHistogram* histogram =
+        metrics->histograms[id].load(std::memory_order_relaxed);
+    if (histogram == nullptr) {
+      histogram = new LatencyHistogram;
+      metrics->histograms[id].store(histogram, std::memory_order_release);
+    }
+    histogram->Add(ticks);
+  }
+
+  void AddToCounter(const int id, const uint64_t value) {
+    if (id < 0) {
+      return;
+    }
+    std::atomic<uint64_t>& counter = LocalMetrics()->counters[id];
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+                  std::memory_order_relaxed);
+  }
+
+  // Writes every metric, merged over the threads: histograms in nanoseconds.
+  void WriteText(std::ostream* out) {
+    std::vector<Metric> metrics;
+    std::vector<LatencyHistogram*> histograms;
+    std::vector<uint64_t> counters;
+    Collect(&metrics, &histograms, &counters);
+    const double ns_per_tick = NanosecondsPerTick();
+    *out << std::left << std::setw(32) << "histogram" << std::right
+         << std::setw(12) << "count" << std::setw(12) << "mean_ns"
+         << std::setw(10) << "p50_ns" << std::setw(10) << "p90_ns"
+         << std::setw(10) << "p99_ns" << std::setw(10) << "p999_ns"
+         << std::setw(12) << "max_ns" << "\n";
+    for (std::size_t id = 0; id < metrics.size(); ++id) {
+      if (metrics[id].type != MetricType::kHistogram) {
+        continue;
+      }
+      const LatencyHistogram& histogram = *histograms[id];
+      *out << std::left << std::setw(32) << metrics[id].name << std::right
+           << std::setw(12) << histogram.count() << std::setw(12)
+           << Mean(histogram) * ns_per_tick << std::setw(10)
+           << histogram.Percentile(50.0) * ns_per_tick << std::setw(10)
+           << histogram.Percentile(90.0) * ns_per_tick << std::setw(10)
+           << histogram.Percentile(99.0) * ns_per_tick << std::setw(10)
+           << histogram.Percentile(99.9) * ns_per_tick << std::setw(12)
+           << histogram.max() * ns_per_tick << "\n";
+    }
+    *out << std::left << std::setw(32) << "counter" << std::right
+         << std::setw(12) << "value" << "\n";
+    for (std::size_t id = 0; id < metrics.size(); ++id) {
+      if (metrics[id].type == MetricType::kCounter) {
+        *out << std::left << std::setw(32) << metrics[id].name << std::right
+             << std::setw(12) << counters[id] << "\n";
+      }
+    }
+    *out << std::flush;
+    for (LatencyHistogram* histogram : histograms) {
+      delete histogram;
+    }
+  }
+
+  void WriteJson(std::ostream* out) {
+    std::vector<Metric> metrics;
+    std::vector<LatencyHistogram*> histograms;
+    std::vector<uint64_t> counters;
+    Collect(&metrics, &histograms, &counters);
+    const double ns_per_tick = NanosecondsPerTick();
+    *out << "{\"histograms\": [";
+    const char* separator = "";
+    for (std::size_t id = 0; id < metrics.size(); ++id) {
+      if (metrics[id].type != MetricType::kHistogram) {
+        continue;
+      }
+      const LatencyHistogram& histogram = *histograms[id];
+      *out << separator << "\n  {\"name\": " << JsonString(metrics[id].name)
+           << ", \"count\": " << histogram.count()
+           << ", \"mean_ns\": " << Mean(histogram) * ns_per_tick
+           << ", \"p50_ns\": " << histogram.Percentile(50.0) * ns_per_tick
+           << ", \"p90_ns\": " << histogram.Percentile(90.0) * ns_per_tick
+           << ", \"p99_ns\": " << histogram.Percentile(99.0) * ns_per_tick
+           << ", \"p999_ns\": " << histogram.Percentile(99.9) * ns_per_tick
+           << ", \"max_ns\": " << histogram.max() * ns_per_tick << "}";
+      separator = ",";
+    }
+    *out << "],\n \"counters\": [";
+    separator = "";
+    for (std::size_t id = 0; id < metrics.size(); ++id) {
+      if (metrics[id].type == MetricType::kCounter) {
+        *out << separator << "\n  {\"name\": " << JsonString(metrics[id].name)
+             << ", \"value\": " << counters[id] << "}";
+        separator = ",";
+      }
+    }
+    *out << "]}\n" << std::flush;
+    for (LatencyHistogram* histogram : histograms) {
+      delete histogram;
+    }
+  }
+
+  // Writes the report to path, as JSON if path ends in ".json". Returns false
+  // if the file cannot be written.
+  bool ExportToFile(const std::string& path) {
+    std::ofstream file(path.c_str());
+    if (!file) {
+      return false;
+    }
+    const std::string kJsonExtension = ".json";
+    if (path.size() >= kJsonExtension.size() &&
+        path.compare(path.size() - kJsonExtension.size(),
+                     kJsonExtension.size(), kJsonExtension) == 0) {
+      WriteJson(&file);
+    } else {
+      WriteText(&file);
+    }
+    return static_cast<bool>(file);
+  }
+
+  // Rewrites the report to path every interval_seconds from a background
+  // thread, until StopPeriodicExport (called at exit).
+  void StartPeriodicExport(const std::string& path,
+                           const double interval_seconds) {
+    StopPeriodicExport();
+    std::lock_guard<std::mutex> lock(export_mutex_);
+    stop_export_ = false;
+    export_thread_ = std::thread([this, path, interval_seconds]() {
+      std::unique_lock<std::mutex> lock(export_mutex_);
+      const std::chrono::duration<double> interval(interval_seconds);
+      while (!export_done_.wait_for(lock, interval,
+                                    [this]() { return stop_export_; })) {
+        lock.unlock();
+        ExportToFile(path);
+        lock.lock();
+      }
+    });
+  }
+
+  void StopPeriodicExport() {
+    {
+      std::lock_guard<std::mutex> lock(export_mutex_);
+      stop_export_ = true;
+    }
+    export_done_.notify_all();
+    if (export_thread_.joinable()) {
+      export_thread_.join();
+    }
+  }
+
+ private:
+  struct Metric {
+    std::string name;
+    MetricType type;
+  };
+
+  // The metrics of one thread; written only by that thread.
+  struct ThreadMetrics {
+    ThreadMetrics() {
+      for (int id = 0; id < kMaxMetrics; ++id) {
+        histograms[id].store(nullptr, std::memory_order_relaxed);
+        counters[id].store(0, std::memory_order_relaxed);
+      }
+    }
+    std::atomic<LatencyHistogram*> histograms[kMaxMetrics];
+    std::atomic<uint64_t> counters[kMaxMetrics];
+  };
+
+  InstrumentationRegistry()
+      : start_ticks_(ReadTimestamp()),
+        start_time_(std::chrono::steady_clock::now()),
+        stop_export_(false) {}
+
+  static InstrumentationRegistry* Create() {
+    InstrumentationRegistry* registry = new InstrumentationRegistry;
+    const char* path = std::getenv("CPP_LABS_INSTRUMENTATION_FILE");
+    const char* interval =
+        std::getenv("CPP_LABS_INSTRUMENTATION_INTERVAL_SECONDS");
+    if (path != nullptr && interval != nullptr && std::atof(interval) > 0.0) {
+      registry->StartPeriodicExport(path, std::atof(interval));
+    }
+    std::atexit(&ExportAtExit);
+    return registry;
+  }
+
+  static void ExportAtExit() {
+    InstrumentationRegistry& registry = Get();
+    registry.StopPeriodicExport();
+    const char* path = std::getenv("CPP_LABS_INSTRUMENTATION_FILE");
+    if (path == nullptr || !registry.ExportToFile(path)) {
+      registry.WriteText(&std::cerr);
+    }
+  }
+
+  ThreadMetrics* LocalMetrics() {
+    // The data outlives the thread, so that the report includes it.
+    static thread_local ThreadMetrics* metrics = nullptr;
+    if (metrics == nullptr) {
+      metrics = new ThreadMetrics;
+      std::lock_guard<std::mutex> lock(mutex_);
+      threads_.push_back(metrics);
+    }
+    return metrics;
+  }
+
+  // Copies the metrics, and merges the histograms and counters of all the
+  // threads (the caller deletes the histograms).
+  void Collect(std::vector<Metric>* metrics,
+               std::vector<LatencyHistogram*>* histograms,
+               std::vector<uint64_t>* counters) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    *metrics = metrics_;
+    counters->assign(metrics_.size(), 0);
+    for (std::size_t id = 0; id < metrics_.size(); ++id) {
+      histograms->push_back(new LatencyHistogram);
+      for (const ThreadMetrics* thread : threads_) {
+        const LatencyHistogram* histogram =
+            thread->histograms[id].load(std::memory_order_acquire);
+        if (histogram != nullptr) {
+          histograms->back()->Merge(*histogram);
+        }
+        (*counters)[id] += thread->counters[id].load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Calibrates the ticks against steady_clock since the registry was
+  // created, over at least 10 milliseconds.
+  double NanosecondsPerTick() const {
+#if defined(__x86_64__) || defined(__i386__)
+    const std::chrono::nanoseconds kMinElapsed(10000000);
+    std::chrono::steady_clock::time_point now;
+    do {
+      now = std::chrono::steady_clock::now();
+    } while (now - start_time_ < kMinElapsed);
+    const uint64_t ticks = ReadTimestamp() - start_ticks_;
+    return std::chrono::duration<double, std::nano>(now - start_time_).count() /
+           ticks;
+#else
+    return 1.0;
+#endif
+  }
+
+  static double Mean(const LatencyHistogram& histogram) {
+    return histogram.count() == 0
+               ? 0.0
+               : static_cast<double>(histogram.sum()) / histogram.count();
+  }
+
+  static std::string JsonString(const std::string& text) {
+    std::string quoted = "\"";
+    for (const char c : text) {
+      if (static_cast<unsigned char>(c) < 0x20) {
+        // Control characters must be escaped, as \u00XX.
+        const char kHexDigits[] = "0123456789abcdef";
+        quoted += "\\u00";
+        quoted += kHexDigits[(c >> 4) & 0xf];
+        quoted += kHexDigits[c & 0xf];
+        continue;
+      }
+      if (c == '"' || c == '\\') {
+        quoted += '\\';
+      }
+      quoted += c;
+    }
+    return quoted + "\"";
+  }
+
+  const uint64_t start_ticks_;
+  const std::chrono::steady_clock::time_point start_time_;
+  std::mutex mutex_;
+  std::vector<Metric> metrics_;
+  std::vector<ThreadMetrics*> threads_;
+
+  std::mutex export_mutex_;
+  std::condition_variable export_done_;
+  bool stop_export_;
+  std::thread export_thread_;
+};
+
+// Records the ticks between its construction and its destruction.
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(const int metric_id)
+      : metric_id_(metric_id), start_(ReadTimestamp()) {}
+  ~ScopedTimer() {
+    InstrumentationRegistry::Get().RecordTicks(metric_id_,
+                                               ReadTimestamp() - start_);
+  }
+
+ private:
+  const int metric_id_;
+  const uint64_t start_;
+};
+
+namespace internal {
+
+// Returns function(), timed into the given metric.
+template <typename Function>
+auto TimeExpression(const int metric_id, const Function& function)
+    -> decltype(function()) {
+  ScopedTimer timer(metric_id);
+  return function();
+}
+
+}  // namespace internal
+}  // namespace cpp_labs
+
+#define CPP_LABS_INSTRUMENTATION_CONCAT_(a, b) a##b
+#define CPP_LABS_INSTRUMENTATION_NAME_(prefix, line) \
+  CPP_LABS_INSTRUMENTATION_CONCAT_(prefix, line)
+
+#if defined(CPP_LABS_ENABLE_INSTRUMENTATION)
+
+// The id of a metric, registered the first time the call site runs.
+#define CPP_LABS_METRIC_ID_(name, type)                                 \
+  ([]() {                                                               \
+    static const int id =                                               \
+        ::cpp_labs::InstrumentationRegistry::Get().Register(name, type); \
+    return id;                                                          \
+  }())
+
+#define CPP_LABS_SCOPED_TIMER(name)                                      \
+  ::cpp_labs::ScopedTimer CPP_LABS_INSTRUMENTATION_NAME_(               \
+      cpp_labs_scoped_timer_, __LINE__)(                                 \
+      CPP_LABS_METRIC_ID_(name, ::cpp_labs::MetricType::kHistogram))
+
+#define CPP_LABS_TIMED(name, expression)                                 \
+  ::cpp_labs::internal::TimeExpression(                                  \
+      CPP_LABS_METRIC_ID_(name, ::cpp_labs::MetricType::kHistogram),     \
+      [&]() -> decltype((expression)) { return (expression); })
+
+#define CPP_LABS_COUNTER_ADD(name, value)                     \
+  ::cpp_labs::InstrumentationRegistry::Get().AddToCounter(    \
+      CPP_LABS_METRIC_ID_(name, ::cpp_labs::MetricType::kCounter), (value))
+
+#else
+
+#define CPP_LABS_SCOPED_TIMER(name) static_cast<void>(0)
+#define CPP_LABS_TIMED(name, expression) (expression)
+#define CPP_LABS_COUNTER_ADD(name, value) static_cast<void>(0)
+
+#endif  // CPP_LABS_ENABLE_INSTRUMENTATION
+
+#endif  // CPP_LABS_INSTRUMENTATION_H_
@@ -40,12 +40,18 @@
 // 1. The map stores pairs of a key and its corresponding value, i.e., a pair
 // (key, value).
 // 2. Memory is handled dynamically for us.
+// 3. The map operations are timed with the macros of instrumentation.h. They
+// compile to nothing unless the labs are built with
+// -DBUILD_WITH_INSTRUMENTATION=ON, in which case the latency of every
+// operation is reported when the program exits.
 
 #include <iostream>  // Header for printing to stdout.
 #include <map>  // Header for using std::set.
 #include <string>  // Header for using std::string.
 #include <utility>  // Header for using std::pair.
 
+#include "instrumentation.h"
+
 int main(int argc, char** argv) {
   // Declaration of a map requires to types, the key and the value.
   std::map<std::string, int> user_name_to_user_id;
@@ -53,8 +59,10 @@ int main(int argc, char** argv) {
   // be viewed as a dictionary (e.g., as in Python).
   // Inserting into the map example.
   int user_id = 1;
-  user_name_to_user_id["victor"] = user_id;
-  user_name_to_user_id["john"] = ++user_id;
+  CPP_LABS_TIMED("std::map::operator[]", user_name_to_user_id["victor"]) =
+      user_id;
+  CPP_LABS_TIMED("std::map::operator[]", user_name_to_user_id["john"]) =
+      ++user_id;
   // When inserting an entry, the key value goes inside the square brackets.
   // The value then is assigned using the = operator. When this operation is
   // successful, the map stores an std::pair<int, std::string> instance. This
@@ -75,7 +83,7 @@ int main(int argc, char** argv) {
   // returned iterator is equals to std::map::end() then the entry is not in the
   // map, if it is different, then the entry is in the map.
   std::map<std::string, int>::iterator iterator =
-      user_name_to_user_id.find("victor");
+      CPP_LABS_TIMED("std::map::find", user_name_to_user_id.find("victor"));
   if (iterator == user_name_to_user_id.end()) {
     std::cout << "User name not found." << std::endl;
   } else {
@@ -85,7 +93,8 @@ int main(int argc, char** argv) {
   // Note that the iterator "points" to a std::pair, which its first member is
   // the key and the second member is the value.
   // Let's search for a non-existing entry.
-  iterator = user_name_to_user_id.find("aladin");
+  iterator =
+      CPP_LABS_TIMED("std::map::find", user_name_to_user_id.find("aladin"));
   if (iterator == user_name_to_user_id.end()) {
     std::cout << "User name not found." << std::endl;
   } else {
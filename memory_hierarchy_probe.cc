@@ -0,0 +1,322 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary probes the memory hierarchy of the machine it runs on.
+//
+// pointers_example.cc walks an array with a pointer and prints the address of
+// each element. Here we walk much larger arrays and time the walk instead: for
+// working sets from 4 KB to 4 GB the probe measures
+//
+// 1. Load-to-use latency (ns per load) of a pointer chase, where every load
+// needs the address read by the previous one, so no two loads overlap. The
+// chase visits cache-line-sized nodes in three orders:
+//    - sequential: the next node is the next cache line (the hardware
+//      prefetcher sees this coming),
+//    - strided: the next node is 4 KB away (one cache line per page),
+//    - random: a random cycle through all the nodes (neither the prefetcher
+//      nor the caches can help once the working set does not fit).
+// 2. Bandwidth (GB/s) of streaming reads (a sum) and streaming writes (a fill)
+// over the same working set.
+//
+// The output is CSV (one row per working set) followed by the cache
+// boundaries detected from the jumps of the random-chase latency, which is
+// where a working set stops fitting in L1, L2, L3 and falls to DRAM. Use them
+// to size nodes, buckets and chunks of containers for a given host.
+//
+// Usage: memory_hierarchy_probe [max_bytes] [min_bytes]
+//   Defaults: max_bytes = 4294967296 (4 GB), min_bytes = 4096.
+//
+// Notes:
+//
+// 1. The probe allocates max_bytes at once; pass a smaller max_bytes on
+// machines with less memory.
+// 2. At large working sets the random chase also misses the TLB; the latency
+// then includes page walks, as it does for a real container of that size.
+
+#include <unistd.h>  // Header for sysconf.
+
+#include <algorithm>  // Header for std::swap.
+#include <cstdint>  // Header for uint64_t.
+#include <iostream>  // Header for printing to stdout.
+#include <random>  // Header for std::mt19937_64.
+#include <string>  // Header for std::string.
+#include <vector>  // Header for std::vector.
+
+#include "aligned_memory.h"
+#include "benchmark_utils.h"
+
+namespace {
+
+// One node per cache line. The chase only reads 'next'.
+struct Node {
+  Node* next;
+  char padding[cpp_labs::kCacheLineSize - sizeof(Node*)];
+};
+
+static_assert(sizeof(Node) == cpp_labs::kCacheLineSize,
+              "A node must fill exactly one cache line.");
+
+// Number of dependent loads timed for each working set, per round. The
+// fastest of kNumChaseRounds rounds is reported, which filters out noise from
+// interrupts and other processes.
+const std::size_t kNumChaseSteps = 1 << 22;
+const int kNumChaseRounds = 3;
+// Bytes streamed for each bandwidth measurement (repeating small sets).
+const std::size_t kBytesStreamed = std::size_t(1) << 30;
+// Distance between consecutive nodes of the strided chase.
+const std::size_t kStrideBytes = 4096;
+
+enum ChaseOrder { kSequential, kStrided, kRandom };
+
+// Links nodes[0, num_nodes) into a single cycle in the given order.
+void LinkNodes(const ChaseOrder order, const std::size_t num_nodes,
+               Node* nodes, std::mt19937_64* rng) {
+  std::vector<std::size_t> order_of_visit(num_nodes);
+  if (order == kSequential) {
+    for (std::size_t i = 0; i < num_nodes; ++i) {
+      order_of_visit[i] = i;
+    }
+  } else if (order == kStrided) {
+    // Visit node 0, stride, 2 * stride, ..., then 1, 1 + stride, ... so the
+    // cycle still covers every node.
+    const std::size_t stride_nodes =
+        std::min(num_nodes, kStrideBytes / sizeof(Node));
+    std::size_t position = 0;
+    for (std::size_t start = 0; start < stride_nodes; ++start) {
+      for (std::size_t i = start; i < num_nodes; i += stride_nodes) {
+        order_of_visit[position++] = i;
+      }
+    }
+  } else {
+    // Sattolo's algorithm: a random permutation that is a single cycle.
+    for (std::size_t i = 0; i < num_nodes; ++i) {
+      order_of_visit[i] = i;
+    }
+    for (std::size_t i = num_nodes - 1; i > 0; --i) {
+      std::uniform_int_distribution<std::size_t> distribution(0, i - 1);
+      std::swap(order_of_visit[i], order_of_visit[distribution(*rng)]);
+    }
+  }
+  for (std::size_t i = 0; i + 1 < num_nodes; ++i) {
+    nodes[order_of_visit[i]].next = &nodes[order_of_visit[i + 1]];
+  }
+  nodes[order_of_visit[num_nodes - 1]].next = &nodes[order_of_visit[0]];
+}
+
+// Returns the average latency of one dependent load in nanoseconds.
+double ChaseLatency(const ChaseOrder order, const std::size_t num_nodes,
+                    Node* nodes, std::mt19937_64* rng) {
+  LinkNodes(order, num_nodes, nodes, rng);
+  // Warm up: one lap (bounded) to bring the working set into the caches and
+  // the TLB, as far as it fits.
+  Node* node = nodes;
+  for (std::size_t i = 0; i < std::min(num_nodes, kNumChaseSteps); ++i) {
+    node = node->next;
+  }
+  double best_nanoseconds = 0.0;
+  for (int round = 0; round < kNumChaseRounds; ++round) {
+    cpp_labs::Timer timer;
+    for (std::size_t i = 0; i < kNumChaseSteps; ++i) {
+      node = node->next;
+    }
+    cpp_labs::DoNotOptimize(node);
+    const double nanoseconds = timer.ElapsedNanoseconds();
+    if (round == 0 || nanoseconds < best_nanoseconds) {
+      best_nanoseconds = nanoseconds;
+    }
+  }
+  return best_nanoseconds / kNumChaseSteps;
+}
+
+std::size_t NumRepetitions(const std::size_t bytes) {
+  return bytes >= kBytesStreamed ? 1 : kBytesStreamed / bytes;
+}
+
+// Returns the bandwidth of summing all the words of the buffer, in GB/s.
+double ReadBandwidth(const uint64_t* words, const std::size_t num_words) {
+  const std::size_t repetitions = NumRepetitions(num_words * sizeof(uint64_t));
+  cpp_labs::Timer timer;
+  uint64_t sum = 0;
+  for (std::size_t r = 0; r < repetitions; ++r) {
+    // Four independent sums so the adds do not limit the loads.
+    uint64_t sums[4] = {0, 0, 0, 0};
+    for (std::size_t i = 0; i + 4 <= num_words; i += 4) {
+      sums[0] += words[i];
+      sums[1] += words[i + 1];
+      sums[2] += words[i + 2];
+      sums[3] += words[i + 3];
+    }
+    sum += sums[0] + sums[1] + sums[2] + sums[3];
+    cpp_labs::ClobberMemory();
+  }
+  cpp_labs::DoNotOptimize(sum);
+  return repetitions * num_words * sizeof(uint64_t) / timer.ElapsedSeconds() /
+         1e9;
+}
+
+// Returns the bandwidth of writing all the words of the buffer, in GB/s.
+double WriteBandwidth(uint64_t* words, const std::size_t num_words) {
+  const std::size_t repetitions = NumRepetitions(num_words * sizeof(uint64_t));
+  cpp_labs::Timer timer;
+  for (std::size_t r = 0; r < repetitions; ++r) {
+    for (std::size_t i = 0; i < num_words; ++i) {
+      words[i] = r;
+    }
+    cpp_labs::ClobberMemory();
+  }
+  return repetitions * num_words * sizeof(uint64_t) / timer.ElapsedSeconds() /
+         1e9;
+}
+
+struct Measurement {
+  std::size_t bytes;
+  double sequential_ns;
+  double strided_ns;
+  double random_ns;
+  double read_gbps;
+  double write_gbps;
+};
+
+std::string HumanBytes(const std::size_t bytes) {
+  const std::size_t kKilobyte = 1 << 10;
+  const std::size_t kMegabyte = 1 << 20;
+  const std::size_t kGigabyte = 1 << 30;
+  if (bytes % kGigabyte == 0) {
+    return std::to_string(bytes / kGigabyte) + " GB";
+  }
+  if (bytes % kMegabyte == 0) {
+    return std::to_string(bytes / kMegabyte) + " MB";
+  }
+  return std::to_string(bytes / kKilobyte) + " KB";
+}
+
+// Reports the working sets where the random-chase latency jumps by more than
+// kJumpRatio: the data stopped fitting in one level of the hierarchy. Jumps at
+// consecutive sizes belong to the same boundary (a level rarely ends sharply,
+// e.g. because of associativity or because a cache is shared).
+void PrintBoundaries(const std::vector<Measurement>& measurements) {
+  const double kJumpRatio = 1.3;
+  const char* kLevelNames[] = {"L1", "L2", "L3", "L4"};
+  const std::size_t kNumLevelNames = 4;
+  std::size_t level = 0;
+  std::cout << "# Detected boundaries (random chase latency jumps):\n";
+  std::size_t i = 1;
+  while (i < measurements.size()) {
+    if (measurements[i].random_ns <=
+        kJumpRatio * measurements[i - 1].random_ns) {
+      ++i;
+      continue;
+    }
+    const Measurement& last_fitting = measurements[i - 1];
+    while (i + 1 < measurements.size() &&
+           measurements[i + 1].random_ns >
+               kJumpRatio * measurements[i].random_ns) {
+      ++i;
+    }
+    const Measurement& first_spilling = measurements[i];
+    std::cout << "#   "
+              << (level < kNumLevelNames ? kLevelNames[level] : "next level")
+              << " ends between " << HumanBytes(last_fitting.bytes) << " and "
+              << HumanBytes(first_spilling.bytes) << ": "
+              << last_fitting.random_ns << " ns -> "
+              << first_spilling.random_ns << " ns" << std::endl;
+    ++level;
+    ++i;
+  }
+  std::cout << "# Last level (DRAM or the largest cache probed): "
+            << measurements.back().random_ns << " ns per load, "
+            << measurements.back().read_gbps << " GB/s read." << std::endl;
+}
+
+void PrintReportedCacheSizes() {
+#if defined(_SC_LEVEL1_DCACHE_SIZE)
+  std::cout << "# Cache sizes reported by the system: L1d "
+            << sysconf(_SC_LEVEL1_DCACHE_SIZE) << ", L2 "
+            << sysconf(_SC_LEVEL2_CACHE_SIZE) << ", L3 "
+            << sysconf(_SC_LEVEL3_CACHE_SIZE) << " bytes." << std::endl;
+#endif
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t max_bytes =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, std::size_t(1) << 32);
+  const std::size_t min_bytes = std::max<std::size_t>(
+      cpp_labs::ParseSizeArgument(argc, argv, 2, 4096), sizeof(Node));
+  if (max_bytes < min_bytes) {
+    std::cerr << "max_bytes must be at least min_bytes." << std::endl;
+    return 1;
+  }
+
+  // One buffer for all the working sets: the smaller sets use its beginning.
+  void* buffer = cpp_labs::AlignedAllocate(kStrideBytes, max_bytes);
+  std::mt19937_64 rng(42);
+
+  PrintReportedCacheSizes();
+  std::cout << "bytes,sequential_ns,strided_ns,random_ns,read_gbps,write_gbps"
+            << std::endl;
+  std::vector<Measurement> measurements;
+  // Two points per doubling (x1 and x1.5) to locate the boundaries better.
+  for (std::size_t base = min_bytes; base <= max_bytes; base *= 2) {
+    const std::size_t sizes[] = {base, base + base / 2};
+    for (const std::size_t bytes : sizes) {
+      if (bytes > max_bytes) {
+        break;
+      }
+      const std::size_t num_nodes = bytes / sizeof(Node);
+      Node* nodes = static_cast<Node*>(buffer);
+      uint64_t* words = static_cast<uint64_t*>(buffer);
+      const std::size_t num_words = num_nodes * sizeof(Node) / sizeof(uint64_t);
+
+      Measurement measurement;
+      measurement.bytes = bytes;
+      measurement.write_gbps = WriteBandwidth(words, num_words);
+      measurement.read_gbps = ReadBandwidth(words, num_words);
+      measurement.sequential_ns =
+          ChaseLatency(kSequential, num_nodes, nodes, &rng);
+      measurement.strided_ns = ChaseLatency(kStrided, num_nodes, nodes, &rng);
+      measurement.random_ns = ChaseLatency(kRandom, num_nodes, nodes, &rng);
+      measurements.push_back(measurement);
+
+      std::cout << measurement.bytes << "," << measurement.sequential_ns << ","
+                << measurement.strided_ns << "," << measurement.random_ns
+                << "," << measurement.read_gbps << ","
+                << measurement.write_gbps << std::endl;
+    }
+  }
+  PrintBoundaries(measurements);
+  cpp_labs::AlignedFree(buffer);
+  return 0;
+}
@@ -0,0 +1,466 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_MEMORY_RECLAMATION_H_
+#define CPP_LABS_MEMORY_RECLAMATION_H_
+
+// Safe memory reclamation for lock-free data structures.
+//
+// heap_memory_example.cc releases memory with 'delete' as soon as it is not
+// needed. With several threads that is not safe: a writer may unlink a node
+// from a shared structure and delete it while a reader, which loaded the
+// pointer a moment earlier, is still reading the node. Locks solve this by
+// making the reader and the writer wait for each other. The two schemes below
+// let readers run without locks instead; the writer "retires" the node and the
+// node is deleted later, once no reader can still hold a pointer to it.
+//
+// 1. Hazard pointers (HazardPointerDomain). Before using a shared pointer, a
+// reader publishes it in one of its hazard slots ("protect"). A retired node
+// is deleted only when it is not published in any slot. Memory use is bounded
+// (at most a few retired nodes per thread wait), but every protect costs a
+// store and a full memory fence.
+// 2. Epoch-based reclamation (EpochDomain). A reader announces that it is
+// inside a read-side critical section, tagged with the current global epoch.
+// A node retired in epoch e is deleted once the global epoch reaches e + 2,
+// which requires every thread inside a critical section to have seen epoch
+// e + 1. Reads cost almost nothing, but one stalled reader delays all
+// reclamation.
+//
+// Both domains have the same interface, so data structures can take the
+// scheme as a template argument:
+//
+//   Domain domain;                        // Shared by all the threads.
+//   // In each thread:
+//   Domain::ThreadContext context(&domain);
+//   {
+//     Domain::Guard guard(&context);      // A read-side critical section.
+//     Node* node = guard.protect(0, shared_head);  // Slot 0.
+//     ... read node ...
+//   }
+//   // A writer that unlinked old_node:
+//   context.retire(old_node);             // Deleted when no one can see it.
+//
+// A ThreadContext belongs to one thread, and it must be destroyed before its
+// domain. Nodes still retired when the domain is destroyed are deleted then.
+
+#include <algorithm>  // Header for std::sort and std::binary_search.
+#include <atomic>  // Header for std::atomic.
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for uint64_t.
+#include <thread>  // Header for std::this_thread::yield.
+#include <vector>  // Header for std::vector.
+
+#include "aligned_memory.h"
+
+namespace cpp_labs {
+namespace internal {
+
+template <typename T>
+void DeleteObject(void* object) {
+  delete static_cast<T*>(object);
+}
+
+// A node waiting to be deleted.
+struct RetiredObject {
+  void* object;
+  void (*deleter)(void*);
+  // Epoch-based reclamation only: the global epoch when it was retired.
+  uint64_t epoch;
+};
+
+// Per-thread state is kept in records that are linked into a list owned by
+// the domain. Records are never unlinked: when a thread is done its record is
+// released and the next thread reuses it, along with any objects it retired
+// that could not be deleted yet.
+template <typename Record>
+class RecordList {
+ public:
+  RecordList() : head_(nullptr) {}
+
+  ~RecordList() {
+    Record* record = head_.load();
+    while (record != nullptr) {
+      Record* next = record->next;
+      for (const RetiredObject& retired : record->retired) {
+        retired.deleter(retired.object);
+      }
+      record->~Record();
+      AlignedFree(record);
+      record = next;
+    }
+  }
+
+  Record* Acquire() {
+    for (Record* record = head_.load(std::memory_order_acquire);
+         record != nullptr; record = record->next) {
+      bool expected = false;
+      if (!record->in_use.load(std::memory_order_relaxed) &&
+          record->in_use.compare_exchange_strong(expected, true)) {
+        return record;
+      }
+    }
+    // Records are cache-line aligned so two threads never share a line.
+    Record* record = new (AlignedAllocate(kCacheLineSize, sizeof(Record)))
+        Record;
+    record->in_use.store(true, std::memory_order_relaxed);
+    Record* head = head_.load(std::memory_order_relaxed);
+    do {
+      record->next = head;
+    } while (!head_.compare_exchange_weak(head, record,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+    return record;
+  }
+
+  void Release(Record* record) {
+    record->in_use.store(false, std::memory_order_release);
+  }
+
+  Record* head() const { return head_.load(std::memory_order_acquire); }
+
+ private:
+  std::atomic<Record*> head_;
+};
+
+}  // namespace internal
+
+class HazardPointerDomain {
+ public:
+  // Hazard slots per thread: how many pointers a thread can protect at once.
+  static const int kSlotsPerThread = 4;
+
+  // scan_threshold: retired objects a thread accumulates before it scans the
+  // hazard slots of all threads to delete the unprotected ones.
+  explicit HazardPointerDomain(const std::size_t scan_threshold = 64)
+      : scan_threshold_(scan_threshold) {}
+
+  HazardPointerDomain(const HazardPointerDomain&) = delete;
+  HazardPointerDomain& operator=(const HazardPointerDomain&) = delete;
+
+  struct Record {
+    Record() : next(nullptr), next_scan_size(0) {
+      in_use.store(false, std::memory_order_relaxed);
+      for (int i = 0; i < kSlotsPerThread; ++i) {
+        hazards[i].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+
+    std::atomic<const void*> hazards[kSlotsPerThread];
+    std::atomic<bool> in_use;
+    Record* next;
+    std::vector<internal::RetiredObject> retired;
+    // Scan when retired reaches this size.
+    std::size_t next_scan_size;
+  };
+
+  class ThreadContext {
+   public:
+    explicit ThreadContext(HazardPointerDomain* domain)
+        : domain_(domain), record_(domain->records_.Acquire()) {}
+
+    ~ThreadContext() {
+      ClearAll();
+      domain_->Scan(record_);
+      domain_->records_.Release(record_);
+    }
+
+    ThreadContext(const ThreadContext&) = delete;
+    ThreadContext& operator=(const ThreadContext&) = delete;
+
+    // Loads source and protects the loaded pointer in the given slot. The
+    // pointer stays valid until the slot is cleared or reused.
+    template <typename T>
+    T* protect(const int slot, const std::atomic<T*>& source) {
+      T* pointer = source.load(std::memory_order_relaxed);
+      while (true) {
+        // The store must be visible to other threads before the source is
+        // read again, hence the sequentially consistent store and load.
+        record_->hazards[slot].store(pointer, std::memory_order_seq_cst);
+        T* current = source.load(std::memory_order_seq_cst);
+        if (current == pointer) {
+          return pointer;
+        }
+        pointer = current;
+      }
+    }
+
+    void clear(const int slot) {
+      record_->hazards[slot].store(nullptr, std::memory_order_release);
+    }
+
+    void ClearAll() {
+      for (int i = 0; i < kSlotsPerThread; ++i) {
+        clear(i);
+      }
+    }
+
+    // Deletes object (with 'delete') once no hazard slot holds it. object
+    // must already be unreachable for threads that have not protected it.
+    template <typename T>
+    void retire(T* object) {
+      internal::RetiredObject retired = {object, &internal::DeleteObject<T>,
+                                         0};
+      record_->retired.push_back(retired);
+      if (record_->retired.size() >= record_->next_scan_size) {
+        domain_->Scan(record_);
+      }
+    }
+
+    // Number of objects retired by this thread and not deleted yet.
+    std::size_t num_retired() const { return record_->retired.size(); }
+
+   private:
+    HazardPointerDomain* domain_;
+    Record* record_;
+  };
+
+  // Scope of a read-side operation: clears the slots it used on exit.
+  class Guard {
+   public:
+    explicit Guard(ThreadContext* context) : context_(context) {}
+    ~Guard() { context_->ClearAll(); }
+
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+
+    template <typename T>
+    T* protect(const int slot, const std::atomic<T*>& source) {
+      return context_->protect(slot, source);
+    }
+
+   private:
+    ThreadContext* context_;
+  };
+
+  static const char* Name() { return "hazard pointers"; }
+
+ private:
+  // Deletes the objects retired by record that no thread protects.
+  void Scan(Record* record) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::vector<const void*> protected_objects;
+    for (Record* other = records_.head(); other != nullptr;
+         other = other->next) {
+      for (int i = 0; i < kSlotsPerThread; ++i) {
+        const void* hazard = other->hazards[i].load(std::memory_order_seq_cst);
+        if (hazard != nullptr) {
+          protected_objects.push_back(hazard);
+        }
+      }
+    }
+    std::sort(protected_objects.begin(), protected_objects.end());
+
+    std::vector<internal::RetiredObject> still_retired;
+    for (const internal::RetiredObject& retired : record->retired) {
+      if (std::binary_search(protected_objects.begin(),
+                             protected_objects.end(),
+                             static_cast<const void*>(retired.object))) {
+        still_retired.push_back(retired);
+      } else {
+        retired.deleter(retired.object);
+      }
+    }
+    record->retired.swap(still_retired);
+    // The objects that stayed are protected; do not scan them again until
+    // scan_threshold_ more objects are retired.
+    record->next_scan_size = record->retired.size() + scan_threshold_;
+  }
+
+  const std::size_t scan_threshold_;
+  internal::RecordList<Record> records_;
+};
+
+class EpochDomain {
+ public:
+  // reclaim_threshold: retired objects a thread accumulates before it tries
+  // to advance the global epoch and delete the objects that became safe.
+  explicit EpochDomain(const std::size_t reclaim_threshold = 64)
+      : reclaim_threshold_(reclaim_threshold), global_epoch_(1) {}
+
+  EpochDomain(const EpochDomain&) = delete;
+  EpochDomain& operator=(const EpochDomain&) = delete;
+
+  struct Record {
+    Record() : next(nullptr), nesting(0), next_reclaim_size(0) {
+      in_use.store(false, std::memory_order_relaxed);
+      announced_epoch.store(kQuiescent, std::memory_order_relaxed);
+    }
+
+    // Epoch seen when the thread entered its critical section, or kQuiescent.
+    std::atomic<uint64_t> announced_epoch;
+    std::atomic<bool> in_use;
+    Record* next;
+    int nesting;
+    std::vector<internal::RetiredObject> retired;
+    // Try to reclaim when retired reaches this size.
+    std::size_t next_reclaim_size;
+  };
+
+  class ThreadContext {
+   public:
+    explicit ThreadContext(EpochDomain* domain)
+        : domain_(domain), record_(domain->records_.Acquire()) {}
+
+    ~ThreadContext() {
+      domain_->TryReclaim(record_);
+      domain_->records_.Release(record_);
+    }
+
+    ThreadContext(const ThreadContext&) = delete;
+    ThreadContext& operator=(const ThreadContext&) = delete;
+
+    // Starts a read-side critical section (they may nest).
+    void Enter() {
+      if (record_->nesting++ == 0) {
+        record_->announced_epoch.store(
+            domain_->global_epoch_.load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+        // Readers must not load shared pointers before the announcement is
+        // visible to threads that advance the epoch.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+      }
+    }
+
+    void Exit() {
+      if (--record_->nesting == 0) {
+        record_->announced_epoch.store(kQuiescent, std::memory_order_release);
+      }
+    }
+
+    // Inside a critical section a plain load is enough.
+    template <typename T>
+    T* protect(const int slot, const std::atomic<T*>& source) {
+      (void)slot;
+      return source.load(std::memory_order_acquire);
+    }
+
+    // Deletes object (with 'delete') two epochs from now. object must already
+    // be unreachable for threads that enter a critical section later.
+    template <typename T>
+    void retire(T* object) {
+      internal::RetiredObject retired = {
+          object, &internal::DeleteObject<T>,
+          domain_->global_epoch_.load(std::memory_order_acquire)};
+      record_->retired.push_back(retired);
+      if (record_->retired.size() >= record_->next_reclaim_size) {
+        domain_->TryReclaim(record_);
+      }
+    }
+
+    std::size_t num_retired() const { return record_->retired.size(); }
+
+    // Blocks until every object this thread retired has been deleted (like
+    // synchronize_rcu in Linux): advances the epoch as soon as the readers in
+    // critical sections leave them. Must not be called inside a critical
+    // section of this thread, which would wait for itself.
+    void Synchronize() {
+      domain_->TryReclaim(record_);
+      while (!record_->retired.empty()) {
+        std::this_thread::yield();
+        domain_->TryReclaim(record_);
+      }
+    }
+
+   private:
+    EpochDomain* domain_;
+    Record* record_;
+  };
+
+  class Guard {
+   public:
+    explicit Guard(ThreadContext* context) : context_(context) {
+      context_->Enter();
+    }
+    ~Guard() { context_->Exit(); }
+
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+
+    template <typename T>
+    T* protect(const int slot, const std::atomic<T*>& source) {
+      return context_->protect(slot, source);
+    }
+
+   private:
+    ThreadContext* context_;
+  };
+
+  static const char* Name() { return "epochs"; }
+
+ private:
+  static const uint64_t kQuiescent = ~uint64_t(0);
+
+  // Advances the global epoch if every thread in a critical section has seen
+  // it, then deletes the objects of record retired two or more epochs ago.
+  void TryReclaim(Record* record) {
+    uint64_t epoch = global_epoch_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool all_caught_up = true;
+    for (Record* other = records_.head(); other != nullptr;
+         other = other->next) {
+      const uint64_t announced =
+          other->announced_epoch.load(std::memory_order_acquire);
+      if (announced != kQuiescent && announced != epoch) {
+        all_caught_up = false;
+        break;
+      }
+    }
+    if (all_caught_up &&
+        global_epoch_.compare_exchange_strong(epoch, epoch + 1)) {
+      ++epoch;
+    }
+
+    std::vector<internal::RetiredObject> still_retired;
+    for (const internal::RetiredObject& retired : record->retired) {
+      if (retired.epoch + 2 <= epoch) {
+        retired.deleter(retired.object);
+      } else {
+        still_retired.push_back(retired);
+      }
+    }
+    record->retired.swap(still_retired);
+    // While a reader holds the epoch back, the objects that stayed cannot be
+    // deleted; do not check them again until reclaim_threshold_ more objects
+    // are retired.
+    record->next_reclaim_size = record->retired.size() + reclaim_threshold_;
+  }
+
+  const std::size_t reclaim_threshold_;
+  std::atomic<uint64_t> global_epoch_;
+  internal::RecordList<Record> records_;
+};
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_MEMORY_RECLAMATION_H_
@@ -0,0 +1,382 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary compares the memory reclamation schemes of
+// memory_reclamation.h against std::shared_ptr on a read-mostly workload,
+// and stress tests them.
+//
+// Usage: memory_reclamation_benchmark [max_threads] [milliseconds]
+//        memory_reclamation_benchmark --stress [max_threads] [milliseconds]
+//   Defaults: max_threads = 64, milliseconds = 200 (per measurement).
+//
+// Workload: kNumSlots shared pointers to small objects. Each thread picks a
+// slot at random; 99% of the time it reads the object (and checks that it is
+// intact), 1% of the time it replaces the object with a new one and reclaims
+// the old one through the scheme under test:
+//
+// 1. hazard pointers and epochs: readers take no locks and write no shared
+// memory (hazard pointers write to a slot owned by the reading thread).
+// 2. std::shared_ptr: readers copy the shared_ptr with std::atomic_load, which
+// increments and decrements a reference count shared by all the readers (and,
+// in libstdc++, takes a lock from a small global pool).
+// 3. no reclamation: the old objects are leaked, which is the upper bound.
+//
+// The stress mode runs the same workload and a lock-free stack (whose pop
+// reads a node that another thread may pop and retire at the same time) for
+// every thread count, and fails if any thread reads a deleted object or if
+// objects are leaked.
+
+#include <atomic>  // Header for std::atomic.
+#include <cstdint>  // Header for uint64_t.
+#include <cstring>  // Header for std::strcmp.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <memory>  // Header for std::shared_ptr.
+#include <thread>  // Header for std::thread.
+#include <vector>  // Header for std::vector.
+
+#include "benchmark_utils.h"
+#include "memory_reclamation.h"
+
+namespace {
+
+const int kNumSlots = 16;
+// One write every kWritePeriod operations.
+const uint64_t kWritePeriod = 100;
+
+// Objects created and not deleted yet, to detect leaks.
+std::atomic<long> num_live_objects(0);
+
+// A shared object that knows whether it is intact: check is always ~value
+// while it is alive, and the destructor breaks that.
+struct Object {
+  explicit Object(const uint64_t new_value)
+      : value(new_value), check(~new_value), next(nullptr) {
+    num_live_objects.fetch_add(1, std::memory_order_relaxed);
+  }
+  ~Object() {
+    check = value;
+    num_live_objects.fetch_sub(1, std::memory_order_relaxed);
+  }
+  bool intact() const { return check == ~value; }
+
+  uint64_t value;
+  uint64_t check;
+  // Used by the lock-free stack.
+  Object* next;
+};
+
+// Fast per-thread random numbers.
+inline uint64_t NextRandom(uint64_t* state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+struct ThreadResult {
+  uint64_t num_operations;
+  uint64_t num_errors;
+};
+
+// Runs body(thread_index, &stop, &result) in num_threads threads for the given
+// time, and returns the sum of their results.
+template <typename Body>
+ThreadResult RunThreads(const int num_threads, const int milliseconds,
+                        const Body& body) {
+  std::atomic<bool> stop(false);
+  std::vector<ThreadResult> results(num_threads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.push_back(std::thread([&, i]() { body(i, &stop, &results[i]); }));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+  stop.store(true);
+  ThreadResult total = {0, 0};
+  for (int i = 0; i < num_threads; ++i) {
+    threads[i].join();
+    total.num_operations += results[i].num_operations;
+    total.num_errors += results[i].num_errors;
+  }
+  return total;
+}
+
+// Read-mostly workload reclaiming through Domain (hazard pointers or epochs).
+template <typename Domain>
+ThreadResult ReadMostly(const int num_threads, const int milliseconds) {
+  std::atomic<Object*> slots[kNumSlots];
+  ThreadResult total;
+  {
+    Domain domain;
+    for (int i = 0; i < kNumSlots; ++i) {
+      slots[i].store(new Object(i));
+    }
+    total = RunThreads(num_threads, milliseconds,
+                       [&](const int thread_index, std::atomic<bool>* stop,
+                           ThreadResult* result) {
+      typename Domain::ThreadContext context(&domain);
+      uint64_t random_state = 88172645463325252ULL + thread_index;
+      ThreadResult local = {0, 0};
+      while (!stop->load(std::memory_order_relaxed)) {
+        const uint64_t random = NextRandom(&random_state);
+        std::atomic<Object*>& slot = slots[random % kNumSlots];
+        if (random % kWritePeriod == 0) {
+          Object* old_object = slot.exchange(new Object(random));
+          context.retire(old_object);
+        } else {
+          typename Domain::Guard guard(&context);
+          const Object* object = guard.protect(0, slot);
+          local.num_errors += object->intact() ? 0 : 1;
+        }
+        ++local.num_operations;
+      }
+      *result = local;
+    });
+    for (int i = 0; i < kNumSlots; ++i) {
+      delete slots[i].load();
+    }
+  }
+  return total;
+}
+
+ThreadResult ReadMostlySharedPtr(const int num_threads,
+                                 const int milliseconds) {
+  std::shared_ptr<const Object> slots[kNumSlots];
+  for (int i = 0; i < kNumSlots; ++i) {
+    slots[i] = std::make_shared<const Object>(i);
+  }
+  return RunThreads(num_threads, milliseconds,
+                    [&](const int thread_index, std::atomic<bool>* stop,
+                        ThreadResult* result) {
+    uint64_t random_state = 88172645463325252ULL + thread_index;
+    ThreadResult local = {0, 0};
+    while (!stop->load(std::memory_order_relaxed)) {
+      const uint64_t random = NextRandom(&random_state);
+      std::shared_ptr<const Object>* slot = &slots[random % kNumSlots];
+      if (random % kWritePeriod == 0) {
+        std::atomic_store(slot, std::make_shared<const Object>(random));
+      } else {
+        const std::shared_ptr<const Object> object = std::atomic_load(slot);
+        local.num_errors += object->intact() ? 0 : 1;
+      }
+      ++local.num_operations;
+    }
+    *result = local;
+  });
+}
+
+ThreadResult ReadMostlyLeak(const int num_threads, const int milliseconds) {
+  std::atomic<Object*> slots[kNumSlots];
+  for (int i = 0; i < kNumSlots; ++i) {
+    slots[i].store(new Object(i));
+  }
+  return RunThreads(num_threads, milliseconds,
+                    [&](const int thread_index, std::atomic<bool>* stop,
+                        ThreadResult* result) {
+    uint64_t random_state = 88172645463325252ULL + thread_index;
+    ThreadResult local = {0, 0};
+    while (!stop->load(std::memory_order_relaxed)) {
+      const uint64_t random = NextRandom(&random_state);
+      std::atomic<Object*>& slot = slots[random % kNumSlots];
+      if (random % kWritePeriod == 0) {
+        slot.store(new Object(random));
+      } else {
+        const Object* object = slot.load(std::memory_order_acquire);
+        local.num_errors += object->intact() ? 0 : 1;
+      }
+      ++local.num_operations;
+    }
+    *result = local;
+  });
+}
+
+// A Treiber stack: pop reads head->next while other threads may pop (and
+// retire) the same head. The reclamation scheme keeps head alive meanwhile,
+// which also prevents the ABA problem (head cannot be deleted and reused).
+template <typename Domain>
+class LockFreeStack {
+ public:
+  LockFreeStack() : head_(nullptr) {}
+
+  ~LockFreeStack() {
+    Object* node = head_.load();
+    while (node != nullptr) {
+      Object* next = node->next;
+      delete node;
+      node = next;
+    }
+  }
+
+  void Push(Object* node) {
+    Object* head = head_.load(std::memory_order_relaxed);
+    do {
+      node->next = head;
+    } while (!head_.compare_exchange_weak(head, node,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+  }
+
+  // Returns false if the stack is empty or the popped node was not intact.
+  bool Pop(typename Domain::ThreadContext* context, bool* intact) {
+    typename Domain::Guard guard(context);
+    while (true) {
+      Object* head = guard.protect(0, head_);
+      if (head == nullptr) {
+        return false;
+      }
+      Object* next = head->next;
+      if (head_.compare_exchange_strong(head, next)) {
+        *intact = head->intact();
+        context->retire(head);
+        return true;
+      }
+    }
+  }
+
+ private:
+  std::atomic<Object*> head_;
+};
+
+template <typename Domain>
+ThreadResult StackStress(const int num_threads, const int milliseconds) {
+  ThreadResult total;
+  {
+    Domain domain;
+    LockFreeStack<Domain> stack;
+    total = RunThreads(num_threads, milliseconds,
+                       [&](const int thread_index, std::atomic<bool>* stop,
+                           ThreadResult* result) {
+      typename Domain::ThreadContext context(&domain);
+      uint64_t random_state = 88172645463325252ULL + thread_index;
+      ThreadResult local = {0, 0};
+      while (!stop->load(std::memory_order_relaxed)) {
+        const uint64_t random = NextRandom(&random_state);
+        if (random % 2 == 0) {
+          stack.Push(new Object(random));
+        } else {
+          bool intact = true;
+          stack.Pop(&context, &intact);
+          local.num_errors += intact ? 0 : 1;
+        }
+        ++local.num_operations;
+      }
+      *result = local;
+    });
+  }
+  return total;
+}
+
+template <typename Function>
+bool Check(const char* name, const int num_threads, const Function& function) {
+  const ThreadResult result = function();
+  const long leaked = num_live_objects.load();
+  const bool ok = result.num_errors == 0 && leaked == 0;
+  std::cout << std::setw(28) << name << std::setw(9) << num_threads
+            << std::setw(14) << result.num_operations << std::setw(10)
+            << result.num_errors << std::setw(10) << leaked
+            << (ok ? "" : "  FAILED") << std::endl;
+  num_live_objects.store(0);
+  return ok;
+}
+
+bool RunStressTest(const int max_threads, const int milliseconds) {
+  std::cout << std::setw(28) << "test" << std::setw(9) << "threads"
+            << std::setw(14) << "operations" << std::setw(10) << "errors"
+            << std::setw(10) << "leaked" << std::endl;
+  bool ok = true;
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    ok &= Check("read-mostly, hazard pointers", threads, [&]() {
+      return ReadMostly<cpp_labs::HazardPointerDomain>(threads, milliseconds);
+    });
+    ok &= Check("read-mostly, epochs", threads, [&]() {
+      return ReadMostly<cpp_labs::EpochDomain>(threads, milliseconds);
+    });
+    ok &= Check("stack, hazard pointers", threads, [&]() {
+      return StackStress<cpp_labs::HazardPointerDomain>(threads, milliseconds);
+    });
+    ok &= Check("stack, epochs", threads, [&]() {
+      return StackStress<cpp_labs::EpochDomain>(threads, milliseconds);
+    });
+  }
+  std::cout << (ok ? "Stress test passed." : "Stress test FAILED.")
+            << std::endl;
+  return ok;
+}
+
+void RunBenchmark(const int max_threads, const int milliseconds) {
+  std::cout << "Read-mostly workload (" << 100.0 / kWritePeriod
+            << "% writes), million operations per second\n"
+            << std::setw(9) << "threads" << std::setw(18) << "hazard ptrs"
+            << std::setw(18) << "epochs" << std::setw(18) << "shared_ptr"
+            << std::setw(18) << "no reclamation" << std::endl;
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    const double seconds = milliseconds / 1000.0;
+    std::cout
+        << std::setw(9) << threads << std::setw(18)
+        << ReadMostly<cpp_labs::HazardPointerDomain>(threads, milliseconds)
+                   .num_operations / seconds / 1e6
+        << std::setw(18)
+        << ReadMostly<cpp_labs::EpochDomain>(threads, milliseconds)
+                   .num_operations / seconds / 1e6
+        << std::setw(18)
+        << ReadMostlySharedPtr(threads, milliseconds).num_operations /
+               seconds / 1e6
+        << std::setw(18)
+        << ReadMostlyLeak(threads, milliseconds).num_operations / seconds /
+               1e6
+        << std::endl;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool stress = false;
+  int first_number = 1;
+  if (argc > 1 && std::strcmp(argv[1], "--stress") == 0) {
+    stress = true;
+    first_number = 2;
+  }
+  const int max_threads = static_cast<int>(
+      cpp_labs::ParseSizeArgument(argc, argv, first_number, 64));
+  const int milliseconds = static_cast<int>(
+      cpp_labs::ParseSizeArgument(argc, argv, first_number + 1, 200));
+  std::cout << "Hardware threads: " << std::thread::hardware_concurrency()
+            << std::endl;
+  if (stress) {
+    return RunStressTest(max_threads, milliseconds) ? 0 : 1;
+  }
+  RunBenchmark(max_threads, milliseconds);
+  return 0;
+}
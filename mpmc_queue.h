@@ -0,0 +1,206 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_MPMC_QUEUE_H_
+#define CPP_LABS_MPMC_QUEUE_H_
+
+// MpmcQueue<T> is a bounded queue that any number of threads can push to and
+// pop from at the same time without locks (Dmitry Vyukov's design).
+//
+// The queue is a ring of cells, and each cell carries a sequence number that
+// says whose turn it is:
+//
+// - sequence == position: the cell is empty and the producer that claims
+//   'position' may write it,
+// - sequence == position + 1: the cell is full and the consumer that claims
+//   'position' may read it; after reading it sets the sequence to
+//   position + capacity, the next lap's producer position.
+//
+// Producers claim positions with a compare-and-swap on enqueue_position_ and
+// consumers on dequeue_position_. Each counter sits in its own cache line, so
+// producers and consumers only share the cells they hand to each other.
+//
+// try_push/try_pop never block. push/pop block when the queue is full/empty:
+// they spin briefly and then sleep on a FutexEvent (see futex_event.h). Only
+// push/pop signal the threads that sleep, so try_push/try_pop cost no more
+// than the compare-and-swap; a thread blocked in pop is woken up by push (and
+// one blocked in push by pop), so use the blocking variants on both sides
+// when either side blocks.
+//
+// Example:
+//   MpmcQueue<std::vector<int> > queue(1024);
+//   queue.push(std::move(batch));      // In a producer thread.
+//   std::vector<int> batch;
+//   queue.pop(&batch);                 // In a consumer thread.
+
+#include <atomic>  // Header for std::atomic.
+#include <cstddef>  // Header for std::size_t.
+#include <new>  // Header for placement new.
+#include <utility>  // Header for std::move and std::forward.
+
+#include "aligned_memory.h"
+#include "futex_event.h"
+
+namespace cpp_labs {
+
+template <typename T>
+class MpmcQueue {
+ public:
+  // capacity is rounded up to a power of two (at least 2).
+  explicit MpmcQueue(const std::size_t capacity)
+      : capacity_(RoundUpToPowerOfTwo(capacity)), mask_(capacity_ - 1) {
+    cells_ = static_cast<Cell*>(
+        AlignedAllocate(kCacheLineSize, capacity_ * sizeof(Cell)));
+    for (std::size_t i = 0; i < capacity_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueue_position_.store(0, std::memory_order_relaxed);
+    dequeue_position_.store(0, std::memory_order_relaxed);
+  }
+
+  // Must not run concurrently with any other member function.
+  ~MpmcQueue() {
+    const std::size_t end = enqueue_position_.load(std::memory_order_relaxed);
+    for (std::size_t position =
+             dequeue_position_.load(std::memory_order_relaxed);
+         position != end; ++position) {
+      reinterpret_cast<T*>(cells_[position & mask_].storage)->~T();
+    }
+    AlignedFree(cells_);
+  }
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  std::size_t capacity() const { return capacity_; }
+
+  // Returns false if the queue is full.
+  template <typename... Arguments>
+  bool try_emplace(Arguments&&... arguments) {
+    std::size_t position = enqueue_position_.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+    while (true) {
+      cell = &cells_[position & mask_];
+      const std::size_t sequence =
+          cell->sequence.load(std::memory_order_acquire);
+      const std::ptrdiff_t difference =
+          static_cast<std::ptrdiff_t>(sequence - position);
+      if (difference == 0) {
+        if (enqueue_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (difference < 0) {
+        // The cell still holds the value of the previous lap: full.
+        return false;
+      } else {
+        position = enqueue_position_.load(std::memory_order_relaxed);
+      }
+    }
+    ::new (static_cast<void*>(cell->storage))
+        T(std::forward<Arguments>(arguments)...);
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool try_push(const T& value) { return try_emplace(value); }
+  bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+  // Returns false if the queue is empty.
+  bool try_pop(T* value) {
+    std::size_t position = dequeue_position_.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+    while (true) {
+      cell = &cells_[position & mask_];
+      const std::size_t sequence =
+          cell->sequence.load(std::memory_order_acquire);
+      const std::ptrdiff_t difference =
+          static_cast<std::ptrdiff_t>(sequence - (position + 1));
+      if (difference == 0) {
+        if (dequeue_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (difference < 0) {
+        // The producer of this position has not written it yet: empty.
+        return false;
+      } else {
+        position = dequeue_position_.load(std::memory_order_relaxed);
+      }
+    }
+    T* stored = reinterpret_cast<T*>(cell->storage);
+    *value = std::move(*stored);
+    stored->~T();
+    cell->sequence.store(position + capacity_, std::memory_order_release);
+    return true;
+  }
+
+  // Blocks while the queue is full.
+  void push(T value) {
+    WaitUntil(&not_full_, [&]() { return try_push(std::move(value)); });
+    not_empty_.Notify();
+  }
+
+  // Blocks while the queue is empty.
+  void pop(T* value) {
+    WaitUntil(&not_empty_, [&]() { return try_pop(value); });
+    not_full_.Notify();
+  }
+
+ private:
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  static std::size_t RoundUpToPowerOfTwo(const std::size_t value) {
+    std::size_t power = 2;
+    while (power < value) {
+      power *= 2;
+    }
+    return power;
+  }
+
+  const std::size_t capacity_;
+  const std::size_t mask_;
+  Cell* cells_;
+  alignas(kCacheLineSize) std::atomic<std::size_t> enqueue_position_;
+  alignas(kCacheLineSize) std::atomic<std::size_t> dequeue_position_;
+  alignas(kCacheLineSize) FutexEvent not_empty_;
+  alignas(kCacheLineSize) FutexEvent not_full_;
+};
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_MPMC_QUEUE_H_
@@ -0,0 +1,403 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_NUMA_ALLOCATOR_H_
+#define CPP_LABS_NUMA_ALLOCATOR_H_
+
+// NUMA-aware allocation and placement for large containers.
+//
+// On a machine with several sockets, every socket (NUMA node) has its own
+// memory, and reading the memory of another node takes longer and shares a
+// narrower link. Linux places a page on the node of the thread that first
+// touches it, so an array allocated with 'new' (see heap_memory_example.cc)
+// and initialized by one thread lives entirely on one node: the threads of
+// the other nodes then read it remotely, at roughly half the bandwidth.
+//
+// This header provides:
+//
+// 1. NumaTopology: the nodes of the machine and their CPUs, read from
+// /sys/devices/system/node; or a simulated topology that splits the CPUs of a
+// single-node machine into several "nodes", so that every code path runs (the
+// memory of all of them is the one real node).
+// 2. NumaAllocate/NumaFree: whole pages from mmap with a placement policy:
+// kFirstTouch (the Linux default), kInterleave (pages round-robin over the
+// nodes, good for data read by every thread) or kBind (all pages on one node).
+// The policies use the mbind system call directly, so there is no dependency
+// on libnuma; if the kernel refuses it (no NUMA support, or a container
+// without permission), the memory is still returned, with the default policy.
+// 3. RunOnNodes and ParallelFill: run a function over the parts of a range on
+// threads pinned to the nodes, so that the pages of each part fault in on the
+// node of the thread that will use them (and the scans that follow should use
+// the same parts).
+// 4. NumaAllocator: an STL allocator with a placement policy that does not
+// initialize trivial elements, so that std::vector::resize leaves the
+// first touch to ParallelFill.
+// 5. NodeOfAddress: the node where a page actually is (move_pages).
+
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for uintptr_t.
+#include <cstdlib>  // Header for std::atoi.
+#include <fstream>  // Header for std::ifstream.
+#include <new>  // Header for std::bad_alloc and placement new.
+#include <sstream>  // Header for std::istringstream.
+#include <string>  // Header for std::string.
+#include <thread>  // Header for std::thread.
+#include <type_traits>  // Header for std::is_trivially_default_constructible.
+#include <utility>  // Header for std::forward.
+#include <vector>  // Header for std::vector.
+
+#include <sys/mman.h>  // Header for mmap and munmap.
+#if defined(__linux__)
+#include <sched.h>  // Header for sched_setaffinity.
+#include <sys/syscall.h>  // Header for SYS_mbind and SYS_move_pages.
+#include <unistd.h>  // Header for syscall and sysconf.
+#endif
+
+namespace cpp_labs {
+namespace internal {
+
+// Memory policies of mbind (see linux/mempolicy.h).
+const int kMpolBind = 2;
+const int kMpolInterleave = 3;
+
+// Parses a list of ranges such as "0-3,8,10-11".
+inline std::vector<int> ParseCpuList(const std::string& text) {
+  std::vector<int> values;
+  std::istringstream stream(text);
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    const std::size_t dash = range.find('-');
+    const int first = std::atoi(range.c_str());
+    const int last =
+        dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+    for (int value = first; value <= last && !range.empty(); ++value) {
+      values.push_back(value);
+    }
+  }
+  return values;
+}
+
+inline std::string ReadFirstLine(const std::string& path) {
+  std::ifstream file(path.c_str());
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+inline std::size_t NumaPageSize() {
+#if defined(__linux__)
+  static const std::size_t page_size = sysconf(_SC_PAGESIZE);
+  return page_size;
+#else
+  return 4096;
+#endif
+}
+
+}  // namespace internal
+
+class NumaTopology {
+ public:
+  // The nodes of this machine, or one node with every CPU if the system does
+  // not say.
+  static NumaTopology Detect() {
+    NumaTopology topology;
+    const std::vector<int> nodes = internal::ParseCpuList(
+        internal::ReadFirstLine("/sys/devices/system/node/online"));
+    for (const int node : nodes) {
+      const std::vector<int> cpus = internal::ParseCpuList(
+          internal::ReadFirstLine("/sys/devices/system/node/node" +
+                                  std::to_string(node) + "/cpulist"));
+      // Nodes with memory but no CPUs (e.g., CXL memory) are left out.
+      if (!cpus.empty()) {
+        topology.cpus_.push_back(cpus);
+        topology.physical_nodes_.push_back(node);
+      }
+    }
+    if (topology.cpus_.empty()) {
+      topology.cpus_.push_back(AllCpus());
+      topology.physical_nodes_.push_back(0);
+    }
+    return topology;
+  }
+
+  // Splits the CPUs of the machine into num_nodes nodes (nodes share CPUs if
+  // there are fewer CPUs than nodes); the memory of each is a real node, taken
+  // round-robin.
+  static NumaTopology Simulated(const int num_nodes) {
+    const NumaTopology real = Detect();
+    std::vector<int> cpus;
+    for (const std::vector<int>& node_cpus : real.cpus_) {
+      cpus.insert(cpus.end(), node_cpus.begin(), node_cpus.end());
+    }
+    NumaTopology topology;
+    topology.simulated_ = true;
+    const std::size_t nodes = num_nodes < 1 ? 1 : num_nodes;
+    for (std::size_t node = 0; node < nodes; ++node) {
+      if (cpus.size() >= nodes) {
+        topology.cpus_.push_back(std::vector<int>(
+            cpus.begin() + cpus.size() * node / nodes,
+            cpus.begin() + cpus.size() * (node + 1) / nodes));
+      } else {
+        topology.cpus_.push_back(
+            std::vector<int>(1, cpus[node % cpus.size()]));
+      }
+      topology.physical_nodes_.push_back(
+          real.physical_nodes_[node % real.physical_nodes_.size()]);
+    }
+    return topology;
+  }
+
+  int num_nodes() const { return static_cast<int>(cpus_.size()); }
+  const std::vector<int>& cpus(const int node) const { return cpus_[node]; }
+  // The node of the system that holds the memory of node.
+  int physical_node(const int node) const { return physical_nodes_[node]; }
+  bool simulated() const { return simulated_; }
+
+  // The node of the thread-th of num_threads threads: consecutive threads
+  // share a node, so consecutive parts of a range stay on one node.
+  int NodeOfThread(const int thread, const int num_threads) const {
+    return static_cast<int>(static_cast<long long>(thread) * num_nodes() /
+                            num_threads);
+  }
+
+ private:
+  NumaTopology() : simulated_(false) {}
+
+  static std::vector<int> AllCpus() {
+    std::vector<int> cpus;
+    const unsigned num_cpus = std::thread::hardware_concurrency();
+    for (unsigned cpu = 0; cpu < (num_cpus > 0 ? num_cpus : 1); ++cpu) {
+      cpus.push_back(static_cast<int>(cpu));
+    }
+    return cpus;
+  }
+
+  std::vector<std::vector<int> > cpus_;
+  std::vector<int> physical_nodes_;
+  bool simulated_;
+};
+
+enum class NumaPolicy {
+  // Each page goes to the node of the thread that touches it first.
+  kFirstTouch,
+  // Pages round-robin over all the nodes.
+  kInterleave,
+  // Every page on one node.
+  kBind
+};
+
+struct NumaPlacement {
+  NumaPlacement() : policy(NumaPolicy::kFirstTouch), node(0) {}
+  NumaPlacement(const NumaPolicy policy, const int node = 0)
+      : policy(policy), node(node) {}
+
+  NumaPolicy policy;
+  // The node of kBind (a node of the topology).
+  int node;
+};
+
+inline bool operator==(const NumaPlacement& lhs, const NumaPlacement& rhs) {
+  return lhs.policy == rhs.policy && lhs.node == rhs.node;
+}
+
+// Applies placement to the whole pages in [memory, memory + bytes). Returns
+// false if the system does not support it (the memory keeps its policy).
+inline bool ApplyNumaPlacement(void* memory, const std::size_t bytes,
+                               const NumaTopology& topology,
+                               const NumaPlacement& placement) {
+  if (placement.policy == NumaPolicy::kFirstTouch) {
+    return true;
+  }
+#if defined(__linux__) && defined(SYS_mbind)
+  const int kMaxNodes = 1024;
+  const int kBitsPerWord = 8 * sizeof(unsigned long);
+  unsigned long mask[kMaxNodes / kBitsPerWord] = {0};
+  for (int node = 0; node < topology.num_nodes(); ++node) {
+    if (placement.policy == NumaPolicy::kInterleave ||
+        node == placement.node) {
+      const int physical = topology.physical_node(node);
+      mask[physical / kBitsPerWord] |= 1ul << (physical % kBitsPerWord);
+    }
+  }
+  const int mode = placement.policy == NumaPolicy::kInterleave
+                       ? internal::kMpolInterleave
+                       : internal::kMpolBind;
+  return syscall(SYS_mbind, memory, bytes, mode, mask, kMaxNodes + 1, 0) == 0;
+#else
+  return false;
+#endif
+}
+
+// Allocates bytes (rounded up to whole pages) with the given placement. The
+// pages are not touched. If applied is not null, it tells whether the
+// placement policy took effect.
+inline void* NumaAllocate(const std::size_t bytes, const NumaTopology& topology,
+                          const NumaPlacement& placement,
+                          bool* applied = nullptr) {
+  void* memory = mmap(nullptr, bytes == 0 ? 1 : bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  const bool ok = ApplyNumaPlacement(memory, bytes, topology, placement);
+  if (applied != nullptr) {
+    *applied = ok;
+  }
+  return memory;
+}
+
+inline void NumaFree(void* memory, const std::size_t bytes) {
+  munmap(memory, bytes == 0 ? 1 : bytes);
+}
+
+// Returns the node of the system that holds the page of address, or -1 if the
+// page is not in memory yet or the system cannot tell.
+inline int NodeOfAddress(const void* address) {
+#if defined(__linux__) && defined(SYS_move_pages)
+  void* page = reinterpret_cast<void*>(
+      reinterpret_cast<uintptr_t>(address) & ~(internal::NumaPageSize() - 1));
+  int status = -1;
+  // With no target nodes, move_pages only reports where the pages are.
+  if (syscall(SYS_move_pages, 0, 1ul, &page, nullptr, &status, 0) != 0) {
+    return -1;
+  }
+  // A negative status is an errno value, e.g., -ENOENT for a page that is not
+  // in memory.
+  return status < 0 ? -1 : status;
+#else
+  return -1;
+#endif
+}
+
+// Splits [0, size) into num_threads parts and calls function(thread, begin,
+// end) for each on its own thread, pinned to the CPUs of
+// topology.NodeOfThread(thread, num_threads). The parts are the same for the
+// same size and num_threads.
+template <typename Function>
+void RunOnNodes(const NumaTopology& topology, const int num_threads,
+                const std::size_t size, const Function& function) {
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < num_threads; ++thread) {
+    threads.push_back(std::thread([&topology, &function, thread, num_threads,
+                                   size]() {
+#if defined(__linux__)
+      const int node = topology.NodeOfThread(thread, num_threads);
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      for (const int cpu : topology.cpus(node)) {
+        CPU_SET(cpu, &cpus);
+      }
+      // Not fatal: e.g., a container may not allow some CPUs.
+      sched_setaffinity(0, sizeof(cpus), &cpus);
+#endif
+      function(thread, size * thread / num_threads,
+               size * (thread + 1) / num_threads);
+    }));
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+// Sets data[0, size) to value from threads pinned to the nodes, so that with
+// kFirstTouch every part is placed on the node of the thread that fills it.
+template <typename T>
+void ParallelFill(const NumaTopology& topology, const int num_threads,
+                  T* data, const std::size_t size, const T& value) {
+  RunOnNodes(topology, num_threads, size,
+             [data, &value](const int, const std::size_t begin,
+                            const std::size_t end) {
+               for (std::size_t i = begin; i < end; ++i) {
+                 data[i] = value;
+               }
+             });
+}
+
+// An STL allocator that takes memory from NumaAllocate. Every allocation is
+// at least a page, so it is meant for large containers such as vectors of
+// millions of elements. Elements of trivial types are not initialized by
+// construct() without arguments (e.g., in resize), to leave their first touch
+// to ParallelFill.
+template <typename T>
+class NumaAllocator {
+ public:
+  typedef T value_type;
+
+  NumaAllocator(const NumaTopology& topology, const NumaPlacement& placement)
+      : topology_(&topology), placement_(placement) {}
+  template <typename U>
+  NumaAllocator(const NumaAllocator<U>& other)
+      : topology_(&other.topology()), placement_(other.placement()) {}
+
+  T* allocate(const std::size_t n) {
+    return static_cast<T*>(
+        NumaAllocate(n * sizeof(T), *topology_, placement_));
+  }
+  void deallocate(T* p, const std::size_t n) { NumaFree(p, n * sizeof(T)); }
+
+  template <typename U>
+  void construct(U* p) {
+    if (std::is_trivially_default_constructible<U>::value) {
+      ::new (static_cast<void*>(p)) U;
+    } else {
+      ::new (static_cast<void*>(p)) U();
+    }
+  }
+  template <typename U, typename... Args>
+  void construct(U* p, Args&&... args) {
+    ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+  }
+
+  const NumaTopology& topology() const { return *topology_; }
+  const NumaPlacement& placement() const { return placement_; }
+
+ private:
+  const NumaTopology* topology_;
+  NumaPlacement placement_;
+};
+
+template <typename T, typename U>
+bool operator==(const NumaAllocator<T>& lhs, const NumaAllocator<U>& rhs) {
+  return &lhs.topology() == &rhs.topology() &&
+         lhs.placement() == rhs.placement();
+}
+
+template <typename T, typename U>
+bool operator!=(const NumaAllocator<T>& lhs, const NumaAllocator<U>& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_NUMA_ALLOCATOR_H_
@@ -0,0 +1,236 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary measures the scan and lookup bandwidth of a large array by
+// NUMA placement policy (see numa_allocator.h).
+//
+// Usage: numa_benchmark [megabytes] [num_threads] [simulated_nodes]
+//   Defaults: megabytes = 1024, num_threads = the number of CPUs,
+//   simulated_nodes = 2 on a single-node machine, 0 (the real nodes)
+//   otherwise.
+//
+// The array is initialized and then read by num_threads threads pinned to
+// the nodes (consecutive threads on the same node), and the placements are:
+//
+// 1. new + serial fill: a std::vector filled by the main thread, as in
+// heap_memory_example.cc; every page lands on the node of the main thread.
+// 2. first touch: NumaAllocator (kFirstTouch) and ParallelFill, so each part
+// is on the node of the thread that fills (and later scans) it.
+// 3. interleave: pages round-robin over the nodes.
+// 4. bind node 0: every page on the first node.
+//
+// For each one it reports:
+//
+// 1. fill: the time to initialize the array (and fault its pages in).
+// 2. local scan: every thread sums its own part.
+// 3. remote scan: every thread sums the part of a thread half-way across the
+// list, i.e., a part on another node when pages were placed by first touch.
+// 4. lookups: every thread reads kLookupsPerThread random elements.
+// 5. pages per node: where a sample of the pages actually are (move_pages).
+//
+// Notes:
+//
+// 1. In simulation mode the "nodes" are groups of CPUs of one real node, so
+// all the memory is local and the bandwidth does not depend on the policy;
+// the run checks the placement code paths and the pinning. On a machine with
+// several nodes, the remote scans of first touch and all scans of the serial
+// fill run at about half the bandwidth of the local ones.
+// 2. "mbind" says whether the kernel accepted the placement policy (it may
+// not in a container); without it every policy behaves as first touch.
+
+#include <cstdint>  // Header for uint64_t.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <map>  // Header for std::map.
+#include <sstream>  // Header for std::ostringstream.
+#include <string>  // Header for std::string.
+#include <thread>  // Header for std::thread::hardware_concurrency.
+#include <vector>  // Header for std::vector.
+
+#include "benchmark_utils.h"
+#include "numa_allocator.h"
+
+namespace {
+
+const std::size_t kLookupsPerThread = 1 << 22;
+const std::size_t kNumSampledPages = 256;
+
+typedef std::vector<uint64_t, cpp_labs::NumaAllocator<uint64_t> > NumaVector;
+
+// Sums, on every thread, the part of thread (thread + shift) % num_threads,
+// and returns the bandwidth in GB/s.
+double Scan(const cpp_labs::NumaTopology& topology, const int num_threads,
+            const uint64_t* data, const std::size_t size, const int shift) {
+  std::vector<uint64_t> sums(num_threads);
+  cpp_labs::Timer timer;
+  cpp_labs::RunOnNodes(
+      topology, num_threads, size,
+      [&](const int thread, const std::size_t, const std::size_t) {
+        const int part = (thread + shift) % num_threads;
+        uint64_t sum = 0;
+        for (std::size_t i = size * part / num_threads;
+             i < size * (part + 1) / num_threads; ++i) {
+          sum += data[i];
+        }
+        sums[thread] = sum;
+      });
+  const double seconds = timer.ElapsedSeconds();
+  cpp_labs::DoNotOptimize(sums);
+  return size * sizeof(uint64_t) / seconds / 1e9;
+}
+
+// Random reads over the whole array; returns millions of lookups per second.
+double Lookups(const cpp_labs::NumaTopology& topology, const int num_threads,
+               const uint64_t* data, const std::size_t size) {
+  std::vector<uint64_t> sums(num_threads);
+  cpp_labs::Timer timer;
+  cpp_labs::RunOnNodes(
+      topology, num_threads, size,
+      [&](const int thread, const std::size_t, const std::size_t) {
+        uint64_t state = 0x9E3779B97F4A7C15ull * (thread + 1);
+        uint64_t sum = 0;
+        for (std::size_t i = 0; i < kLookupsPerThread; ++i) {
+          // xorshift64, then a multiply to map it to [0, size).
+          state ^= state << 13;
+          state ^= state >> 7;
+          state ^= state << 17;
+          sum += data[static_cast<std::size_t>(
+              (static_cast<unsigned __int128>(state) * size) >> 64)];
+        }
+        sums[thread] = sum;
+      });
+  const double seconds = timer.ElapsedSeconds();
+  cpp_labs::DoNotOptimize(sums);
+  return num_threads * kLookupsPerThread / seconds / 1e6;
+}
+
+// Where a sample of the pages are, e.g., "0:128 1:128".
+std::string PagesPerNode(const uint64_t* data, const std::size_t size) {
+  std::map<int, int> pages;
+  for (std::size_t i = 0; i < kNumSampledPages; ++i) {
+    ++pages[cpp_labs::NodeOfAddress(data + size * i / kNumSampledPages)];
+  }
+  std::ostringstream text;
+  for (const std::pair<const int, int>& node_pages : pages) {
+    text << (node_pages.first < 0 ? std::string("?")
+                                  : std::to_string(node_pages.first))
+         << ":" << node_pages.second << " ";
+  }
+  return text.str();
+}
+
+void Measure(const std::string& name, const std::string& mbind,
+             const cpp_labs::NumaTopology& topology, const int num_threads,
+             const uint64_t* data, const std::size_t size,
+             const double fill_seconds) {
+  std::cout << std::setw(22) << name << std::setw(7) << mbind << std::setw(10)
+            << fill_seconds * 1e3 << std::setw(12)
+            << Scan(topology, num_threads, data, size, 0) << std::setw(12)
+            << Scan(topology, num_threads, data, size, num_threads / 2)
+            << std::setw(12) << Lookups(topology, num_threads, data, size)
+            << "   " << PagesPerNode(data, size) << std::endl;
+}
+
+// Allocates the array with placement, fills it in parallel and measures it.
+void MeasurePlacement(const std::string& name,
+                      const cpp_labs::NumaTopology& topology,
+                      const int num_threads, const std::size_t size,
+                      const cpp_labs::NumaPlacement& placement) {
+  const cpp_labs::NumaAllocator<uint64_t> allocator(topology, placement);
+  NumaVector values(allocator);
+  // Does not touch the memory (NumaAllocator leaves uint64_t uninitialized).
+  values.resize(size);
+  // The allocator has applied the policy already; applying it again tells
+  // whether the kernel accepts it.
+  const bool applied = cpp_labs::ApplyNumaPlacement(
+      values.data(), size * sizeof(uint64_t), topology, placement);
+  cpp_labs::Timer timer;
+  cpp_labs::ParallelFill(topology, num_threads, values.data(), size,
+                         uint64_t(1));
+  const double fill_seconds = timer.ElapsedSeconds();
+  Measure(name,
+          placement.policy == cpp_labs::NumaPolicy::kFirstTouch
+              ? "-"
+              : (applied ? "yes" : "no"),
+          topology, num_threads, values.data(), size, fill_seconds);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t megabytes =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, 1024);
+  const unsigned num_cpus = std::thread::hardware_concurrency();
+  const int num_threads = static_cast<int>(
+      cpp_labs::ParseSizeArgument(argc, argv, 2, num_cpus > 0 ? num_cpus : 1));
+  const cpp_labs::NumaTopology real_topology = cpp_labs::NumaTopology::Detect();
+  const int simulated_nodes = static_cast<int>(cpp_labs::ParseSizeArgument(
+      argc, argv, 3, real_topology.num_nodes() == 1 ? 2 : 0));
+  if (megabytes == 0 || num_threads <= 0) {
+    std::cerr << "megabytes and num_threads must be positive." << std::endl;
+    return 1;
+  }
+  const cpp_labs::NumaTopology topology =
+      simulated_nodes > 0 ? cpp_labs::NumaTopology::Simulated(simulated_nodes)
+                          : real_topology;
+  const std::size_t size = (megabytes << 20) / sizeof(uint64_t);
+
+  std::cout << megabytes << " MB, " << num_threads << " threads, "
+            << topology.num_nodes() << " nodes"
+            << (topology.simulated() ? " (simulated)" : "") << "\n";
+  for (int node = 0; node < topology.num_nodes(); ++node) {
+    std::cout << "  node " << node << ": " << topology.cpus(node).size()
+              << " CPUs, memory on node " << topology.physical_node(node)
+              << "\n";
+  }
+  std::cout << std::setw(22) << "placement" << std::setw(7) << "mbind"
+            << std::setw(10) << "fill ms" << std::setw(12) << "local GB/s"
+            << std::setw(12) << "remote GB/s" << std::setw(12) << "M lookups/s"
+            << "   pages per node" << std::endl;
+
+  {
+    cpp_labs::Timer timer;
+    const std::vector<uint64_t> values(size, 1);
+    const double fill_seconds = timer.ElapsedSeconds();
+    Measure("new + serial fill", "-", topology, num_threads, values.data(),
+            size, fill_seconds);
+  }
+  MeasurePlacement("first touch", topology, num_threads, size,
+                   cpp_labs::NumaPlacement(cpp_labs::NumaPolicy::kFirstTouch));
+  MeasurePlacement("interleave", topology, num_threads, size,
+                   cpp_labs::NumaPlacement(cpp_labs::NumaPolicy::kInterleave));
+  MeasurePlacement("bind node 0", topology, num_threads, size,
+                   cpp_labs::NumaPlacement(cpp_labs::NumaPolicy::kBind, 0));
+  return 0;
+}
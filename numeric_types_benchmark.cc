@@ -0,0 +1,278 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary compares the memory footprint, precision and throughput of
+// float columns against the compact types of fixed_point.h and half_float.h.
+//
+// Usage: numeric_types_benchmark [num_elements]
+//   Defaults: num_elements = 100000000.
+//
+// For each type the benchmark stores two columns a and b of num_elements
+// values uniformly distributed in [-50, 50), and measures:
+//
+// 1. sum: the sum of column a (read num_elements values),
+// 2. add: c[i] = AddNumbers(a[i], b[i]) with the generic helper of
+// constexpr_utils.h (read two columns, write one),
+// 3. for the 16-bit float types, also add by blocks: convert kBlockSize values
+// of a and b to float with ConvertToFloat, add, and convert back with
+// ConvertFromFloat.
+//
+// Notes:
+//
+// 1. Large columns do not fit in the caches, so a loop that does little work
+// per element is bound by the memory bandwidth; halving the bytes per element
+// can then nearly halve the time, if the conversions are cheap enough (SIMD).
+// Build with -DBUILD_WITH_NATIVE_ARCH=ON for the F16C/AVX-512 conversions.
+// 2. Sums of float use kLanes independent accumulators (and so do the sums of
+// 16-bit floats, after conversion); sums of Fixed add the integers exactly.
+// 3. "max error" is the largest difference between a stored value and the
+// original float.
+
+#include <algorithm>  // Header for std::max.
+#include <cmath>  // Header for std::fabs.
+#include <cstdint>  // Header for int64_t.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <random>  // Header for std::mt19937.
+#include <string>  // Header for std::string.
+#include <vector>  // Header for std::vector.
+
+#include "benchmark_utils.h"
+#include "constexpr_utils.h"
+#include "fixed_point.h"
+#include "half_float.h"
+
+namespace {
+
+const std::size_t kLanes = 16;
+const std::size_t kBlockSize = 1024;
+
+typedef cpp_labs::Fixed<8, 8> Fixed8x8;
+typedef cpp_labs::Fixed<16, 16> Fixed16x16;
+
+// Conversions between float and every type.
+template <typename T>
+T FromFloat(const float value) {
+  return T(value);
+}
+
+float ToFloat(const float value) { return value; }
+float ToFloat(const cpp_labs::Float16 value) { return value.ToFloat(); }
+float ToFloat(const cpp_labs::BFloat16 value) { return value.ToFloat(); }
+template <int IntBits, int FracBits>
+float ToFloat(const cpp_labs::Fixed<IntBits, FracBits> value) {
+  return value.ToFloat();
+}
+
+double SumFloats(const float* values, const std::size_t size) {
+  float lanes[kLanes] = {0.0f};
+  std::size_t i = 0;
+  for (; i + kLanes <= size; i += kLanes) {
+    for (std::size_t lane = 0; lane < kLanes; ++lane) {
+      lanes[lane] += values[i + lane];
+    }
+  }
+  double sum = 0.0;
+  for (; i < size; ++i) {
+    sum += values[i];
+  }
+  for (std::size_t lane = 0; lane < kLanes; ++lane) {
+    sum += lanes[lane];
+  }
+  return sum;
+}
+
+// Sums a column; each type uses its fastest exact or vectorizable way.
+double Sum(const std::vector<float>& column) {
+  return SumFloats(column.data(), column.size());
+}
+
+template <typename Half>
+double SumHalfColumn(const std::vector<Half>& column) {
+  float block[kBlockSize];
+  double sum = 0.0;
+  for (std::size_t first = 0; first < column.size(); first += kBlockSize) {
+    const std::size_t size = column.size() - first < kBlockSize
+                                 ? column.size() - first
+                                 : kBlockSize;
+    cpp_labs::ConvertToFloat(column.data() + first, size, block);
+    sum += SumFloats(block, size);
+  }
+  return sum;
+}
+
+double Sum(const std::vector<cpp_labs::Float16>& column) {
+  return SumHalfColumn(column);
+}
+
+double Sum(const std::vector<cpp_labs::BFloat16>& column) {
+  return SumHalfColumn(column);
+}
+
+template <int IntBits, int FracBits>
+double Sum(const std::vector<cpp_labs::Fixed<IntBits, FracBits> >& column) {
+  int64_t sum = 0;
+  for (const cpp_labs::Fixed<IntBits, FracBits> value : column) {
+    sum += value.raw();
+  }
+  return sum * cpp_labs::Fixed<IntBits, FracBits>::Resolution();
+}
+
+template <typename T>
+void AddColumns(const std::vector<T>& a, const std::vector<T>& b,
+                std::vector<T>* c) {
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    (*c)[i] = cpp_labs::AddNumbers(a[i], b[i]);
+  }
+}
+
+template <typename Half>
+void AddColumnsByBlocks(const std::vector<Half>& a, const std::vector<Half>& b,
+                        std::vector<Half>* c) {
+  float block_a[kBlockSize];
+  float block_b[kBlockSize];
+  for (std::size_t first = 0; first < a.size(); first += kBlockSize) {
+    const std::size_t size =
+        a.size() - first < kBlockSize ? a.size() - first : kBlockSize;
+    cpp_labs::ConvertToFloat(a.data() + first, size, block_a);
+    cpp_labs::ConvertToFloat(b.data() + first, size, block_b);
+    for (std::size_t i = 0; i < size; ++i) {
+      block_a[i] += block_b[i];
+    }
+    cpp_labs::ConvertFromFloat(block_a, size, c->data() + first);
+  }
+}
+
+void PrintRow(const std::string& name, const std::string& operation,
+              const std::size_t bytes_per_element, const double megabytes,
+              const double max_error, const double seconds,
+              const double bytes_moved, const std::size_t num_elements) {
+  std::cout << std::setw(14) << name << std::setw(10) << operation
+            << std::setw(8) << bytes_per_element << std::setw(10)
+            << megabytes << std::setw(14) << max_error << std::setw(10)
+            << seconds * 1e3 << std::setw(10) << bytes_moved / seconds / 1e9
+            << std::setw(12) << num_elements / seconds / 1e9 << std::endl;
+}
+
+// Converts the float data to columns of type T, and returns the largest
+// difference between a stored value and its float.
+template <typename T>
+double BuildColumns(const std::vector<float>& x, const std::vector<float>& y,
+                    std::vector<T>* a, std::vector<T>* b) {
+  double max_error = 0.0;
+  for (std::size_t i = 0; i < x.size(); ++i) {
+    (*a)[i] = FromFloat<T>(x[i]);
+    (*b)[i] = FromFloat<T>(y[i]);
+    max_error = std::max(
+        max_error, static_cast<double>(std::fabs(ToFloat((*a)[i]) - x[i])));
+  }
+  return max_error;
+}
+
+// Builds the columns of type T from the float data and measures them.
+template <typename T>
+void Measure(const std::string& name, const std::vector<float>& x,
+             const std::vector<float>& y) {
+  const std::size_t n = x.size();
+  std::vector<T> a(n);
+  std::vector<T> b(n);
+  std::vector<T> c(n);
+  const double max_error = BuildColumns(x, y, &a, &b);
+  const double megabytes = n * sizeof(T) / 1e6;
+
+  cpp_labs::Timer timer;
+  const double sum = Sum(a);
+  double seconds = timer.ElapsedSeconds();
+  cpp_labs::DoNotOptimize(sum);
+  PrintRow(name, "sum", sizeof(T), megabytes, max_error, seconds,
+           n * sizeof(T), n);
+
+  timer.Reset();
+  AddColumns(a, b, &c);
+  cpp_labs::ClobberMemory();
+  seconds = timer.ElapsedSeconds();
+  PrintRow(name, "add", sizeof(T), megabytes, max_error, seconds,
+           3.0 * n * sizeof(T), n);
+}
+
+template <typename Half>
+void MeasureBlocks(const std::string& name, const std::vector<float>& x,
+                   const std::vector<float>& y) {
+  const std::size_t n = x.size();
+  std::vector<Half> a(n);
+  std::vector<Half> b(n);
+  std::vector<Half> c(n);
+  const double max_error = BuildColumns(x, y, &a, &b);
+  cpp_labs::Timer timer;
+  AddColumnsByBlocks(a, b, &c);
+  cpp_labs::ClobberMemory();
+  const double seconds = timer.ElapsedSeconds();
+  PrintRow(name, "add/block", sizeof(Half), n * sizeof(Half) / 1e6,
+           max_error, seconds, 3.0 * n * sizeof(Half), n);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t num_elements =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, 100000000);
+  if (num_elements == 0) {
+    std::cerr << "num_elements must be positive." << std::endl;
+    return 1;
+  }
+
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> distribution(-50.0f, 50.0f);
+  std::vector<float> x(num_elements);
+  std::vector<float> y(num_elements);
+  for (std::size_t i = 0; i < num_elements; ++i) {
+    x[i] = distribution(rng);
+    y[i] = distribution(rng);
+  }
+
+  std::cout << num_elements << " elements per column\n"
+            << std::setw(14) << "type" << std::setw(10) << "operation"
+            << std::setw(8) << "B/elem" << std::setw(10) << "MB/column"
+            << std::setw(14) << "max error" << std::setw(10) << "ms"
+            << std::setw(10) << "GB/s" << std::setw(12) << "G elem/s"
+            << std::endl;
+  Measure<float>("float", x, y);
+  Measure<Fixed16x16>("Fixed<16,16>", x, y);
+  Measure<Fixed8x8>("Fixed<8,8>", x, y);
+  Measure<cpp_labs::Float16>("Float16", x, y);
+  MeasureBlocks<cpp_labs::Float16>("Float16", x, y);
+  Measure<cpp_labs::BFloat16>("BFloat16", x, y);
+  MeasureBlocks<cpp_labs::BFloat16>("BFloat16", x, y);
+  return 0;
+}
@@ -0,0 +1,504 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_PARALLEL_BULK_LOAD_H_
+#define CPP_LABS_PARALLEL_BULK_LOAD_H_
+
+// Bulk loading of sets from unsorted records with several threads.
+//
+// set_example.cc builds a std::set by inserting one element at a time: every
+// insertion searches the tree from the root (a chain of cache misses) and
+// allocates a node, and it cannot use more than one thread. When all the
+// records are available up front, it is much faster to sort them, remove the
+// duplicates, and build a read-only structure from the sorted array:
+//
+// 1. ParallelRadixSort sorts integers: every pass counts the digits of each
+// thread's part of the input, and then each thread scatters its part to the
+// positions that the counts give it. Passes in which all the values share a
+// digit are skipped.
+// 2. ParallelMergeSort sorts anything with operator< (e.g., strings): every
+// thread sorts a part with std::sort, and the sorted runs are merged pairwise;
+// each merge is split into independent pieces with a binary search, so all the
+// threads work until the last merge.
+// 3. ParallelUnique removes the duplicates of a sorted vector: every thread
+// marks the first element of each group of equal ones in its part, and then
+// copies them to their final positions.
+// 4. SortedArraySet (binary search) and StaticBTree (a B+-tree packed in one
+// array per level) are built from the sorted, unique values. IntegerHashSet
+// is built directly from the unsorted values, with the threads inserting into
+// the same table with compare-and-swap.
+//
+// All the functions take the number of threads to use, including the calling
+// one; 1 runs everything on the calling thread.
+
+#include <algorithm>  // Header for std::sort and std::merge.
+#include <atomic>  // Header for std::atomic.
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for uint64_t.
+#include <functional>  // Header for std::less.
+#include <iterator>  // Header for std::make_move_iterator.
+#include <limits>  // Header for std::numeric_limits.
+#include <memory>  // Header for std::unique_ptr.
+#include <thread>  // Header for std::thread.
+#include <type_traits>  // Header for std::make_unsigned.
+#include <utility>  // Header for std::move.
+#include <vector>  // Header for std::vector.
+
+namespace cpp_labs {
+namespace internal {
+
+// Splits [0, size) into num_parts contiguous ranges and calls
+// function(part, begin, end) for each of them, each one on its own thread
+// (part 0 on the calling thread). The split only depends on size and
+// num_parts, so two calls with the same arguments see the same ranges.
+template <typename Function>
+void ParallelForRanges(const int num_parts, const std::size_t size,
+                       const Function& function) {
+  std::vector<std::thread> threads;
+  for (int part = 1; part < num_parts; ++part) {
+    threads.push_back(std::thread([&function, part, num_parts, size]() {
+      function(part, size * part / num_parts, size * (part + 1) / num_parts);
+    }));
+  }
+  function(0, 0, size / num_parts);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+// Number of parts for size elements: one per thread, but no part smaller than
+// kMinPartSize elements (starting a thread costs tens of microseconds).
+inline int NumParts(const int num_threads, const std::size_t size) {
+  const std::size_t kMinPartSize = 1 << 14;
+  const std::size_t max_parts = size / kMinPartSize + 1;
+  return num_threads < 1 ? 1
+         : static_cast<std::size_t>(num_threads) < max_parts
+             ? num_threads
+             : static_cast<int>(max_parts);
+}
+
+}  // namespace internal
+
+// Sorts a vector of integers (LSD radix sort, one byte per pass).
+template <typename T>
+void ParallelRadixSort(std::vector<T>* values, const int num_threads) {
+  static_assert(std::is_integral<T>::value, "Radix sort needs integers.");
+  typedef typename std::make_unsigned<T>::type Key;
+  // Flipping the sign bit orders signed values as unsigned ones.
+  const Key kSignFlip = std::is_signed<T>::value
+                            ? static_cast<Key>(Key(1) << (8 * sizeof(T) - 1))
+                            : Key(0);
+  const std::size_t kNumBuckets = 256;
+
+  const std::size_t size = values->size();
+  if (size < 2) {
+    return;
+  }
+  const int num_parts = internal::NumParts(num_threads, size);
+  std::vector<T> buffer(size);
+  T* source = values->data();
+  T* target = buffer.data();
+  // counts[part * kNumBuckets + digit], then the positions to write to.
+  std::vector<std::size_t> counts(num_parts * kNumBuckets);
+
+  for (std::size_t shift = 0; shift < 8 * sizeof(T); shift += 8) {
+    const auto digit = [kSignFlip, shift](const T value) {
+      return ((static_cast<Key>(value) ^ kSignFlip) >> shift) & 0xFF;
+    };
+    internal::ParallelForRanges(
+        num_parts, size,
+        [&](const int part, const std::size_t begin, const std::size_t end) {
+          std::size_t* part_counts = counts.data() + part * kNumBuckets;
+          std::fill(part_counts, part_counts + kNumBuckets, 0);
+          for (std::size_t i = begin; i < end; ++i) {
+            ++part_counts[digit(source[i])];
+          }
+        });
+
+    // Skip the pass if every value has the same digit.
+    const std::size_t first_digit = digit(source[0]);
+    std::size_t first_digit_count = 0;
+    for (int part = 0; part < num_parts; ++part) {
+      first_digit_count += counts[part * kNumBuckets + first_digit];
+    }
+    if (first_digit_count == size) {
+      continue;
+    }
+
+    // The values of each digit go in part order, which keeps the sort stable.
+    std::size_t position = 0;
+    for (std::size_t bucket = 0; bucket < kNumBuckets; ++bucket) {
+      for (int part = 0; part < num_parts; ++part) {
+        const std::size_t count = counts[part * kNumBuckets + bucket];
+        counts[part * kNumBuckets + bucket] = position;
+        position += count;
+      }
+    }
+
+    internal::ParallelForRanges(
+        num_parts, size,
+        [&](const int part, const std::size_t begin, const std::size_t end) {
+          std::size_t* positions = counts.data() + part * kNumBuckets;
+          for (std::size_t i = begin; i < end; ++i) {
+            target[positions[digit(source[i])]++] = source[i];
+          }
+        });
+    std::swap(source, target);
+  }
+  if (source != values->data()) {
+    values->swap(buffer);
+  }
+}
+
+// Sorts a vector with less (a merge sort of per-thread std::sort runs).
+template <typename T, typename Less = std::less<T> >
+void ParallelMergeSort(std::vector<T>* values, const int num_threads,
+                       const Less& less = Less()) {
+  const std::size_t size = values->size();
+  const int num_parts = internal::NumParts(num_threads, size);
+  // runs[i] is the beginning of the i-th sorted run; the last entry is size.
+  std::vector<std::size_t> runs;
+  for (int part = 0; part <= num_parts; ++part) {
+    runs.push_back(size * part / num_parts);
+  }
+  internal::ParallelForRanges(
+      num_parts, size,
+      [&](const int, const std::size_t begin, const std::size_t end) {
+        std::sort(values->begin() + begin, values->begin() + end, less);
+      });
+  if (num_parts == 1) {
+    return;
+  }
+
+  // A piece of a merge: source[a_begin, a_end) and source[b_begin, b_end)
+  // go to target starting at output.
+  struct MergePiece {
+    std::size_t a_begin, a_end, b_begin, b_end, output;
+  };
+  std::vector<T> buffer(size);
+  T* source = values->data();
+  T* target = buffer.data();
+  while (runs.size() > 2) {
+    const std::size_t num_runs = runs.size() - 1;
+    const std::size_t num_merges = num_runs / 2;
+    const std::size_t pieces_per_merge =
+        num_threads > static_cast<int>(num_merges) ? num_threads / num_merges
+                                                   : 1;
+    std::vector<MergePiece> pieces;
+    std::vector<std::size_t> next_runs;
+    for (std::size_t run = 0; run + 1 < num_runs; run += 2) {
+      const std::size_t a_begin = runs[run];
+      const std::size_t b_begin = runs[run + 1];
+      const std::size_t b_end = runs[run + 2];
+      // Split run a evenly, and run b where each piece of a starts.
+      std::size_t previous_a = a_begin;
+      std::size_t previous_b = b_begin;
+      for (std::size_t piece = 1; piece <= pieces_per_merge; ++piece) {
+        const std::size_t a_split =
+            a_begin + (b_begin - a_begin) * piece / pieces_per_merge;
+        const std::size_t b_split =
+            piece == pieces_per_merge
+                ? b_end
+                : std::lower_bound(source + b_begin, source + b_end,
+                                   source[a_split], less) -
+                      source;
+        const MergePiece merge_piece = {
+            previous_a, a_split, previous_b, b_split,
+            previous_a + (previous_b - b_begin)};
+        pieces.push_back(merge_piece);
+        previous_a = a_split;
+        previous_b = b_split;
+      }
+      next_runs.push_back(a_begin);
+    }
+    if (num_runs % 2 == 1) {
+      // The last run has no partner: move it as is.
+      const MergePiece merge_piece = {runs[num_runs - 1], runs[num_runs],
+                                      runs[num_runs], runs[num_runs],
+                                      runs[num_runs - 1]};
+      pieces.push_back(merge_piece);
+      next_runs.push_back(runs[num_runs - 1]);
+    }
+    next_runs.push_back(size);
+
+    const int num_merge_threads =
+        num_threads < static_cast<int>(pieces.size())
+            ? num_threads
+            : static_cast<int>(pieces.size());
+    internal::ParallelForRanges(
+        num_merge_threads, pieces.size(),
+        [&](const int, const std::size_t begin, const std::size_t end) {
+          for (std::size_t i = begin; i < end; ++i) {
+            const MergePiece& piece = pieces[i];
+            std::merge(std::make_move_iterator(source + piece.a_begin),
+                       std::make_move_iterator(source + piece.a_end),
+                       std::make_move_iterator(source + piece.b_begin),
+                       std::make_move_iterator(source + piece.b_end),
+                       target + piece.output, less);
+          }
+        });
+    std::swap(source, target);
+    runs.swap(next_runs);
+  }
+  if (source != values->data()) {
+    values->swap(buffer);
+  }
+}
+
+// Removes the consecutive duplicates of a sorted vector, like std::unique
+// followed by erase.
+template <typename T>
+void ParallelUnique(std::vector<T>* sorted_values, const int num_threads) {
+  std::vector<T>& values = *sorted_values;
+  const std::size_t size = values.size();
+  const int num_parts = internal::NumParts(num_threads, size);
+  // The flags are computed before anything moves, since the first element of
+  // a part is compared with the last element of the previous part.
+  std::vector<unsigned char> keep(size);
+  std::vector<std::size_t> offsets(num_parts + 1, 0);
+  internal::ParallelForRanges(
+      num_parts, size,
+      [&](const int part, const std::size_t begin, const std::size_t end) {
+        std::size_t count = 0;
+        for (std::size_t i = begin; i < end; ++i) {
+          keep[i] = i == 0 || !(values[i] == values[i - 1]);
+          count += keep[i];
+        }
+        offsets[part + 1] = count;
+      });
+  for (int part = 0; part < num_parts; ++part) {
+    offsets[part + 1] += offsets[part];
+  }
+  std::vector<T> unique_values(offsets[num_parts]);
+  internal::ParallelForRanges(
+      num_parts, size,
+      [&](const int part, const std::size_t begin, const std::size_t end) {
+        std::size_t output = offsets[part];
+        for (std::size_t i = begin; i < end; ++i) {
+          if (keep[i]) {
+            unique_values[output++] = std::move(values[i]);
+          }
+        }
+      });
+  values.swap(unique_values);
+}
+
+// A read-only set stored as a sorted array: half the memory of a hash table
+// and a fraction of a std::set, and lookups by binary search.
+template <typename T>
+class SortedArraySet {
+ public:
+  typedef typename std::vector<T>::const_iterator const_iterator;
+
+  SortedArraySet() {}
+  // sorted_values must be sorted and have no duplicates (e.g., the output of
+  // ParallelRadixSort or ParallelMergeSort followed by ParallelUnique).
+  explicit SortedArraySet(std::vector<T>&& sorted_values)
+      : values_(std::move(sorted_values)) {}
+
+  bool contains(const T& value) const {
+    const const_iterator it =
+        std::lower_bound(values_.begin(), values_.end(), value);
+    return it != values_.end() && !(value < *it);
+  }
+
+  std::size_t size() const { return values_.size(); }
+  const_iterator begin() const { return values_.begin(); }
+  const_iterator end() const { return values_.end(); }
+
+ private:
+  std::vector<T> values_;
+};
+
+// A read-only B+-tree whose nodes are NodeSize consecutive keys of an array.
+// The leaf level is the sorted values; each key of the level above is the
+// largest key of one node below, so a lookup scans one node per level (a
+// cache line or two) instead of jumping across the whole array like a binary
+// search.
+template <typename T, std::size_t NodeSize = 16>
+class StaticBTree {
+ public:
+  StaticBTree() {}
+  // sorted_values must be sorted and have no duplicates.
+  StaticBTree(std::vector<T>&& sorted_values, const int num_threads) {
+    levels_.push_back(std::move(sorted_values));
+    while (levels_.back().size() > NodeSize) {
+      const std::vector<T>& below = levels_.back();
+      std::vector<T> level((below.size() + NodeSize - 1) / NodeSize);
+      internal::ParallelForRanges(
+          internal::NumParts(num_threads, below.size()), level.size(),
+          [&](const int, const std::size_t begin, const std::size_t end) {
+            for (std::size_t node = begin; node < end; ++node) {
+              const std::size_t last = std::min((node + 1) * NodeSize,
+                                                below.size()) - 1;
+              level[node] = below[last];
+            }
+          });
+      levels_.push_back(std::move(level));
+    }
+  }
+
+  bool contains(const T& value) const {
+    if (levels_.empty() || levels_[0].empty()) {
+      return false;
+    }
+    std::size_t node = 0;
+    for (std::size_t level = levels_.size(); level-- > 0;) {
+      const std::vector<T>& keys = levels_[level];
+      const std::size_t begin = node * NodeSize;
+      const std::size_t end = std::min(begin + NodeSize, keys.size());
+      std::size_t i = begin;
+      while (i < end && keys[i] < value) {
+        ++i;
+      }
+      if (i == end) {
+        // Larger than every key (this only happens at the root).
+        return false;
+      }
+      node = i;
+    }
+    return !(value < levels_[0][node]);
+  }
+
+  std::size_t size() const { return levels_.empty() ? 0 : levels_[0].size(); }
+  std::size_t num_levels() const { return levels_.size(); }
+
+ private:
+  std::vector<std::vector<T> > levels_;
+};
+
+// A read-only hash set of integers with open addressing (linear probing) and
+// a load factor of at most 1/2, built by several threads at once: each thread
+// claims empty slots with compare-and-swap.
+template <typename T>
+class IntegerHashSet {
+ public:
+  static_assert(std::is_integral<T>::value, "IntegerHashSet needs integers.");
+
+  // values may be unsorted and contain duplicates.
+  IntegerHashSet(const std::vector<T>& values, const int num_threads)
+      : num_bits_(1), has_empty_key_(false), size_(0) {
+    while ((std::size_t(1) << num_bits_) < 2 * values.size()) {
+      ++num_bits_;
+    }
+    const std::size_t capacity = std::size_t(1) << num_bits_;
+    mask_ = capacity - 1;
+    slots_.reset(new std::atomic<T>[capacity]);
+    // Each thread first touches its own part of the table.
+    internal::ParallelForRanges(
+        internal::NumParts(num_threads, capacity), capacity,
+        [&](const int, const std::size_t begin, const std::size_t end) {
+          for (std::size_t i = begin; i < end; ++i) {
+            slots_[i].store(kEmpty, std::memory_order_relaxed);
+          }
+        });
+
+    std::atomic<std::size_t> size(0);
+    std::atomic<bool> has_empty_key(false);
+    internal::ParallelForRanges(
+        internal::NumParts(num_threads, values.size()), values.size(),
+        [&](const int, const std::size_t begin, const std::size_t end) {
+          std::size_t num_inserted = 0;
+          for (std::size_t i = begin; i < end; ++i) {
+            if (values[i] == kEmpty) {
+              has_empty_key.store(true, std::memory_order_relaxed);
+            } else {
+              num_inserted += Insert(values[i]) ? 1 : 0;
+            }
+          }
+          size.fetch_add(num_inserted, std::memory_order_relaxed);
+        });
+    has_empty_key_ = has_empty_key.load();
+    size_ = size.load() + (has_empty_key_ ? 1 : 0);
+  }
+
+  bool contains(const T value) const {
+    if (value == kEmpty) {
+      return has_empty_key_;
+    }
+    for (std::size_t slot = Hash(value);; slot = (slot + 1) & mask_) {
+      const T key = slots_[slot].load(std::memory_order_relaxed);
+      if (key == value) {
+        return true;
+      }
+      if (key == kEmpty) {
+        return false;
+      }
+    }
+  }
+
+  std::size_t size() const { return size_; }
+  std::size_t capacity() const { return mask_ + 1; }
+
+ private:
+  // Marks empty slots; the value itself is tracked by has_empty_key_.
+  static constexpr T kEmpty = std::numeric_limits<T>::max();
+
+  // Fibonacci hashing: the top bits of the product by 2^64 / golden ratio.
+  std::size_t Hash(const T value) const {
+    return static_cast<std::size_t>(
+        (static_cast<uint64_t>(value) * 0x9E3779B97F4A7C15ull) >>
+        (64 - num_bits_));
+  }
+
+  // Returns false if the value was already in the table.
+  bool Insert(const T value) {
+    for (std::size_t slot = Hash(value);; slot = (slot + 1) & mask_) {
+      T key = slots_[slot].load(std::memory_order_relaxed);
+      if (key == kEmpty &&
+          slots_[slot].compare_exchange_strong(key, value,
+                                               std::memory_order_relaxed)) {
+        return true;
+      }
+      // Either the slot was taken, or another thread just took it (and key
+      // now holds its value).
+      if (key == value) {
+        return false;
+      }
+    }
+  }
+
+  int num_bits_;
+  std::size_t mask_;
+  std::unique_ptr<std::atomic<T>[]> slots_;
+  bool has_empty_key_;
+  std::size_t size_;
+};
+
+template <typename T>
+constexpr T IntegerHashSet<T>::kEmpty;
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_PARALLEL_BULK_LOAD_H_
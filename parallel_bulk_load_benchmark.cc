@@ -0,0 +1,231 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary measures how long it takes to build a set from unsorted records,
+// inserting them one at a time into std::set (as set_example.cc does) or bulk
+// loading them with parallel_bulk_load.h on 1 to max_threads threads.
+//
+// Usage: parallel_bulk_load_benchmark [num_records] [max_threads]
+//   Defaults: num_records = 10000000, max_threads = the number of CPUs.
+//
+// The records are num_records random int64_t keys (about 63% of them
+// distinct) and num_records / 4 random user names. Every time includes the
+// whole build from the unsorted input:
+//
+// 1. integers: ParallelRadixSort, ParallelUnique, and then SortedArraySet or
+// StaticBTree; IntegerHashSet is built from the unsorted keys directly.
+// 2. strings: ParallelMergeSort and ParallelUnique, then SortedArraySet.
+//
+// Notes:
+//
+// 1. The thread counts are powers of two up to max_threads. Threads beyond the
+// number of CPUs only add overhead; with one CPU, the rows show the cost of
+// the parallel algorithms themselves.
+// 2. The std::set, std::unordered_set and std::sort baselines run on one
+// thread, as the standard containers cannot be built in parallel.
+// 3. At the end every set is checked against std::set: same size, and the same
+// answers for a sample of present and absent keys.
+
+#include <algorithm>  // Header for std::sort and std::unique.
+#include <cstdint>  // Header for int64_t.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <random>  // Header for std::mt19937_64.
+#include <set>  // Header for std::set.
+#include <string>  // Header for std::string.
+#include <thread>  // Header for std::thread::hardware_concurrency.
+#include <unordered_set>  // Header for std::unordered_set.
+#include <vector>  // Header for std::vector.
+
+#include "benchmark_utils.h"
+#include "parallel_bulk_load.h"
+
+namespace {
+
+const std::size_t kNumChecks = 100000;
+
+void PrintRow(const std::string& name, const int num_threads,
+              const double seconds, const std::size_t num_records) {
+  std::cout << std::setw(40) << name << std::setw(9) << num_threads
+            << std::setw(12) << seconds * 1e3 << std::setw(14)
+            << num_records / seconds / 1e6 << std::endl;
+}
+
+// Checks set against the reference set with keys that are (mostly) present
+// and keys that are (mostly) absent.
+template <typename Set, typename T>
+bool Check(const Set& set, const std::set<T>& reference,
+           const std::vector<T>& present, const std::vector<T>& absent) {
+  if (set.size() != reference.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < kNumChecks; ++i) {
+    const T& a = present[i % present.size()];
+    const T& b = absent[i % absent.size()];
+    if (set.contains(a) != (reference.count(a) == 1) ||
+        set.contains(b) != (reference.count(b) == 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void PrintCheck(const std::string& name, const bool ok) {
+  std::cout << std::setw(40) << name << (ok ? "  ok" : "  MISMATCH!")
+            << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t num_records =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, 10000000);
+  const unsigned num_cpus = std::thread::hardware_concurrency();
+  const int max_threads = static_cast<int>(
+      cpp_labs::ParseSizeArgument(argc, argv, 2, num_cpus > 0 ? num_cpus : 1));
+  if (num_records == 0 || max_threads <= 0) {
+    std::cerr << "num_records and max_threads must be positive." << std::endl;
+    return 1;
+  }
+
+  std::mt19937_64 rng(1234);
+  std::uniform_int_distribution<int64_t> key_distribution(
+      0, static_cast<int64_t>(num_records) - 1);
+  std::vector<int64_t> keys(num_records);
+  for (int64_t& key : keys) {
+    key = key_distribution(rng);
+  }
+  const std::size_t num_names = num_records / 4 + 1;
+  std::vector<std::string> names(num_names);
+  for (std::string& name : names) {
+    name = "user_" + std::to_string(rng() % (num_names * 2));
+  }
+  // Negative keys are never in the input; about half of these names are.
+  std::vector<int64_t> absent_keys(kNumChecks);
+  std::vector<std::string> absent_names(kNumChecks);
+  for (std::size_t i = 0; i < kNumChecks; ++i) {
+    absent_keys[i] = -key_distribution(rng) - 1;
+    absent_names[i] = "user_" + std::to_string(rng() % (num_names * 2));
+  }
+
+  std::cout << num_records << " integer records, " << num_names
+            << " string records\n"
+            << std::setw(40) << "build" << std::setw(9) << "threads"
+            << std::setw(12) << "ms" << std::setw(14) << "M records/s"
+            << std::endl;
+
+  // Baselines, one thread.
+  cpp_labs::Timer timer;
+  std::set<int64_t> key_set;
+  for (const int64_t key : keys) {
+    key_set.insert(key);
+  }
+  PrintRow("std::set insert, int64", 1, timer.ElapsedSeconds(), num_records);
+
+  timer.Reset();
+  std::unordered_set<int64_t> key_hash_set;
+  for (const int64_t key : keys) {
+    key_hash_set.insert(key);
+  }
+  PrintRow("std::unordered_set insert, int64", 1, timer.ElapsedSeconds(),
+           num_records);
+  cpp_labs::DoNotOptimize(key_hash_set.size());
+
+  std::vector<int64_t> sorted_keys = keys;
+  timer.Reset();
+  std::sort(sorted_keys.begin(), sorted_keys.end());
+  sorted_keys.erase(std::unique(sorted_keys.begin(), sorted_keys.end()),
+                    sorted_keys.end());
+  PrintRow("std::sort + std::unique, int64", 1, timer.ElapsedSeconds(),
+           num_records);
+
+  timer.Reset();
+  std::set<std::string> name_set;
+  for (const std::string& name : names) {
+    name_set.insert(name);
+  }
+  PrintRow("std::set insert, string", 1, timer.ElapsedSeconds(), num_names);
+
+  bool all_ok = sorted_keys.size() == key_set.size();
+  for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    std::cout << std::endl;
+    // The copies of the input are not timed.
+    std::vector<int64_t> values = keys;
+    timer.Reset();
+    cpp_labs::ParallelRadixSort(&values, num_threads);
+    const double sort_seconds = timer.ElapsedSeconds();
+    cpp_labs::ParallelUnique(&values, num_threads);
+    const double unique_seconds = timer.ElapsedSeconds();
+    std::vector<int64_t> btree_values = values;
+    timer.Reset();
+    const cpp_labs::SortedArraySet<int64_t> sorted_set(std::move(values));
+    const double sorted_set_seconds = unique_seconds + timer.ElapsedSeconds();
+    timer.Reset();
+    const cpp_labs::StaticBTree<int64_t> btree(std::move(btree_values),
+                                               num_threads);
+    const double btree_seconds = unique_seconds + timer.ElapsedSeconds();
+    PrintRow("ParallelRadixSort, int64", num_threads, sort_seconds,
+             num_records);
+    PrintRow("+ ParallelUnique", num_threads, unique_seconds, num_records);
+    PrintRow("= SortedArraySet", num_threads, sorted_set_seconds,
+             num_records);
+    PrintRow("= StaticBTree", num_threads, btree_seconds, num_records);
+
+    timer.Reset();
+    const cpp_labs::IntegerHashSet<int64_t> hash_set(keys, num_threads);
+    PrintRow("IntegerHashSet", num_threads, timer.ElapsedSeconds(),
+             num_records);
+
+    std::vector<std::string> name_values = names;
+    timer.Reset();
+    cpp_labs::ParallelMergeSort(&name_values, num_threads);
+    const double name_sort_seconds = timer.ElapsedSeconds();
+    cpp_labs::ParallelUnique(&name_values, num_threads);
+    const cpp_labs::SortedArraySet<std::string> name_sorted_set(
+        std::move(name_values));
+    const double name_set_seconds = timer.ElapsedSeconds();
+    PrintRow("ParallelMergeSort, string", num_threads, name_sort_seconds,
+             num_names);
+    PrintRow("= SortedArraySet, string", num_threads, name_set_seconds,
+             num_names);
+
+    all_ok = all_ok && Check(sorted_set, key_set, keys, absent_keys) &&
+             Check(btree, key_set, keys, absent_keys) &&
+             Check(hash_set, key_set, keys, absent_keys) &&
+             Check(name_sorted_set, name_set, names, absent_names);
+  }
+  std::cout << std::endl;
+  PrintCheck("all sets match std::set", all_ok);
+  return all_ok ? 0 : 1;
+}
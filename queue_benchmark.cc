@@ -0,0 +1,352 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary compares MpmcQueue (mpmc_queue.h) and SpscRing (spsc_ring.h)
+// against a bounded queue guarded by a mutex and condition variables: the
+// throughput across producer:consumer counts and payloads, and the latency of
+// a hand-off between two threads.
+//
+// Usage: queue_benchmark [num_items] [num_round_trips]
+//   Defaults: num_items = 2000000, num_round_trips = 100000.
+//
+// Payloads:
+//
+// 1. uint64_t: 8 bytes, the cost of the queue itself.
+// 2. DummyRecord: a 64-byte record with the fields of the DummyObject of
+// references_example.cc, copied into and out of the queue.
+// 3. std::vector<int> batches of kBatchSize ints: only the vector (three
+// pointers) moves through the queue; the producer allocates each batch and the
+// consumer frees it, as in our pipeline.
+//
+// Notes:
+//
+// 1. All the queues hold kCapacity elements and use their blocking push/pop.
+// When a queue is full or empty the thread spins for a moment and then sleeps
+// (futex for the lock-free queues, condition variable for the locked one), so
+// the benchmark also works when there are more threads than cores.
+// 2. The latency is the round trip of a value sent through one queue and
+// returned through a second queue by another thread (half of it is one
+// hand-off). When the two threads share a core every round trip includes two
+// context switches.
+// 3. "SpscRing, batch" pushes and pops kBatchSize values at a time.
+
+#include <atomic>  // Header for std::atomic.
+#include <condition_variable>  // Header for std::condition_variable.
+#include <cstdint>  // Header for uint64_t.
+#include <deque>  // Header for std::deque.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <mutex>  // Header for std::mutex.
+#include <string>  // Header for std::string.
+#include <thread>  // Header for std::thread.
+#include <utility>  // Header for std::move.
+#include <vector>  // Header for std::vector.
+
+#include "benchmark_utils.h"
+#include "mpmc_queue.h"
+#include "spsc_ring.h"
+
+namespace {
+
+const std::size_t kCapacity = 1024;
+const std::size_t kBatchSize = 64;
+
+// The fields of the DummyObject of references_example.cc, padded to a cache
+// line.
+struct DummyRecord {
+  uint64_t instance_id;
+  int64_t state_variable;
+  uint64_t payload[6];
+};
+
+// The usual bounded queue: a std::deque guarded by a mutex, and two condition
+// variables to wait while it is full or empty.
+template <typename T>
+class LockedQueue {
+ public:
+  explicit LockedQueue(const std::size_t capacity) : capacity_(capacity) {}
+
+  void push(T value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this]() { return queue_.size() < capacity_; });
+    queue_.push_back(std::move(value));
+    lock.unlock();
+    not_empty_.notify_one();
+  }
+
+  void pop(T* value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this]() { return !queue_.empty(); });
+    *value = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+    not_full_.notify_one();
+  }
+
+ private:
+  const std::size_t capacity_;
+  std::deque<T> queue_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+};
+
+// Builds the i-th value of each payload, and reads back its number.
+void MakeValue(const uint64_t i, uint64_t* value) { *value = i; }
+
+void MakeValue(const uint64_t i, DummyRecord* value) {
+  *value = DummyRecord();
+  value->instance_id = i;
+  value->state_variable = -1;
+}
+
+void MakeValue(const uint64_t i, std::vector<int>* value) {
+  value->assign(kBatchSize, static_cast<int>(i));
+}
+
+uint64_t ValueNumber(const uint64_t value) { return value; }
+uint64_t ValueNumber(const DummyRecord& value) { return value.instance_id; }
+uint64_t ValueNumber(const std::vector<int>& value) {
+  return static_cast<uint64_t>(value.front());
+}
+
+// Pushes and pops through the blocking single-element interface or through
+// SpscRing's batch interface.
+struct SingleTransfer {
+  template <typename Queue, typename T>
+  static void Produce(Queue* queue, const uint64_t first, const uint64_t end) {
+    T value;
+    for (uint64_t i = first; i < end; ++i) {
+      MakeValue(i, &value);
+      queue->push(std::move(value));
+    }
+  }
+
+  template <typename Queue, typename T>
+  static uint64_t Consume(Queue* queue, const uint64_t num_values) {
+    uint64_t sum = 0;
+    T value;
+    for (uint64_t i = 0; i < num_values; ++i) {
+      queue->pop(&value);
+      sum += ValueNumber(value);
+    }
+    return sum;
+  }
+};
+
+struct BatchTransfer {
+  template <typename Queue, typename T>
+  static void Produce(Queue* queue, const uint64_t first, const uint64_t end) {
+    T values[kBatchSize];
+    uint64_t i = first;
+    while (i < end) {
+      const std::size_t count =
+          end - i < kBatchSize ? static_cast<std::size_t>(end - i) : kBatchSize;
+      for (std::size_t j = 0; j < count; ++j) {
+        MakeValue(i + j, &values[j]);
+      }
+      std::size_t pushed = 0;
+      while (pushed < count) {
+        pushed += queue->push_batch(values + pushed, count - pushed);
+      }
+      i += count;
+    }
+  }
+
+  template <typename Queue, typename T>
+  static uint64_t Consume(Queue* queue, const uint64_t num_values) {
+    uint64_t sum = 0;
+    T values[kBatchSize];
+    uint64_t num_popped = 0;
+    while (num_popped < num_values) {
+      const std::size_t max_values = num_values - num_popped < kBatchSize
+                                         ? num_values - num_popped
+                                         : kBatchSize;
+      const std::size_t count = queue->pop_batch(values, max_values);
+      for (std::size_t j = 0; j < count; ++j) {
+        sum += ValueNumber(values[j]);
+      }
+      num_popped += count;
+    }
+    return sum;
+  }
+};
+
+// Moves num_items values from num_producers to num_consumers threads and
+// returns the number of values per second, or 0 if values were lost.
+template <typename Queue, typename T, typename Transfer>
+double MeasureThroughput(const int num_producers, const int num_consumers,
+                         const uint64_t num_items) {
+  Queue queue(kCapacity);
+  std::atomic<bool> start(false);
+  std::atomic<uint64_t> sum(0);
+  std::vector<std::thread> threads;
+  for (int p = 0; p < num_producers; ++p) {
+    const uint64_t first = num_items * p / num_producers;
+    const uint64_t end = num_items * (p + 1) / num_producers;
+    threads.push_back(std::thread([&, first, end]() {
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      Transfer::template Produce<Queue, T>(&queue, first, end);
+    }));
+  }
+  for (int c = 0; c < num_consumers; ++c) {
+    const uint64_t num_values = num_items * (c + 1) / num_consumers -
+                                num_items * c / num_consumers;
+    threads.push_back(std::thread([&, num_values]() {
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      sum.fetch_add(Transfer::template Consume<Queue, T>(&queue, num_values));
+    }));
+  }
+
+  cpp_labs::Timer timer;
+  start.store(true, std::memory_order_release);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  const double seconds = timer.ElapsedSeconds();
+  if (sum.load() != num_items * (num_items - 1) / 2) {
+    return 0.0;
+  }
+  return num_items / seconds;
+}
+
+template <typename Queue, typename T, typename Transfer>
+void PrintThroughput(const std::string& queue_name,
+                     const std::string& payload_name, const int num_producers,
+                     const int num_consumers, const uint64_t num_items) {
+  const double items_per_second = MeasureThroughput<Queue, T, Transfer>(
+      num_producers, num_consumers, num_items);
+  std::cout << std::setw(20) << queue_name << std::setw(18) << payload_name
+            << std::setw(6) << num_producers << ":" << num_consumers;
+  if (items_per_second == 0.0) {
+    std::cout << "  lost values!" << std::endl;
+    return;
+  }
+  std::cout << std::setw(14) << items_per_second / 1e6 << std::setw(12)
+            << 1e9 / items_per_second << std::endl;
+}
+
+// Measures every producer:consumer configuration of one payload.
+template <typename T>
+void PrintPayloadThroughput(const std::string& payload_name,
+                            const uint64_t num_items) {
+  const int kConfigurations[][2] = {{1, 1}, {2, 2}, {4, 4}, {1, 4}, {4, 1}};
+  for (const auto& configuration : kConfigurations) {
+    const int num_producers = configuration[0];
+    const int num_consumers = configuration[1];
+    PrintThroughput<LockedQueue<T>, T, SingleTransfer>(
+        "mutex + condvar", payload_name, num_producers, num_consumers,
+        num_items);
+    PrintThroughput<cpp_labs::MpmcQueue<T>, T, SingleTransfer>(
+        "MpmcQueue", payload_name, num_producers, num_consumers, num_items);
+    if (num_producers == 1 && num_consumers == 1) {
+      PrintThroughput<cpp_labs::SpscRing<T>, T, SingleTransfer>(
+          "SpscRing", payload_name, 1, 1, num_items);
+      PrintThroughput<cpp_labs::SpscRing<T>, T, BatchTransfer>(
+          "SpscRing, batch", payload_name, 1, 1, num_items);
+    }
+  }
+}
+
+// Sends num_round_trips values to an echo thread and back, and prints the
+// percentiles of the round trip time.
+template <typename Queue>
+void PrintLatency(const std::string& queue_name,
+                  const std::size_t num_round_trips) {
+  Queue requests(kCapacity);
+  Queue responses(kCapacity);
+  std::thread echo([&]() {
+    uint64_t value = 0;
+    for (std::size_t i = 0; i < num_round_trips; ++i) {
+      requests.pop(&value);
+      responses.push(value);
+    }
+  });
+
+  std::vector<int64_t> latencies(num_round_trips);
+  cpp_labs::Timer timer;
+  uint64_t value = 0;
+  for (std::size_t i = 0; i < num_round_trips; ++i) {
+    timer.Reset();
+    requests.push(i);
+    responses.pop(&value);
+    latencies[i] = static_cast<int64_t>(timer.ElapsedNanoseconds());
+  }
+  echo.join();
+
+  std::cout << std::setw(20) << queue_name;
+  const double kPercentiles[] = {50.0, 99.0, 99.9};
+  for (const double percentile : kPercentiles) {
+    std::cout << std::setw(12)
+              << cpp_labs::Percentile(&latencies, percentile);
+  }
+  std::cout << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const uint64_t num_items =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, 2000000);
+  const std::size_t num_round_trips =
+      cpp_labs::ParseSizeArgument(argc, argv, 2, 100000);
+  if (num_items == 0 || num_round_trips == 0) {
+    std::cerr << "num_items and num_round_trips must be positive."
+              << std::endl;
+    return 1;
+  }
+
+  std::cout << "Throughput: " << num_items << " values per run, capacity "
+            << kCapacity << ", " << std::thread::hardware_concurrency()
+            << " hardware threads\n"
+            << std::setw(20) << "queue" << std::setw(18) << "payload"
+            << std::setw(8) << "P:C" << std::setw(14) << "M values/s"
+            << std::setw(12) << "ns/value" << std::endl;
+  PrintPayloadThroughput<uint64_t>("uint64_t", num_items);
+  PrintPayloadThroughput<DummyRecord>("DummyRecord", num_items);
+  PrintPayloadThroughput<std::vector<int> >("vector<int>(64)", num_items);
+
+  std::cout << "\nRound trip latency (ns): " << num_round_trips
+            << " round trips\n"
+            << std::setw(20) << "queue" << std::setw(12) << "p50"
+            << std::setw(12) << "p99" << std::setw(12) << "p99.9" << std::endl;
+  PrintLatency<LockedQueue<uint64_t> >("mutex + condvar", num_round_trips);
+  PrintLatency<cpp_labs::MpmcQueue<uint64_t> >("MpmcQueue", num_round_trips);
+  PrintLatency<cpp_labs::SpscRing<uint64_t> >("SpscRing", num_round_trips);
+  return 0;
+}
@@ -0,0 +1,217 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_RCU_MAP_H_
+#define CPP_LABS_RCU_MAP_H_
+
+// A read-copy-update (RCU) map for tables that are read all the time and
+// changed rarely, such as the user_name_to_user_id map of
+// unordered_map_example.cc in a server.
+//
+// Guarding a std::unordered_map with a std::shared_mutex makes every lookup
+// write the mutex (to count the reader), and these writes from all the cores
+// fight over its cache line; a writer also has to wait for the readers to
+// leave, and stalls the new readers meanwhile. An RcuMap never changes a
+// version of the map once readers can see it:
+// 1. Readers load the pointer to the current version (one atomic load, after
+// announcing an epoch in a slot of their own thread) and look up in it
+// without any lock.
+// 2. Writers copy the current version (or build a new one), change the copy,
+// and publish it by storing its pointer: readers that start afterwards see
+// the new version, readers that started before keep reading the old one.
+// 3. The old version is retired to an EpochDomain (memory_reclamation.h) and
+// deleted once no reader can still be reading it.
+//
+// Usage (every thread has its own ThreadContext):
+//
+//   cpp_labs::RcuMap<std::string, int> user_name_to_user_id;
+//   // Readers:
+//   cpp_labs::RcuMap<std::string, int>::ThreadContext context(
+//       user_name_to_user_id.domain());
+//   int user_id;
+//   if (user_name_to_user_id.find(&context, "victor", &user_id)) { ... }
+//   // Many lookups in one version (the cheapest way to read):
+//   {
+//     cpp_labs::RcuMap<std::string, int>::Snapshot snapshot(
+//         user_name_to_user_id, &context);
+//     const int* user_id = snapshot.find("victor");
+//     for (const auto& entry : snapshot.map()) { ... }
+//   }
+//   // Writers:
+//   typedef cpp_labs::RcuMap<std::string, int>::Map Map;
+//   user_name_to_user_id.Update(&context, [](Map* map) {
+//     (*map)["john"] = 2;
+//   });
+//   user_name_to_user_id.Replace(&context, LoadUserIds());
+//
+// Notes:
+//
+// 1. A write costs a copy of the whole map (Update) or building a new one
+// (Replace), so RCU suits tables changed a few times per second or less.
+// Writers are serialized by a mutex; readers never wait for them.
+// 2. The versions a reader sees are consistent: a Snapshot reads one version
+// throughout, even if writers publish new ones meanwhile.
+// 3. A write deletes the version it replaces before returning, so at most
+// two versions (plus the one being built) are alive at any time: it waits
+// for the readers that could still see the old version to finish (readers
+// never wait for writers, but writers wait for readers), so a reader that
+// holds a Snapshot for long delays the writes. A thread must not write while
+// it holds a Snapshot with the same ThreadContext.
+// 4. The ThreadContexts must be destroyed before the map.
+
+#include <atomic>  // Header for std::atomic.
+#include <cstdint>  // Header for uint64_t.
+#include <functional>  // Header for std::hash.
+#include <memory>  // Header for std::unique_ptr.
+#include <mutex>  // Header for std::mutex.
+#include <unordered_map>  // Header for std::unordered_map.
+#include <utility>  // Header for std::move.
+
+#include "memory_reclamation.h"
+
+namespace cpp_labs {
+
+template <typename Key, typename Value, typename Hash = std::hash<Key> >
+class RcuMap {
+ private:
+  // An immutable version of the map; defined below.
+  struct Version;
+
+ public:
+  typedef std::unordered_map<Key, Value, Hash> Map;
+  typedef EpochDomain::ThreadContext ThreadContext;
+
+  explicit RcuMap(Map initial = Map())
+      // Try to reclaim on every write: versions are large.
+      : domain_(1), current_(new Version(std::move(initial), 1)) {}
+
+  // No thread may use the map anymore.
+  ~RcuMap() { delete current_.load(std::memory_order_relaxed); }
+
+  RcuMap(const RcuMap&) = delete;
+  RcuMap& operator=(const RcuMap&) = delete;
+
+  // The domain to create the ThreadContexts from.
+  EpochDomain* domain() { return &domain_; }
+
+  // A read-side critical section: the version of the map when it was created,
+  // which stays valid (and unchanged) until it is destroyed.
+  class Snapshot {
+   public:
+    Snapshot(const RcuMap& rcu_map, ThreadContext* context)
+        : guard_(context),
+          version_(rcu_map.current_.load(std::memory_order_acquire)) {}
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    const Map& map() const { return version_->map; }
+
+    // Counts the writes: 1 for the initial map, and +1 per write.
+    uint64_t version() const { return version_->number; }
+
+    // Returns the value of key, or nullptr if key is not in the map.
+    const Value* find(const Key& key) const {
+      typename Map::const_iterator it = version_->map.find(key);
+      return it == version_->map.end() ? nullptr : &it->second;
+    }
+
+   private:
+    EpochDomain::Guard guard_;
+    const Version* version_;
+  };
+
+  // Returns whether key is in the map, and its value in value (if not null).
+  bool find(ThreadContext* context, const Key& key, Value* value) const {
+    const Snapshot snapshot(*this, context);
+    const Value* found = snapshot.find(key);
+    if (found != nullptr && value != nullptr) {
+      *value = *found;
+    }
+    return found != nullptr;
+  }
+
+  // Publishes map as the new version. Returns its number.
+  uint64_t Replace(ThreadContext* context, Map map) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    const Version* old_version = current_.load(std::memory_order_relaxed);
+    return Publish(context, new Version(std::move(map),
+                                        old_version->number + 1));
+  }
+
+  // Calls function(Map*) on a copy of the current version, and publishes the
+  // copy. Returns its number.
+  template <typename Function>
+  uint64_t Update(ThreadContext* context, Function function) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    const Version* old_version = current_.load(std::memory_order_relaxed);
+    // Deleted if function throws.
+    std::unique_ptr<Version> new_version(
+        new Version(old_version->map, old_version->number + 1));
+    function(&new_version->map);
+    return Publish(context, new_version.release());
+  }
+
+ private:
+  struct Version {
+    Version(const Map& new_map, const uint64_t new_number)
+        : map(new_map), number(new_number) {}
+    Version(Map&& new_map, const uint64_t new_number)
+        : map(std::move(new_map)), number(new_number) {}
+
+    Map map;
+    const uint64_t number;
+  };
+
+  // Needs write_mutex_.
+  uint64_t Publish(ThreadContext* context, Version* new_version) {
+    Version* old_version =
+        current_.exchange(new_version, std::memory_order_acq_rel);
+    // Readers that loaded old_version may still be reading it: wait for them
+    // and delete it now, instead of keeping a copy of a large map alive until
+    // later writes.
+    context->retire(old_version);
+    context->Synchronize();
+    return new_version->number;
+  }
+
+  // Destroyed last: it deletes the versions still retired then.
+  EpochDomain domain_;
+  std::atomic<Version*> current_;
+  std::mutex write_mutex_;
+};
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_RCU_MAP_H_
@@ -0,0 +1,293 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary compares the read-copy-update map of rcu_map.h against a
+// std::unordered_map behind a std::shared_mutex on a read-mostly table: many
+// threads look up user ids by user name while one thread replaces the whole
+// table periodically.
+//
+// Usage: rcu_map_benchmark [max_threads] [milliseconds] [num_users]
+//                          [update_period_ms]
+//   Defaults: max_threads = 64, milliseconds = 200 (per measurement),
+//             num_users = 100000, update_period_ms = 10.
+//
+// For each number of reader threads it prints the lookups per second and the
+// time the writer took to publish a new table and delete an old one (mean and
+// maximum); building the new table is the same for all and is not included.
+// The tables:
+//
+// 1. shared_mutex: readers lock the mutex in shared mode for every lookup,
+// and the writer swaps the new table in under the exclusive lock. With many
+// readers the writer may wait for the lock for the whole run (glibc prefers
+// readers); the readers stop on time regardless.
+// 2. RCU find: RcuMap::find for every lookup.
+// 3. RCU snapshot: one RcuMap::Snapshot for every kBatchSize lookups.
+//
+// The tables map "user<i>" to i and to num_users + i alternately, and the
+// readers check that every id they get is one of the two; "errors" counts the
+// ones that are not, and the binary returns 1 if there are any.
+
+#include <algorithm>  // Header for std::max.
+#include <atomic>  // Header for std::atomic.
+#include <cstdint>  // Header for uint64_t.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <mutex>  // Header for std::unique_lock.
+#include <shared_mutex>  // Header for std::shared_mutex (C++17).
+#include <string>  // Header for std::string.
+#include <thread>  // Header for std::thread.
+#include <unordered_map>  // Header for std::unordered_map.
+#include <utility>  // Header for std::move.
+#include <vector>  // Header for std::vector.
+
+#include "benchmark_utils.h"
+#include "rcu_map.h"
+
+namespace {
+
+typedef std::unordered_map<std::string, int> UserIdMap;
+
+// Lookups per read-side critical section of "RCU snapshot".
+const int kBatchSize = 16;
+
+// Fast per-thread random numbers.
+inline uint64_t NextRandom(uint64_t* state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+// Returns whether id is a valid id of user.
+inline bool IsValidId(const int id, const uint64_t user, const int num_users) {
+  return static_cast<uint64_t>(id % num_users) == user;
+}
+
+class SharedMutexTable {
+ public:
+  struct ThreadContext {
+    explicit ThreadContext(SharedMutexTable*) {}
+  };
+
+  explicit SharedMutexTable(const UserIdMap& map) : map_(map) {}
+
+  // Looks up the users of names; returns the number of invalid ids.
+  int Lookup(ThreadContext*, const std::vector<std::string>& names,
+             const uint64_t* users, const int num_users) const {
+    int errors = 0;
+    for (int i = 0; i < kBatchSize; ++i) {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      UserIdMap::const_iterator it = map_.find(names[users[i]]);
+      errors += it != map_.end() && IsValidId(it->second, users[i], num_users)
+                    ? 0
+                    : 1;
+    }
+    return errors;
+  }
+
+  void Publish(ThreadContext*, UserIdMap* map) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    map_.swap(*map);
+  }
+
+ private:
+  mutable std::shared_mutex mutex_;
+  UserIdMap map_;
+};
+
+// RcuMap, with one read-side critical section per lookup or per batch.
+template <bool kSnapshotPerBatch>
+class RcuTable {
+ public:
+  struct ThreadContext : public cpp_labs::EpochDomain::ThreadContext {
+    explicit ThreadContext(RcuTable* table)
+        : cpp_labs::EpochDomain::ThreadContext(table->map_.domain()) {}
+  };
+
+  explicit RcuTable(const UserIdMap& map) : map_(map) {}
+
+  int Lookup(ThreadContext* context, const std::vector<std::string>& names,
+             const uint64_t* users, const int num_users) const {
+    int errors = 0;
+    if (kSnapshotPerBatch) {
+      const cpp_labs::RcuMap<std::string, int>::Snapshot snapshot(map_,
+                                                                  context);
+      for (int i = 0; i < kBatchSize; ++i) {
+        const int* id = snapshot.find(names[users[i]]);
+        errors += id != nullptr && IsValidId(*id, users[i], num_users) ? 0 : 1;
+      }
+    } else {
+      for (int i = 0; i < kBatchSize; ++i) {
+        int id = -1;
+        errors += map_.find(context, names[users[i]], &id) &&
+                          IsValidId(id, users[i], num_users)
+                      ? 0
+                      : 1;
+      }
+    }
+    return errors;
+  }
+
+  void Publish(ThreadContext* context, UserIdMap* map) {
+    map_.Replace(context, std::move(*map));
+  }
+
+ private:
+  cpp_labs::RcuMap<std::string, int> map_;
+};
+
+struct Result {
+  double million_lookups_per_second;
+  double mean_update_microseconds;
+  double max_update_microseconds;
+  uint64_t num_errors;
+};
+
+// Runs num_threads readers and one writer on Table for the given time.
+template <typename Table>
+Result ReadMostly(const int num_threads, const int milliseconds,
+                  const std::vector<std::string>& names,
+                  const UserIdMap* tables, const int update_period_ms) {
+  const int num_users = static_cast<int>(names.size());
+  Table table(tables[0]);
+  // Readers stop by themselves: a writer that never gets the lock must not
+  // keep them running.
+  const std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(milliseconds);
+  std::vector<uint64_t> lookups(num_threads, 0);
+  std::vector<uint64_t> errors(num_threads, 0);
+  std::vector<std::thread> readers;
+  for (int t = 0; t < num_threads; ++t) {
+    readers.push_back(std::thread([&, t]() {
+      typename Table::ThreadContext context(&table);
+      uint64_t random_state = 88172645463325252ULL + t;
+      uint64_t users[kBatchSize];
+      while (std::chrono::steady_clock::now() < deadline) {
+        for (int i = 0; i < kBatchSize; ++i) {
+          users[i] = NextRandom(&random_state) % num_users;
+        }
+        errors[t] += table.Lookup(&context, names, users, num_users);
+        lookups[t] += kBatchSize;
+      }
+    }));
+  }
+  // The writer runs in this thread.
+  double total_update_seconds = 0.0;
+  double max_update_seconds = 0.0;
+  int num_updates = 0;
+  {
+    typename Table::ThreadContext context(&table);
+    cpp_labs::Timer update_timer;
+    while (std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(update_period_ms));
+      UserIdMap next_table = tables[(num_updates + 1) % 2];
+      update_timer.Reset();
+      table.Publish(&context, &next_table);
+      // With the shared_mutex, next_table holds the old table now.
+      UserIdMap().swap(next_table);
+      const double seconds = update_timer.ElapsedSeconds();
+      total_update_seconds += seconds;
+      max_update_seconds = std::max(max_update_seconds, seconds);
+      ++num_updates;
+    }
+    for (std::thread& reader : readers) {
+      reader.join();
+    }
+  }
+  Result result = {0.0, 0.0, max_update_seconds * 1e6, 0};
+  for (int t = 0; t < num_threads; ++t) {
+    result.million_lookups_per_second += lookups[t];
+    result.num_errors += errors[t];
+  }
+  result.million_lookups_per_second /= milliseconds / 1000.0 * 1e6;
+  result.mean_update_microseconds =
+      num_updates == 0 ? 0.0 : total_update_seconds / num_updates * 1e6;
+  return result;
+}
+
+void PrintResult(const Result& result) {
+  std::cout << std::setw(12) << result.million_lookups_per_second
+            << std::setw(10) << result.mean_update_microseconds
+            << std::setw(10) << result.max_update_microseconds;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int max_threads =
+      static_cast<int>(cpp_labs::ParseSizeArgument(argc, argv, 1, 64));
+  const int milliseconds =
+      static_cast<int>(cpp_labs::ParseSizeArgument(argc, argv, 2, 200));
+  const int num_users =
+      static_cast<int>(cpp_labs::ParseSizeArgument(argc, argv, 3, 100000));
+  const int update_period_ms =
+      static_cast<int>(cpp_labs::ParseSizeArgument(argc, argv, 4, 10));
+
+  std::vector<std::string> names;
+  UserIdMap tables[2];
+  for (int i = 0; i < num_users; ++i) {
+    names.push_back("user" + std::to_string(i));
+    tables[0][names.back()] = i;
+    tables[1][names.back()] = num_users + i;
+  }
+
+  std::cout << "Hardware threads: " << std::thread::hardware_concurrency()
+            << "\n"
+            << num_users << " users, table replaced every "
+            << update_period_ms << " ms; million lookups per second, and "
+            << "publishing time in microseconds (mean, max)\n"
+            << std::setw(9) << "threads" << std::setw(32) << "shared_mutex"
+            << std::setw(32) << "RCU find" << std::setw(32) << "RCU snapshot"
+            << std::setw(8) << "errors" << std::endl;
+  std::cout << std::fixed << std::setprecision(2);
+  uint64_t num_errors = 0;
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    const Result locked = ReadMostly<SharedMutexTable>(
+        threads, milliseconds, names, tables, update_period_ms);
+    const Result rcu_find = ReadMostly<RcuTable<false> >(
+        threads, milliseconds, names, tables, update_period_ms);
+    const Result rcu_snapshot = ReadMostly<RcuTable<true> >(
+        threads, milliseconds, names, tables, update_period_ms);
+    std::cout << std::setw(9) << threads;
+    PrintResult(locked);
+    PrintResult(rcu_find);
+    PrintResult(rcu_snapshot);
+    const uint64_t run_errors =
+        locked.num_errors + rcu_find.num_errors + rcu_snapshot.num_errors;
+    std::cout << std::setw(8) << run_errors << std::endl;
+    num_errors += run_errors;
+  }
+  return num_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,247 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary measures what trivial relocation (see trivially_relocatable.h)
+// buys when containers grow, insert and erase, using element types from the
+// labs: std::string and std::pair<std::string, int> (map examples), a
+// DummyObject like the one of references_example.cc, and std::vector<int>.
+//
+// Usage: relocation_benchmark [num_elements]  (default: 1000000)
+//
+// Notes:
+//
+// 1. std::vector moves its elements one at a time when it reallocates. For
+// DummyObject it even copies them: the class declares a copy constructor, so
+// it has no move constructor.
+// 2. GrowableVector, SmallVector and RingDeque move relocatable elements with
+// memcpy/memmove (or realloc/mremap) instead.
+// 3. libstdc++'s std::string is not trivially relocatable, so with libstdc++
+// the string rows measure the fallback path (the "relocatable" column says
+// which path was used).
+
+#include <deque>  // Header for std::deque.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <string>  // Header for std::string.
+#include <utility>  // Header for std::pair.
+#include <vector>  // Header for std::vector.
+
+#include "benchmark_utils.h"
+#include "growable_vector.h"
+#include "ring_deque.h"
+#include "small_vector.h"
+#include "trivially_relocatable.h"
+
+namespace {
+
+// Same shape as the DummyObject of references_example.cc, without the
+// printing.
+class DummyObject {
+ public:
+  DummyObject() : instance_id_(0), state_variable_(-1) {}
+  explicit DummyObject(const int instance_id)
+      : instance_id_(instance_id), state_variable_(-1) {}
+  DummyObject(const DummyObject& object)
+      : instance_id_(object.instance_id_),
+        state_variable_(object.state_variable_) {}
+  DummyObject& operator=(const DummyObject& rhs_object) {
+    instance_id_ = rhs_object.instance_id_;
+    state_variable_ = rhs_object.state_variable_;
+    return *this;
+  }
+  virtual ~DummyObject() {}
+
+  int instance_id() const { return instance_id_; }
+
+ private:
+  int instance_id_;
+  int state_variable_;
+};
+
+}  // namespace
+
+// DummyObject does not store its own address anywhere.
+CPP_LABS_DECLARE_TRIVIALLY_RELOCATABLE(DummyObject)
+
+namespace {
+
+// Builds the i-th test value of each element type.
+template <typename T>
+T MakeValue(const int i);
+
+template <>
+std::string MakeValue<std::string>(const int i) {
+  // Long enough to live on the heap.
+  return "user_name_number_" + std::to_string(i) + "_with_a_long_suffix";
+}
+
+template <>
+std::pair<std::string, int> MakeValue<std::pair<std::string, int> >(
+    const int i) {
+  return std::make_pair(MakeValue<std::string>(i), i);
+}
+
+template <>
+DummyObject MakeValue<DummyObject>(const int i) {
+  return DummyObject(i);
+}
+
+template <>
+std::vector<int> MakeValue<std::vector<int> >(const int i) {
+  return std::vector<int>(4, i);
+}
+
+// Number of insertions and erasures in the middle of a container.
+const int kNumMiddleOperations = 1000;
+
+template <typename Container, typename T>
+double TimeAppend(const std::vector<T>& values) {
+  cpp_labs::Timer timer;
+  Container container;
+  for (const T& value : values) {
+    container.push_back(value);
+  }
+  cpp_labs::DoNotOptimize(container.size());
+  return timer.ElapsedSeconds();
+}
+
+// Time of the last reallocation alone: the container is filled to exactly its
+// capacity and then grown once.
+template <typename Container, typename T>
+double TimeOneReallocation(const std::vector<T>& values) {
+  Container container;
+  container.reserve(values.size());
+  for (const T& value : values) {
+    container.push_back(value);
+  }
+  cpp_labs::Timer timer;
+  container.reserve(2 * values.size() + 1);
+  const double seconds = timer.ElapsedSeconds();
+  cpp_labs::DoNotOptimize(container.size());
+  return seconds;
+}
+
+// Inserts into and erases from the middle of a vector.
+template <typename Container, typename T>
+double TimeMiddleInsertErase(const std::vector<T>& values) {
+  Container container;
+  for (const T& value : values) {
+    container.push_back(value);
+  }
+  cpp_labs::Timer timer;
+  for (int i = 0; i < kNumMiddleOperations; ++i) {
+    container.insert(container.begin() + container.size() / 3, values[i]);
+  }
+  for (int i = 0; i < kNumMiddleOperations; ++i) {
+    container.erase(container.begin() + container.size() / 3);
+  }
+  cpp_labs::DoNotOptimize(container.size());
+  return timer.ElapsedSeconds();
+}
+
+// Grows many small vectors from empty to 32 elements.
+template <typename Container, typename T>
+double TimeSmallVectors(const std::vector<T>& values) {
+  const std::size_t kSmallSize = 32;
+  cpp_labs::Timer timer;
+  for (std::size_t begin = 0; begin + kSmallSize <= values.size();
+       begin += kSmallSize) {
+    Container container;
+    for (std::size_t i = begin; i < begin + kSmallSize; ++i) {
+      container.push_back(values[i]);
+    }
+    cpp_labs::DoNotOptimize(container.size());
+  }
+  return timer.ElapsedSeconds();
+}
+
+void PrintRow(const char* name, const double baseline_seconds,
+              const double seconds) {
+  std::cout << "  " << std::setw(28) << std::left << name << std::right
+            << std::setw(12) << baseline_seconds * 1e3 << std::setw(12)
+            << seconds * 1e3 << std::setw(10) << baseline_seconds / seconds
+            << "x" << std::endl;
+}
+
+template <typename T>
+void RunBenchmark(const char* type_name, const std::size_t num_elements) {
+  std::vector<T> values;
+  values.reserve(num_elements);
+  for (std::size_t i = 0; i < num_elements; ++i) {
+    values.push_back(MakeValue<T>(static_cast<int>(i)));
+  }
+
+  std::cout << "\n" << type_name << " (relocatable: "
+            << (cpp_labs::IsTriviallyRelocatable<T>::value ? "yes" : "no")
+            << ")\n  " << std::setw(28) << std::left << "operation"
+            << std::right << std::setw(12) << "std ms" << std::setw(12)
+            << "cpp_labs ms" << std::setw(11) << "speedup" << std::endl;
+  typedef std::vector<T> StdVector;
+  typedef cpp_labs::GrowableVector<T> Vector;
+  PrintRow("append (vector)", TimeAppend<StdVector>(values),
+           TimeAppend<Vector>(values));
+  PrintRow("one reallocation (vector)",
+           TimeOneReallocation<StdVector>(values),
+           TimeOneReallocation<Vector>(values));
+  PrintRow("insert+erase middle (vector)",
+           TimeMiddleInsertErase<StdVector>(values),
+           TimeMiddleInsertErase<Vector>(values));
+  PrintRow("grow 32 elements (small vec)",
+           TimeSmallVectors<StdVector>(values),
+           TimeSmallVectors<cpp_labs::SmallVector<T, 8> >(values));
+  PrintRow("append (deque)", TimeAppend<std::deque<T> >(values),
+           TimeAppend<cpp_labs::RingDeque<T> >(values));
+  PrintRow("insert+erase middle (deque)",
+           TimeMiddleInsertErase<std::deque<T> >(values),
+           TimeMiddleInsertErase<cpp_labs::RingDeque<T> >(values));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t num_elements =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, 1000000);
+  if (num_elements < static_cast<std::size_t>(kNumMiddleOperations)) {
+    std::cerr << "num_elements must be at least " << kNumMiddleOperations
+              << std::endl;
+    return 1;
+  }
+  std::cout << "Elements: " << num_elements << std::endl;
+  RunBenchmark<std::string>("std::string", num_elements);
+  RunBenchmark<std::pair<std::string, int> >("std::pair<std::string, int>",
+                                             num_elements);
+  RunBenchmark<DummyObject>("DummyObject", num_elements);
+  RunBenchmark<std::vector<int> >("std::vector<int>", num_elements);
+  return 0;
+}
@@ -0,0 +1,391 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_RING_DEQUE_H_
+#define CPP_LABS_RING_DEQUE_H_
+
+// RingDeque<T> is a double-ended queue stored in one circular buffer whose
+// capacity is a power of two. Pushing and popping at either end is O(1), and
+// indexing is one addition and one mask (std::deque needs two lookups through
+// its block map).
+//
+// Growing, inserting and erasing relocate the elements: trivially relocatable
+// types (see trivially_relocatable.h) are moved with at most a few memmove
+// calls, one per contiguous run of the circular buffer. insert and erase shift
+// whichever side of the position is shorter.
+
+#include <cassert>  // Header for assert.
+#include <cstddef>  // Header for std::size_t.
+#include <cstdlib>  // Header for malloc and free.
+#include <iterator>  // Header for std::random_access_iterator_tag.
+#include <new>  // Header for std::bad_alloc and placement new.
+#include <type_traits>  // Header for std::conditional.
+#include <utility>  // Header for std::move and std::forward.
+
+#include "trivially_relocatable.h"
+
+namespace cpp_labs {
+
+template <typename T>
+class RingDeque {
+ public:
+  static_assert(alignof(T) <= alignof(std::max_align_t),
+                "RingDeque does not support over-aligned types.");
+
+  typedef T value_type;
+  typedef std::size_t size_type;
+
+  // Random-access iterator over the logical positions of the deque.
+  template <bool IsConst>
+  class BasicIterator {
+   public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef typename std::conditional<IsConst, const T*, T*>::type pointer;
+    typedef typename std::conditional<IsConst, const T&, T&>::type reference;
+    typedef typename std::conditional<IsConst, const RingDeque*,
+                                      RingDeque*>::type ContainerPointer;
+
+    BasicIterator(ContainerPointer deque, const std::size_t index)
+        : deque_(deque), index_(index) {}
+
+    // Converts an iterator into a const_iterator.
+    template <bool OtherIsConst,
+              typename = typename std::enable_if<IsConst &&
+                                                 !OtherIsConst>::type>
+    BasicIterator(const BasicIterator<OtherIsConst>& other)
+        : deque_(other.deque_), index_(other.index_) {}
+
+    reference operator*() const { return (*deque_)[index_]; }
+    pointer operator->() const { return &(*deque_)[index_]; }
+    reference operator[](const difference_type offset) const {
+      return (*deque_)[index_ + offset];
+    }
+    BasicIterator& operator++() { ++index_; return *this; }
+    BasicIterator& operator--() { --index_; return *this; }
+    BasicIterator operator++(int) {
+      BasicIterator previous(*this);
+      ++index_;
+      return previous;
+    }
+    BasicIterator operator--(int) {
+      BasicIterator previous(*this);
+      --index_;
+      return previous;
+    }
+    BasicIterator& operator+=(const difference_type offset) {
+      index_ += offset;
+      return *this;
+    }
+    BasicIterator& operator-=(const difference_type offset) {
+      index_ -= offset;
+      return *this;
+    }
+    BasicIterator operator+(const difference_type offset) const {
+      return BasicIterator(deque_, index_ + offset);
+    }
+    friend BasicIterator operator+(const difference_type offset,
+                                   const BasicIterator& iterator) {
+      return iterator + offset;
+    }
+    BasicIterator operator-(const difference_type offset) const {
+      return BasicIterator(deque_, index_ - offset);
+    }
+    difference_type operator-(const BasicIterator& other) const {
+      return static_cast<difference_type>(index_) -
+             static_cast<difference_type>(other.index_);
+    }
+    bool operator==(const BasicIterator& other) const {
+      return index_ == other.index_;
+    }
+    bool operator!=(const BasicIterator& other) const {
+      return index_ != other.index_;
+    }
+    bool operator<(const BasicIterator& other) const {
+      return index_ < other.index_;
+    }
+    bool operator>(const BasicIterator& other) const {
+      return index_ > other.index_;
+    }
+    bool operator<=(const BasicIterator& other) const {
+      return index_ <= other.index_;
+    }
+    bool operator>=(const BasicIterator& other) const {
+      return index_ >= other.index_;
+    }
+
+    std::size_t index() const { return index_; }
+
+   private:
+    friend class BasicIterator<!IsConst>;
+
+    ContainerPointer deque_;
+    std::size_t index_;
+  };
+
+  typedef BasicIterator<false> iterator;
+  typedef BasicIterator<true> const_iterator;
+
+  RingDeque() : buffer_(nullptr), capacity_(0), head_(0), size_(0) {}
+
+  RingDeque(const RingDeque& other)
+      : buffer_(nullptr), capacity_(0), head_(0), size_(0) {
+    reserve(other.size_);
+    for (std::size_t i = 0; i < other.size_; ++i) {
+      push_back(other[i]);
+    }
+  }
+
+  RingDeque(RingDeque&& other)
+      : buffer_(other.buffer_), capacity_(other.capacity_),
+        head_(other.head_), size_(other.size_) {
+    other.buffer_ = nullptr;
+    other.capacity_ = 0;
+    other.head_ = 0;
+    other.size_ = 0;
+  }
+
+  RingDeque& operator=(RingDeque other) {
+    std::swap(buffer_, other.buffer_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(head_, other.head_);
+    std::swap(size_, other.size_);
+    return *this;
+  }
+
+  ~RingDeque() {
+    clear();
+    std::free(static_cast<void*>(buffer_));
+  }
+
+  std::size_t size() const { return size_; }
+  std::size_t capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+
+  T& operator[](const std::size_t index) {
+    assert(index < size_);
+    return buffer_[Physical(index)];
+  }
+  const T& operator[](const std::size_t index) const {
+    assert(index < size_);
+    return buffer_[Physical(index)];
+  }
+
+  T& front() { return (*this)[0]; }
+  T& back() { return (*this)[size_ - 1]; }
+  const T& front() const { return (*this)[0]; }
+  const T& back() const { return (*this)[size_ - 1]; }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, size_); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size_); }
+
+  // Makes room for at least new_capacity elements (rounded up to a power of
+  // two).
+  void reserve(const std::size_t new_capacity) {
+    if (new_capacity > capacity_) {
+      std::size_t capacity = capacity_ == 0 ? kMinCapacity : capacity_;
+      while (capacity < new_capacity) {
+        capacity *= 2;
+      }
+      Reallocate(capacity);
+    }
+  }
+
+  template <typename... Arguments>
+  T& emplace_back(Arguments&&... arguments) {
+    T value(std::forward<Arguments>(arguments)...);
+    GrowIfFull();
+    T* slot = buffer_ + Physical(size_);
+    ::new (static_cast<void*>(slot)) T(std::move(value));
+    ++size_;
+    return *slot;
+  }
+
+  template <typename... Arguments>
+  T& emplace_front(Arguments&&... arguments) {
+    T value(std::forward<Arguments>(arguments)...);
+    GrowIfFull();
+    head_ = (head_ - 1) & (capacity_ - 1);
+    ::new (static_cast<void*>(buffer_ + head_)) T(std::move(value));
+    ++size_;
+    return buffer_[head_];
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+  void push_front(const T& value) { emplace_front(value); }
+  void push_front(T&& value) { emplace_front(std::move(value)); }
+
+  void pop_back() {
+    assert(size_ > 0);
+    buffer_[Physical(size_ - 1)].~T();
+    --size_;
+  }
+
+  void pop_front() {
+    assert(size_ > 0);
+    buffer_[head_].~T();
+    head_ = (head_ + 1) & (capacity_ - 1);
+    --size_;
+  }
+
+  // Inserts value before the index-th element.
+  void insert(const std::size_t index, T value) {
+    assert(index <= size_);
+    GrowIfFull();
+    if (index < size_ / 2) {
+      // Shift the front part one slot towards the front.
+      MoveLogicalRange(0, index, static_cast<std::size_t>(-1));
+      head_ = (head_ - 1) & (capacity_ - 1);
+    } else {
+      MoveLogicalRange(index, size_ - index, index + 1);
+    }
+    ::new (static_cast<void*>(buffer_ + Physical(index))) T(std::move(value));
+    ++size_;
+  }
+
+  iterator insert(const const_iterator& position, T value) {
+    insert(position.index(), std::move(value));
+    return iterator(this, position.index());
+  }
+
+  // Removes the index-th element.
+  void erase(const std::size_t index) {
+    assert(index < size_);
+    buffer_[Physical(index)].~T();
+    if (index < size_ / 2) {
+      // Shift the front part one slot towards the back.
+      MoveLogicalRange(0, index, 1);
+      head_ = (head_ + 1) & (capacity_ - 1);
+    } else {
+      MoveLogicalRange(index + 1, size_ - index - 1, index);
+    }
+    --size_;
+  }
+
+  iterator erase(const const_iterator& position) {
+    erase(position.index());
+    return iterator(this, position.index());
+  }
+
+  void clear() {
+    for (std::size_t i = 0; i < size_; ++i) {
+      buffer_[Physical(i)].~T();
+    }
+    head_ = 0;
+    size_ = 0;
+  }
+
+ private:
+  static const std::size_t kMinCapacity = 16;
+
+  // Maps a logical index (0 is the front) to a slot of the buffer. Indices
+  // are taken modulo the capacity, so index -1 is the slot before the front.
+  std::size_t Physical(const std::size_t index) const {
+    return (head_ + index) & (capacity_ - 1);
+  }
+
+  void GrowIfFull() {
+    if (size_ == capacity_) {
+      Reallocate(capacity_ == 0 ? kMinCapacity : 2 * capacity_);
+    }
+  }
+
+  // Moves the elements to a new buffer where they start at slot 0. The old
+  // buffer holds at most two contiguous runs: [head, capacity) and [0, tail).
+  void Reallocate(const std::size_t new_capacity) {
+    T* new_buffer = static_cast<T*>(std::malloc(new_capacity * sizeof(T)));
+    if (new_buffer == nullptr) {
+      throw std::bad_alloc();
+    }
+    const std::size_t first_run =
+        size_ < capacity_ - head_ ? size_ : capacity_ - head_;
+    if (size_ > 0) {
+      RelocateRange(buffer_ + head_, first_run, new_buffer);
+      RelocateRange(buffer_, size_ - first_run, new_buffer + first_run);
+    }
+    std::free(static_cast<void*>(buffer_));
+    buffer_ = new_buffer;
+    capacity_ = new_capacity;
+    head_ = 0;
+  }
+
+  // Relocates count elements from logical index source to logical index
+  // destination, one contiguous run of the circular buffer at a time. Runs are
+  // processed in the order that never overwrites an element not yet moved.
+  void MoveLogicalRange(const std::size_t source, const std::size_t count,
+                        const std::size_t destination) {
+    const bool backwards =
+        static_cast<std::ptrdiff_t>(destination - source) > 0;
+    std::size_t moved = 0;
+    while (moved < count) {
+      std::size_t run = count - moved;
+      std::size_t from = 0;
+      std::size_t to = 0;
+      if (backwards) {
+        // The run ends right before logical index source + count - moved.
+        const std::size_t last_from = Physical(source + count - moved - 1);
+        const std::size_t last_to = Physical(destination + count - moved - 1);
+        run = Min(run, Min(last_from + 1, last_to + 1));
+        from = last_from + 1 - run;
+        to = last_to + 1 - run;
+      } else {
+        from = Physical(source + moved);
+        to = Physical(destination + moved);
+        run = Min(run, Min(capacity_ - from, capacity_ - to));
+      }
+      RelocateRange(buffer_ + from, run, buffer_ + to);
+      moved += run;
+    }
+  }
+
+  static std::size_t Min(const std::size_t a, const std::size_t b) {
+    return a < b ? a : b;
+  }
+
+  T* buffer_;
+  std::size_t capacity_;
+  std::size_t head_;
+  std::size_t size_;
+};
+
+template <typename T>
+const std::size_t RingDeque<T>::kMinCapacity;
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_RING_DEQUE_H_
@@ -0,0 +1,423 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_ROARING_BITMAP_H_
+#define CPP_LABS_ROARING_BITMAP_H_
+
+// A compressed set of 32-bit ids in the style of Roaring bitmaps (Chambi,
+// Lemire, Kaser and Godin, 2016).
+//
+// The ids are split by their upper 16 bits into chunks of 65536 possible ids,
+// and every non-empty chunk is stored in a container of its density:
+// 1. an array container: the sorted lower 16 bits of its ids, 2 bytes per id,
+// for chunks of at most kArrayContainerMaxSize (4096) ids;
+// 2. a bitmap container: 65536 bits (8 KB), for denser chunks.
+// A set thus takes at most ~2 bytes per id (a sorted uint32_t array takes 4,
+// a std::set<int> ~40), and operations between two chunks run on the smaller
+// representation: word-wise ANDs and ORs between bitmaps (which the compiler
+// vectorizes), bit tests from arrays into bitmaps, and the merges or galloping
+// searches of sorted_set_ops.h between arrays.
+//
+// Usage:
+//
+//   RoaringBitmap active = RoaringBitmap::FromSorted(ids.data(), ids.size());
+//   RoaringBitmap premium;
+//   premium.add(42);
+//   const RoaringBitmap both = And(active, premium);
+//   const RoaringBitmap either = Or(active, premium);
+//   const RoaringBitmap only_active = AndNot(active, premium);
+//   std::vector<uint32_t> both_ids;
+//   both.ToVector(&both_ids);
+//
+// The run-length containers of the full format (for long runs of consecutive
+// ids) are not implemented; such chunks use bitmaps.
+
+#include <algorithm>  // Header for std::lower_bound.
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for uint16_t, uint32_t and uint64_t.
+#include <utility>  // Header for std::move.
+#include <vector>  // Header for std::vector.
+
+#include "sorted_set_ops.h"
+
+namespace cpp_labs {
+
+// Chunks with more ids than this use a bitmap container.
+const std::size_t kArrayContainerMaxSize = 4096;
+
+namespace internal {
+
+const std::size_t kBitmapContainerWords = 65536 / 64;
+
+// The ids of one chunk: an array container if bitmap is empty, a bitmap
+// container otherwise.
+struct RoaringContainer {
+  RoaringContainer() : key(0), cardinality(0) {}
+
+  bool is_bitmap() const { return !bitmap.empty(); }
+
+  bool contains(const uint16_t low) const {
+    if (is_bitmap()) {
+      return (bitmap[low >> 6] >> (low & 63)) & 1;
+    }
+    return std::binary_search(array.begin(), array.end(), low);
+  }
+
+  void ToBitmap() {
+    bitmap.assign(kBitmapContainerWords, 0);
+    for (const uint16_t low : array) {
+      bitmap[low >> 6] |= uint64_t(1) << (low & 63);
+    }
+    std::vector<uint16_t>().swap(array);
+  }
+
+  void ToArray() {
+    array.clear();
+    array.reserve(cardinality);
+    for (std::size_t word = 0; word < kBitmapContainerWords; ++word) {
+      uint64_t bits = bitmap[word];
+      while (bits != 0) {
+        array.push_back(
+            static_cast<uint16_t>(word * 64 + __builtin_ctzll(bits)));
+        bits &= bits - 1;
+      }
+    }
+    std::vector<uint64_t>().swap(bitmap);
+  }
+
+  // Recounts the bits of a bitmap container, and turns it into an array
+  // container if it got sparse.
+  void Normalize() {
+    if (is_bitmap()) {
+      cardinality = 0;
+      for (const uint64_t word : bitmap) {
+        cardinality += __builtin_popcountll(word);
+      }
+      if (cardinality <= kArrayContainerMaxSize) {
+        ToArray();
+      }
+    } else {
+      cardinality = static_cast<uint32_t>(array.size());
+      if (cardinality > kArrayContainerMaxSize) {
+        ToBitmap();
+      }
+    }
+  }
+
+  uint16_t key;
+  uint32_t cardinality;
+  std::vector<uint16_t> array;
+  std::vector<uint64_t> bitmap;
+};
+
+// The ids of array (an array container) that are (kKeep = true) or are not
+// in bitmap.
+template <bool kKeep>
+void FilterArray(const RoaringContainer& array, const RoaringContainer& bitmap,
+                 RoaringContainer* output) {
+  for (const uint16_t low : array.array) {
+    if (bitmap.contains(low) == kKeep) {
+      output->array.push_back(low);
+    }
+  }
+}
+
+inline void ContainerAnd(const RoaringContainer& a, const RoaringContainer& b,
+                         RoaringContainer* output) {
+  if (a.is_bitmap() && b.is_bitmap()) {
+    output->bitmap.resize(kBitmapContainerWords);
+    for (std::size_t i = 0; i < kBitmapContainerWords; ++i) {
+      output->bitmap[i] = a.bitmap[i] & b.bitmap[i];
+    }
+  } else if (a.is_bitmap()) {
+    FilterArray<true>(b, a, output);
+  } else if (b.is_bitmap()) {
+    FilterArray<true>(a, b, output);
+  } else {
+    const RoaringContainer& small = a.array.size() <= b.array.size() ? a : b;
+    const RoaringContainer& large = a.array.size() <= b.array.size() ? b : a;
+    output->array.resize(small.array.size());
+    const std::size_t size =
+        small.array.size() * kGallopingRatio < large.array.size()
+            ? IntersectGalloping(small.array.data(), small.array.size(),
+                                 large.array.data(), large.array.size(),
+                                 output->array.data())
+            : IntersectScalar(small.array.data(), small.array.size(),
+                              large.array.data(), large.array.size(),
+                              output->array.data());
+    output->array.resize(size);
+  }
+  output->Normalize();
+}
+
+// Sets the bits of the ids of array in output (a bitmap container).
+inline void SetBits(const RoaringContainer& array, RoaringContainer* output) {
+  for (const uint16_t low : array.array) {
+    output->bitmap[low >> 6] |= uint64_t(1) << (low & 63);
+  }
+}
+
+inline void ContainerOr(const RoaringContainer& a, const RoaringContainer& b,
+                        RoaringContainer* output) {
+  if (a.is_bitmap() && b.is_bitmap()) {
+    output->bitmap.resize(kBitmapContainerWords);
+    for (std::size_t i = 0; i < kBitmapContainerWords; ++i) {
+      output->bitmap[i] = a.bitmap[i] | b.bitmap[i];
+    }
+  } else if (a.is_bitmap() || b.is_bitmap()) {
+    output->bitmap = a.is_bitmap() ? a.bitmap : b.bitmap;
+    SetBits(a.is_bitmap() ? b : a, output);
+  } else {
+    output->array.resize(a.array.size() + b.array.size());
+    output->array.resize(Union(a.array.data(), a.array.size(),
+                               b.array.data(), b.array.size(),
+                               output->array.data()));
+  }
+  output->Normalize();
+}
+
+inline void ContainerAndNot(const RoaringContainer& a,
+                            const RoaringContainer& b,
+                            RoaringContainer* output) {
+  if (a.is_bitmap() && b.is_bitmap()) {
+    output->bitmap.resize(kBitmapContainerWords);
+    for (std::size_t i = 0; i < kBitmapContainerWords; ++i) {
+      output->bitmap[i] = a.bitmap[i] & ~b.bitmap[i];
+    }
+  } else if (a.is_bitmap()) {
+    output->bitmap = a.bitmap;
+    for (const uint16_t low : b.array) {
+      output->bitmap[low >> 6] &= ~(uint64_t(1) << (low & 63));
+    }
+  } else if (b.is_bitmap()) {
+    FilterArray<false>(a, b, output);
+  } else {
+    output->array.resize(a.array.size());
+    const std::size_t size =
+        a.array.size() * kGallopingRatio < b.array.size() ||
+                b.array.size() * kGallopingRatio < a.array.size()
+            ? DifferenceGalloping(a.array.data(), a.array.size(),
+                                  b.array.data(), b.array.size(),
+                                  output->array.data())
+            : DifferenceScalar(a.array.data(), a.array.size(),
+                               b.array.data(), b.array.size(),
+                               output->array.data());
+    output->array.resize(size);
+  }
+  output->Normalize();
+}
+
+}  // namespace internal
+
+class RoaringBitmap {
+ public:
+  RoaringBitmap() {}
+
+  // Builds the set of ids, which must be sorted and without duplicates.
+  static RoaringBitmap FromSorted(const uint32_t* ids, const std::size_t size) {
+    RoaringBitmap result;
+    std::size_t begin = 0;
+    while (begin < size) {
+      const uint16_t key = static_cast<uint16_t>(ids[begin] >> 16);
+      std::size_t end = begin;
+      internal::RoaringContainer container;
+      container.key = key;
+      while (end < size && (ids[end] >> 16) == key) {
+        container.array.push_back(static_cast<uint16_t>(ids[end] & 0xFFFF));
+        ++end;
+      }
+      container.Normalize();
+      result.containers_.push_back(std::move(container));
+      begin = end;
+    }
+    return result;
+  }
+
+  void add(const uint32_t id) {
+    const uint16_t key = static_cast<uint16_t>(id >> 16);
+    const uint16_t low = static_cast<uint16_t>(id & 0xFFFF);
+    std::vector<internal::RoaringContainer>::iterator it = Find(key);
+    if (it == containers_.end() || it->key != key) {
+      it = containers_.insert(it, internal::RoaringContainer());
+      it->key = key;
+    }
+    if (it->is_bitmap()) {
+      uint64_t& word = it->bitmap[low >> 6];
+      const uint64_t bit = uint64_t(1) << (low & 63);
+      it->cardinality += (word & bit) == 0 ? 1 : 0;
+      word |= bit;
+      return;
+    }
+    std::vector<uint16_t>::iterator position =
+        std::lower_bound(it->array.begin(), it->array.end(), low);
+    if (position == it->array.end() || *position != low) {
+      it->array.insert(position, low);
+      it->Normalize();
+    }
+  }
+
+  bool contains(const uint32_t id) const {
+    const uint16_t key = static_cast<uint16_t>(id >> 16);
+    std::vector<internal::RoaringContainer>::const_iterator it = Find(key);
+    return it != containers_.end() && it->key == key &&
+           it->contains(static_cast<uint16_t>(id & 0xFFFF));
+  }
+
+  std::size_t cardinality() const {
+    std::size_t total = 0;
+    for (const internal::RoaringContainer& container : containers_) {
+      total += container.cardinality;
+    }
+    return total;
+  }
+
+  bool empty() const { return containers_.empty(); }
+
+  // Memory used by the containers.
+  std::size_t bytes() const {
+    std::size_t total = containers_.capacity() * sizeof(containers_[0]);
+    for (const internal::RoaringContainer& container : containers_) {
+      total += container.array.capacity() * sizeof(uint16_t) +
+               container.bitmap.capacity() * sizeof(uint64_t);
+    }
+    return total;
+  }
+
+  // Writes the ids in order.
+  void ToVector(std::vector<uint32_t>* ids) const {
+    ids->clear();
+    ids->reserve(cardinality());
+    for (const internal::RoaringContainer& container : containers_) {
+      const uint32_t high = uint32_t(container.key) << 16;
+      if (!container.is_bitmap()) {
+        for (const uint16_t low : container.array) {
+          ids->push_back(high | low);
+        }
+        continue;
+      }
+      for (std::size_t word = 0; word < internal::kBitmapContainerWords;
+           ++word) {
+        uint64_t bits = container.bitmap[word];
+        while (bits != 0) {
+          ids->push_back(high | static_cast<uint32_t>(
+                                    word * 64 + __builtin_ctzll(bits)));
+          bits &= bits - 1;
+        }
+      }
+    }
+  }
+
+  friend RoaringBitmap And(const RoaringBitmap& a, const RoaringBitmap& b) {
+    return Combine<kAnd>(a, b);
+  }
+  friend RoaringBitmap Or(const RoaringBitmap& a, const RoaringBitmap& b) {
+    return Combine<kOr>(a, b);
+  }
+  // The ids of a that are not in b.
+  friend RoaringBitmap AndNot(const RoaringBitmap& a, const RoaringBitmap& b) {
+    return Combine<kAndNot>(a, b);
+  }
+
+ private:
+  enum Operation { kAnd, kOr, kAndNot };
+
+  std::vector<internal::RoaringContainer>::iterator Find(const uint16_t key) {
+    return std::lower_bound(containers_.begin(), containers_.end(), key,
+                            ContainerKeyLess);
+  }
+  std::vector<internal::RoaringContainer>::const_iterator Find(
+      const uint16_t key) const {
+    return std::lower_bound(containers_.begin(), containers_.end(), key,
+                            ContainerKeyLess);
+  }
+
+  static bool ContainerKeyLess(const internal::RoaringContainer& container,
+                               const uint16_t key) {
+    return container.key < key;
+  }
+
+  // Merges the containers of a and b by key, like a merge of sorted arrays.
+  template <Operation kOperation>
+  static RoaringBitmap Combine(const RoaringBitmap& a, const RoaringBitmap& b) {
+    RoaringBitmap result;
+    std::size_t i = 0;
+    std::size_t j = 0;
+    const std::vector<internal::RoaringContainer>& containers_a =
+        a.containers_;
+    const std::vector<internal::RoaringContainer>& containers_b =
+        b.containers_;
+    while (i < containers_a.size() || j < containers_b.size()) {
+      const bool has_a = i < containers_a.size();
+      const bool has_b = j < containers_b.size();
+      if (has_a && (!has_b || containers_a[i].key < containers_b[j].key)) {
+        // Only in a.
+        if (kOperation != kAnd) {
+          result.containers_.push_back(containers_a[i]);
+        }
+        ++i;
+      } else if (has_b &&
+                 (!has_a || containers_b[j].key < containers_a[i].key)) {
+        // Only in b.
+        if (kOperation == kOr) {
+          result.containers_.push_back(containers_b[j]);
+        }
+        ++j;
+      } else {
+        internal::RoaringContainer container;
+        container.key = containers_a[i].key;
+        if (kOperation == kAnd) {
+          internal::ContainerAnd(containers_a[i], containers_b[j], &container);
+        } else if (kOperation == kOr) {
+          internal::ContainerOr(containers_a[i], containers_b[j], &container);
+        } else {
+          internal::ContainerAndNot(containers_a[i], containers_b[j],
+                                    &container);
+        }
+        if (container.cardinality > 0) {
+          result.containers_.push_back(std::move(container));
+        }
+        ++i;
+        ++j;
+      }
+    }
+    return result;
+  }
+
+  // Sorted by key.
+  std::vector<internal::RoaringContainer> containers_;
+};
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_ROARING_BITMAP_H_
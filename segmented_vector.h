@@ -0,0 +1,398 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_SEGMENTED_VECTOR_H_
+#define CPP_LABS_SEGMENTED_VECTOR_H_
+
+// SegmentedVector<T> is a vector made of chunks whose sizes double: chunk 0
+// holds FirstChunkSize elements, chunk 1 twice as many, and so on. When the
+// last chunk is full a new one is added, but the elements already stored are
+// never copied. Hence:
+//
+// 1. push_back is O(1) in the worst case, not only amortized: there is no
+// reallocation stall that copies the whole vector.
+// 2. The address of an element never changes while it is in the vector, so
+// pointers and references to elements stay valid after push_back.
+// 3. operator[] finds the chunk of an index with a few bit operations (the
+// chunk number is the position of the highest set bit of the index) and a
+// lookup in a fixed-size chunk table.
+//
+// Chunks are recycled: pop_back and clear keep the emptied chunks allocated
+// and push_back reuses them. shrink_to_fit returns them to the system.
+//
+// Example:
+//   SegmentedVector<int> my_vector;
+//   my_vector.push_back(1);
+//   int* first = &my_vector[0];
+//   for (int i = 0; i < 1000000; ++i) {
+//     my_vector.push_back(i);
+//   }
+//   // first still points to my_vector[0].
+
+#include <cassert>  // Header for assert.
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for uint64_t.
+#include <iterator>  // Header for std::random_access_iterator_tag.
+#include <new>  // Header for placement new.
+#include <type_traits>  // Header for std::conditional.
+#include <utility>  // Header for std::move and std::forward.
+
+#include "aligned_memory.h"
+
+namespace cpp_labs {
+namespace internal {
+
+// Position of the highest set bit of value, which must not be zero.
+inline std::size_t HighestBit(const uint64_t value) {
+  return 63 - __builtin_clzll(value);
+}
+
+// Floor of the base-2 logarithm of value, at compile time.
+constexpr std::size_t Log2(const std::size_t value) {
+  return value <= 1 ? 0 : 1 + Log2(value / 2);
+}
+
+}  // namespace internal
+
+template <typename T, std::size_t FirstChunkSize = 64>
+class SegmentedVector {
+ public:
+  static_assert(FirstChunkSize > 0 &&
+                    (FirstChunkSize & (FirstChunkSize - 1)) == 0,
+                "FirstChunkSize must be a power of two.");
+
+  typedef T value_type;
+  typedef std::size_t size_type;
+
+  // Enough chunks to index the whole 64-bit address space.
+  static const std::size_t kMaxChunks = 64;
+
+  // Random-access iterator. Incrementing it only touches the chunk table when
+  // it crosses into the next chunk.
+  template <bool IsConst>
+  class BasicIterator {
+   public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef typename std::conditional<IsConst, const T*, T*>::type pointer;
+    typedef typename std::conditional<IsConst, const T&, T&>::type reference;
+    typedef typename std::conditional<IsConst, const SegmentedVector*,
+                                      SegmentedVector*>::type ContainerPointer;
+
+    BasicIterator(ContainerPointer vector, const std::size_t index)
+        : vector_(vector), index_(index), current_(nullptr),
+          chunk_end_(nullptr) {
+      Seek();
+    }
+
+    // Converts an iterator into a const_iterator.
+    template <bool OtherIsConst,
+              typename = typename std::enable_if<IsConst &&
+                                                 !OtherIsConst>::type>
+    BasicIterator(const BasicIterator<OtherIsConst>& other)
+        : vector_(other.vector_), index_(other.index_),
+          current_(other.current_), chunk_end_(other.chunk_end_) {}
+
+    reference operator*() const { return *current_; }
+    pointer operator->() const { return current_; }
+
+    reference operator[](const difference_type offset) const {
+      return (*vector_)[index_ + offset];
+    }
+
+    BasicIterator& operator++() {
+      ++index_;
+      if (++current_ == chunk_end_) {
+        Seek();
+      }
+      return *this;
+    }
+    // Stepping back may leave the chunk, so it looks the position up again.
+    BasicIterator& operator--() {
+      --index_;
+      Seek();
+      return *this;
+    }
+    BasicIterator operator++(int) {
+      BasicIterator previous(*this);
+      ++*this;
+      return previous;
+    }
+    BasicIterator operator--(int) {
+      BasicIterator previous(*this);
+      --*this;
+      return previous;
+    }
+    BasicIterator& operator+=(const difference_type offset) {
+      index_ += offset;
+      Seek();
+      return *this;
+    }
+    BasicIterator& operator-=(const difference_type offset) {
+      index_ -= offset;
+      Seek();
+      return *this;
+    }
+    BasicIterator operator+(const difference_type offset) const {
+      return BasicIterator(vector_, index_ + offset);
+    }
+    friend BasicIterator operator+(const difference_type offset,
+                                   const BasicIterator& iterator) {
+      return iterator + offset;
+    }
+    BasicIterator operator-(const difference_type offset) const {
+      return BasicIterator(vector_, index_ - offset);
+    }
+    difference_type operator-(const BasicIterator& other) const {
+      return static_cast<difference_type>(index_) -
+             static_cast<difference_type>(other.index_);
+    }
+    bool operator==(const BasicIterator& other) const {
+      return index_ == other.index_;
+    }
+    bool operator!=(const BasicIterator& other) const {
+      return index_ != other.index_;
+    }
+    bool operator<(const BasicIterator& other) const {
+      return index_ < other.index_;
+    }
+    bool operator>(const BasicIterator& other) const {
+      return index_ > other.index_;
+    }
+    bool operator<=(const BasicIterator& other) const {
+      return index_ <= other.index_;
+    }
+    bool operator>=(const BasicIterator& other) const {
+      return index_ >= other.index_;
+    }
+
+   private:
+    friend class BasicIterator<!IsConst>;
+
+    void Seek() {
+      if (index_ < vector_->size_) {
+        const std::size_t chunk = ChunkIndex(index_);
+        current_ = vector_->chunks_[chunk] + ChunkOffset(index_, chunk);
+        chunk_end_ = vector_->chunks_[chunk] + ChunkSize(chunk);
+      }
+    }
+
+    ContainerPointer vector_;
+    std::size_t index_;
+    pointer current_;
+    pointer chunk_end_;
+  };
+
+  typedef BasicIterator<false> iterator;
+  typedef BasicIterator<true> const_iterator;
+
+  SegmentedVector()
+      : size_(0), num_chunks_(0), next_(nullptr), chunk_end_(nullptr) {
+    for (std::size_t i = 0; i < kMaxChunks; ++i) {
+      chunks_[i] = nullptr;
+    }
+  }
+
+  SegmentedVector(const SegmentedVector& other)
+      : size_(0), num_chunks_(0), next_(nullptr), chunk_end_(nullptr) {
+    for (std::size_t i = 0; i < kMaxChunks; ++i) {
+      chunks_[i] = nullptr;
+    }
+    reserve(other.size_);
+    for (const T& value : other) {
+      push_back(value);
+    }
+  }
+
+  SegmentedVector& operator=(const SegmentedVector& other) {
+    if (this != &other) {
+      clear();
+      reserve(other.size_);
+      for (const T& value : other) {
+        push_back(value);
+      }
+    }
+    return *this;
+  }
+
+  ~SegmentedVector() {
+    clear();
+    shrink_to_fit();
+  }
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  // Number of elements that fit in the allocated chunks.
+  std::size_t capacity() const { return ChunkStart(num_chunks_); }
+  std::size_t num_chunks() const { return num_chunks_; }
+
+  T& operator[](const std::size_t index) {
+    assert(index < size_);
+    const std::size_t chunk = ChunkIndex(index);
+    return chunks_[chunk][ChunkOffset(index, chunk)];
+  }
+  const T& operator[](const std::size_t index) const {
+    assert(index < size_);
+    const std::size_t chunk = ChunkIndex(index);
+    return chunks_[chunk][ChunkOffset(index, chunk)];
+  }
+
+  T& front() { return *chunks_[0]; }
+  T& back() { return *(next_ - 1); }
+  const T& front() const { return *chunks_[0]; }
+  const T& back() const { return *(next_ - 1); }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, size_); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size_); }
+
+  // Allocates chunks until at least new_capacity elements fit.
+  void reserve(const std::size_t new_capacity) {
+    while (capacity() < new_capacity) {
+      AllocateChunk();
+    }
+  }
+
+  template <typename... Arguments>
+  T& emplace_back(Arguments&&... arguments) {
+    if (next_ == chunk_end_) {
+      NextChunk();
+    }
+    ::new (static_cast<void*>(next_)) T(std::forward<Arguments>(arguments)...);
+    ++size_;
+    return *next_++;
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  void pop_back() {
+    assert(size_ > 0);
+    (*this)[size_ - 1].~T();
+    --size_;
+    UpdateCursor();
+  }
+
+  // Destroys all the elements but keeps the chunks for reuse.
+  void clear() {
+    for (T& value : *this) {
+      value.~T();
+    }
+    size_ = 0;
+    UpdateCursor();
+  }
+
+  // Frees the chunks that hold no elements.
+  void shrink_to_fit() {
+    const std::size_t used_chunks = size_ == 0 ? 0 : ChunkIndex(size_ - 1) + 1;
+    while (num_chunks_ > used_chunks) {
+      --num_chunks_;
+      AlignedFree(chunks_[num_chunks_]);
+      chunks_[num_chunks_] = nullptr;
+    }
+    UpdateCursor();
+  }
+
+ private:
+  static const std::size_t kFirstChunkBits = internal::Log2(FirstChunkSize);
+
+  // Chunk k covers the indices [FirstChunkSize * (2^k - 1),
+  // FirstChunkSize * (2^(k + 1) - 1)).
+  static std::size_t ChunkIndex(const std::size_t index) {
+    return internal::HighestBit((index >> kFirstChunkBits) + 1);
+  }
+  static std::size_t ChunkStart(const std::size_t chunk) {
+    return (FirstChunkSize << chunk) - FirstChunkSize;
+  }
+  static std::size_t ChunkSize(const std::size_t chunk) {
+    return FirstChunkSize << chunk;
+  }
+  static std::size_t ChunkOffset(const std::size_t index,
+                                 const std::size_t chunk) {
+    return index - ChunkStart(chunk);
+  }
+
+  void AllocateChunk() {
+    assert(num_chunks_ < kMaxChunks);
+    const std::size_t alignment =
+        alignof(T) > kCacheLineSize ? alignof(T) : kCacheLineSize;
+    chunks_[num_chunks_] = static_cast<T*>(
+        AlignedAllocate(alignment, ChunkSize(num_chunks_) * sizeof(T)));
+    ++num_chunks_;
+  }
+
+  // Called when the current chunk is full: moves the cursor to the start of
+  // the next chunk, reusing it when it is already allocated.
+  void NextChunk() {
+    const std::size_t chunk = ChunkIndex(size_);
+    if (chunk == num_chunks_) {
+      AllocateChunk();
+    }
+    next_ = chunks_[chunk];
+    chunk_end_ = next_ + ChunkSize(chunk);
+  }
+
+  // Points the cursor at the slot of index size_. When that slot is the
+  // first one of a chunk the cursor is left "full" so that the next
+  // push_back calls NextChunk.
+  void UpdateCursor() {
+    if (size_ == 0) {
+      next_ = chunk_end_ = nullptr;
+      return;
+    }
+    const std::size_t chunk = ChunkIndex(size_ - 1);
+    next_ = chunks_[chunk] + ChunkOffset(size_ - 1, chunk) + 1;
+    chunk_end_ = chunks_[chunk] + ChunkSize(chunk);
+  }
+
+  T* chunks_[kMaxChunks];
+  std::size_t size_;
+  std::size_t num_chunks_;
+  // Slot where the next push_back constructs its element, and the end of the
+  // chunk that holds it.
+  T* next_;
+  T* chunk_end_;
+};
+
+template <typename T, std::size_t FirstChunkSize>
+const std::size_t SegmentedVector<T, FirstChunkSize>::kMaxChunks;
+
+template <typename T, std::size_t FirstChunkSize>
+const std::size_t SegmentedVector<T, FirstChunkSize>::kFirstChunkBits;
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_SEGMENTED_VECTOR_H_
@@ -0,0 +1,217 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary measures the latency of every single push_back into a
+// std::vector<int> (as in heap_memory_example.cc) and into a
+// SegmentedVector<int>, and reports the percentiles of those latencies.
+//
+// Usage: segmented_vector_benchmark [num_elements]  (default: 100000000)
+//
+// Notes:
+//
+// 1. Most push_back calls take a few nanoseconds in both containers. The
+// difference is in the tail: when std::vector grows it copies all of its
+// elements, so the push_back that triggers the growth takes milliseconds (and
+// that stall grows with the vector). SegmentedVector never copies.
+// 2. The first write to each new page of memory causes a page fault in both
+// containers; that cost shows in the p999 of both. The "recycled chunks" row
+// appends into chunks kept by clear(), whose pages are already mapped.
+// 3. Each latency includes the cost of reading the clock; the "timer" row
+// shows that cost alone.
+// 4. The second table compares reading the elements back: sequentially with
+// iterators and at random positions with operator[].
+// 5. Before exiting, the binary sorts a SegmentedVector with std::sort, which
+// needs random-access iterators, and returns 1 if the result is wrong.
+
+#include <algorithm>  // Header for std::sort and std::is_sorted.
+#include <cstdint>  // Header for uint32_t.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <iterator>  // Header for std::prev.
+#include <random>  // Header for std::mt19937.
+#include <vector>  // Header for std::vector.
+
+#include "benchmark_utils.h"
+#include "segmented_vector.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+uint32_t NanosecondsBetween(const Clock::time_point& start,
+                            const Clock::time_point& end) {
+  return static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+          .count());
+}
+
+// Appends num_elements ints and stores the latency of each push_back.
+template <typename Container>
+void MeasureAppend(const std::size_t num_elements, Container* container,
+                   std::vector<uint32_t>* latencies) {
+  for (std::size_t i = 0; i < num_elements; ++i) {
+    const Clock::time_point start = Clock::now();
+    container->push_back(static_cast<int>(i));
+    const Clock::time_point end = Clock::now();
+    (*latencies)[i] = NanosecondsBetween(start, end);
+  }
+  cpp_labs::DoNotOptimize(container->back());
+}
+
+// Measures only the clock reads.
+void MeasureTimer(const std::size_t num_elements,
+                  std::vector<uint32_t>* latencies) {
+  for (std::size_t i = 0; i < num_elements; ++i) {
+    const Clock::time_point start = Clock::now();
+    cpp_labs::ClobberMemory();
+    const Clock::time_point end = Clock::now();
+    (*latencies)[i] = NanosecondsBetween(start, end);
+  }
+}
+
+void PrintLatencies(const char* name, std::vector<uint32_t>* latencies) {
+  uint32_t max_latency = 0;
+  for (const uint32_t latency : *latencies) {
+    max_latency = latency > max_latency ? latency : max_latency;
+  }
+  std::cout << std::setw(20) << name << std::setw(10)
+            << cpp_labs::Percentile(latencies, 50.0) << std::setw(10)
+            << cpp_labs::Percentile(latencies, 99.0) << std::setw(10)
+            << cpp_labs::Percentile(latencies, 99.9) << std::setw(10)
+            << cpp_labs::Percentile(latencies, 99.99) << std::setw(14)
+            << max_latency << std::endl;
+}
+
+template <typename Container>
+void MeasureReads(const char* name, const Container& container,
+                  const std::vector<std::size_t>& random_indices) {
+  cpp_labs::Timer timer;
+  long long sum = 0;
+  for (const int value : container) {
+    sum += value;
+  }
+  cpp_labs::DoNotOptimize(sum);
+  const double sequential_seconds = timer.ElapsedSeconds();
+
+  timer.Reset();
+  sum = 0;
+  for (const std::size_t index : random_indices) {
+    sum += container[index];
+  }
+  cpp_labs::DoNotOptimize(sum);
+  const double random_seconds = timer.ElapsedSeconds();
+
+  std::cout << std::setw(20) << name << std::setw(16)
+            << sequential_seconds * 1e9 / container.size() << std::setw(16)
+            << random_seconds * 1e9 / random_indices.size() << std::endl;
+}
+
+// Sorts a SegmentedVector of several chunks with the standard algorithms.
+// Returns whether the result is right.
+bool SortsWithStdAlgorithms() {
+  const int kNumValues = 100000;
+  cpp_labs::SegmentedVector<int> values;
+  for (int i = 0; i < kNumValues; ++i) {
+    // A permutation of [0, kNumValues), as 7919 is prime.
+    values.push_back(static_cast<int>((i * 7919LL) % kNumValues));
+  }
+  std::sort(values.begin(), values.end());
+  return values.num_chunks() > 1 &&
+         std::is_sorted(values.begin(), values.end()) &&
+         values[0] == 0 && *std::prev(values.end()) == kNumValues - 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t num_elements =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, 100000000);
+  if (num_elements == 0) {
+    std::cerr << "num_elements must be positive." << std::endl;
+    return 1;
+  }
+  std::vector<uint32_t> latencies(num_elements);
+
+  std::cout << "push_back latency (ns) over " << num_elements << " ints\n"
+            << std::setw(20) << "container" << std::setw(10) << "p50"
+            << std::setw(10) << "p99" << std::setw(10) << "p999"
+            << std::setw(10) << "p9999" << std::setw(14) << "max"
+            << std::endl;
+  MeasureTimer(num_elements, &latencies);
+  PrintLatencies("timer", &latencies);
+
+  std::vector<int> my_vector;
+  MeasureAppend(num_elements, &my_vector, &latencies);
+  PrintLatencies("std::vector", &latencies);
+
+  cpp_labs::SegmentedVector<int> segmented_vector;
+  const int* first_element = nullptr;
+  {
+    // Remember the address of the first element to show it never moves.
+    segmented_vector.push_back(0);
+    first_element = &segmented_vector[0];
+    segmented_vector.pop_back();
+  }
+  MeasureAppend(num_elements, &segmented_vector, &latencies);
+  PrintLatencies("SegmentedVector", &latencies);
+  std::cout << "SegmentedVector chunks: " << segmented_vector.num_chunks()
+            << ", first element stayed at the same address: "
+            << (first_element == &segmented_vector[0] ? "yes" : "no")
+            << std::endl;
+
+  // Recycled chunks: after clear() the chunks are reused, so appending again
+  // does not allocate at all.
+  segmented_vector.clear();
+  MeasureAppend(num_elements, &segmented_vector, &latencies);
+  PrintLatencies("recycled chunks", &latencies);
+
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<std::size_t> distribution(0, num_elements - 1);
+  std::vector<std::size_t> random_indices(10000000);
+  for (std::size_t& index : random_indices) {
+    index = distribution(rng);
+  }
+  std::cout << "\nRead latency (ns/element)\n" << std::setw(20) << "container"
+            << std::setw(16) << "sequential" << std::setw(16) << "random"
+            << std::endl;
+  MeasureReads("std::vector", my_vector, random_indices);
+  MeasureReads("SegmentedVector", segmented_vector, random_indices);
+
+  if (!SortsWithStdAlgorithms()) {
+    std::cerr << "std::sort gave a wrong order on a SegmentedVector."
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}
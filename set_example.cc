@@ -40,10 +40,16 @@
 // 1. The set mimics the mathematical set. That is, it only stores unique
 // elements.
 // 2. Memory is also handled dynamically for us.
+// 3. The set operations are timed with the macros of instrumentation.h. They
+// compile to nothing unless the labs are built with
+// -DBUILD_WITH_INSTRUMENTATION=ON, in which case the latency of every
+// operation is reported when the program exits.
 
 #include <iostream>  // Header for printing to stdout.
 #include <set>  // Header for using std::set.
 
+#include "instrumentation.h"
+
 int main(int argc, char** argv) {
   // Declaration of a set is very similar to a vector.
   std::set<int> my_integers_set;
@@ -52,7 +58,7 @@ int main(int argc, char** argv) {
   // A neat trick to get the size of arrays.
   const int kArraySize = sizeof(integers) / sizeof(integers[0]);
   for (int i = 0; i < kArraySize; ++i) {
-    my_integers_set.insert(integers[i]);
+    CPP_LABS_TIMED("std::set::insert", my_integers_set.insert(integers[i]));
   }
   // Let's print out the contents of set.
   std::cout << "Elements of set\n";
@@ -66,14 +72,15 @@ int main(int argc, char** argv) {
   // The set returns an iterator different than std::set::end() when the element
   // is present in the set, and returns std::set::end() otherwise.
   // Let's search for an element not in the set.
-  std::set<int>::iterator iterator = my_integers_set.find(5);
+  std::set<int>::iterator iterator =
+      CPP_LABS_TIMED("std::set::find", my_integers_set.find(5));
   if (iterator == my_integers_set.end()) {
     std::cout << "Element not found in set" << std::endl;
   } else {
     std::cout << "Element found in set" << std::endl;
   }
   // Let's search for an element in the set.
-  iterator = my_integers_set.find(1);
+  iterator = CPP_LABS_TIMED("std::set::find", my_integers_set.find(1));
   if (iterator == my_integers_set.end()) {
     std::cout << "Element not found in set" << std::endl;
   } else {
@@ -85,10 +92,10 @@ int main(int argc, char** argv) {
   // iterators_example.cc for explanation and illustration of iterators.
   // To erase one element from the set, we need to obtain an iterator first to
   // that element and pass the iterator as the element to erase.
-  my_integers_set.erase(iterator);
+  CPP_LABS_TIMED("std::set::erase", my_integers_set.erase(iterator));
   // Let's verify that it erased the element, in this case will erase 1 since
   // iterator is "pointing" to it.
-  iterator = my_integers_set.find(1);
+  iterator = CPP_LABS_TIMED("std::set::find", my_integers_set.find(1));
   if (iterator == my_integers_set.end()) {
     std::cout << "Element not found in set" << std::endl;
   } else {
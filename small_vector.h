@@ -0,0 +1,274 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_SMALL_VECTOR_H_
+#define CPP_LABS_SMALL_VECTOR_H_
+
+// SmallVector<T, N> is a vector that stores up to N elements inside the object
+// itself (for instance, on the stack) and only allocates heap memory when it
+// grows beyond N elements. Most vectors in a program hold a handful of
+// elements, and for them SmallVector avoids the call to 'new' altogether.
+//
+// Growing, inserting and erasing relocate the elements: trivially relocatable
+// types (see trivially_relocatable.h) are moved with memcpy/memmove, and the
+// heap buffer of such types grows with realloc.
+//
+// Example:
+//   SmallVector<int, 8> my_vector;  // No heap allocation.
+//   for (int i = 0; i < 8; ++i) {
+//     my_vector.push_back(i);       // Still no heap allocation.
+//   }
+//   my_vector.push_back(8);         // Moves to the heap.
+
+#include <cassert>  // Header for assert.
+#include <cstddef>  // Header for std::size_t.
+#include <cstdlib>  // Header for malloc, realloc and free.
+#include <new>  // Header for std::bad_alloc and placement new.
+#include <utility>  // Header for std::move and std::forward.
+
+#include "trivially_relocatable.h"
+
+namespace cpp_labs {
+
+template <typename T, std::size_t N>
+class SmallVector {
+ public:
+  static_assert(N > 0, "SmallVector needs room for at least one element.");
+  static_assert(alignof(T) <= alignof(std::max_align_t),
+                "SmallVector does not support over-aligned types.");
+
+  typedef T value_type;
+  typedef T* iterator;
+  typedef const T* const_iterator;
+  typedef std::size_t size_type;
+
+  static const std::size_t kInlineCapacity = N;
+  static const bool kRelocatable = IsTriviallyRelocatable<T>::value;
+
+  SmallVector() : data_(InlineData()), size_(0), capacity_(N) {}
+
+  SmallVector(const SmallVector& other)
+      : data_(InlineData()), size_(0), capacity_(N) {
+    reserve(other.size_);
+    for (std::size_t i = 0; i < other.size_; ++i) {
+      ::new (static_cast<void*>(data_ + i)) T(other.data_[i]);
+    }
+    size_ = other.size_;
+  }
+
+  SmallVector(SmallVector&& other)
+      : data_(InlineData()), size_(0), capacity_(N) {
+    StealFrom(&other);
+  }
+
+  SmallVector& operator=(const SmallVector& other) {
+    if (this != &other) {
+      SmallVector copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  SmallVector& operator=(SmallVector&& other) {
+    if (this != &other) {
+      clear();
+      FreeHeap();
+      data_ = InlineData();
+      capacity_ = N;
+      StealFrom(&other);
+    }
+    return *this;
+  }
+
+  ~SmallVector() {
+    clear();
+    FreeHeap();
+  }
+
+  std::size_t size() const { return size_; }
+  std::size_t capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+  // True while the elements live inside the object.
+  bool is_inline() const { return data_ == InlineData(); }
+
+  T* data() { return data_; }
+  const T* data() const { return data_; }
+  T* begin() { return data_; }
+  T* end() { return data_ + size_; }
+  const T* begin() const { return data_; }
+  const T* end() const { return data_ + size_; }
+
+  T& operator[](const std::size_t index) {
+    assert(index < size_);
+    return data_[index];
+  }
+  const T& operator[](const std::size_t index) const {
+    assert(index < size_);
+    return data_[index];
+  }
+
+  T& front() { return data_[0]; }
+  T& back() { return data_[size_ - 1]; }
+  const T& front() const { return data_[0]; }
+  const T& back() const { return data_[size_ - 1]; }
+
+  void reserve(const std::size_t new_capacity) {
+    if (new_capacity > capacity_) {
+      Reallocate(new_capacity);
+    }
+  }
+
+  void push_back(const T& value) { emplace_back(value); }
+  void push_back(T&& value) { emplace_back(std::move(value)); }
+
+  template <typename... Arguments>
+  T& emplace_back(Arguments&&... arguments) {
+    if (size_ == capacity_) {
+      // The arguments may refer to an element, so build the value first.
+      T value(std::forward<Arguments>(arguments)...);
+      Reallocate(2 * capacity_);
+      ::new (static_cast<void*>(data_ + size_)) T(std::move(value));
+    } else {
+      ::new (static_cast<void*>(data_ + size_))
+          T(std::forward<Arguments>(arguments)...);
+    }
+    return data_[size_++];
+  }
+
+  void pop_back() {
+    assert(size_ > 0);
+    data_[--size_].~T();
+  }
+
+  T* insert(const T* position, const T& value) {
+    T copy(value);
+    return emplace(position, std::move(copy));
+  }
+
+  T* insert(const T* position, T&& value) {
+    return emplace(position, std::move(value));
+  }
+
+  template <typename... Arguments>
+  T* emplace(const T* position, Arguments&&... arguments) {
+    const std::size_t index = position - data_;
+    assert(index <= size_);
+    T value(std::forward<Arguments>(arguments)...);
+    if (size_ == capacity_) {
+      Reallocate(2 * capacity_);
+    }
+    RelocateRange(data_ + index, size_ - index, data_ + index + 1);
+    ::new (static_cast<void*>(data_ + index)) T(std::move(value));
+    ++size_;
+    return data_ + index;
+  }
+
+  T* erase(const T* first, const T* last) {
+    const std::size_t begin = first - data_;
+    const std::size_t end = last - data_;
+    assert(begin <= end && end <= size_);
+    for (std::size_t i = begin; i < end; ++i) {
+      data_[i].~T();
+    }
+    RelocateRange(data_ + end, size_ - end, data_ + begin);
+    size_ -= end - begin;
+    return data_ + begin;
+  }
+
+  T* erase(const T* position) { return erase(position, position + 1); }
+
+  void clear() {
+    for (std::size_t i = 0; i < size_; ++i) {
+      data_[i].~T();
+    }
+    size_ = 0;
+  }
+
+ private:
+  T* InlineData() { return reinterpret_cast<T*>(inline_storage_); }
+  const T* InlineData() const {
+    return reinterpret_cast<const T*>(inline_storage_);
+  }
+
+  // Takes the elements of other, which is left empty. This object must be
+  // empty and inline.
+  void StealFrom(SmallVector* other) {
+    if (other->is_inline()) {
+      RelocateRange(other->data_, other->size_, data_);
+    } else {
+      data_ = other->data_;
+      capacity_ = other->capacity_;
+      other->data_ = other->InlineData();
+      other->capacity_ = N;
+    }
+    size_ = other->size_;
+    other->size_ = 0;
+  }
+
+  void Reallocate(const std::size_t new_capacity) {
+    T* new_data = nullptr;
+    if (kRelocatable && !is_inline()) {
+      // realloc may extend the buffer in place.
+      new_data = static_cast<T*>(std::realloc(static_cast<void*>(data_),
+                                              new_capacity * sizeof(T)));
+      if (new_data == nullptr) {
+        throw std::bad_alloc();
+      }
+    } else {
+      new_data = static_cast<T*>(std::malloc(new_capacity * sizeof(T)));
+      if (new_data == nullptr) {
+        throw std::bad_alloc();
+      }
+      RelocateRange(data_, size_, new_data);
+      FreeHeap();
+    }
+    data_ = new_data;
+    capacity_ = new_capacity;
+  }
+
+  void FreeHeap() {
+    if (!is_inline()) {
+      std::free(static_cast<void*>(data_));
+    }
+  }
+
+  T* data_;
+  std::size_t size_;
+  std::size_t capacity_;
+  alignas(T) unsigned char inline_storage_[N * sizeof(T)];
+};
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_SMALL_VECTOR_H_
@@ -0,0 +1,506 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_SOA_VECTOR_H_
+#define CPP_LABS_SOA_VECTOR_H_
+
+// SoAVector stores records in a "structure of arrays" (columnar) layout.
+//
+// A std::vector<Record> stores whole records one after another (an "array of
+// structures"): reading one field of every record drags the other fields into
+// the cache as well. SoAVector<int, double, char> instead keeps one contiguous,
+// cache-line-aligned array per field. A scan over a single field only streams
+// that field's memory, and the compiler can vectorize the loop because the
+// values are packed together.
+//
+// Example:
+//   SoAVector<int, double> records;
+//   records.push_back(1, 2.5);
+//   records[0].get<1>() = 3.5;          // Row access through a proxy.
+//   double total = 0.0;
+//   for (const double price : records.column<1>()) {  // Column access.
+//     total += price;
+//   }
+
+#include <cassert>  // Header for assert.
+#include <cstddef>  // Header for std::size_t.
+#include <iterator>  // Header for std::random_access_iterator_tag.
+#include <new>  // Header for placement new.
+#include <tuple>  // Header for std::tuple.
+#include <type_traits>  // Header for std::conditional.
+#include <utility>  // Header for std::move.
+
+#include "aligned_memory.h"
+#include "index_sequence.h"
+#include "span.h"
+
+namespace cpp_labs {
+
+template <typename... Fields>
+class SoAVector {
+ public:
+  static_assert(sizeof...(Fields) > 0, "SoAVector needs at least one field.");
+
+  // Every column starts at a cache line boundary.
+  static const std::size_t kAlignment = kCacheLineSize;
+  static const std::size_t kNumColumns = sizeof...(Fields);
+
+  // The type of the I-th field.
+  template <std::size_t I>
+  using FieldType =
+      typename std::tuple_element<I, std::tuple<Fields...> >::type;
+
+  // Proxy to one row. Copying the proxy does not copy the row, it only copies
+  // the reference to it.
+  template <bool IsConst>
+  class BasicRowReference {
+   public:
+    typedef typename std::conditional<IsConst, const SoAVector*,
+                                      SoAVector*>::type ContainerPointer;
+
+    BasicRowReference(ContainerPointer container, const std::size_t index)
+        : container_(container), index_(index) {}
+
+    template <std::size_t I>
+    typename std::conditional<IsConst, const FieldType<I>&,
+                              FieldType<I>&>::type get() const {
+      return container_->template get<I>(index_);
+    }
+
+    // Copies the row into a tuple.
+    std::tuple<Fields...> ToTuple() const {
+      return ToTupleImpl(MakeIndexSequence<kNumColumns>());
+    }
+
+    // Assigns all the fields of the row at once.
+    const BasicRowReference& operator=(const std::tuple<Fields...>& values)
+        const {
+      static_assert(!IsConst, "Cannot assign through a const row.");
+      AssignImpl(values, MakeIndexSequence<kNumColumns>());
+      return *this;
+    }
+
+    std::size_t index() const { return index_; }
+
+   private:
+    template <std::size_t... I>
+    std::tuple<Fields...> ToTupleImpl(IndexSequence<I...>) const {
+      return std::tuple<Fields...>(get<I>()...);
+    }
+
+    template <std::size_t... I>
+    void AssignImpl(const std::tuple<Fields...>& values,
+                    IndexSequence<I...>) const {
+      (void)Swallow{0, (get<I>() = std::get<I>(values), 0)...};
+    }
+
+    ContainerPointer container_;
+    std::size_t index_;
+  };
+
+  typedef BasicRowReference<false> RowReference;
+  typedef BasicRowReference<true> ConstRowReference;
+
+  // Random-access iterator over rows. Dereferencing yields a row proxy.
+  template <bool IsConst>
+  class BasicRowIterator {
+   public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef BasicRowReference<IsConst> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef BasicRowReference<IsConst> reference;
+
+    // There is no row object to point to, so operator-> returns a proxy that
+    // holds the row reference, e.g., it->get<0>().
+    class pointer {
+     public:
+      explicit pointer(const reference& row) : row_(row) {}
+      const reference* operator->() const { return &row_; }
+
+     private:
+      reference row_;
+    };
+
+    BasicRowIterator(typename value_type::ContainerPointer container,
+                     const std::size_t index)
+        : container_(container), index_(index) {}
+
+    reference operator*() const { return reference(container_, index_); }
+    pointer operator->() const {
+      return pointer(reference(container_, index_));
+    }
+    reference operator[](const difference_type offset) const {
+      return reference(container_, index_ + offset);
+    }
+
+    BasicRowIterator& operator++() { ++index_; return *this; }
+    BasicRowIterator& operator--() { --index_; return *this; }
+    BasicRowIterator operator++(int) {
+      BasicRowIterator copy = *this;
+      ++index_;
+      return copy;
+    }
+    BasicRowIterator operator--(int) {
+      BasicRowIterator copy = *this;
+      --index_;
+      return copy;
+    }
+    BasicRowIterator& operator+=(const difference_type offset) {
+      index_ += offset;
+      return *this;
+    }
+    BasicRowIterator& operator-=(const difference_type offset) {
+      index_ -= offset;
+      return *this;
+    }
+    BasicRowIterator operator+(const difference_type offset) const {
+      return BasicRowIterator(container_, index_ + offset);
+    }
+    friend BasicRowIterator operator+(const difference_type offset,
+                                      const BasicRowIterator& iterator) {
+      return iterator + offset;
+    }
+    BasicRowIterator operator-(const difference_type offset) const {
+      return BasicRowIterator(container_, index_ - offset);
+    }
+    difference_type operator-(const BasicRowIterator& other) const {
+      return static_cast<difference_type>(index_) -
+             static_cast<difference_type>(other.index_);
+    }
+
+    bool operator==(const BasicRowIterator& other) const {
+      return index_ == other.index_;
+    }
+    bool operator!=(const BasicRowIterator& other) const {
+      return index_ != other.index_;
+    }
+    bool operator<(const BasicRowIterator& other) const {
+      return index_ < other.index_;
+    }
+    bool operator>(const BasicRowIterator& other) const {
+      return index_ > other.index_;
+    }
+    bool operator<=(const BasicRowIterator& other) const {
+      return index_ <= other.index_;
+    }
+    bool operator>=(const BasicRowIterator& other) const {
+      return index_ >= other.index_;
+    }
+
+   private:
+    typename value_type::ContainerPointer container_;
+    std::size_t index_;
+  };
+
+  typedef BasicRowIterator<false> iterator;
+  typedef BasicRowIterator<true> const_iterator;
+
+  SoAVector() : size_(0), capacity_(0) { ResetColumns(); }
+
+  explicit SoAVector(const std::size_t size) : size_(0), capacity_(0) {
+    ResetColumns();
+    resize(size);
+  }
+
+  SoAVector(const SoAVector& other) : size_(0), capacity_(0) {
+    ResetColumns();
+    reserve(other.size_);
+    CopyConstructColumns(other, MakeIndexSequence<kNumColumns>());
+    size_ = other.size_;
+  }
+
+  SoAVector(SoAVector&& other)
+      : columns_(other.columns_),
+        size_(other.size_),
+        capacity_(other.capacity_) {
+    other.ResetColumns();
+    other.size_ = 0;
+    other.capacity_ = 0;
+  }
+
+  SoAVector& operator=(SoAVector other) {
+    swap(other);
+    return *this;
+  }
+
+  ~SoAVector() {
+    clear();
+    FreeColumns(columns_, MakeIndexSequence<kNumColumns>());
+  }
+
+  void swap(SoAVector& other) {
+    std::swap(columns_, other.columns_);
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+  }
+
+  std::size_t size() const { return size_; }
+  std::size_t capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+
+  // Allocates memory for at least new_capacity rows in every column.
+  void reserve(const std::size_t new_capacity) {
+    if (new_capacity <= capacity_) {
+      return;
+    }
+    std::tuple<Fields*...> new_columns;
+    AllocateColumns(&new_columns, new_capacity,
+                    MakeIndexSequence<kNumColumns>());
+    MoveColumns(&new_columns, MakeIndexSequence<kNumColumns>());
+    FreeColumns(columns_, MakeIndexSequence<kNumColumns>());
+    columns_ = new_columns;
+    capacity_ = new_capacity;
+  }
+
+  // Grows (value-initializing the new rows) or shrinks the container.
+  void resize(const std::size_t new_size) {
+    if (new_size < size_) {
+      DestroyRows(new_size, size_, MakeIndexSequence<kNumColumns>());
+    } else if (new_size > size_) {
+      GrowFor(new_size);
+      ConstructRows(size_, new_size, MakeIndexSequence<kNumColumns>());
+    }
+    size_ = new_size;
+  }
+
+  void clear() {
+    DestroyRows(0, size_, MakeIndexSequence<kNumColumns>());
+    size_ = 0;
+  }
+
+  // Appends a row given the value of each field.
+  void push_back(const Fields&... values) {
+    if (size_ == capacity_) {
+      // The values may refer to a row of this container, which GrowFor
+      // moves: copy them first.
+      std::tuple<Fields...> copy(values...);
+      GrowFor(size_ + 1);
+      MoveBackImpl(&copy, MakeIndexSequence<kNumColumns>());
+    } else {
+      PushBackImpl(MakeIndexSequence<kNumColumns>(), values...);
+    }
+    ++size_;
+  }
+
+  void push_back(const std::tuple<Fields...>& values) {
+    PushBackTuple(values, MakeIndexSequence<kNumColumns>());
+  }
+
+  void pop_back() {
+    assert(size_ > 0);
+    DestroyRows(size_ - 1, size_, MakeIndexSequence<kNumColumns>());
+    --size_;
+  }
+
+  // Access to the I-th field of a row.
+  template <std::size_t I>
+  FieldType<I>& get(const std::size_t row) {
+    assert(row < size_);
+    return std::get<I>(columns_)[row];
+  }
+
+  template <std::size_t I>
+  const FieldType<I>& get(const std::size_t row) const {
+    assert(row < size_);
+    return std::get<I>(columns_)[row];
+  }
+
+  // Contiguous view of the I-th field of all rows.
+  template <std::size_t I>
+  Span<FieldType<I> > column() {
+    return Span<FieldType<I> >(std::get<I>(columns_), size_);
+  }
+
+  template <std::size_t I>
+  Span<const FieldType<I> > column() const {
+    return Span<const FieldType<I> >(std::get<I>(columns_), size_);
+  }
+
+  RowReference operator[](const std::size_t row) {
+    assert(row < size_);
+    return RowReference(this, row);
+  }
+
+  ConstRowReference operator[](const std::size_t row) const {
+    assert(row < size_);
+    return ConstRowReference(this, row);
+  }
+
+  RowReference back() { return (*this)[size_ - 1]; }
+  ConstRowReference back() const { return (*this)[size_ - 1]; }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, size_); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size_); }
+
+ private:
+  void ResetColumns() {
+    ResetColumnsImpl(MakeIndexSequence<kNumColumns>());
+  }
+
+  template <std::size_t... I>
+  void ResetColumnsImpl(IndexSequence<I...>) {
+    (void)Swallow{0, (std::get<I>(columns_) = nullptr, 0)...};
+  }
+
+  // Grows the capacity geometrically so that appending is amortized O(1).
+  void GrowFor(const std::size_t required_size) {
+    if (required_size <= capacity_) {
+      return;
+    }
+    std::size_t new_capacity = capacity_ == 0 ? 16 : 2 * capacity_;
+    if (new_capacity < required_size) {
+      new_capacity = required_size;
+    }
+    reserve(new_capacity);
+  }
+
+  // Allocates every column, or none: if an allocation throws, the columns
+  // already allocated are freed.
+  template <std::size_t... I>
+  static void AllocateColumns(std::tuple<Fields*...>* columns,
+                              const std::size_t capacity,
+                              IndexSequence<I...>) {
+    (void)Swallow{0, (std::get<I>(*columns) = nullptr, 0)...};
+    try {
+      (void)Swallow{0, (std::get<I>(*columns) = static_cast<Fields*>(
+                            AlignedAllocate(kAlignment,
+                                            capacity * sizeof(Fields))),
+                        0)...};
+    } catch (...) {
+      FreeColumns(*columns, IndexSequence<I...>());
+      throw;
+    }
+  }
+
+  template <std::size_t... I>
+  static void FreeColumns(const std::tuple<Fields*...>& columns,
+                          IndexSequence<I...>) {
+    (void)Swallow{0, (AlignedFree(std::get<I>(columns)), 0)...};
+  }
+
+  template <typename T>
+  static void MoveColumn(T* source, T* destination, const std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+      ::new (static_cast<void*>(destination + i)) T(std::move(source[i]));
+      source[i].~T();
+    }
+  }
+
+  template <std::size_t... I>
+  void MoveColumns(std::tuple<Fields*...>* new_columns, IndexSequence<I...>) {
+    (void)Swallow{0, (MoveColumn(std::get<I>(columns_),
+                                 std::get<I>(*new_columns), size_),
+                      0)...};
+  }
+
+  template <typename T>
+  static void CopyColumn(const T* source, T* destination,
+                         const std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+      ::new (static_cast<void*>(destination + i)) T(source[i]);
+    }
+  }
+
+  template <std::size_t... I>
+  void CopyConstructColumns(const SoAVector& other, IndexSequence<I...>) {
+    (void)Swallow{0, (CopyColumn(std::get<I>(other.columns_),
+                                 std::get<I>(columns_), other.size_),
+                      0)...};
+  }
+
+  template <typename T>
+  static void ConstructColumn(T* column, const std::size_t begin,
+                              const std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      ::new (static_cast<void*>(column + i)) T();
+    }
+  }
+
+  template <std::size_t... I>
+  void ConstructRows(const std::size_t begin, const std::size_t end,
+                     IndexSequence<I...>) {
+    (void)Swallow{0, (ConstructColumn(std::get<I>(columns_), begin, end),
+                      0)...};
+  }
+
+  template <typename T>
+  static void DestroyColumn(T* column, const std::size_t begin,
+                            const std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      column[i].~T();
+    }
+  }
+
+  template <std::size_t... I>
+  void DestroyRows(const std::size_t begin, const std::size_t end,
+                   IndexSequence<I...>) {
+    (void)Swallow{0, (DestroyColumn(std::get<I>(columns_), begin, end),
+                      0)...};
+  }
+
+  template <std::size_t... I>
+  void PushBackImpl(IndexSequence<I...>, const Fields&... values) {
+    (void)Swallow{0, (::new (static_cast<void*>(std::get<I>(columns_) + size_))
+                          Fields(values),
+                      0)...};
+  }
+
+  template <std::size_t... I>
+  void MoveBackImpl(std::tuple<Fields...>* values, IndexSequence<I...>) {
+    (void)Swallow{0, (::new (static_cast<void*>(std::get<I>(columns_) + size_))
+                          Fields(std::move(std::get<I>(*values))),
+                      0)...};
+  }
+
+  template <std::size_t... I>
+  void PushBackTuple(const std::tuple<Fields...>& values,
+                     IndexSequence<I...>) {
+    push_back(std::get<I>(values)...);
+  }
+
+  std::tuple<Fields*...> columns_;
+  std::size_t size_;
+  std::size_t capacity_;
+};
+
+template <typename... Fields>
+const std::size_t SoAVector<Fields...>::kAlignment;
+template <typename... Fields>
+const std::size_t SoAVector<Fields...>::kNumColumns;
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_SOA_VECTOR_H_
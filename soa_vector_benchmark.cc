@@ -0,0 +1,180 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary compares scanning a single field of many records stored as an
+// array of structures (std::vector<Record>) against the same records stored
+// column by column (SoAVector).
+//
+// Usage: soa_vector_benchmark [num_records]  (default: 10000000)
+//
+// Notes:
+//
+// 1. Record below is 40 bytes, but the scans only read the 4-byte quantity
+// and the 8-byte price. With std::vector<Record> every cache line brought from
+// memory contains mostly bytes the loop never looks at.
+// 2. With SoAVector the quantity column is a packed array of int32_t, so the
+// loop reads only the bytes it needs and the compiler can vectorize it.
+
+#include <cstdint>  // Header for fixed width integers.
+#include <iostream>  // Header for printing to stdout.
+#include <random>  // Header for std::mt19937.
+#include <vector>  // Header for std::vector.
+
+#include "benchmark_utils.h"
+#include "soa_vector.h"
+
+namespace {
+
+// Array-of-structures version of the record.
+struct Record {
+  int64_t id;
+  double price;
+  int32_t quantity;
+  int32_t flags;
+  int64_t timestamp;
+  int64_t owner_id;
+};
+
+// Structure-of-arrays version of the same record. Column indices below.
+typedef cpp_labs::SoAVector<int64_t, double, int32_t, int32_t, int64_t,
+                            int64_t> RecordColumns;
+const std::size_t kPriceColumn = 1;
+const std::size_t kQuantityColumn = 2;
+
+const int kNumRepetitions = 10;
+const double kPriceThreshold = 50.0;
+
+int64_t SumQuantities(const std::vector<Record>& records) {
+  int64_t sum = 0;
+  for (const Record& record : records) {
+    sum += record.quantity;
+  }
+  return sum;
+}
+
+int64_t SumQuantities(const RecordColumns& records) {
+  int64_t sum = 0;
+  for (const int32_t quantity : records.column<kQuantityColumn>()) {
+    sum += quantity;
+  }
+  return sum;
+}
+
+std::size_t CountExpensive(const std::vector<Record>& records) {
+  std::size_t count = 0;
+  for (const Record& record : records) {
+    count += record.price > kPriceThreshold;
+  }
+  return count;
+}
+
+std::size_t CountExpensive(const RecordColumns& records) {
+  std::size_t count = 0;
+  for (const double price : records.column<kPriceColumn>()) {
+    count += price > kPriceThreshold;
+  }
+  return count;
+}
+
+// Runs the scan kNumRepetitions times and returns the best time in seconds.
+template <typename Function>
+double TimeScan(const Function& scan) {
+  double best_seconds = 1e30;
+  for (int i = 0; i < kNumRepetitions; ++i) {
+    cpp_labs::Timer timer;
+    cpp_labs::DoNotOptimize(scan());
+    const double seconds = timer.ElapsedSeconds();
+    if (seconds < best_seconds) {
+      best_seconds = seconds;
+    }
+  }
+  return best_seconds;
+}
+
+void PrintResult(const char* name, const std::size_t num_records,
+                 const std::size_t bytes_per_record, const double seconds) {
+  std::cout << name << ": " << seconds * 1e3 << " ms, "
+            << num_records / seconds / 1e6 << " M records/s, "
+            << num_records * bytes_per_record / seconds / 1e9
+            << " GB/s useful" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t num_records =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, 10000000);
+
+  std::mt19937 random_engine(42);
+  std::uniform_real_distribution<double> price_distribution(0.0, 100.0);
+  std::uniform_int_distribution<int32_t> quantity_distribution(0, 1000);
+
+  std::vector<Record> aos_records;
+  RecordColumns soa_records;
+  aos_records.reserve(num_records);
+  soa_records.reserve(num_records);
+  for (std::size_t i = 0; i < num_records; ++i) {
+    Record record;
+    record.id = i;
+    record.price = price_distribution(random_engine);
+    record.quantity = quantity_distribution(random_engine);
+    record.flags = 0;
+    record.timestamp = 1000 * i;
+    record.owner_id = i % 1000;
+    aos_records.push_back(record);
+    soa_records.push_back(record.id, record.price, record.quantity,
+                          record.flags, record.timestamp, record.owner_id);
+  }
+
+  // Sanity check: both layouts must agree.
+  if (SumQuantities(aos_records) != SumQuantities(soa_records) ||
+      CountExpensive(aos_records) != CountExpensive(soa_records)) {
+    std::cerr << "Layouts disagree!" << std::endl;
+    return 1;
+  }
+
+  std::cout << "Records: " << num_records << " (sizeof(Record) = "
+            << sizeof(Record) << " bytes)" << std::endl;
+  std::cout << "Sum of quantity:\n";
+  PrintResult("  std::vector<Record>", num_records, sizeof(int32_t),
+              TimeScan([&]() { return SumQuantities(aos_records); }));
+  PrintResult("  SoAVector          ", num_records, sizeof(int32_t),
+              TimeScan([&]() { return SumQuantities(soa_records); }));
+  std::cout << "Count of price > " << kPriceThreshold << ":\n";
+  PrintResult("  std::vector<Record>", num_records, sizeof(double),
+              TimeScan([&]() { return CountExpensive(aos_records); }));
+  PrintResult("  SoAVector          ", num_records, sizeof(double),
+              TimeScan([&]() { return CountExpensive(soa_records); }));
+  return 0;
+}
@@ -0,0 +1,516 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_SORTED_SET_OPS_H_
+#define CPP_LABS_SORTED_SET_OPS_H_
+
+// Intersection, union and difference of sets of ids stored as sorted arrays.
+//
+// A std::set<int> (set_example.cc) stores every id in a tree node of ~40
+// bytes, and std::set_intersection walks two of them one element (and one
+// cache miss) at a time. A sorted std::vector<uint32_t> stores 4 bytes per id,
+// contiguously, and allows faster algorithms:
+//
+// 1. IntersectSimd (balanced sizes): compares a block of 4 ids of one array
+// with a block of 4 ids of the other in a few SSE2 instructions (8 by 8 with
+// AVX2; build with -DBUILD_WITH_NATIVE_ARCH=ON), instead of a branch per
+// comparison that the CPU mispredicts half of the time.
+// 2. IntersectGalloping (skewed sizes): for every id of the small array,
+// searches the large one from the last position with steps of 1, 2, 4, ...
+// and then a binary search: O(small * log(large / small)) instead of
+// O(small + large).
+// 3. Intersect, Union and Difference pick between the two by the ratio of the
+// sizes (kGallopingRatio); galloping unions and differences copy the runs of
+// the large array between the ids of the small one.
+// 4. IntersectMany starts from the smallest array, and UnionMany merges the
+// arrays in pairs, in log2(k) passes instead of k - 1.
+//
+// Usage:
+//
+//   std::vector<uint32_t> ids_1 = SortedIdsFromSet(my_integers_set);
+//   std::vector<uint32_t> ids_2 = SortedIdsFromUnorderedSet(my_hash_set);
+//   std::vector<uint32_t> common;
+//   Intersect(ids_1, ids_2, &common);
+//
+// Inputs must be sorted and without duplicates, and so are the outputs. The
+// pointer versions write to output, which must have room for the largest
+// possible result (the smaller size for an intersection, the sum of the sizes
+// for a union, the size of the first array for a difference), and return the
+// size of the result. The scalar and galloping versions work with any integer
+// type (RoaringBitmap uses them with uint16_t); the SIMD ones take uint32_t.
+// roaring_bitmap.h compresses dense sets further.
+
+#include <algorithm>  // Header for std::copy, std::lower_bound and std::sort.
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for uint32_t.
+#include <set>  // Header for std::set.
+#include <unordered_set>  // Header for std::unordered_set.
+#include <vector>  // Header for std::vector.
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>  // Header for the SIMD intrinsics.
+#endif
+
+namespace cpp_labs {
+
+// Above this ratio of sizes, galloping beats a linear merge.
+const std::size_t kGallopingRatio = 32;
+
+namespace internal {
+
+// Returns the first index in [begin, size) with array[index] >= value,
+// searching from begin with exponentially growing steps.
+template <typename T>
+std::size_t GallopTo(const T* array, const std::size_t size, std::size_t begin,
+                     const T value) {
+  std::size_t end = begin;
+  std::size_t step = 1;
+  while (end < size && array[end] < value) {
+    begin = end + 1;
+    end += step;
+    step <<= 1;
+  }
+  if (end > size) {
+    end = size;
+  }
+  return std::lower_bound(array + begin, array + end, value) - array;
+}
+
+#if defined(__AVX2__)
+
+// Ids per block of the SIMD kernels.
+const std::size_t kSimdBlock = 8;
+
+// Returns a mask with bit k set if a[k] is in b[0, 8).
+inline unsigned BlockMatchMask(const uint32_t* a, const uint32_t* b) {
+  const __m256i block_a =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+  __m256i block_b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+  const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+  __m256i matches = _mm256_cmpeq_epi32(block_a, block_b);
+  for (int i = 1; i < 8; ++i) {
+    block_b = _mm256_permutevar8x32_epi32(block_b, rotate);
+    matches = _mm256_or_si256(matches, _mm256_cmpeq_epi32(block_a, block_b));
+  }
+  return static_cast<unsigned>(
+      _mm256_movemask_ps(_mm256_castsi256_ps(matches)));
+}
+
+#elif defined(__SSE2__)
+
+const std::size_t kSimdBlock = 4;
+
+// Returns a mask with bit k set if a[k] is in b[0, 4).
+inline unsigned BlockMatchMask(const uint32_t* a, const uint32_t* b) {
+  const __m128i block_a =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+  const __m128i block_b =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+  __m128i matches = _mm_cmpeq_epi32(block_a, block_b);
+  matches = _mm_or_si128(
+      matches,
+      _mm_cmpeq_epi32(block_a,
+                      _mm_shuffle_epi32(block_b, _MM_SHUFFLE(0, 3, 2, 1))));
+  matches = _mm_or_si128(
+      matches,
+      _mm_cmpeq_epi32(block_a,
+                      _mm_shuffle_epi32(block_b, _MM_SHUFFLE(1, 0, 3, 2))));
+  matches = _mm_or_si128(
+      matches,
+      _mm_cmpeq_epi32(block_a,
+                      _mm_shuffle_epi32(block_b, _MM_SHUFFLE(2, 1, 0, 3))));
+  return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(matches)));
+}
+
+#else
+
+const std::size_t kSimdBlock = 4;
+
+inline unsigned BlockMatchMask(const uint32_t* a, const uint32_t* b) {
+  unsigned mask = 0;
+  for (std::size_t i = 0; i < kSimdBlock; ++i) {
+    for (std::size_t j = 0; j < kSimdBlock; ++j) {
+      mask |= static_cast<unsigned>(a[i] == b[j]) << i;
+    }
+  }
+  return mask;
+}
+
+#endif  // defined(__AVX2__)
+
+// Appends block[k] to output for every bit k of mask.
+inline std::size_t WriteMasked(const uint32_t* block, unsigned mask,
+                               uint32_t* output) {
+  std::size_t count = 0;
+  while (mask != 0) {
+    output[count++] = block[__builtin_ctz(mask)];
+    mask &= mask - 1;
+  }
+  return count;
+}
+
+}  // namespace internal
+
+// Intersection with a linear merge.
+template <typename T>
+std::size_t IntersectScalar(const T* a, const std::size_t size_a, const T* b,
+                            const std::size_t size_b, T* output) {
+  std::size_t i = 0;
+  std::size_t j = 0;
+  std::size_t count = 0;
+  while (i < size_a && j < size_b) {
+    if (a[i] < b[j]) {
+      ++i;
+    } else if (b[j] < a[i]) {
+      ++j;
+    } else {
+      output[count++] = a[i];
+      ++i;
+      ++j;
+    }
+  }
+  return count;
+}
+
+// Intersection by searching every id of small in large; best when large is
+// much larger than small.
+template <typename T>
+std::size_t IntersectGalloping(const T* small, const std::size_t size_small,
+                               const T* large, const std::size_t size_large,
+                               T* output) {
+  std::size_t position = 0;
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < size_small; ++i) {
+    position = internal::GallopTo(large, size_large, position, small[i]);
+    if (position == size_large) {
+      break;
+    }
+    if (large[position] == small[i]) {
+      output[count++] = small[i];
+      ++position;
+    }
+  }
+  return count;
+}
+
+// Intersection comparing blocks of kSimdBlock ids at a time.
+inline std::size_t IntersectSimd(const uint32_t* a, const std::size_t size_a,
+                                 const uint32_t* b, const std::size_t size_b,
+                                 uint32_t* output) {
+  const std::size_t block = internal::kSimdBlock;
+  std::size_t i = 0;
+  std::size_t j = 0;
+  std::size_t count = 0;
+  // Each block of a meets every block of b whose range overlaps its own, so
+  // every common id is found exactly once.
+  while (i + block <= size_a && j + block <= size_b) {
+    const uint32_t last_a = a[i + block - 1];
+    const uint32_t last_b = b[j + block - 1];
+    count += internal::WriteMasked(
+        a + i, internal::BlockMatchMask(a + i, b + j), output + count);
+    if (last_a <= last_b) {
+      i += block;
+    }
+    if (last_b <= last_a) {
+      j += block;
+    }
+  }
+  // Ids already matched precede b + j, so they are not matched again.
+  return count + IntersectScalar(a + i, size_a - i, b + j, size_b - j,
+                                 output + count);
+}
+
+// Intersection with the best algorithm for the sizes.
+inline std::size_t Intersect(const uint32_t* a, const std::size_t size_a,
+                             const uint32_t* b, const std::size_t size_b,
+                             uint32_t* output) {
+  if (size_a > size_b) {
+    return Intersect(b, size_b, a, size_a, output);
+  }
+  if (size_a * kGallopingRatio < size_b) {
+    return IntersectGalloping(a, size_a, b, size_b, output);
+  }
+  return IntersectSimd(a, size_a, b, size_b, output);
+}
+
+inline void Intersect(const std::vector<uint32_t>& a,
+                      const std::vector<uint32_t>& b,
+                      std::vector<uint32_t>* output) {
+  output->resize(std::min(a.size(), b.size()));
+  output->resize(
+      Intersect(a.data(), a.size(), b.data(), b.size(), output->data()));
+}
+
+// Intersection of every array in sets, from the smallest up, so that the
+// partial result only shrinks (and galloping applies early).
+inline void IntersectMany(const std::vector<const std::vector<uint32_t>*>& sets,
+                          std::vector<uint32_t>* output) {
+  output->clear();
+  if (sets.empty()) {
+    return;
+  }
+  std::vector<const std::vector<uint32_t>*> by_size(sets);
+  std::sort(by_size.begin(), by_size.end(),
+            [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b) {
+              return a->size() < b->size();
+            });
+  *output = *by_size[0];
+  for (std::size_t k = 1; k < by_size.size() && !output->empty(); ++k) {
+    // The output of Intersect may alias its first input.
+    output->resize(Intersect(output->data(), output->size(),
+                             by_size[k]->data(), by_size[k]->size(),
+                             output->data()));
+  }
+}
+
+// Union of two arrays with a linear merge; output has room for size_a + size_b
+// ids.
+template <typename T>
+std::size_t UnionScalar(const T* a, const std::size_t size_a, const T* b,
+                        const std::size_t size_b, T* output) {
+  std::size_t i = 0;
+  std::size_t j = 0;
+  std::size_t count = 0;
+  while (i < size_a && j < size_b) {
+    const T id_a = a[i];
+    const T id_b = b[j];
+    // Without branches on the comparison, which is unpredictable.
+    output[count++] = id_a < id_b ? id_a : id_b;
+    i += id_a <= id_b;
+    j += id_b <= id_a;
+  }
+  std::copy(a + i, a + size_a, output + count);
+  count += size_a - i;
+  std::copy(b + j, b + size_b, output + count);
+  return count + size_b - j;
+}
+
+// Union of two arrays that searches large for every id of small and copies
+// the runs of large in between; best when large is much larger than small.
+template <typename T>
+std::size_t UnionGalloping(const T* small, const std::size_t size_small,
+                           const T* large, const std::size_t size_large,
+                           T* output) {
+  std::size_t position = 0;
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < size_small; ++i) {
+    const std::size_t next =
+        internal::GallopTo(large, size_large, position, small[i]);
+    std::copy(large + position, large + next, output + count);
+    count += next - position;
+    output[count++] = small[i];
+    position = next < size_large && large[next] == small[i] ? next + 1 : next;
+  }
+  std::copy(large + position, large + size_large, output + count);
+  return count + size_large - position;
+}
+
+// Union with the best algorithm for the sizes.
+template <typename T>
+std::size_t Union(const T* a, const std::size_t size_a, const T* b,
+                  const std::size_t size_b, T* output) {
+  if (size_a * kGallopingRatio < size_b) {
+    return UnionGalloping(a, size_a, b, size_b, output);
+  }
+  if (size_b * kGallopingRatio < size_a) {
+    return UnionGalloping(b, size_b, a, size_a, output);
+  }
+  return UnionScalar(a, size_a, b, size_b, output);
+}
+
+inline void Union(const std::vector<uint32_t>& a,
+                  const std::vector<uint32_t>& b,
+                  std::vector<uint32_t>* output) {
+  output->resize(a.size() + b.size());
+  output->resize(Union(a.data(), a.size(), b.data(), b.size(),
+                       output->data()));
+}
+
+// Union of every array in sets, merged in pairs in a balanced tree: log2(k)
+// passes over the ids, instead of the k - 1 passes (over ever longer results)
+// of a chain of unions. (A k-way merge with a heap makes one pass, but its
+// log2(k) unpredictable comparisons per id make it slower than this.)
+inline void UnionMany(const std::vector<const std::vector<uint32_t>*>& sets,
+                      std::vector<uint32_t>* output) {
+  output->clear();
+  if (sets.empty()) {
+    return;
+  }
+  if (sets.size() == 1) {
+    *output = *sets[0];
+    return;
+  }
+  // The results of the current level of the tree.
+  std::vector<std::vector<uint32_t> > level((sets.size() + 1) / 2);
+  for (std::size_t k = 0; k < level.size(); ++k) {
+    if (2 * k + 1 < sets.size()) {
+      Union(*sets[2 * k], *sets[2 * k + 1], &level[k]);
+    } else {
+      level[k] = *sets[2 * k];
+    }
+  }
+  while (level.size() > 1) {
+    std::vector<std::vector<uint32_t> > next((level.size() + 1) / 2);
+    for (std::size_t k = 0; k < next.size(); ++k) {
+      if (2 * k + 1 < level.size()) {
+        Union(level[2 * k], level[2 * k + 1], &next[k]);
+      } else {
+        next[k].swap(level[2 * k]);
+      }
+    }
+    level.swap(next);
+  }
+  output->swap(level[0]);
+}
+
+// The ids of a that are not in b, with a linear merge.
+template <typename T>
+std::size_t DifferenceScalar(const T* a, const std::size_t size_a, const T* b,
+                             const std::size_t size_b, T* output) {
+  std::size_t j = 0;
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < size_a; ++i) {
+    while (j < size_b && b[j] < a[i]) {
+      ++j;
+    }
+    if (j == size_b || b[j] != a[i]) {
+      output[count++] = a[i];
+    }
+  }
+  return count;
+}
+
+// The ids of a that are not in b, searching the larger array for the ids of
+// the smaller one; best when their sizes differ a lot.
+template <typename T>
+std::size_t DifferenceGalloping(const T* a, const std::size_t size_a,
+                                const T* b, const std::size_t size_b,
+                                T* output) {
+  std::size_t position = 0;
+  std::size_t count = 0;
+  if (size_a <= size_b) {
+    for (std::size_t i = 0; i < size_a; ++i) {
+      position = internal::GallopTo(b, size_b, position, a[i]);
+      if (position == size_b || b[position] != a[i]) {
+        output[count++] = a[i];
+      }
+    }
+    return count;
+  }
+  // Copies the runs of a between the ids of b.
+  for (std::size_t j = 0; j < size_b && position < size_a; ++j) {
+    const std::size_t next = internal::GallopTo(a, size_a, position, b[j]);
+    std::copy(a + position, a + next, output + count);
+    count += next - position;
+    position = next < size_a && a[next] == b[j] ? next + 1 : next;
+  }
+  std::copy(a + position, a + size_a, output + count);
+  return count + size_a - position;
+}
+
+// The ids of a that are not in b, comparing blocks of kSimdBlock ids.
+inline std::size_t DifferenceSimd(const uint32_t* a, const std::size_t size_a,
+                                  const uint32_t* b, const std::size_t size_b,
+                                  uint32_t* output) {
+  const std::size_t block = internal::kSimdBlock;
+  const unsigned all = (1u << block) - 1;
+  std::size_t i = 0;
+  std::size_t j = 0;
+  std::size_t count = 0;
+  // The ids of the block of a found in the blocks of b seen so far; the block
+  // is written once it has met all the blocks that may hold its ids.
+  unsigned found = 0;
+  while (i + block <= size_a && j + block <= size_b) {
+    found |= internal::BlockMatchMask(a + i, b + j);
+    const uint32_t last_a = a[i + block - 1];
+    const uint32_t last_b = b[j + block - 1];
+    if (last_a <= last_b) {
+      count += internal::WriteMasked(a + i, ~found & all, output + count);
+      found = 0;
+      i += block;
+    }
+    if (last_b <= last_a) {
+      j += block;
+    }
+  }
+  // The rest, skipping the ids of the current block already found in b.
+  for (; i < size_a; ++i, found >>= 1) {
+    if ((found & 1) != 0) {
+      continue;
+    }
+    while (j < size_b && b[j] < a[i]) {
+      ++j;
+    }
+    if (j == size_b || b[j] != a[i]) {
+      output[count++] = a[i];
+    }
+  }
+  return count;
+}
+
+// The ids of a that are not in b, with the best algorithm for the sizes.
+inline std::size_t Difference(const uint32_t* a, const std::size_t size_a,
+                              const uint32_t* b, const std::size_t size_b,
+                              uint32_t* output) {
+  if (size_a * kGallopingRatio < size_b ||
+      size_b * kGallopingRatio < size_a) {
+    return DifferenceGalloping(a, size_a, b, size_b, output);
+  }
+  return DifferenceSimd(a, size_a, b, size_b, output);
+}
+
+inline void Difference(const std::vector<uint32_t>& a,
+                       const std::vector<uint32_t>& b,
+                       std::vector<uint32_t>* output) {
+  output->resize(a.size());
+  output->resize(
+      Difference(a.data(), a.size(), b.data(), b.size(), output->data()));
+}
+
+// Conversions from the standard sets; ids must not be negative.
+inline std::vector<uint32_t> SortedIdsFromSet(const std::set<int>& set) {
+  // Already in order.
+  return std::vector<uint32_t>(set.begin(), set.end());
+}
+
+inline std::vector<uint32_t> SortedIdsFromUnorderedSet(
+    const std::unordered_set<int>& set) {
+  std::vector<uint32_t> ids(set.begin(), set.end());
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_SORTED_SET_OPS_H_
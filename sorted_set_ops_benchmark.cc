@@ -0,0 +1,353 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary compares the set operations of sorted_set_ops.h and
+// roaring_bitmap.h against std::set_intersection, std::set_union and
+// std::set_difference on sorted arrays of ids.
+//
+// Usage: sorted_set_ops_benchmark [min_ids] [max_ids]
+//   Defaults: min_ids = 1M, max_ids = 1G. The sizes grow 4 times per step
+//   from min_ids to max_ids, and stop where the arrays would take more than
+//   half of the physical memory (~16 bytes per id).
+//
+// For every size n it builds two kinds of inputs:
+//
+// 1. balanced: two sets of ~n ids, each id of [0, 2n) in either with
+// probability 1/2 (so they share ~n/2 ids).
+// 2. skewed: a set of ~n ids as above and a set of ~n/1000 ids.
+//
+// and reports milliseconds for the intersection, union and difference with
+// the standard algorithms, the merge, SIMD and galloping versions, the
+// automatic choice (Intersect, Union, Difference) and the Roaring bitmaps
+// (without building them, whose size is also shown). The last row of each size
+// is the union of 8 sets of ~n/8 ids: chained std::set_union calls against
+// UnionMany (pairs of merges in a tree) and chained Or. A "mismatch" marks
+// results that differ from the standard algorithm's, and makes the binary
+// return 1.
+
+#include <algorithm>  // Header for std::set_intersection and std::equal.
+#include <cstdint>  // Header for uint32_t.
+#include <functional>  // Header for std::function.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <iterator>  // Header for std::back_inserter.
+#include <string>  // Header for std::string.
+#include <unistd.h>  // Header for sysconf.
+#include <vector>  // Header for std::vector.
+
+#include "benchmark_utils.h"
+#include "roaring_bitmap.h"
+#include "sorted_set_ops.h"
+
+namespace {
+
+typedef std::vector<uint32_t> Ids;
+
+// Fast random numbers.
+inline uint64_t NextRandom(uint64_t* state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+// The ids of [0, universe) drawn with probability 1 / period, in order.
+Ids SampleIds(const uint64_t universe, const uint64_t period, uint64_t seed) {
+  Ids ids;
+  ids.reserve(universe / period + universe / period / 8 + 16);
+  for (uint64_t id = 0; id < universe; ++id) {
+    if (NextRandom(&seed) % period == 0) {
+      ids.push_back(static_cast<uint32_t>(id));
+    }
+  }
+  return ids;
+}
+
+// Milliseconds of the fastest of a few runs of function, which returns the
+// size of its result.
+template <typename Function>
+double Milliseconds(const std::size_t n, const Function& function,
+                    std::size_t* result_size) {
+  const int repetitions = n <= (1 << 22) ? 5 : 1;
+  double best = 1e30;
+  for (int i = 0; i < repetitions; ++i) {
+    cpp_labs::Timer timer;
+    *result_size = function();
+    best = std::min(best, timer.ElapsedSeconds() * 1e3);
+  }
+  return best;
+}
+
+const int kColumnWidth = 11;
+
+// Prints one row of results: the time of the standard algorithm first, then
+// the others (negative if not applicable).
+void PrintRow(const std::string& name, const std::vector<double>& times,
+              const bool mismatch) {
+  std::cout << std::setw(26) << name;
+  for (const double time : times) {
+    if (time < 0.0) {
+      std::cout << std::setw(kColumnWidth) << "-";
+    } else {
+      std::cout << std::setw(kColumnWidth) << time;
+    }
+  }
+  std::cout << (mismatch ? "  mismatch" : "") << std::endl;
+}
+
+// Runs the three operations on a and b. Returns false if any result differs
+// from the standard algorithm's.
+bool CompareOperations(const std::string& name, const Ids& a, const Ids& b,
+                       Ids* output) {
+  const cpp_labs::RoaringBitmap roaring_a =
+      cpp_labs::RoaringBitmap::FromSorted(a.data(), a.size());
+  const cpp_labs::RoaringBitmap roaring_b =
+      cpp_labs::RoaringBitmap::FromSorted(b.data(), b.size());
+  const std::size_t n = std::max(a.size(), b.size());
+  output->resize(a.size() + b.size());
+  uint32_t* out = output->data();
+  Ids expected;
+  bool mismatch = false;
+  bool correct = true;
+  std::vector<double> times;
+  // Records the time of the standard algorithm, which writes to out, and
+  // keeps its result.
+  auto run_std = [&](const std::function<std::size_t()>& function) {
+    std::size_t size = 0;
+    times.push_back(Milliseconds(n, function, &size));
+    expected.assign(out, out + size);
+  };
+  // Records the time of an operation that writes to out, and whether its
+  // result matches.
+  auto run = [&](const std::function<std::size_t()>& function) {
+    std::size_t size = 0;
+    times.push_back(Milliseconds(n, function, &size));
+    mismatch |= size != expected.size() ||
+                !std::equal(expected.begin(), expected.end(), out);
+  };
+  // The same for an operation on the Roaring bitmaps.
+  auto run_roaring =
+      [&](const std::function<cpp_labs::RoaringBitmap()>& function) {
+        cpp_labs::RoaringBitmap result;
+        std::size_t size = 0;
+        times.push_back(Milliseconds(n, [&]() {
+          result = function();
+          return result.cardinality();
+        }, &size));
+        Ids ids;
+        result.ToVector(&ids);
+        mismatch |= ids != expected;
+      };
+
+  run_std([&]() {
+    return std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), out) -
+           out;
+  });
+  run([&]() {
+    return cpp_labs::IntersectScalar(a.data(), a.size(), b.data(), b.size(),
+                                     out);
+  });
+  run([&]() {
+    return cpp_labs::IntersectSimd(a.data(), a.size(), b.data(), b.size(),
+                                   out);
+  });
+  run([&]() {
+    return a.size() <= b.size()
+               ? cpp_labs::IntersectGalloping(a.data(), a.size(), b.data(),
+                                              b.size(), out)
+               : cpp_labs::IntersectGalloping(b.data(), b.size(), a.data(),
+                                              a.size(), out);
+  });
+  run([&]() {
+    return cpp_labs::Intersect(a.data(), a.size(), b.data(), b.size(), out);
+  });
+  run_roaring([&]() { return And(roaring_a, roaring_b); });
+  PrintRow(name + " intersection", times, mismatch);
+  correct &= !mismatch;
+
+  times.clear();
+  mismatch = false;
+  run_std([&]() {
+    return std::set_union(a.begin(), a.end(), b.begin(), b.end(), out) - out;
+  });
+  run([&]() {
+    return cpp_labs::UnionScalar(a.data(), a.size(), b.data(), b.size(), out);
+  });
+  times.push_back(-1.0);
+  run([&]() {
+    return a.size() <= b.size()
+               ? cpp_labs::UnionGalloping(a.data(), a.size(), b.data(),
+                                          b.size(), out)
+               : cpp_labs::UnionGalloping(b.data(), b.size(), a.data(),
+                                          a.size(), out);
+  });
+  run([&]() {
+    return cpp_labs::Union(a.data(), a.size(), b.data(), b.size(), out);
+  });
+  run_roaring([&]() { return Or(roaring_a, roaring_b); });
+  PrintRow(name + " union", times, mismatch);
+  correct &= !mismatch;
+
+  times.clear();
+  mismatch = false;
+  run_std([&]() {
+    return std::set_difference(a.begin(), a.end(), b.begin(), b.end(), out) -
+           out;
+  });
+  run([&]() {
+    return cpp_labs::DifferenceScalar(a.data(), a.size(), b.data(), b.size(),
+                                      out);
+  });
+  run([&]() {
+    return cpp_labs::DifferenceSimd(a.data(), a.size(), b.data(), b.size(),
+                                    out);
+  });
+  run([&]() {
+    return cpp_labs::DifferenceGalloping(a.data(), a.size(), b.data(),
+                                         b.size(), out);
+  });
+  run([&]() {
+    return cpp_labs::Difference(a.data(), a.size(), b.data(), b.size(), out);
+  });
+  run_roaring([&]() { return AndNot(roaring_a, roaring_b); });
+  PrintRow(name + " difference", times, mismatch);
+  correct &= !mismatch;
+
+  std::cout << std::setw(26) << name + " MB (arrays)" << std::setw(kColumnWidth)
+            << (a.size() + b.size()) * sizeof(uint32_t) / 1e6 << std::setw(
+                   kColumnWidth * 5)
+            << (roaring_a.bytes() + roaring_b.bytes()) / 1e6 << std::endl;
+  return correct;
+}
+
+// The union of 8 sets: a chain of std::set_union against UnionMany (shown in
+// the merge and automatic columns) and a chain of Or. Returns false if a
+// result differs from the chain of std::set_union.
+bool CompareUnionMany(const uint64_t n) {
+  const int kNumSets = 8;
+  std::vector<Ids> sets;
+  std::vector<const Ids*> pointers;
+  std::vector<cpp_labs::RoaringBitmap> bitmaps;
+  for (int k = 0; k < kNumSets; ++k) {
+    // Each id of [0, 2n) with probability 1/16.
+    sets.push_back(SampleIds(2 * n, 16, 1000 + k));
+    bitmaps.push_back(cpp_labs::RoaringBitmap::FromSorted(sets.back().data(),
+                                                          sets.back().size()));
+  }
+  for (const Ids& set : sets) {
+    pointers.push_back(&set);
+  }
+  Ids expected;
+  std::size_t size = 0;
+  std::vector<double> times;
+  times.push_back(Milliseconds(n, [&]() {
+    Ids result;
+    Ids next;
+    for (const Ids& set : sets) {
+      next.clear();
+      std::set_union(result.begin(), result.end(), set.begin(), set.end(),
+                     std::back_inserter(next));
+      result.swap(next);
+    }
+    expected.swap(result);
+    return expected.size();
+  }, &size));
+  Ids result;
+  times.push_back(Milliseconds(n, [&]() {
+    cpp_labs::UnionMany(pointers, &result);
+    return result.size();
+  }, &size));
+  bool mismatch = result != expected;
+  times.push_back(-1.0);
+  times.push_back(-1.0);
+  times.push_back(times[1]);
+  cpp_labs::RoaringBitmap bitmap_result;
+  times.push_back(Milliseconds(n, [&]() {
+    bitmap_result = bitmaps[0];
+    for (int k = 1; k < kNumSets; ++k) {
+      bitmap_result = Or(bitmap_result, bitmaps[k]);
+    }
+    return bitmap_result.cardinality();
+  }, &size));
+  bitmap_result.ToVector(&result);
+  mismatch |= result != expected;
+  PrintRow("union of 8 (n/8 each)", times, mismatch);
+  return !mismatch;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const uint64_t min_ids = cpp_labs::ParseSizeArgument(argc, argv, 1, 1 << 20);
+  uint64_t max_ids = cpp_labs::ParseSizeArgument(argc, argv, 2, 1 << 30);
+  const uint64_t physical_bytes =
+      static_cast<uint64_t>(sysconf(_SC_PHYS_PAGES)) *
+      static_cast<uint64_t>(sysconf(_SC_PAGE_SIZE));
+  // Two inputs of 4 bytes per id and an output of 8.
+  if (max_ids > physical_bytes / 2 / 16) {
+    max_ids = physical_bytes / 2 / 16;
+    std::cout << "Sizes limited to " << max_ids
+              << " ids (half of the physical memory).\n";
+  }
+  // Ids are below 2n, and must fit in 32 bits.
+  if (max_ids > (uint64_t(1) << 31)) {
+    max_ids = uint64_t(1) << 31;
+  }
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "Milliseconds (fastest of 5 runs up to 4M ids)\n"
+            << std::setw(26) << "" << std::setw(kColumnWidth) << "std::"
+            << std::setw(kColumnWidth) << "merge" << std::setw(kColumnWidth)
+            << "SIMD" << std::setw(kColumnWidth) << "galloping"
+            << std::setw(kColumnWidth) << "automatic"
+            << std::setw(kColumnWidth) << "Roaring" << std::endl;
+  Ids output;
+  bool correct = true;
+  for (uint64_t n = min_ids; n <= max_ids; n *= 4) {
+    std::cout << "n = " << n << " ids\n";
+    {
+      const Ids a = SampleIds(2 * n, 2, 1);
+      const Ids b = SampleIds(2 * n, 2, 2);
+      correct &= CompareOperations("balanced", a, b, &output);
+    }
+    {
+      const Ids a = SampleIds(2 * n, 2, 1);
+      const Ids b = SampleIds(2 * n, 2000, 3);
+      correct &= CompareOperations("skewed", a, b, &output);
+    }
+    correct &= CompareUnionMany(n);
+    Ids().swap(output);
+  }
+  return correct ? 0 : 1;
+}
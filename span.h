@@ -0,0 +1,92 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_SPAN_H_
+#define CPP_LABS_SPAN_H_
+
+// A non-owning view over a contiguous array, similar to C++20's std::span.
+// A span is just a pointer and a size, so it is cheap to pass by value. It
+// lets a function iterate over the elements of a std::vector, a plain array or
+// a column of a container without knowing (or copying) the container.
+
+#include <cassert>  // Header for assert.
+#include <cstddef>  // Header for std::size_t.
+#include <vector>  // Header for std::vector.
+
+namespace cpp_labs {
+
+template <typename T>
+class Span {
+ public:
+  typedef T value_type;
+  typedef T* iterator;
+  typedef std::size_t size_type;
+
+  Span() : data_(nullptr), size_(0) {}
+  Span(T* data, const std::size_t size) : data_(data), size_(size) {}
+  template <std::size_t N>
+  Span(T (&array)[N]) : data_(array), size_(N) {}
+  template <typename U, typename Allocator>
+  Span(std::vector<U, Allocator>& vector)
+      : data_(vector.data()), size_(vector.size()) {}
+  template <typename U, typename Allocator>
+  Span(const std::vector<U, Allocator>& vector)
+      : data_(vector.data()), size_(vector.size()) {}
+
+  T* data() const { return data_; }
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  T* begin() const { return data_; }
+  T* end() const { return data_ + size_; }
+
+  T& operator[](const std::size_t index) const {
+    assert(index < size_);
+    return data_[index];
+  }
+
+  // Returns the view of count elements starting at offset.
+  Span subspan(const std::size_t offset, const std::size_t count) const {
+    assert(offset + count <= size_);
+    return Span(data_ + offset, count);
+  }
+
+ private:
+  T* data_;
+  std::size_t size_;
+};
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_SPAN_H_
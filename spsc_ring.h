@@ -0,0 +1,243 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_SPSC_RING_H_
+#define CPP_LABS_SPSC_RING_H_
+
+// SpscRing<T> is a bounded queue for exactly one producer thread and one
+// consumer thread. With a single thread on each side no compare-and-swap is
+// needed: the producer owns tail_ and the consumer owns head_, and each side
+// publishes its index with a release store.
+//
+// Two details keep the cache traffic low:
+//
+// 1. head_ and tail_ live in different cache lines, so the producer writing
+// tail_ does not invalidate the line the consumer writes (false sharing).
+// 2. Each side keeps a cached copy of the other side's index and only reloads
+// it when the cached value says the ring is full (producer) or empty
+// (consumer). Most operations then touch no shared index at all.
+//
+// push_batch/pop_batch move several elements while publishing the index once,
+// which amortizes the synchronization over the batch. push/pop (and the
+// blocking batch variants) sleep on a FutexEvent when they cannot progress.
+// Only the blocking variants signal the other side, so a ring used with
+// try_* alone never pays for waking up threads; a thread blocked in pop is
+// woken up by push (and one blocked in push by pop), so use the blocking
+// variants on both sides when either side blocks.
+//
+// Example:
+//   SpscRing<uint64_t> ring(4096);
+//   ring.push_batch(values, 64);                   // Producer thread.
+//   const std::size_t n = ring.pop_batch(out, 64);  // Consumer thread.
+
+#include <atomic>  // Header for std::atomic.
+#include <cstddef>  // Header for std::size_t.
+#include <new>  // Header for placement new.
+#include <utility>  // Header for std::move and std::forward.
+
+#include "aligned_memory.h"
+#include "futex_event.h"
+
+namespace cpp_labs {
+
+template <typename T>
+class SpscRing {
+ public:
+  // capacity is rounded up to a power of two (at least 2).
+  explicit SpscRing(const std::size_t capacity)
+      : capacity_(RoundUpToPowerOfTwo(capacity)),
+        mask_(capacity_ - 1),
+        elements_(static_cast<T*>(
+            AlignedAllocate(kCacheLineSize, capacity_ * sizeof(T)))),
+        head_(0),
+        cached_tail_(0),
+        tail_(0),
+        cached_head_(0) {}
+
+  // Must not run concurrently with any other member function.
+  ~SpscRing() {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    for (std::size_t i = head_.load(std::memory_order_relaxed); i != tail;
+         ++i) {
+      elements_[i & mask_].~T();
+    }
+    AlignedFree(elements_);
+  }
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  std::size_t capacity() const { return capacity_; }
+
+  // Producer side. Returns false if the ring is full.
+  template <typename... Arguments>
+  bool try_emplace(Arguments&&... arguments) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == capacity_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == capacity_) {
+        return false;
+      }
+    }
+    ::new (static_cast<void*>(&elements_[tail & mask_]))
+        T(std::forward<Arguments>(arguments)...);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool try_push(const T& value) { return try_emplace(value); }
+  bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+  // Producer side. Copies up to num_values values and returns how many fit.
+  std::size_t try_push_batch(const T* values, const std::size_t num_values) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    std::size_t free_slots = capacity_ - (tail - cached_head_);
+    if (free_slots < num_values) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      free_slots = capacity_ - (tail - cached_head_);
+    }
+    const std::size_t count = num_values < free_slots ? num_values : free_slots;
+    for (std::size_t i = 0; i < count; ++i) {
+      ::new (static_cast<void*>(&elements_[(tail + i) & mask_])) T(values[i]);
+    }
+    if (count != 0) {
+      tail_.store(tail + count, std::memory_order_release);
+    }
+    return count;
+  }
+
+  // Consumer side. Returns false if the ring is empty.
+  bool try_pop(T* value) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return false;
+      }
+    }
+    T& element = elements_[head & mask_];
+    *value = std::move(element);
+    element.~T();
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Moves up to max_values values to 'values' and returns how
+  // many were moved.
+  std::size_t try_pop_batch(T* values, const std::size_t max_values) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    std::size_t available = cached_tail_ - head;
+    if (available < max_values) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      available = cached_tail_ - head;
+    }
+    const std::size_t count = max_values < available ? max_values : available;
+    for (std::size_t i = 0; i < count; ++i) {
+      T& element = elements_[(head + i) & mask_];
+      values[i] = std::move(element);
+      element.~T();
+    }
+    if (count != 0) {
+      head_.store(head + count, std::memory_order_release);
+    }
+    return count;
+  }
+
+  // Blocking variants: push waits while the ring is full and pop while it is
+  // empty. The batch variants wait until they can move at least one value.
+  // They wake up the other side if it sleeps in a blocking variant.
+  void push(T value) {
+    WaitUntil(&not_full_, [&]() { return try_push(std::move(value)); });
+    not_empty_.Notify();
+  }
+
+  void pop(T* value) {
+    WaitUntil(&not_empty_, [&]() { return try_pop(value); });
+    not_full_.Notify();
+  }
+
+  std::size_t push_batch(const T* values, const std::size_t num_values) {
+    std::size_t count = 0;
+    WaitUntil(&not_full_, [&]() {
+      count = try_push_batch(values, num_values);
+      return count != 0 || num_values == 0;
+    });
+    if (count != 0) {
+      not_empty_.Notify();
+    }
+    return count;
+  }
+
+  std::size_t pop_batch(T* values, const std::size_t max_values) {
+    std::size_t count = 0;
+    WaitUntil(&not_empty_, [&]() {
+      count = try_pop_batch(values, max_values);
+      return count != 0 || max_values == 0;
+    });
+    if (count != 0) {
+      not_full_.Notify();
+    }
+    return count;
+  }
+
+ private:
+  static std::size_t RoundUpToPowerOfTwo(const std::size_t value) {
+    std::size_t power = 2;
+    while (power < value) {
+      power *= 2;
+    }
+    return power;
+  }
+
+  const std::size_t capacity_;
+  const std::size_t mask_;
+  T* const elements_;
+
+  // Written by the consumer.
+  alignas(kCacheLineSize) std::atomic<std::size_t> head_;
+  std::size_t cached_tail_;
+
+  // Written by the producer.
+  alignas(kCacheLineSize) std::atomic<std::size_t> tail_;
+  std::size_t cached_head_;
+
+  // Each event in its own cache line: the producer signals not_empty_ while
+  // the consumer signals not_full_.
+  alignas(kCacheLineSize) FutexEvent not_empty_;
+  alignas(kCacheLineSize) FutexEvent not_full_;
+};
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_SPSC_RING_H_
@@ -0,0 +1,175 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_TAGGED_PTR_H_
+#define CPP_LABS_TAGGED_PTR_H_
+
+// TaggedPtr<T> is a 64-bit pointer that carries extra bits of information in
+// the bits of the address that are always zero:
+//
+// 1. The high 16 bits: on x86-64 (and AArch64) user-space addresses only use
+// the low 48 bits. TaggedPtr stores a 16-bit tag there, typically a version
+// counter that is incremented every time the pointer is replaced. Lock-free
+// structures compare the pointer and its version in a single compare-and-swap,
+// which detects the ABA problem: the pointer went from A to B and back to A,
+// so comparing the address alone would wrongly succeed.
+// 2. The low bits: an object aligned to alignof(T) bytes has an address whose
+// low log2(alignof(T)) bits are zero. TaggedPtr exposes them as flags (e.g.,
+// the color of a red-black tree node as in tree_set.h, or a "marked for
+// deletion" bit).
+//
+// TaggedPtr is exactly as large as a raw pointer, trivially copyable (so
+// std::atomic<TaggedPtr<T>> is lock free) and keeps the '*', '->' and
+// arithmetic of pointers_example.cc; the tags follow the pointer through the
+// arithmetic.
+//
+// Example:
+//   TaggedPtr<Node> head(node, 0);
+//   TaggedPtr<Node> next_head = head.WithPointer(other_node);  // Version 1.
+//   next_head->key = 4;
+
+#include <cassert>  // Header for assert.
+#include <cstddef>  // Header for std::size_t and std::nullptr_t.
+#include <cstdint>  // Header for uint64_t and uintptr_t.
+
+namespace cpp_labs {
+
+// Alignment defaults to alignof(T), so T must be a complete type. A node that
+// holds TaggedPtr to its own type must pass the Alignment explicitly.
+template <typename T, std::size_t Alignment = alignof(T)>
+class TaggedPtr {
+ public:
+  static_assert(sizeof(void*) == 8, "TaggedPtr needs 64-bit pointers.");
+
+  // Bits available for the tag and for the flags (up to 4 flags).
+  static const int kTagBits = 16;
+  static const int kFlagBits = Alignment >= 16 ? 4
+                               : Alignment >= 8 ? 3
+                               : Alignment >= 4 ? 2
+                               : Alignment >= 2 ? 1
+                                                : 0;
+
+  TaggedPtr() : bits_(0) {}
+  TaggedPtr(std::nullptr_t) : bits_(0) {}
+  explicit TaggedPtr(T* pointer, const uint16_t tag = 0,
+                     const unsigned flags = 0)
+      : bits_(Pack(pointer, tag, flags)) {}
+
+  T* get() const { return reinterpret_cast<T*>(bits_ & kPointerMask); }
+  uint16_t tag() const { return static_cast<uint16_t>(bits_ >> kTagShift); }
+  unsigned flags() const { return static_cast<unsigned>(bits_ & kFlagMask); }
+  // The packed representation.
+  uint64_t bits() const { return bits_; }
+
+  void set_tag(const uint16_t tag) {
+    bits_ = (bits_ & ~kTagMask) | (static_cast<uint64_t>(tag) << kTagShift);
+  }
+  void set_flags(const unsigned flags) {
+    assert(flags <= kFlagMask);
+    bits_ = (bits_ & ~kFlagMask) | flags;
+  }
+
+  // Returns pointer tagged with the next version (tag + 1, wrapping around),
+  // the usual way to replace the value of an atomic TaggedPtr.
+  TaggedPtr WithPointer(T* pointer) const {
+    return TaggedPtr(pointer, static_cast<uint16_t>(tag() + 1), 0);
+  }
+
+  T& operator*() const { return *get(); }
+  T* operator->() const { return get(); }
+  explicit operator bool() const { return get() != nullptr; }
+
+  // Arithmetic moves the address and keeps the tag and the flags.
+  TaggedPtr& operator+=(const std::ptrdiff_t offset) {
+    bits_ = Pack(get() + offset, tag(), flags());
+    return *this;
+  }
+  TaggedPtr& operator-=(const std::ptrdiff_t offset) {
+    return *this += -offset;
+  }
+  TaggedPtr& operator++() { return *this += 1; }
+  TaggedPtr& operator--() { return *this -= 1; }
+  TaggedPtr operator+(const std::ptrdiff_t offset) const {
+    TaggedPtr result = *this;
+    return result += offset;
+  }
+  TaggedPtr operator-(const std::ptrdiff_t offset) const {
+    TaggedPtr result = *this;
+    return result -= offset;
+  }
+  std::ptrdiff_t operator-(const TaggedPtr& other) const {
+    return get() - other.get();
+  }
+
+  // Two tagged pointers are equal when the address, the tag and the flags are
+  // all equal, which is what a compare-and-swap on the packed bits checks.
+  bool operator==(const TaggedPtr& other) const {
+    return bits_ == other.bits_;
+  }
+  bool operator!=(const TaggedPtr& other) const {
+    return bits_ != other.bits_;
+  }
+
+ private:
+  static const int kTagShift = 64 - kTagBits;
+  static const uint64_t kTagMask = ~uint64_t(0) << kTagShift;
+  static const uint64_t kFlagMask = (uint64_t(1) << kFlagBits) - 1;
+  static const uint64_t kPointerMask = ~kTagMask & ~kFlagMask;
+
+  static uint64_t Pack(T* pointer, const uint16_t tag, const unsigned flags) {
+    const uint64_t address = reinterpret_cast<uintptr_t>(pointer);
+    assert((address & ~kPointerMask) == 0);
+    assert(flags <= kFlagMask);
+    return address | (static_cast<uint64_t>(tag) << kTagShift) | flags;
+  }
+
+  uint64_t bits_;
+};
+
+template <typename T, std::size_t Alignment>
+const int TaggedPtr<T, Alignment>::kTagBits;
+template <typename T, std::size_t Alignment>
+const int TaggedPtr<T, Alignment>::kFlagBits;
+template <typename T, std::size_t Alignment>
+const int TaggedPtr<T, Alignment>::kTagShift;
+template <typename T, std::size_t Alignment>
+const uint64_t TaggedPtr<T, Alignment>::kTagMask;
+template <typename T, std::size_t Alignment>
+const uint64_t TaggedPtr<T, Alignment>::kFlagMask;
+template <typename T, std::size_t Alignment>
+const uint64_t TaggedPtr<T, Alignment>::kPointerMask;
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_TAGGED_PTR_H_
@@ -0,0 +1,301 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_TREE_SET_H_
+#define CPP_LABS_TREE_SET_H_
+
+// TreeSet<Key, NodePolicy> is an ordered set implemented as a left-leaning
+// red-black tree (the balanced binary tree behind std::set, in its simplest
+// form). The NodePolicy decides how the nodes point to their children, so the
+// same tree can be built with three kinds of pointers:
+//
+// 1. RawNodePolicy: 64-bit pointers and a bool for the color, allocated with
+// 'new' as std::set does.
+// 2. CompressedNodePolicy: 32-bit CompressedPtr (see compressed_ptr.h) into a
+// CompressedArena, with the color in the top bit of one of them.
+// 3. TaggedNodePolicy: 64-bit pointers whose lowest bit stores the color of
+// the node (see tagged_ptr.h), which removes the bool and its padding.
+//
+// Example:
+//   TreeSet<uint64_t, CompressedNodePolicy> my_set;
+//   my_set.insert(4);
+//   if (my_set.contains(4)) { ... }
+
+#include <cassert>  // Header for assert.
+#include <cstddef>  // Header for std::size_t.
+#include <cstdint>  // Header for uint32_t.
+#include <new>  // Header for std::bad_alloc.
+
+#include "compressed_ptr.h"
+#include "tagged_ptr.h"
+
+namespace cpp_labs {
+
+// Nodes linked with raw pointers; the color takes its own field.
+struct RawNodePolicy {
+  static const char* Name() { return "raw pointers"; }
+
+  template <typename Key>
+  class Node {
+   public:
+    typedef Node* Pointer;
+
+    explicit Node(const Key& key)
+        : key_(key), left_(nullptr), right_(nullptr), red_(true) {}
+
+    const Key& key() const { return key_; }
+    Pointer left() const { return left_; }
+    Pointer right() const { return right_; }
+    bool red() const { return red_; }
+    void set_left(const Pointer left) { left_ = left; }
+    void set_right(const Pointer right) { right_ = right; }
+    void set_red(const bool red) { red_ = red; }
+
+    static Pointer New(const Key& key) { return new Node(key); }
+    static void Delete(const Pointer node) { delete node; }
+
+   private:
+    Key key_;
+    Node* left_;
+    Node* right_;
+    bool red_;
+  };
+};
+
+// Nodes linked with 32-bit indices into a CompressedArena. The color is the
+// top bit of the left index, so that a node with a 64-bit key takes 16 bytes
+// (a bool would be padded to 24); the arena then holds up to 2^31 - 1 nodes,
+// and New throws std::bad_alloc beyond them.
+struct CompressedNodePolicy {
+  static const char* Name() { return "compressed pointers"; }
+
+  template <typename Key>
+  class Node {
+   public:
+    typedef CompressedPtr<Node> Pointer;
+
+    explicit Node(const Key& key) : key_(key), left_(kRedBit), right_(0) {}
+
+    const Key& key() const { return key_; }
+    Pointer left() const { return Pointer::FromIndex(left_ & ~kRedBit); }
+    Pointer right() const { return Pointer::FromIndex(right_); }
+    bool red() const { return (left_ & kRedBit) != 0; }
+    void set_left(const Pointer left) {
+      assert((left.index() & kRedBit) == 0);
+      left_ = (left_ & kRedBit) | left.index();
+    }
+    void set_right(const Pointer right) { right_ = right.index(); }
+    void set_red(const bool red) {
+      left_ = red ? (left_ | kRedBit) : (left_ & ~kRedBit);
+    }
+
+    static Pointer New(const Key& key) {
+      const Pointer node = CompressedArena<Node>::New(key);
+      // Indices from 2^31 on would overwrite the color bit.
+      if ((node.index() & kRedBit) != 0) {
+        CompressedArena<Node>::Delete(node);
+        throw std::bad_alloc();
+      }
+      return node;
+    }
+    static void Delete(const Pointer node) {
+      CompressedArena<Node>::Delete(node);
+    }
+
+   private:
+    static const uint32_t kRedBit = uint32_t(1) << 31;
+
+    Key key_;
+    uint32_t left_;
+    uint32_t right_;
+  };
+};
+
+// Nodes linked with raw pointers; the color lives in the lowest bit of the
+// pointer to the left child (nodes are at least 8-byte aligned).
+struct TaggedNodePolicy {
+  static const char* Name() { return "tagged pointers"; }
+
+  template <typename Key>
+  class Node {
+   public:
+    typedef Node* Pointer;
+
+    explicit Node(const Key& key)
+        : left_(nullptr, 0, kRed), right_(nullptr), key_(key) {}
+
+    const Key& key() const { return key_; }
+    Pointer left() const { return left_.get(); }
+    Pointer right() const { return right_.get(); }
+    bool red() const { return left_.flags() == kRed; }
+    void set_left(const Pointer left) {
+      left_ = TaggedPointer(left, 0, left_.flags());
+    }
+    void set_right(const Pointer right) { right_ = TaggedPointer(right); }
+    void set_red(const bool red) { left_.set_flags(red ? kRed : 0); }
+
+    static Pointer New(const Key& key) { return new Node(key); }
+    static void Delete(const Pointer node) { delete node; }
+
+   private:
+    // Node is incomplete here, so the alignment is given explicitly.
+    typedef TaggedPtr<Node, alignof(void*)> TaggedPointer;
+    static const unsigned kRed = 1;
+
+    TaggedPointer left_;
+    TaggedPointer right_;
+    Key key_;
+  };
+};
+
+template <typename Key, typename NodePolicy = RawNodePolicy>
+class TreeSet {
+ public:
+  typedef typename NodePolicy::template Node<Key> Node;
+  typedef typename Node::Pointer Pointer;
+
+  TreeSet() : root_(nullptr), size_(0) {}
+  ~TreeSet() { clear(); }
+
+  TreeSet(const TreeSet&) = delete;
+  TreeSet& operator=(const TreeSet&) = delete;
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Bytes of one node, without any allocator overhead.
+  static std::size_t node_size() { return sizeof(Node); }
+
+  // Returns true if the key was not in the set.
+  bool insert(const Key& key) {
+    bool inserted = false;
+    root_ = Insert(root_, key, &inserted);
+    root_->set_red(false);
+    return inserted;
+  }
+
+  bool contains(const Key& key) const {
+    Pointer node = root_;
+    while (node) {
+      if (key < node->key()) {
+        node = node->left();
+      } else if (node->key() < key) {
+        node = node->right();
+      } else {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // The root node, for lookups that walk the tree themselves (e.g., the
+  // interleaved lookups of coroutine_lookup.h).
+  Pointer root() const { return root_; }
+
+  void clear() {
+    DeleteSubtree(root_);
+    root_ = nullptr;
+    size_ = 0;
+  }
+
+ private:
+  static bool IsRed(const Pointer node) { return node && node->red(); }
+
+  static Pointer RotateLeft(const Pointer node) {
+    const Pointer right = node->right();
+    node->set_right(right->left());
+    right->set_left(node);
+    right->set_red(node->red());
+    node->set_red(true);
+    return right;
+  }
+
+  static Pointer RotateRight(const Pointer node) {
+    const Pointer left = node->left();
+    node->set_left(left->right());
+    left->set_right(node);
+    left->set_red(node->red());
+    node->set_red(true);
+    return left;
+  }
+
+  static void FlipColors(const Pointer node) {
+    node->set_red(!node->red());
+    node->left()->set_red(!node->left()->red());
+    node->right()->set_red(!node->right()->red());
+  }
+
+  Pointer Insert(const Pointer node, const Key& key, bool* inserted) {
+    if (!node) {
+      // New may throw std::bad_alloc; count the node only once it exists.
+      const Pointer new_node = Node::New(key);
+      *inserted = true;
+      ++size_;
+      return new_node;
+    }
+    if (key < node->key()) {
+      node->set_left(Insert(node->left(), key, inserted));
+    } else if (node->key() < key) {
+      node->set_right(Insert(node->right(), key, inserted));
+    }
+
+    // Restore the invariants of the left-leaning red-black tree.
+    Pointer root = node;
+    if (IsRed(root->right()) && !IsRed(root->left())) {
+      root = RotateLeft(root);
+    }
+    if (IsRed(root->left()) && IsRed(root->left()->left())) {
+      root = RotateRight(root);
+    }
+    if (IsRed(root->left()) && IsRed(root->right())) {
+      FlipColors(root);
+    }
+    return root;
+  }
+
+  static void DeleteSubtree(const Pointer node) {
+    if (node) {
+      DeleteSubtree(node->left());
+      DeleteSubtree(node->right());
+      Node::Delete(node);
+    }
+  }
+
+  Pointer root_;
+  std::size_t size_;
+};
+
+}  // namespace cpp_labs
+
+#endif  // CPP_LABS_TREE_SET_H_
@@ -0,0 +1,177 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// This binary compares the memory and the lookup speed of the same balanced
+// tree (tree_set.h) built with raw, compressed (32-bit) and tagged pointers,
+// and of std::set.
+//
+// Usage: tree_set_benchmark [num_keys] [num_lookups]
+//   Defaults: num_keys = 10000000, num_lookups = 10000000.
+//
+// Notes:
+//
+// 1. Each tree is built in its own child process, and its memory is the growth
+// of the peak resident memory of that process during the build. This includes
+// the allocator overhead: 'new' rounds each node up and adds a header, while
+// the CompressedArena packs the nodes back to back.
+// 2. A lookup follows about log2(num_keys) child pointers, each one a likely
+// cache miss in a large tree. Smaller nodes mean more of the tree stays in the
+// caches.
+
+#include <cstdint>  // Header for uint64_t.
+#include <iomanip>  // Header for std::setw.
+#include <iostream>  // Header for printing to stdout.
+#include <random>  // Header for std::mt19937_64.
+#include <set>  // Header for std::set.
+#include <string>  // Header for std::string.
+#include <vector>  // Header for std::vector.
+
+#include "benchmark_utils.h"
+#include "tree_set.h"
+
+namespace {
+
+struct Result {
+  double build_seconds;
+  double lookup_seconds;
+  double bytes_per_key;
+  std::size_t num_found;
+};
+
+std::vector<uint64_t> MakeKeys(const std::size_t num_keys) {
+  std::mt19937_64 rng(1234);
+  std::vector<uint64_t> keys(num_keys);
+  for (uint64_t& key : keys) {
+    key = rng();
+  }
+  return keys;
+}
+
+// std::set and TreeSet have different member names for lookups.
+template <typename Key, typename Policy>
+bool Contains(const cpp_labs::TreeSet<Key, Policy>& set, const Key& key) {
+  return set.contains(key);
+}
+
+template <typename Key>
+bool Contains(const std::set<Key>& set, const Key& key) {
+  return set.find(key) != set.end();
+}
+
+template <typename Set>
+Result BuildAndLookup(const std::size_t num_keys,
+                      const std::size_t num_lookups) {
+  const std::vector<uint64_t> keys = MakeKeys(num_keys);
+  std::mt19937_64 rng(99);
+  std::uniform_int_distribution<std::size_t> distribution(0, num_keys - 1);
+  std::vector<uint64_t> lookups(num_lookups);
+  for (uint64_t& lookup : lookups) {
+    lookup = keys[distribution(rng)];
+  }
+
+  Result result;
+  const long memory_before_kb = cpp_labs::PeakMemoryKb();
+  cpp_labs::Timer timer;
+  Set* set = new Set;
+  for (const uint64_t key : keys) {
+    set->insert(key);
+  }
+  result.build_seconds = timer.ElapsedSeconds();
+  result.bytes_per_key =
+      (cpp_labs::PeakMemoryKb() - memory_before_kb) * 1024.0 / num_keys;
+
+  timer.Reset();
+  std::size_t num_found = 0;
+  for (const uint64_t lookup : lookups) {
+    num_found += Contains(*set, lookup) ? 1 : 0;
+  }
+  result.lookup_seconds = timer.ElapsedSeconds();
+  result.num_found = num_found;
+  // The process exits right after; skip the (slow) destruction of the tree.
+  return result;
+}
+
+template <typename Set>
+void Measure(const std::string& name, const std::size_t node_size,
+             const std::size_t num_keys, const std::size_t num_lookups) {
+  Result result;
+  long peak_memory_kb = 0;
+  std::cout << std::setw(32) << name;
+  if (!cpp_labs::RunInChildProcess(
+          [&]() { return BuildAndLookup<Set>(num_keys, num_lookups); },
+          &result, &peak_memory_kb)) {
+    std::cout << "  failed (out of memory?)" << std::endl;
+    return;
+  }
+  std::cout << std::setw(10) << node_size << std::setw(12)
+            << result.bytes_per_key << std::setw(12)
+            << result.build_seconds * 1e9 / num_keys << std::setw(12)
+            << result.lookup_seconds * 1e9 / num_lookups;
+  if (result.num_found != num_lookups) {
+    std::cout << "  (lost " << num_lookups - result.num_found << " keys!)";
+  }
+  std::cout << std::endl;
+}
+
+template <typename Policy>
+void MeasureTreeSet(const std::size_t num_keys, const std::size_t num_lookups) {
+  typedef cpp_labs::TreeSet<uint64_t, Policy> Set;
+  Measure<Set>(std::string("TreeSet, ") + Policy::Name(), Set::node_size(),
+               num_keys, num_lookups);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::size_t num_keys =
+      cpp_labs::ParseSizeArgument(argc, argv, 1, 10000000);
+  const std::size_t num_lookups =
+      cpp_labs::ParseSizeArgument(argc, argv, 2, 10000000);
+  if (num_keys == 0) {
+    std::cerr << "num_keys must be positive." << std::endl;
+    return 1;
+  }
+
+  std::cout << num_keys << " uint64_t keys, " << num_lookups << " lookups\n"
+            << std::setw(32) << "container" << std::setw(10) << "node B"
+            << std::setw(12) << "B/key" << std::setw(12) << "insert ns"
+            << std::setw(12) << "lookup ns" << std::endl;
+  // A std::set node has three pointers, a color and the key.
+  Measure<std::set<uint64_t> >("std::set", 4 * sizeof(void*) + 8, num_keys,
+                               num_lookups);
+  MeasureTreeSet<cpp_labs::RawNodePolicy>(num_keys, num_lookups);
+  MeasureTreeSet<cpp_labs::TaggedNodePolicy>(num_keys, num_lookups);
+  MeasureTreeSet<cpp_labs::CompressedNodePolicy>(num_keys, num_lookups);
+  return 0;
+}
@@ -0,0 +1,156 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef CPP_LABS_TRIVIALLY_RELOCATABLE_H_
+#define CPP_LABS_TRIVIALLY_RELOCATABLE_H_
+
+// Trivial relocation: moving an object to a new address with memcpy.
+//
+// When a std::vector grows it calls the move (or copy) constructor of every
+// element to build it in the new buffer, and then the destructor of the old
+// element. For many types the pair "move-construct + destroy the source" has
+// exactly the same effect as copying the bytes and forgetting the source:
+// the object does not store its own address anywhere. Such types are called
+// trivially relocatable, and containers can move them with one memcpy (or
+// memmove, or even realloc/mremap) instead of a loop of constructor calls.
+//
+// IsTriviallyRelocatable<T> is true for trivially copyable types, for the
+// standard library types known to be relocatable, and for any type opted in
+// with CPP_LABS_DECLARE_TRIVIALLY_RELOCATABLE:
+//
+//   class DummyObject { ... };
+//   CPP_LABS_DECLARE_TRIVIALLY_RELOCATABLE(DummyObject)
+//
+// Only opt in types that do not point into themselves and that are not
+// registered by address somewhere else. A class with a virtual destructor (as
+// DummyObject in references_example.cc) is fine: the vtable pointer is the same
+// at any address.
+//
+// Note that libstdc++'s std::string is NOT trivially relocatable: a short
+// string points into its own internal buffer. libc++'s std::string is, so it
+// is only opted in when building against libc++.
+
+#include <cstddef>  // Header for std::size_t.
+#include <cstring>  // Header for std::memmove.
+#include <memory>  // Header for std::unique_ptr and std::shared_ptr.
+#include <new>  // Header for placement new.
+#include <string>  // Header for std::basic_string.
+#include <type_traits>  // Header for std::integral_constant.
+#include <utility>  // Header for std::pair.
+#include <vector>  // Header for std::vector.
+
+namespace cpp_labs {
+
+template <typename T>
+struct IsTriviallyRelocatable
+    : std::integral_constant<bool, std::is_trivially_copyable<T>::value> {};
+
+// A pair is relocatable if both of its members are.
+template <typename First, typename Second>
+struct IsTriviallyRelocatable<std::pair<First, Second> >
+    : std::integral_constant<bool, IsTriviallyRelocatable<First>::value &&
+                                       IsTriviallyRelocatable<Second>::value> {
+};
+
+// Smart pointers and vectors only hold pointers to heap memory.
+template <typename T>
+struct IsTriviallyRelocatable<std::unique_ptr<T, std::default_delete<T> > >
+    : std::true_type {};
+
+template <typename T>
+struct IsTriviallyRelocatable<std::shared_ptr<T> > : std::true_type {};
+
+template <typename T>
+struct IsTriviallyRelocatable<std::vector<T, std::allocator<T> > >
+    : std::true_type {};
+
+#if defined(_LIBCPP_VERSION)
+template <typename Char>
+struct IsTriviallyRelocatable<
+    std::basic_string<Char, std::char_traits<Char>, std::allocator<Char> > >
+    : std::true_type {};
+#endif
+
+namespace internal {
+
+template <typename T>
+void RelocateRange(T* source, const std::size_t count, T* destination,
+                   std::true_type) {
+  if (count > 0 && source != destination) {
+    std::memmove(static_cast<void*>(destination),
+                 static_cast<const void*>(source), count * sizeof(T));
+  }
+}
+
+template <typename T>
+void RelocateRange(T* source, const std::size_t count, T* destination,
+                   std::false_type) {
+  if (destination < source) {
+    for (std::size_t i = 0; i < count; ++i) {
+      ::new (static_cast<void*>(destination + i)) T(std::move(source[i]));
+      source[i].~T();
+    }
+  } else if (destination > source) {
+    // Walk backwards so that an overlapping tail is not overwritten before it
+    // is moved.
+    for (std::size_t i = count; i > 0; --i) {
+      ::new (static_cast<void*>(destination + i - 1))
+          T(std::move(source[i - 1]));
+      source[i - 1].~T();
+    }
+  }
+}
+
+}  // namespace internal
+
+// Moves count objects from source to the uninitialized memory at destination
+// and ends the lifetime of the objects at source. The two ranges may overlap,
+// which is what insert and erase need to shift elements.
+template <typename T>
+void RelocateRange(T* source, const std::size_t count, T* destination) {
+  internal::RelocateRange(
+      source, count, destination,
+      std::integral_constant<bool, IsTriviallyRelocatable<T>::value>());
+}
+
+}  // namespace cpp_labs
+
+// Opts Type into trivial relocation. Use it in the global namespace.
+#define CPP_LABS_DECLARE_TRIVIALLY_RELOCATABLE(Type)                    \
+  namespace cpp_labs {                                                  \
+  template <>                                                           \
+  struct IsTriviallyRelocatable<Type> : std::true_type {};              \
+  }  // namespace cpp_labs
+
+#endif  // CPP_LABS_TRIVIALLY_RELOCATABLE_H_
@@ -49,10 +49,17 @@
 // 5. Always allocate memory for the vector, even if you exceed what is needed.
 // This allows the computer to be more efficient since the goal is to minimize
 // the number of times a std::vector reallocates memory.
+// 6. The vector operations are timed with the macros of instrumentation.h, and
+// the reallocations counted (an insertion reallocates when the size of the
+// vector reaches its capacity). They compile to nothing unless the labs are
+// built with -DBUILD_WITH_INSTRUMENTATION=ON, in which case the latency of
+// every operation is reported when the program exits.
 
 #include <iostream>  // Header for printing to stdout.
 #include <vector>  // Header for using std::vector.
 
+#include "instrumentation.h"
+
 int main(int argc, char** argv) {
   const int kNumElements = 10;
   // Constructs a vector with 10 integers.
@@ -80,8 +87,11 @@ int main(int argc, char** argv) {
   std::vector<int> my_vector2;  // Empty vector.
   my_vector2.reserve(kNumElements);  // Reserves memory to fit kNumelements.
   for (int i = 0; i < kNumElements; ++i) {
-    // Insert elements at the end of the vector.
-    my_vector2.push_back(i);
+    // Insert elements at the end of the vector. A push_back reallocates when
+    // the vector is full (size equals capacity).
+    CPP_LABS_COUNTER_ADD("std::vector reallocations",
+                         my_vector2.size() == my_vector2.capacity());
+    CPP_LABS_TIMED("std::vector::push_back", my_vector2.push_back(i));
   }
   // Print out the elements of the vector to the console using a plain for-loop.
   // Note we are using the [] to access the i-th element of the vector, as in
@@ -92,8 +102,12 @@ int main(int argc, char** argv) {
   }
   // Try to avoid the following scenario.
   std::cout << "Size before: " << my_vector2.size() << std::endl;
-  my_vector2.push_back(1000);
-  my_vector2.push_back(1001);
+  CPP_LABS_COUNTER_ADD("std::vector reallocations",
+                       my_vector2.size() == my_vector2.capacity());
+  CPP_LABS_TIMED("std::vector::push_back", my_vector2.push_back(1000));
+  CPP_LABS_COUNTER_ADD("std::vector reallocations",
+                       my_vector2.size() == my_vector2.capacity());
+  CPP_LABS_TIMED("std::vector::push_back", my_vector2.push_back(1001));
   std::cout << "Size after insertion: " << my_vector2.size() << std::endl;
   // Why? What happens is that my_vector2 only allocated memory to store
   // kNumElements However, since we inserted two new elements '1000' and '1001'
@@ -110,7 +124,9 @@ int main(int argc, char** argv) {
   // of copying objects might be expensive making the program slow.
 
   // 3. Resizing a vector.
-  my_vector2.resize(2 * kNumElements);
+  CPP_LABS_COUNTER_ADD("std::vector reallocations",
+                       2 * kNumElements > my_vector2.capacity());
+  CPP_LABS_TIMED("std::vector::resize", my_vector2.resize(2 * kNumElements));
   // This operation will execute the steps (a) and (b).
 
   // 4. Creating a vector with a different type. Note that the type goes inside
@@ -126,7 +142,10 @@ int main(int argc, char** argv) {
   char letters[] = {'a', 'b', 'c', 'd', 'e'};
   const int kLettersArraySize = 5;
   for (int i = 0; i < kLettersArraySize; ++i) {
-    my_char_vector.push_back(letters[i]);
+    CPP_LABS_COUNTER_ADD("std::vector reallocations",
+                         my_char_vector.size() == my_char_vector.capacity());
+    CPP_LABS_TIMED("std::vector::push_back",
+                   my_char_vector.push_back(letters[i]));
   }
   // Print out the elements of the vector to the console using a plain for-loop.
   // Note we are using the [] to access the i-th element of the vector, as in